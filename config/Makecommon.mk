@@ -45,10 +45,19 @@ override DEFINES+=-DMFM_TREE_VERSION="$(MFM_TREE_VERSION)"
 override DEFINES+=-DDEBIAN_PACKAGE_NAME="$(DEBIAN_PACKAGE_NAME)"
 override DEFINES+=-DMAGIC_DEBIAN_PACKAGE_VERSION="$(MAGIC_DEBIAN_PACKAGE_VERSION)"
 
+# Random's generator: 'make MFM_RANDOM=xoshiro' for xoshiro256**,
+# anything else for the default Mersenne Twister
+ifeq ($(MFM_RANDOM),xoshiro)
+  override DEFINES+=-DMFM_RANDOM_XOSHIRO
+endif
+
 # (AAAaand, we are now adopting a preemptive first strike policy!  See
 # 'EXTRA DEFINES', above.  Drop the override bomb!)
 override LIBS+=$(EXTERNAL_LIBS)
 
+# zlib, for core's EventHistorySpill.  Last, after every -lmfmcore
+override LIBS+=-lz
+
 ### TOOL STUFF
 
 ALLDEP+=$(wildcard $(BASEDIR)/config/*.mk) Makefile   # If config or local makefile changes, nuke it from orbit
@@ -74,6 +74,6 @@ ulam_checkvar:
 
 #LIBS := -L $(ULAM_BLD_DIR) -l culam $(LIBS)
 
-override LIBS += -L $(BASEDIR)/build/core -l mfmcore
+override LIBS += -L $(BASEDIR)/build/core -l mfmcore -lz
 
 .PHONY:	$(PHONY_TARGETS)
@@ -0,0 +1,192 @@
+/*                                              -*- mode:C++ -*-
+  AtomColorCache.h Remembering the colors recently computed for atoms
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file AtomColorCache.h Remembering the colors recently computed for atoms
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef ATOMCOLORCACHE_H
+#define ATOMCOLORCACHE_H
+
+#include "itype.h"
+#include "BitVector.h"
+
+namespace MFM
+{
+  /**
+     A direct-mapped table of Element::GetAtomColor results, keyed on
+     all the bits of the atom plus the color selector, so a site
+     whose atom hasn't changed since the last frame -- or that holds
+     the same atom as some other site -- costs a hash and a compare
+     instead of a (possibly ulam) getColor call.  SiteColorer
+     consults one, if given, for the dynamic site types.
+
+     Only the element's own color is kept; lowlighting is applied on
+     the way out (see Element::ModifyRenderColor), so toggling it
+     takes effect at once.  GetAtomColor is supposed to depend only
+     on the atom, but element parameters can change under it, so the
+     whole table is dropped every REFRESH_FRAMES frames (see
+     BeginFrame) and such changes show up within that many frames.
+
+     Not thread safe: each painting thread needs a cache of its own.
+   */
+  template <class EC>
+  class AtomColorCache
+  {
+  public:
+    typedef typename EC::ATOM_CONFIG AC;
+    typedef typename AC::ATOM_TYPE T;
+
+    enum
+    {
+      ENTRY_BITS = 12,
+      ENTRIES = 1 << ENTRY_BITS,
+      WORDS = BitVector<AC::BITS_PER_ATOM>::ARRAY_LENGTH,
+      REFRESH_FRAMES = 64
+    };
+
+    AtomColorCache()
+      : m_selector(0)
+      , m_index(0)
+      , m_frames(0)
+      , m_hits(0)
+      , m_misses(0)
+    {
+      Clear();
+    }
+
+    /**
+       Forget every cached color
+     */
+    void Clear()
+    {
+      for (u32 i = 0; i < ENTRIES; ++i)
+      {
+        m_entries[i].m_selector = 0;
+      }
+    }
+
+    /**
+       Note that a new frame is starting, dropping all cached colors
+       every REFRESH_FRAMES frames.
+     */
+    void BeginFrame()
+    {
+      if (++m_frames % REFRESH_FRAMES == 0)
+      {
+        Clear();
+      }
+    }
+
+    /**
+       Look for the color of \c atom under \c selector, which must be
+       nonzero.  If found, store it in \c color and return true.  If
+       not, return false, and the caller should compute the color and
+       hand it to Store before the next Find.
+     */
+    bool Find(const T & atom, u32 selector, u32 & color)
+    {
+      atom.GetBits().ToArray(m_key);
+
+      u32 hash = selector;
+      for (u32 i = 0; i < WORDS; ++i)
+      {
+        hash = (hash ^ m_key[i]) * 0x9e3779b1;  // Fibonacci hashing
+      }
+      m_index = hash >> (32 - ENTRY_BITS);
+      m_selector = selector;
+
+      const Entry & e = m_entries[m_index];
+      if (e.m_selector == selector)
+      {
+        bool same = true;
+        for (u32 i = 0; same && i < WORDS; ++i)
+        {
+          same = e.m_bits[i] == m_key[i];
+        }
+        if (same)
+        {
+          color = e.m_color;
+          ++m_hits;
+          return true;
+        }
+      }
+      ++m_misses;
+      return false;
+    }
+
+    /**
+       Remember \c color for the atom and selector of the last Find,
+       which must have returned false.
+     */
+    void Store(u32 color)
+    {
+      Entry & e = m_entries[m_index];
+      for (u32 i = 0; i < WORDS; ++i)
+      {
+        e.m_bits[i] = m_key[i];
+      }
+      e.m_selector = m_selector;
+      e.m_color = color;
+    }
+
+    u64 GetHits() const
+    {
+      return m_hits;
+    }
+
+    u64 GetMisses() const
+    {
+      return m_misses;
+    }
+
+    /**
+       Percentage of all Finds so far that hit, or 0 if there have
+       been none.
+     */
+    double GetHitPercent() const
+    {
+      const u64 total = m_hits + m_misses;
+      return total ? 100.0 * m_hits / total : 0;
+    }
+
+  private:
+    struct Entry
+    {
+      u32 m_bits[WORDS];
+      u32 m_selector;    // 0 if the entry is empty
+      u32 m_color;
+    };
+
+    Entry m_entries[ENTRIES];
+
+    /* The key of the last Find, for Store */
+    u32 m_key[WORDS];
+    u32 m_selector;
+    u32 m_index;
+
+    u32 m_frames;
+    u64 m_hits;
+    u64 m_misses;
+  };
+} /* namespace MFM */
+
+#endif /* ATOMCOLORCACHE_H */
@@ -108,6 +108,34 @@ namespace MFM {
       return (m_bits[idx] >> shift) & MakeMaskClip(length);
     }
 
+    /**
+     * The index of the unit after \c idx, or \c idx itself if it is
+     * the last unit.  Lets a field that may or may not cross into the
+     * next unit be handled as one 64 bit window without branching:
+     * when there is no next unit, the field lies entirely in the high
+     * half of the window, and the duplicated low half is ignored.
+     */
+    static inline u32 NextUnitIdx(const u32 idx) {
+      return MIN(idx + 1, ARRAY_LENGTH - 1);
+    }
+
+    /**
+     * The 64 bits starting at unit \c idx, with unit \c idx in the
+     * high half.  See NextUnitIdx.
+     */
+    inline u64 ReadWindow(const u32 idx) const {
+      return (((u64) m_bits[idx]) << BITS_PER_UNIT) | m_bits[NextUnitIdx(idx)];
+    }
+
+    /**
+     * Store a window read by ReadWindow(idx) back.  The high half is
+     * stored last, so it wins when there is no next unit.
+     */
+    inline void WriteWindow(const u32 idx, const u64 window) {
+      m_bits[NextUnitIdx(idx)] = (BitUnitType) window;
+      m_bits[idx] = (BitUnitType) (window >> BITS_PER_UNIT);
+    }
+
   public:
 
     /**
@@ -202,23 +230,9 @@ namespace MFM {
 
       /* See Write(u32,u32,u32) for theory, such as it is */
 
-      const u32 firstUnitIdx = startIdx / BITS_PER_UNIT;
-      const u32 firstUnitFirstBit = startIdx % BITS_PER_UNIT;
-      const bool hasSecondUnit = (firstUnitFirstBit + length) > BITS_PER_UNIT;
-      const u32 firstUnitLength = hasSecondUnit ? BITS_PER_UNIT-firstUnitFirstBit : length;
-
-      u32 ret = ReadFromUnit(firstUnitIdx, firstUnitFirstBit, firstUnitLength);
-
-      // NOTE: The ARRAY_LENGTH > 1 clause of the following 'if' is
-      // strictly unnecessary, since it is implied by hasSecondUnit --
-      // but without it, gcc's optimizer (at least in some versions)
-      // mistakenly declares an array bounds warning (which we treat as
-      // an error) when inlining the code involving firstUnitIdx + 1
-      if (ARRAY_LENGTH > 1 && hasSecondUnit) {
-	const u32 secondUnitLength = length - firstUnitLength;
-	ret = (ret << secondUnitLength) | ReadFromUnit(firstUnitIdx + 1, 0, secondUnitLength);
-      }
-      return ret;
+      const u32 unitIdx = startIdx / BITS_PER_UNIT;
+      const u32 shift = 2 * BITS_PER_UNIT - (startIdx % BITS_PER_UNIT) - length;
+      return (u32) ((ReadWindow(unitIdx) >> shift) & ((((u64) 1) << length) - 1));
     } //Read
 
     /**
@@ -242,24 +256,16 @@ namespace MFM {
       MFM_API_ASSERT_ARG(length <= sizeof(BitUnitType) * CHAR_BIT);
 
       /* Since we're writing no more than 32 bits into an array of 32 bit
-	 words, we can't need to touch more than two of them.  So unroll
-	 the loop.
+	 words, we can't need to touch more than two of them.  So treat
+	 the two as a single 64 bit window, and skip all the
+	 does-it-cross-a-unit branching.
       */
 
-      const u32 firstUnitIdx = startIdx / BITS_PER_UNIT;
-      const u32 firstUnitFirstBit = startIdx % BITS_PER_UNIT;
-      const bool hasSecondUnit = (firstUnitFirstBit + length) > BITS_PER_UNIT;
-      const u32 firstUnitLength = hasSecondUnit ? BITS_PER_UNIT - firstUnitFirstBit : length;
-
-      WriteToUnit(firstUnitIdx, firstUnitFirstBit, firstUnitLength, value >> (length - firstUnitLength));
-
-      // NOTE: The ARRAY_LENGTH > 1 clause of the following 'if' is
-      // strictly unnecessary, since it is implied by hasSecondUnit --
-      // but without it, gcc's optimizer (at least in some versions)
-      // mistakenly declares an array bounds warning (which we treat as
-      // an error) when inlining the code involving firstUnitIdx + 1
-      if (ARRAY_LENGTH > 1 && hasSecondUnit)
-	WriteToUnit(firstUnitIdx + 1, 0, length - firstUnitLength, value);
+      const u32 unitIdx = startIdx / BITS_PER_UNIT;
+      const u32 shift = 2 * BITS_PER_UNIT - (startIdx % BITS_PER_UNIT) - length;
+      const u64 mask = ((((u64) 1) << length) - 1) << shift;
+      const u64 window = ReadWindow(unitIdx);
+      WriteWindow(unitIdx, (window & ~mask) | ((((u64) value) << shift) & mask));
     } //Write
 
     /**
@@ -613,6 +619,28 @@ namespace MFM {
 
     bool operator==(const BitVector & rhs) const;
 
+    bool operator!=(const BitVector & rhs) const
+    {
+      return !(*this == rhs);
+    }
+
+    /**
+     * Determine which of \c count pairs of BitVectors differ, setting
+     * \c changed[i] to whether \c before[i] != \c after[i].  \c
+     * before and \c after are arrays of objects that are \c stride
+     * bytes apart (default: packed BitVectors), so arrays of
+     * structures holding BitVectors -- such as atoms -- can be
+     * compared in place.
+     *
+     * Each comparison is straight-line code over whole units, without
+     * early exits.
+     *
+     * @returns The number of pairs that differ.
+     */
+    static u32 FindChanged(const BitVector * before, const BitVector * after,
+                           const u32 count, bool * changed,
+                           const u32 stride = sizeof(BitVector));
+
     void ToArray(u32 array[ARRAY_LENGTH]) const;
 
     void FromArray(const u32 array[ARRAY_LENGTH]);
@@ -245,8 +245,39 @@ namespace MFM {
   template <u32 B>
   bool BitVector<B>::operator==(const BitVector & rhs) const
   {
-    return 0 == memcmp(m_bits, rhs.m_bits, sizeof(m_bits));
+    // OR together all the differences rather than stopping at the
+    // first, so the loop has no data-dependent branches
+    BitUnitType diffs = 0;
+    for (u32 i = 0; i < ARRAY_LENGTH; ++i)
+    {
+      diffs |= m_bits[i] ^ rhs.m_bits[i];
+    }
+    return diffs == 0;
+  }
+
+  template <u32 B>
+  u32 BitVector<B>::FindChanged(const BitVector * before, const BitVector * after,
+                                const u32 count, bool * changed, const u32 stride)
+  {
+    u32 changes = 0;
+    if (stride == sizeof(BitVector))
+    {
+      for (u32 n = 0; n < count; ++n)
+      {
+        changes += (changed[n] = (before[n] != after[n]));
+      }
+      return changes;
+    }
 
+    const u8 * bp = (const u8 *) before;
+    const u8 * ap = (const u8 *) after;
+    for (u32 n = 0; n < count; ++n, bp += stride, ap += stride)
+    {
+      const bool differs = *(const BitVector *) bp != *(const BitVector *) ap;
+      changed[n] = differs;
+      changes += differs;
+    }
+    return changes;
   }
 
   template <u32 B>
@@ -33,6 +33,7 @@
 #include "Fail.h"
 #include "Point.h"
 #include "Packet.h"
+#include "PacketIO.h"
 #include "ChannelEnd.h"
 #include "MDist.h"  /* for EVENT_WINDOW_SITES */
 #include "Logger.h"
@@ -205,6 +206,12 @@ namespace MFM {
     u32 m_toSendCount;    // Used length of m_toSend
     u32 m_sentCount;      // Next index to send in m_toSend
 
+    /**
+       m_toSend serialized as a single UPDATE_FRAME packet, built by
+       StartShipping and held until the channel has room for it.
+     */
+    PacketIO m_updateFrame;
+
     enum State
     {
       IDLE,         // Unlocked, not in use
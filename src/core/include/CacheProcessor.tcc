@@ -3,6 +3,7 @@
 #include "PacketIO.h"
 #include "CharBufferByteSource.h"
 #include "EventHistoryBuffer.h"
+#include "TileCounters.h"
 
 namespace MFM
 {
@@ -62,10 +63,12 @@ namespace MFM
     // Now it's about shipping
     SetStateInternal(SHIPPING);
 
-    PacketIO pbuffer;
-    if (!pbuffer.SendUpdateBegin(*this, m_eventCenter))
+    // Serialize the whole update once; AdvanceShipping writes it
+    m_updateFrame.StartUpdateFrame(*this, m_eventCenter, m_toSendCount);
+    for (u32 i = 0; i < m_toSendCount; ++i)
     {
-      FAIL(ILLEGAL_STATE);
+      CachePacketInfo & cpi = m_toSend[i];
+      m_updateFrame.AddFrameAtom(cpi.m_type, *this, cpi.m_siteNumber, cpi.m_atom);
     }
   }
 
@@ -127,17 +130,14 @@ namespace MFM
   template <class EC>
   bool CacheProcessor<EC>::ShipBufferAsPacket(PacketBuffer & pb)
   {
-    MFM_API_ASSERT(!pb.HasOverflowed(), OUT_OF_ROOM);
-
-    u32 plen = pb.GetLength();
-    if (m_channelEnd.CanWrite() <= plen) // Total write will be plen+1
+    const u32 length = pb.GetLength();
+    if (!m_channelEnd.SendPacket(pb))
     {
       return false;
     }
-
-    u8 byte = (u8) plen;  // plen<128 since OString128..
-    m_channelEnd.Write(&byte, 1);  // Packet length, then data
-    m_channelEnd.Write((const u8 *) pb.GetBuffer(), plen);
+    TileCounters & counters = GetTile().GetCounters();
+    counters.Add(m_cacheDir, TileCounters::PACKETS_SENT);
+    counters.Add(m_cacheDir, TileCounters::BYTES_SENT, length);
     return true;
   }
 
@@ -265,6 +265,7 @@ namespace MFM
 
     if (consistentCount != m_toSendCount)
     {
+      GetTile().GetCounters().Add(m_cacheDir, TileCounters::CHECK_FAILURES);
       ReportCheckFailure();
     }
     else
@@ -344,42 +345,23 @@ namespace MFM
 		  m_locksNeeded > 2? Dirs::GetName(m_lockRegions[2]) : "-",
                   m_farSideOrigin.GetX(),
                   m_farSideOrigin.GetY()));
-    bool didWork = false;
-    PacketIO pbuffer;
-
-    // Try to send any unsent packets
-    while (m_sentCount < m_toSendCount)
+    // Try to send the whole update at once
+    if (!m_updateFrame.ShipUpdateFrame(*this))
     {
-      CachePacketInfo & cpi = m_toSend[m_sentCount];
-      if (!pbuffer.SendAtom(cpi.m_type, *this, cpi.m_siteNumber, cpi.m_atom))
-      {
-        return didWork;
-      }
-      didWork = true;
-      ++m_sentCount;
-      MFM_LOG_DBG7(("CP %s %s %d[%s %s %s]: Ship %d (site #%d)",
-                    GetTile().GetLabel(),
-                    Dirs::GetName(m_cacheDir),
-		    m_locksNeeded,
-		    Dirs::GetName(m_lockRegions[0]),
-		    m_locksNeeded > 1? Dirs::GetName(m_lockRegions[1]) : "-",
-		    m_locksNeeded > 2? Dirs::GetName(m_lockRegions[2]) : "-",
-                    m_sentCount,
-                    cpi.m_siteNumber));
-    }
-
-    // Try to send the update end packet if not yet sent
-    if (m_sentCount == m_toSendCount)
-    {
-      if (!pbuffer.SendUpdateEnd(*this))
-      {
-        return didWork;
-      }
-      didWork = true;
+      return false;  // No room yet
     }
+    m_sentCount = m_toSendCount;
+    MFM_LOG_DBG7(("CP %s %s %d[%s %s %s]: Shipped %d",
+                  GetTile().GetLabel(),
+                  Dirs::GetName(m_cacheDir),
+		  m_locksNeeded,
+		  Dirs::GetName(m_lockRegions[0]),
+		  m_locksNeeded > 1? Dirs::GetName(m_lockRegions[1]) : "-",
+		  m_locksNeeded > 2? Dirs::GetName(m_lockRegions[2]) : "-",
+                  m_sentCount));
 
     SetStateInternal(RECEIVING);
-    return didWork;
+    return true;
   }
 
   template <class EC>
@@ -400,6 +382,9 @@ namespace MFM
         return didWork;
       }
       didWork = true;
+      TileCounters & counters = GetTile().GetCounters();
+      counters.Add(m_cacheDir, TileCounters::PACKETS_RECEIVED);
+      counters.Add(m_cacheDir, TileCounters::BYTES_RECEIVED, pb->GetLength());
       if (!pio.HandlePacket(*this, *pb))
       {
         FAIL(INCOMPLETE_CODE);
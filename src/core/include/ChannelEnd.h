@@ -146,6 +146,14 @@ namespace MFM
       m_onSideA = onSideA;
     }
 
+    /**
+       Write the bytes in \c pb to the channel as a single packet,
+       preceded by its length as a big-endian u16.  Return false,
+       writing nothing, if there isn't room for the whole packet.
+       FAILs with OUT_OF_ROOM if pb has overflowed.
+     */
+    bool SendPacket(const PacketBuffer & pb) ;
+
     /**
        Return NULL if no complete packet is available.  Otherwise
        return a pointer to a buffered, complete, unparsed packet.
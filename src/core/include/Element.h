@@ -99,6 +99,13 @@ namespace MFM
      */
     bool m_renderLowlight;
 
+    /**
+     * A flag indicating that events on Atoms of this Element can
+     * never change anything, so the Tile may count them without
+     * actually running them.
+     */
+    bool m_isInert;
+
     /**
      * The basic, most generic Atom of this Element to be used when
      * placing a new Atom.
@@ -251,6 +258,19 @@ namespace MFM
       m_name = name;
     }
 
+    /**
+     * Declares that this Element is inert: its Behavior never reads
+     * or writes the event window, and it never diffuses, so an event
+     * on one of its Atoms is a no-op.  Tiles count such events
+     * without locking, loading, or storing an event window for them.
+     * Only call this from the constructor of an Element whose
+     * Behavior is empty.
+     */
+    void SetInert()
+    {
+      m_isInert = true;
+    }
+
    public:
 
     /**
@@ -263,6 +283,7 @@ namespace MFM
     Element(const UUID & uuid) : m_UUID(uuid), m_type(0),
                                  m_hasType(false),
                                  m_renderLowlight(false),
+                                 m_isInert(false),
                                  m_atomicSymbol("!!"),
                                  m_name("UNNAMED")
     {
@@ -359,6 +380,18 @@ namespace MFM
       return m_name;
     }
 
+    /**
+     * Checks whether events on Atoms of this Element are no-ops.
+     *
+     * @returns \c true if this Element has been declared inert.
+     *
+     * @sa SetInert
+     */
+    bool IsInert() const
+    {
+      return m_isInert;
+    }
+
     /**
      * Appends a short description of the data held by an Atom of this
      * Element.
@@ -447,8 +480,17 @@ namespace MFM
      */
     u32 GetStaticColor() const
     {
-      u32 baseColor = this->GetElementColor();
+      return ModifyRenderColor(this->GetElementColor());
+    }
 
+    /**
+     * Applies any user-requested lowlighting etc. to \c baseColor,
+     * as GetStaticColor and GetDynamicColor do to the colors they
+     * compute.  For renderers that cache GetAtomColor results and
+     * so must not cache the modifications.
+     */
+    u32 ModifyRenderColor(u32 baseColor) const
+    {
       if(m_renderLowlight)
       {
         baseColor = DarkenColor(baseColor, 50);
@@ -521,14 +563,7 @@ namespace MFM
      */
     u32 GetDynamicColor(const ElementTable<EC> & et, const UlamClassRegistry<EC> & ucr, const T& atom, u32 selector) const
     {
-      u32 baseColor = this->GetAtomColor(et, ucr, atom, selector);
-
-      if(m_renderLowlight)
-      {
-        baseColor = DarkenColor(baseColor, 50);
-      }
-
-      return baseColor;
+      return ModifyRenderColor(this->GetAtomColor(et, ucr, atom, selector));
     }
 
     /**
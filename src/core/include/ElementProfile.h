@@ -0,0 +1,170 @@
+/*                                              -*- mode:C++ -*-
+  ElementProfile.h Sampled per-element-type event costs for a tile
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file ElementProfile.h Sampled per-element-type event costs for a tile
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef ELEMENTPROFILE_H
+#define ELEMENTPROFILE_H
+
+#include "itype.h"
+
+namespace MFM
+{
+  /**
+     A sampling profile of where a Tile's event time goes, by the
+     type of the atom at the event center.  When enabled, one event
+     attempt in every GetSampling() has each of its phases timed, and
+     if the event ran, the ticks (see TileCounters::ReadTicks) are
+     added to the slot of the center's element -- its index in the
+     Tile's ElementTable.  Attempts that failed to get their locks
+     are not samples; TileCounters::LOCK_FAILURES counts them.
+
+     Like TileCounters, a profile is written only by the thread
+     advancing its Tile, without locking, and may be copied from
+     other threads with SampleSlot.  Grid::WriteElementProfile merges
+     the tiles' profiles by element.
+   */
+  class ElementProfile
+  {
+  public:
+    enum Phase
+    {
+      LOCK,       //< Acquiring cache locks
+      LOAD,       //< LoadFromTile
+      BEHAVIOR,   //< The element's behavior
+      STORE,      //< StoreToTile and starting cache updates
+      PHASE_COUNT
+    };
+
+    enum
+    {
+      SLOTS = 256,                //< At least the ElementTable size
+      MAX_SAMPLING = 1 << 20
+    };
+
+    struct Slot
+    {
+      u64 m_samples;
+      u64 m_ticks[PHASE_COUNT];
+
+      void Clear()
+      {
+        m_samples = 0;
+        for (u32 i = 0; i < PHASE_COUNT; ++i)
+        {
+          m_ticks[i] = 0;
+        }
+      }
+
+      u64 GetTotalTicks() const
+      {
+        u64 total = 0;
+        for (u32 i = 0; i < PHASE_COUNT; ++i)
+        {
+          total += m_ticks[i];
+        }
+        return total;
+      }
+
+      void Add(const Slot & other)
+      {
+        m_samples += other.m_samples;
+        for (u32 i = 0; i < PHASE_COUNT; ++i)
+        {
+          m_ticks[i] += other.m_ticks[i];
+        }
+      }
+    };
+
+    ElementProfile()
+      : m_sampleMask(0)
+      , m_enabled(false)
+    {
+      Reset();
+    }
+
+    void Reset()
+    {
+      for (u32 i = 0; i < SLOTS; ++i)
+      {
+        m_slots[i].Clear();
+      }
+    }
+
+    /**
+       Sample one event in every \c oneIn, which must be a power of
+       two no larger than MAX_SAMPLING, or stop sampling if it is 0.
+       Samples already taken are kept.
+     */
+    void SetSampling(u32 oneIn) ;
+
+    /**
+       One in how many events is sampled, or 0 if none are
+     */
+    u32 GetSampling() const
+    {
+      return m_enabled ? (u32) m_sampleMask + 1 : 0;
+    }
+
+    /**
+       Return true if the event attempt numbered \c attempt should be
+       sampled.  One load and a test when disabled.
+     */
+    bool IsSampled(u64 attempt) const
+    {
+      return m_enabled && (attempt & m_sampleMask) == 0;
+    }
+
+    void AddSample(u32 slot, const u64 (& ticks)[PHASE_COUNT])
+    {
+      Slot & s = m_slots[slot];
+      ++s.m_samples;
+      for (u32 i = 0; i < PHASE_COUNT; ++i)
+      {
+        s.m_ticks[i] += ticks[i];
+      }
+    }
+
+    const Slot & GetSlot(u32 slot) const
+    {
+      return m_slots[slot];
+    }
+
+    /**
+       Copy slot \c slot into \c into, from a thread that need not be
+       the one writing it.  As with TileCounters::Sample, each count
+       is consistent but the slot as a whole may not be.
+     */
+    void SampleSlot(u32 slot, Slot & into) const ;
+
+    static const char * GetPhaseName(Phase phase) ;
+
+  private:
+    u64 m_sampleMask;
+    bool m_enabled;
+    Slot m_slots[SLOTS];
+  };
+
+} /* namespace MFM */
+
+#endif /* ELEMENTPROFILE_H */
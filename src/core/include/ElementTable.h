@@ -54,6 +54,27 @@ namespace MFM
     // -3 to avoid 2**k and 2**k-1 sizes; they seem to beat against type assignments
     static const u32 SIZE = (1u<<(B/2)) - 3; // ~250
 
+    /**
+     * What the event loop needs to know about a registered element,
+     * kept together so an event's lookup touches one cache line.
+     * Everything but m_element is captured when the element is
+     * registered.
+     */
+    struct ElementEntry {
+      void Clear() {
+        m_element = 0;
+        m_boundary = 0;
+        m_isInert = false;
+        m_elementDataStart = 0;
+        m_elementDataLength = 0;
+      }
+      const Element<EC>* m_element;
+      u8 m_boundary;           // GetEventWindowBoundary(), at most R + 1
+      bool m_isInert;          // IsInert()
+      u16 m_elementDataStart;
+      u16 m_elementDataLength;
+    };
+
     /**
      * Reinitialize this ElementTable to empty.
      */
@@ -116,7 +137,21 @@ namespace MFM
      *          type \c elementType resides, or -1 if \c elementType
      *          is not found in the table.
      */
-    s32 GetIndex(u32 elementType) const ;
+    s32 GetIndex(u32 elementType) const
+    {
+      const u32 index = IndexFor(elementType);
+      return index == NO_INDEX ? -1 : (s32) index;
+    }
+
+    /**
+     * Gets the ElementEntry at index \c index, as returned by
+     * GetIndex.  Entries past the registered elements are clear.
+     */
+    const ElementEntry & GetEntryAtIndex(u32 index) const
+    {
+      MFM_API_ASSERT_ARG(index <= SIZE);
+      return m_entries[index];
+    }
 
     /**
      * Constructs and calls \c Reinit() on a new new ElementTable.
@@ -139,7 +174,20 @@ namespace MFM
      *          this table. If an Element with this type is not found
      *          in this ElementTable, will return NULL .
      */
-    const Element<EC> * Lookup(u32 elementType) const;
+    const Element<EC> * Lookup(u32 elementType) const
+    {
+      return LookupEntry(elementType).m_element;
+    }
+
+    /**
+     * Gets the ElementEntry for a type, in two indexed loads and no
+     * search.  An unregistered type gets an entry whose m_element is
+     * NULL.
+     */
+    const ElementEntry & LookupEntry(u32 elementType) const
+    {
+      return m_entries[IndexFor(elementType)];
+    }
 
     /**
      * Gets a pointer to an immutable Element which is stored in this
@@ -230,30 +278,38 @@ namespace MFM
     u64 * GetDataIfRegistered(const u32 elementType, u32 slots) ;
 
   private:
+    enum {
+      LOW_BITS = B / 2,
+      HIGH_BITS = B - LOW_BITS,
+      LOW_MASK = (1u << LOW_BITS) - 1,
+      NO_INDEX = SIZE,          // m_entries[NO_INDEX] is always clear
+
+      /** Pages of the type index that may be in use at once, counting
+          the shared all-NO_INDEX page 0.  Each distinct high half of
+          a registered type needs one. */
+      INDEX_PAGES = 32
+    };
 
     /**
-     * Acting as a hashing function, finds a slot inside this
-     * ElementTable table for an Element with a given type.
-     *
-     * @param elementType The type of an Element to find a slot in
-     * this ElementTable for.
-     *
-     * @returns The index of the slot of the internal table which
-     *          belongs to an Element of \c elementType type.
+     * Finds the index in m_entries of a given element type, or
+     * NO_INDEX if it is not registered.  The high half of the type
+     * picks a page, and the low half picks the index within it.
+     * High halves with no registered types all share page 0.
      */
-    u32 SlotFor(u32 elementType) const ;
+    u32 IndexFor(u32 elementType) const
+    {
+      if (elementType >> B) return NO_INDEX;
+      return m_pages[m_pageOf[elementType >> LOW_BITS]][elementType & LOW_MASK];
+    }
 
-    struct ElementEntry {
-      void Clear() {
-        m_element = 0;
-        m_elementDataStart = 0;
-        m_elementDataLength = 0;
-      }
-      const Element<EC>* m_element;
-      u16 m_elementDataStart;
-      u16 m_elementDataLength;
-    } m_hash[SIZE];
-    u32 m_hashSlotsInUse;
+    void SetEntry(u32 index, const Element<EC> & theElement) ;
+
+    u8 m_pageOf[1u << HIGH_BITS];
+    u8 m_pages[INDEX_PAGES][1u << LOW_BITS];
+    u32 m_pagesInUse;
+
+    ElementEntry m_entries[SIZE + 1];  // Densely packed, in registration order
+    u32 m_entriesInUse;
 
   };
 
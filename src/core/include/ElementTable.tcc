@@ -3,51 +3,49 @@
 #include "Dirs.h"
 #include "MDist.h"
 #include "Element.h"
+#include "Util.h"      /* For COMPILATION_REQUIREMENT */
 
 namespace MFM {
 
   template <class EC>
-  s32 ElementTable<EC>::GetIndex(u32 elementType) const
+  void ElementTable<EC>::SetEntry(u32 index, const Element<EC> & theElement)
   {
-    u32 slot = SlotFor(elementType);
-    if (m_hash[slot].m_element == 0) return -1;
-    return (s32) slot;
-  }
-
-  template <class EC>
-  u32 ElementTable<EC>::SlotFor(u32 elementType) const
-  {
-    u32 collide = 0;
-    u32 slot = elementType;
-    while (true)
-    {
-      slot %= SIZE;
-      const Element<EC> * elt = m_hash[slot].m_element;
-      if (elt==0 || elt->GetType() == elementType)
-        return slot;   // Empty or match: This is the slot for you
-      ++collide;
-      slot = elementType+(collide*(1+collide))/2;
-    }
+    ElementEntry & entry = m_entries[index];
+    const u32 boundary = theElement.GetEventWindowBoundary();
+    entry.m_element = &theElement;
+    entry.m_boundary = (u8) (boundary > R + 1 ? R + 1 : boundary);
+    entry.m_isInert = theElement.IsInert();
   }
 
   template <class EC>
   void ElementTable<EC>::Insert(const Element<EC> & theElement)
   {
     u32 type = theElement.GetType();
-    u32 slotFor = SlotFor(type);
+    MFM_API_ASSERT_ARG((type >> B) == 0);
 
-    if (m_hash[slotFor].m_element != 0) {
+    u32 index = IndexFor(type);
+    if (index != NO_INDEX) {
 
-      if (m_hash[slotFor].m_element != &theElement)
+      if (m_entries[index].m_element != &theElement)
         FAIL(DUPLICATE_ENTRY);
-      else return;
 
-    } else {
-      if (++m_hashSlotsInUse > SIZE/2)
-        FAIL(OUT_OF_ROOM);
-      m_hash[slotFor].m_element = &theElement;
+      SetEntry(index, theElement);  // Re-registering refreshes the entry
+      return;
+    }
 
+    if (m_entriesInUse >= SIZE)
+      FAIL(OUT_OF_ROOM);
+
+    const u32 high = type >> LOW_BITS;
+    if (m_pageOf[high] == 0) {
+      if (m_pagesInUse >= INDEX_PAGES)
+        FAIL(OUT_OF_ROOM);
+      m_pageOf[high] = (u8) m_pagesInUse++;
     }
+
+    index = m_entriesInUse++;
+    m_pages[m_pageOf[high]][type & LOW_MASK] = (u8) index;
+    SetEntry(index, theElement);
   }
 
   template <class EC>
@@ -57,38 +55,31 @@ namespace MFM {
 
     MFM_API_ASSERT_ARG(newEmptyElement.GetType() == ATOM_EMPTY_TYPE); // New guy must think it's the empty element
 
-    u32 eslot = SlotFor(ATOM_EMPTY_TYPE);
-    const Element<EC> * old = m_hash[eslot].m_element;
+    u32 eindex = IndexFor(ATOM_EMPTY_TYPE);
+    MFM_API_ASSERT_STATE(eindex != NO_INDEX);
+    const Element<EC> * old = m_entries[eindex].m_element;
 
     MFM_API_ASSERT_STATE(old && old->GetType() == ATOM_EMPTY_TYPE);   // Must have old guy that also thinks it's the empty element
 
     //    MFM_ASSERT_API_STATE(old != &newEmptyElement);   // Must not be the same guy (can we require this?  loses idempotency)
 
-    m_hash[eslot].m_element = &newEmptyElement; // And so the deed is done; have mercy on our souls.
+    SetEntry(eindex, newEmptyElement); // And so the deed is done; have mercy on our souls.
 
     return old;
   }
 
-
-  template <class EC>
-  const Element<EC> * ElementTable<EC>::Lookup(u32 elementType) const
-  {
-    return m_hash[SlotFor(elementType)].m_element;
-  }
-
   template <class EC>
   const Element<EC> * ElementTable<EC>::Lookup(const u8 * symbol) const
   {
     MFM_API_ASSERT_NONNULL(symbol);
 
     const Element<EC> * found = 0;
-    for (u32 i = 0; i < SIZE; ++i) 
+    for (u32 i = 0; i < m_entriesInUse; ++i)
     {
-      if (m_hash[i].m_element == 0) continue;
-      if (!strcmp(m_hash[i].m_element->GetAtomicSymbol(),(const char *) symbol)) 
+      if (!strcmp(m_entries[i].m_element->GetAtomicSymbol(),(const char *) symbol))
       {
         if (found) return 0;  // multiple hits
-        found = m_hash[i].m_element;
+        found = m_entries[i].m_element;
       }
     }
 
@@ -122,15 +113,15 @@ namespace MFM {
     s32 index = GetIndex(elementType);
     if (index < 0) return false;
 
-    if (m_hash[index].m_elementDataLength != 0) {
-      if (m_hash[index].m_elementDataLength != slots)
+    if (m_entries[index].m_elementDataLength != 0) {
+      if (m_entries[index].m_elementDataLength != slots)
         return false;
     } else {
       if (m_nextFreeElementDataIndex+slots > ELEMENT_DATA_SLOTS)
         return false;
 
-      m_hash[index].m_elementDataLength = slots;
-      m_hash[index].m_elementDataStart = m_nextFreeElementDataIndex;
+      m_entries[index].m_elementDataLength = slots;
+      m_entries[index].m_elementDataStart = m_nextFreeElementDataIndex;
       m_nextFreeElementDataIndex += slots;
     }
 
@@ -150,9 +141,9 @@ namespace MFM {
     s32 index = GetIndex(elementType);
     if (index < 0) return 0;
 
-    if (m_hash[index].m_elementDataLength == 0) return 0;
-    if (m_hash[index].m_elementDataLength != slots) return 0;
-    return & m_elementData[m_hash[index].m_elementDataStart];
+    if (m_entries[index].m_elementDataLength == 0) return 0;
+    if (m_entries[index].m_elementDataLength != slots) return 0;
+    return & m_elementData[m_entries[index].m_elementDataStart];
   }
 
   template <class EC>
@@ -193,9 +184,19 @@ namespace MFM {
   template <class EC>
   void ElementTable<EC>::Reinit()
   {
-    m_hashSlotsInUse = 0;
-    for (u32 i = 0; i < SIZE; ++i)
-      m_hash[i].Clear();
+    COMPILATION_REQUIREMENT< (SIZE < 256) >();         // Indices fit in a u8
+    COMPILATION_REQUIREMENT< (INDEX_PAGES <= 256) >();  // Pages too
+
+    for (u32 i = 0; i < (1u << HIGH_BITS); ++i)
+      m_pageOf[i] = 0;
+    for (u32 p = 0; p < INDEX_PAGES; ++p)
+      for (u32 i = 0; i < (1u << LOW_BITS); ++i)
+        m_pages[p][i] = NO_INDEX;
+    m_pagesInUse = 1;  // Page 0 stays all NO_INDEX
+
+    for (u32 i = 0; i <= SIZE; ++i)
+      m_entries[i].Clear();
+    m_entriesInUse = 0;
     //XXX    m_nextFreeElementDataIndex = 0;
   }
 
@@ -54,6 +54,7 @@ namespace MFM
       Element<EC>::AllocateEmptyType(); // A special method just for Empty!
       Element<EC>::SetAtomicSymbol("E");
       Element<EC>::SetName("Empty");
+      Element<EC>::SetInert();
     }
 
     virtual u32 GetEventWindowBoundary() const
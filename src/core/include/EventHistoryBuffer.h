@@ -28,10 +28,13 @@
 #define EVENTHISTORYBUFFER_H
 
 #include "EventHistoryItem.h"
+#include "EventHistoryRing.h"
+#include "EventHistorySpill.h"
 #include "Base.h"
 #include "Sense.h"
 #include "MDist.h"
 #include "ByteSink.h"
+#include "Util.h"
 
 namespace MFM
 {
@@ -42,7 +45,27 @@ namespace MFM
   /**
      An EventHistoryBuffer records changes made by recent events in a
      tile, allowing the state of a tile to be rewound and replayed
-     within the bounds of the depth of the history buffer.  
+     within the bounds of the depth of the history buffer.
+
+     Each event is stored as one variable-length record in an
+     EventHistoryRing laid over the tile's EventHistoryItem storage.
+     A record's payload is the event center, as two zigzag-encoded
+     varints, followed by one delta per changed 32-bit word:
+
+       (site code << 2) | word     -- one byte
+       mask                        -- one byte: which bytes of the XOR are nonzero
+       the nonzero bytes of (old value XOR new value), low byte first
+
+     Because a delta holds the XOR of the old and new values, the
+     same delta both rewinds and replays its word.  A typical delta
+     takes four or five bytes rather than a twelve-byte item, and an
+     event's framing and center ten rather than two items; a Dreg/Res
+     tile's events average 20 bytes instead of 48.
+
+     Optionally (see SetSpillFile), records evicted from memory go to
+     an EventHistorySpill, which deflates them a segment at a time
+     into a ring kept in a file, and the cursor can move back through
+     them as well.
   */
   template <class EC>
   class EventHistoryBuffer
@@ -54,13 +77,21 @@ namespace MFM
     typedef typename AC::ATOM_TYPE T;
     enum { R = EC::EVENT_WINDOW_RADIUS };
   public:
-    enum { 
+    enum {
       SITE_COUNT = EVENT_WINDOW_SITES(R),
       BASE_ATOM,
       SITE_SENSORS,
       BASE_PAINT
     };
 
+    enum {
+      WORDS_PER_ATOM = 96/32,
+      MAX_CENTER_BYTES = 2 * 3,            //< Two zigzagged s16 varints
+      MAX_DELTA_BYTES = 2 + 4,
+      MAX_DELTAS = (SITE_COUNT + 1) * WORDS_PER_ATOM + 3 + 1,
+      MAX_EVENT_BYTES = MAX_CENTER_BYTES + MAX_DELTAS * MAX_DELTA_BYTES
+    };
+
     /**
        Printing routine for debug
      */
@@ -68,44 +99,55 @@ namespace MFM
 
     EventHistoryBuffer(Tile<EC> & forTile, u32 bufferSize, EventHistoryItem * buffer)
       : m_tile(forTile)
-      , m_bufferSize(bufferSize)
-      , m_historyBuffer(buffer)
-      , m_oldestEventStart(0)
-      , m_newestEventEnd(1)
-      , m_cursor(-1)
+      , m_memory()
+      , m_spill()
+      , m_cursorKind(CURSOR_NONE)
+      , m_cursorInSpill(false)
+      , m_cursor(0)
+      , m_cursorSite(0,0)
       , m_historyActive(true)
       , m_eventsAdded(0)
-      , m_itemsInEvent(0)
+      , m_deltasAdded(0)
       , m_makingEvent(false)
-      , m_makingEventStart(0)
+      , m_eventCenter(0,0)
+      , m_eventBytes(0)
+      , m_deltasInEvent(0)
     {
+      COMPILATION_REQUIREMENT<(BASE_PAINT < 64)>();  // Site codes get six bits
+      COMPILATION_REQUIREMENT<((u32) MAX_EVENT_BYTES <= (u32) EventHistoryRing::MAX_PAYLOAD_BYTES)>();
+      COMPILATION_REQUIREMENT<(sizeof(EventHistoryItem) == EventHistoryItem::BYTES)>();
       MFM_API_ASSERT_NONNULL(buffer);
-      MFM_API_ASSERT_ARG(m_bufferSize > 100); // ?? what is safe here, if we always want at least one event in the buffer??
-      for (u32 i = 0; i < m_bufferSize; ++i)
-        m_historyBuffer[i].MakeUnused();
+      m_memory.InitInMemory(buffer[0].m_bytes, bufferSize * sizeof(EventHistoryItem));
+
       // Load up a dummy event to establish the invariants
-      m_historyBuffer[m_oldestEventStart].MakeStart(SPoint(0,0), 0);
-      m_historyBuffer[m_oldestEventStart].mHeaderItem.m_count = 1;
-      m_historyBuffer[m_newestEventEnd].MakeEnd(m_historyBuffer[m_oldestEventStart], 1);
-      m_cursor = m_oldestEventStart;
+      BeginEvent(SPoint(0,0));
+      m_memory.Append(m_event, m_eventBytes, 0, 0);
+      SetCursor(false, m_memory.GetOldestStart(), CURSOR_AT_START);
     }
 
     bool IsCursorAtAnEventEnd() const
     {
-      return m_cursor >= 0 && m_historyBuffer[m_cursor].IsEnd();
+      return m_cursorKind == CURSOR_AT_END;
     }
 
     bool IsCursorAtAnEventStart() const
     {
-      return m_cursor >= 0 && m_historyBuffer[m_cursor].IsStart();
+      return m_cursorKind == CURSOR_AT_START;
+    }
+
+    /**
+       true if the cursor is on an event that has spilled to the
+       spill file
+     */
+    bool IsCursorInSpill() const
+    {
+      return m_cursorKind != CURSOR_NONE && m_cursorInSpill;
     }
 
     bool SiteOfCursor(SPoint & ret) const
     {
-      if (m_cursor < 0) return false;
-      EventHistoryItem & item = m_historyBuffer[m_cursor];
-      if (!item.IsHeader()) return false;
-      ret = item.GetHeaderSiteInTile();
+      if (m_cursorKind == CURSOR_NONE) return false;
+      ret = m_cursorSite;
       return true;
     }
 
@@ -120,8 +162,8 @@ namespace MFM
 
     bool MoveCursorToNewest()
     {
-      if (m_cursor < 0) return false;
-      while (m_cursor != m_newestEventEnd)
+      if (m_cursorKind == CURSOR_NONE) return false;
+      while (!IsCursorAt(false, m_memory.GetNewestEnd(), CURSOR_AT_END))
       {
         if (!MoveCursorNewer()) return false;
       }
@@ -130,67 +172,14 @@ namespace MFM
 
     bool MoveCursorToOldest()
     {
-      if (m_cursor < 0) return false;
-      while (m_cursor != m_oldestEventStart) 
-      {
-        if (!MoveCursorOlder()) return false;
-      }
+      if (m_cursorKind == CURSOR_NONE) return false;
+      while (MoveCursorOlder()) { }
       return true;
     }
 
-    bool MoveCursorOlder()
-    {
-      if (m_historyBuffer[m_cursor].IsEnd())
-      {
-        s32 start = StartOfEventEndedHere(m_cursor);
-        if (start < 0) return false;
-        SPoint ctr = m_historyBuffer[m_cursor].GetHeaderSiteInTile();
-        while ((m_cursor = Decrement(m_cursor)) != start)
-        {
-          EventHistoryItem & item = m_historyBuffer[m_cursor];
-          MFM_API_ASSERT_STATE(item.IsDelta());
-          ApplyDelta(false, item.mDeltaItem, m_tile, ctr);
-        }
-        return true;
-      }
-      else if (m_historyBuffer[m_cursor].IsStart())
-      {
-        if ((u32) m_cursor == m_oldestEventStart) 
-          return false;
-        s32 prevend = GetWrappedIndex(m_cursor - 1);
-        MFM_API_ASSERT_STATE(m_historyBuffer[prevend].IsEnd());
-        m_cursor = prevend;
-        return true;
-      }
-      return false;
-    }
+    bool MoveCursorOlder() ;
 
-    bool MoveCursorNewer()
-    {
-      if (m_historyBuffer[m_cursor].IsStart())
-      {
-        s32 end = EndOfEventStartedHere(m_cursor);
-        if (end < 0) return false;
-        SPoint ctr = m_historyBuffer[m_cursor].GetHeaderSiteInTile();
-        while ((m_cursor = Increment(m_cursor)) != end)
-        {
-          EventHistoryItem & item = m_historyBuffer[m_cursor];
-          MFM_API_ASSERT_STATE(item.IsDelta());
-          ApplyDelta(true, item.mDeltaItem, m_tile, ctr);
-        }
-        return true;
-      }
-      else if (m_historyBuffer[m_cursor].IsEnd())
-      {
-        if ((u32) m_cursor == m_newestEventEnd) 
-          return false;
-        s32 nextstart = Increment(m_cursor);
-        MFM_API_ASSERT_STATE(m_historyBuffer[nextstart].IsStart());
-        m_cursor = nextstart;
-        return true;
-      }
-      return false;
-    }
+    bool MoveCursorNewer() ;
 
     bool IsHistoryActive() const { return m_historyActive; }
 
@@ -219,166 +208,192 @@ namespace MFM
 
     u32 CountEventsInHistory() const ;
 
-  private:
-
-    void ApplyDelta(bool toNewer, EventHistoryItem::DeltaItem & di, Tile<EC>& tile, const SPoint ctr) ;
+    /**
+       Events held by the spill, if any; included in
+       CountEventsInHistory
+     */
+    u32 CountEventsInSpill() const { return m_historyActive ? m_spill.GetRecordCount() : 0; }
 
-    // Updates m_itemsInEvent
-    void RecordAtomChanges(u32 siteInWindow, const T& oldAtom, const T& newAtom) ;
+    /**
+       Bytes of event records held in memory
+     */
+    u32 GetBytesInHistory() const { return m_memory.GetUsedBytes(); }
 
-    // Updates m_itemsInEvent
-    void RecordBaseChanges(const Base<AC>& oldBase, const Base<AC>& newBase) ;
+    /**
+       Bytes of event records held by the spill, if any: compressed in
+       its file, plus its open segment
+     */
+    u32 GetBytesInSpill() const { return m_spill.GetUsedBytes(); }
 
-    // Updates m_itemsInEvent
-    void RecordSensorChanges(const SiteSensors& oldSense, const SiteSensors& newBase) ;
+    /**
+       Keep up to \c capacity bytes of events evicted from memory,
+       compressed, in a ring in a file created at \c path (see
+       EventHistorySpill::Open), so the cursor can rewind
+       past the oldest event in memory.  Returns false, leaving
+       spilling off, if the file cannot be created.
+     */
+    bool SetSpillFile(const char * path, u32 capacity) ;
 
-    EventHistoryItem & AllocateNextItem() 
-    {
-      m_newestEventEnd = GetWrappedIndex(m_newestEventEnd + 1);
-      EventHistoryItem & item = m_historyBuffer[m_newestEventEnd];
+    /**
+       Stop spilling, discarding any events spilled so far
+     */
+    void CloseSpillFile() ;
 
-      if (m_newestEventEnd == m_oldestEventStart)
-      {
-        MFM_API_ASSERT_STATE(item.IsStart());
-        m_oldestEventStart = GetWrappedIndex(m_oldestEventStart + item.GetHeaderItems() + 1);
-        MFM_API_ASSERT_STATE(m_historyBuffer[m_newestEventEnd].IsStart());
-      }
-      return item;
-    }
+    bool IsSpilling() const { return m_spill.IsOpen(); }
 
-    void DeallocateCurrentStart() 
-    {
-      EventHistoryItem & item = m_historyBuffer[m_newestEventEnd];
-      MFM_API_ASSERT_STATE(item.IsStart());
-      item.MakeUnused();
-      m_newestEventEnd = GetWrappedIndex(m_newestEventEnd - 1);
-    }
+    /**
+       Events, and changed words in them, recorded since construction
+       (wrapping), for sizing reports
+     */
+    u32 GetEventsAdded() const { return m_eventsAdded; }
 
-    bool StepBackward() ;
-    bool StepForward() ;
+    u32 GetDeltasAdded() const { return m_deltasAdded; }
 
-    Tile<EC> & m_tile;
-    u32 m_bufferSize;
-    EventHistoryItem * m_historyBuffer;
-    u32 m_oldestEventStart;
-    u32 m_newestEventEnd;
+  private:
 
-    /*
-      History cursor management:
+    enum CursorKind
+    {
+      CURSOR_NONE,      //< Invalid; must be reset by other means
+      CURSOR_AT_START,  //< Event under the cursor is NOT reflected in the tile
+      CURSOR_AT_END     //< Event under the cursor IS reflected in the tile
+    };
 
-      if m_cursor < 0, it is invalid and must be reset according to
-      mechanisms not defined here.
+    // The spill's ring is whichever segment it is viewing
+    const EventHistoryRing & GetRing(bool inSpill) const { return inSpill ? m_spill.GetView() : m_memory; }
 
-      Otherwise m_cursor indexes a valid EHI, which must be of type
-      END or START.
+    bool IsCursorAt(bool inSpill, u32 offset, CursorKind kind) const
+    {
+      return m_cursorKind == kind && m_cursorInSpill == inSpill && m_cursor == offset;
+    }
 
-      If it is an END item, the event it is the end of IS currently
-      reflected in the tile state.  GetEventSite
+    /**
+       Put the cursor at \c offset in the memory or spill ring, and
+       pick up the site of the event there.
+     */
+    void SetCursor(bool inSpill, u32 offset, CursorKind kind) ;
 
-      If it is a START item, the event it is the start of is NOT
-      currently reflected in the tile state.
+    /**
+       XOR the deltas of the event starting at \c start in the
+       memory or spill ring into the tile.  Rewinds the event if it
+       is reflected in the tile, and replays it if not.
+     */
+    void ApplyEvent(bool inSpill, u32 start) ;
 
-      Stepping the cursor backwards succeeds if there is a valid START
-      item strictly prior to the current cursor position. (Whether the
-      current cursor position is a START or an END).  If so, then,
-      first, the site number of the event is accessed from that START
-      item.  Then cursor moves backwards to that START item, writing
-      to the tile the 'oldValue' field of all DELTA items found along
-      the way, using the site of the event to position the deltas.
-      The cursor ends up on that START item.
+    void ApplyDelta(u32 code, u32 word, u32 xorValue, const SPoint ctr) ;
 
-      Stepping the cursor forwards succeeds if there is a valid END
-      item strictly after the current cursor position.  (Whether the
-      current cursor position is a START or an END).  If so, the site
-      number is accessed from the START item under the cursor, and
-      then the cursor moves to that END item, writing to the tile the
-      'newValue' field of all DELTA items found along the way, using
-      the site of the event to position the deltas.  The cursor ends
-      up on that END item.
+    // Resets m_event to hold just the center of an event at ctr
+    void BeginEvent(const SPoint ctr) ;
 
-      If AddEventWindow is called while m_cursor != m_lastUsedItem,
-      then before the event is recorded, the following occurs:
+    // Stores m_event as a record, if it holds any changes
+    void FinishEvent() ;
 
-      - if m_cursor is at an END item, then m_lastUsedItem is set to
-      m_cursor, and m_cursor is set to -1,
+    // Appends a delta to m_event, if oldv and newv differ
+    void RecordDelta(u32 code, u32 word, u32 oldv, u32 newv) ;
 
-      - if m_cursor is at a START item, then m_lastUsedItem is set to
-      the index prior to m_cursor, and m_cursor is set to -1.
+    void RecordAtomChanges(u32 siteInWindow, const T& oldAtom, const T& newAtom) ;
 
-      This has the effect of truncating the event history at m_cursor,
-      when a new event window is added.  (Note m_cursor will be set >=
-      0 at the end of AddEventWindow, if a non-trivial event is
-      actually stored.)
+    void RecordBaseChanges(const Base<AC>& oldBase, const Base<AC>& newBase) ;
 
-    */
-    s32 m_cursor; // AddEventWindow sets this to index of just-added end item
-    bool m_historyActive;
-    u32 m_eventsAdded;  // Wrappable rolling count of events ever added to buffer
-    u32 m_itemsInEvent;
-    bool m_makingEvent;  // true between AddEventStart and AddEventEnd
-    u32 m_makingEventStart;  // index of start item of in-progress event
+    void RecordSensorChanges(const SiteSensors& oldSense, const SiteSensors& newBase) ;
 
-    u32 GetWrappedIndex(s32 index) const
+    static u32 PutVarint(u8 * dest, u32 value)
     {
-      while (index < 0) index += m_bufferSize;
-      while (((u32) index) >= m_bufferSize) index -= m_bufferSize;
-      return (u32) index;
+      u32 len = 0;
+      while (value >= 0x80)
+      {
+        dest[len++] = (u8) (value | 0x80);
+        value >>= 7;
+      }
+      dest[len++] = (u8) value;
+      return len;
     }
-    u32 Increment(u32 index) const
+
+    static u32 GetVarint(const u8 * src, u32 & pos)
     {
-      return GetWrappedIndex(index + 1);
+      u32 value = 0;
+      for (u32 shift = 0; ; shift += 7)
+      {
+        const u8 b = src[pos++];
+        value |= (u32) (b & 0x7f) << shift;
+        if (!(b & 0x80)) return value;
+      }
     }
-    u32 Decrement(u32 index) const
+
+    static u32 ZigZag(s32 value)
     {
-      return GetWrappedIndex(index - 1);
+      return (((u32) value) << 1) ^ (u32) (value >> 31);
     }
 
-    const EventHistoryItem & GetItemFromWrappedIndex(u32 index) const
+    static s32 UnZigZag(u32 value)
     {
-      return m_historyBuffer[GetWrappedIndex(index)];
+      return (s32) (value >> 1) ^ -(s32) (value & 1);
     }
 
-    EventHistoryItem & GetItemFromWrappedIndex(u32 index) 
+    static SPoint GetCenter(const u8 * payload, u32 & pos)
     {
-      return m_historyBuffer[GetWrappedIndex(index)];
+      const s32 x = UnZigZag(GetVarint(payload, pos));
+      const s32 y = UnZigZag(GetVarint(payload, pos));
+      return SPoint(x, y);
     }
 
-    /**
-       Returns the start item index (which is >= 0), if \c endIndex is
-       at an END item that has a corresponding START item, else -1.
-    */
-    s32 StartOfEventEndedHere(s32 endIndex) const
+    // Decodes the delta at pos, advancing pos past it
+    static u32 GetDelta(const u8 * payload, u32 & pos, u32 & code, u32 & word)
     {
-      const EventHistoryItem & ehiEnd = GetItemFromWrappedIndex(endIndex);
-      if (!ehiEnd.IsEnd()) return -1;
-
-      s32 startIndex = endIndex - (s32) ehiEnd.GetHeaderItems();
-      const EventHistoryItem & ehiStart = GetItemFromWrappedIndex(startIndex);
-    
-      if (!ehiStart.IsStart() || ehiEnd.GetHeaderEventNumber() != ehiStart.GetHeaderEventNumber())
-        return -1;
-    
-      return startIndex;
+      code = payload[pos] >> 2;
+      word = payload[pos] & 3;
+      const u32 mask = payload[pos + 1];
+      pos += 2;
+      u32 xorValue = 0;
+      for (u32 i = 0; i < 4; ++i)
+      {
+        if (mask & (1 << i))
+        {
+          xorValue |= ((u32) payload[pos++]) << (8 * i);
+        }
+      }
+      return xorValue;
     }
 
-    /**
-       Returns the end item index (which is >= 0), if \c startIndex is
-       at a START item that has a corresponding END item, else -1.
+    Tile<EC> & m_tile;
+    EventHistoryRing m_memory;
+    EventHistorySpill m_spill;
+
+    /*
+      History cursor management:
+
+      If m_cursorKind is CURSOR_NONE, the cursor is invalid and must
+      be reset according to mechanisms not defined here.
+
+      Otherwise m_cursor is the offset, in the spill ring if
+      m_cursorInSpill and in the memory ring if not, of the START or
+      END frame of an event record.
+
+      If it is at an END, the event it is the end of IS currently
+      reflected in the tile state.  If it is at a START, the event it
+      is the start of is NOT currently reflected in the tile state.
+
+      Stepping the cursor backwards from an END rewinds that event
+      and leaves the cursor at its START; from a START, it moves to
+      the END of the previous event -- crossing from the oldest event
+      in memory to the newest in the spill ring, if any -- without
+      changing the tile.  Stepping forwards is the mirror image.
+
+      Recording an event leaves the cursor at its END.
     */
-    s32 EndOfEventStartedHere(s32 startIndex) const
-    {
-      const EventHistoryItem & ehiStart = GetItemFromWrappedIndex(startIndex);
-      if (!ehiStart.IsStart()) return -1;
-
-      s32 endIndex = startIndex + ehiStart.GetHeaderItems();
-      const EventHistoryItem & ehiEnd = GetItemFromWrappedIndex(endIndex);
-    
-      if (!ehiEnd.IsEnd() || ehiEnd.GetHeaderEventNumber() != ehiStart.GetHeaderEventNumber())
-        return -1;
-    
-      return endIndex;
-    }
+    CursorKind m_cursorKind;
+    bool m_cursorInSpill;
+    u32 m_cursor;
+    SPoint m_cursorSite;
+
+    bool m_historyActive;
+    u32 m_eventsAdded;  // Wrappable rolling count of events ever added to buffer
+    u32 m_deltasAdded;  // Likewise of deltas in those events
+    bool m_makingEvent;  // true between AddEventStart and AddEventEnd
 
+    SPoint m_eventCenter;  // of the event in m_event
+    u8 m_event[MAX_EVENT_BYTES];  // Payload of the event being recorded or applied
+    u32 m_eventBytes;
+    u32 m_deltasInEvent;
   };
 
 } /* namespace MFM */
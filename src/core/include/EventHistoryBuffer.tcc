@@ -6,72 +6,232 @@
 
 namespace MFM {
 
-  
   template <class EC>
-  bool EventHistoryBuffer<EC>::StepBackward() 
+  u32 EventHistoryBuffer<EC>::CountEventsInHistory() const
   {
-    if (m_cursor < 0) return false;  // not set up
-    FAIL(INCOMPLETE_CODE);
+    if (!m_historyActive) return 0;
+    return m_memory.GetRecordCount() + m_spill.GetRecordCount();
   }
 
   template <class EC>
-  u32 EventHistoryBuffer<EC>::CountEventsInHistory() const
+  bool EventHistoryBuffer<EC>::SetSpillFile(const char * path, u32 capacity)
   {
-    if (!m_historyActive) return 0;
-    u32 events = 0;
-    for (u32 i = m_oldestEventStart; i != m_newestEventEnd; )
+    if (!m_spill.Open(path, capacity))
+    {
+      return false;
+    }
+    if (m_cursorInSpill)
+    {
+      m_cursorKind = CURSOR_NONE;
+    }
+    return true;
+  }
+
+  template <class EC>
+  void EventHistoryBuffer<EC>::CloseSpillFile()
+  {
+    m_spill.Close();
+    if (m_cursorInSpill)
+    {
+      m_cursorKind = CURSOR_NONE;
+    }
+  }
+
+  template <class EC>
+  void EventHistoryBuffer<EC>::SetCursor(bool inSpill, u32 offset, CursorKind kind)
+  {
+    const EventHistoryRing & ring = GetRing(inSpill);
+    const u32 start = kind == CURSOR_AT_START ? offset : ring.StartOf(offset);
+    u8 center[MAX_CENTER_BYTES];
+    ring.PeekPayload(start, center, MAX_CENTER_BYTES);
+    u32 pos = 0;
+    m_cursorSite = GetCenter(center, pos);
+    m_cursorInSpill = inSpill;
+    m_cursor = offset;
+    m_cursorKind = kind;
+  }
+
+  template <class EC>
+  bool EventHistoryBuffer<EC>::MoveCursorOlder()
+  {
+    MFM_API_ASSERT_STATE(!m_makingEvent);
+    const EventHistoryRing & ring = GetRing(m_cursorInSpill);
+    if (m_cursorKind == CURSOR_AT_END)
     {
-      EventHistoryItem & item = m_historyBuffer[i];
-      if (item.IsStart())
+      const u32 start = ring.StartOf(m_cursor);
+      ApplyEvent(m_cursorInSpill, start);
+      m_cursor = start;
+      m_cursorKind = CURSOR_AT_START;
+      return true;
+    }
+    else if (m_cursorKind == CURSOR_AT_START)
+    {
+      if (m_cursor != ring.GetOldestStart())
       {
-        ++events;
-        s32 next = EndOfEventStartedHere(i);
-        MFM_API_ASSERT_STATE(next >= 0);
-        i = (u32) next;
+        SetCursor(m_cursorInSpill, ring.EndBefore(m_cursor), CURSOR_AT_END);
+        return true;
       }
-      else if (item.IsEnd())
+      if (m_cursorInSpill ? m_spill.ViewOlder() : m_spill.ViewNewest())
       {
-        i = GetWrappedIndex(i + 1);
+        SetCursor(true, m_spill.GetView().GetNewestEnd(), CURSOR_AT_END);
+        return true;
       }
     }
-    return events;
+    return false;
   }
 
   template <class EC>
-  void EventHistoryBuffer<EC>::ApplyDelta(bool toNewer, EventHistoryItem::DeltaItem & di, Tile<EC>& tile, const SPoint ctr)
+  bool EventHistoryBuffer<EC>::MoveCursorNewer()
+  {
+    MFM_API_ASSERT_STATE(!m_makingEvent);
+    const EventHistoryRing & ring = GetRing(m_cursorInSpill);
+    if (m_cursorKind == CURSOR_AT_START)
+    {
+      ApplyEvent(m_cursorInSpill, m_cursor);
+      m_cursor = ring.EndOf(m_cursor);
+      m_cursorKind = CURSOR_AT_END;
+      return true;
+    }
+    else if (m_cursorKind == CURSOR_AT_END)
+    {
+      if (m_cursor != ring.GetNewestEnd())
+      {
+        SetCursor(m_cursorInSpill, ring.StartAfter(m_cursor), CURSOR_AT_START);
+        return true;
+      }
+      if (m_cursorInSpill)
+      {
+        if (m_spill.ViewNewer())
+        {
+          SetCursor(true, m_spill.GetView().GetOldestStart(), CURSOR_AT_START);
+        }
+        else
+        {
+          SetCursor(false, m_memory.GetOldestStart(), CURSOR_AT_START);
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  template <class EC>
+  void EventHistoryBuffer<EC>::ApplyEvent(bool inSpill, u32 start)
+  {
+    const u32 len = GetRing(inSpill).ReadPayload(start, m_event, MAX_EVENT_BYTES);
+    u32 pos = 0;
+    const SPoint ctr = GetCenter(m_event, pos);
+    while (pos < len)
+    {
+      u32 code, word;
+      const u32 xorValue = GetDelta(m_event, pos, code, word);
+      ApplyDelta(code, word, xorValue, ctr);
+    }
+    MFM_API_ASSERT_STATE(pos == len);
+    m_tile.NeedAtomRecount();
+  }
+
+  template <class EC>
+  void EventHistoryBuffer<EC>::ApplyDelta(u32 code, u32 word, u32 xorValue, const SPoint ctr)
   {
     const MDist<R> & md = MDist<R>::get();
-    u32 site = di.m_site;
-    if (site < md.GetSiteCount())
+    if (code < md.GetSiteCount())
     {
-      const SPoint pt = md.GetPoint(site) + ctr;
-      T& atom = *tile.GetWritableAtom(pt);
-      u32 idx = di.m_word;
-      u32 val = toNewer ? di.m_newValue : di.m_oldValue;
-      atom.GetBits().Write(idx*32, 32, val);
+      const SPoint pt = md.GetPoint(code) + ctr;
+      BitVector<AC::BITS_PER_ATOM> & bits = m_tile.GetWritableAtom(pt)->GetBits();
+      bits.Write(word * 32, 32, bits.Read(word * 32, 32) ^ xorValue);
+      return;
     }
-    else
+
+    Base<AC> & base = m_tile.GetSite(ctr).GetBase();
+    switch (code)
     {
-      // base info
-      FAIL(INCOMPLETE_CODE);
+    case BASE_ATOM:
+    {
+      BitVector<AC::BITS_PER_ATOM> & bits = base.GetBaseAtom().GetBits();
+      bits.Write(word * 32, 32, bits.Read(word * 32, 32) ^ xorValue);
+      break;
+    }
+    case SITE_SENSORS:
+    {
+      SiteTouchSensor & touch = base.GetSensory().m_touchSensor;
+      if (word == 0)
+      {
+        touch.m_touchType = (SiteTouchType) (touch.m_touchType ^ xorValue);
+      }
+      else
+      {
+        touch.m_lastTouchEventCount ^= ((u64) xorValue) << (32 * (word - 1));
+      }
+      break;
+    }
+    case BASE_PAINT:
+      base.SetPaint(base.GetPaint() ^ xorValue);
+      break;
+    default:
+      FAIL(ILLEGAL_STATE);
     }
-    tile.NeedAtomRecount();
   }
 
   template <class EC>
-  void EventHistoryBuffer<EC>::AddEventStart(const SPoint ctr) 
+  void EventHistoryBuffer<EC>::BeginEvent(const SPoint ctr)
+  {
+    m_eventCenter = ctr;
+    m_eventBytes = PutVarint(m_event, ZigZag(ctr.GetX()));
+    m_eventBytes += PutVarint(m_event + m_eventBytes, ZigZag(ctr.GetY()));
+    m_deltasInEvent = 0;
+  }
+
+  template <class EC>
+  void EventHistoryBuffer<EC>::FinishEvent()
+  {
+    if (m_deltasInEvent == 0) return;  // Fugedabowdit
+    const u32 end = m_memory.Append(m_event, m_eventBytes, (u8) ++m_eventsAdded, &m_spill);
+    m_deltasAdded += m_deltasInEvent;
+    m_cursorSite = m_eventCenter;
+    m_cursorInSpill = false;
+    m_cursor = end;
+    m_cursorKind = CURSOR_AT_END;
+  }
+
+  template <class EC>
+  void EventHistoryBuffer<EC>::RecordDelta(u32 code, u32 word, u32 oldv, u32 newv)
+  {
+    const u32 xorValue = oldv ^ newv;
+    if (xorValue == 0) return;
+    if (m_eventBytes + MAX_DELTA_BYTES > MAX_EVENT_BYTES)
+    {
+      FAIL(OUT_OF_ROOM);
+    }
+    u8 * delta = m_event + m_eventBytes;
+    u32 len = 2;
+    u32 mask = 0;
+    for (u32 i = 0; i < 4; ++i)
+    {
+      const u8 b = (u8) (xorValue >> (8 * i));
+      if (b)
+      {
+        mask |= 1 << i;
+        delta[len++] = b;
+      }
+    }
+    delta[0] = (u8) ((code << 2) | word);
+    delta[1] = (u8) mask;
+    m_eventBytes += len;
+    ++m_deltasInEvent;
+  }
+
+  template <class EC>
+  void EventHistoryBuffer<EC>::AddEventStart(const SPoint ctr)
   {
     if (!m_historyActive) return;
     MFM_API_ASSERT_STATE(!m_makingEvent);
-    EventHistoryItem & s = AllocateNextItem();
-    m_makingEventStart = m_newestEventEnd; // well that's confusing
-    s.MakeStart(ctr, ++m_eventsAdded);
+    BeginEvent(ctr);
     m_makingEvent = true;
-    m_itemsInEvent = 0;
   }
 
   template <class EC>
-  void EventHistoryBuffer<EC>::AddEventAtom(u32 siteInWindow, const T & oldAtom, const T & newAtom) 
+  void EventHistoryBuffer<EC>::AddEventAtom(u32 siteInWindow, const T & oldAtom, const T & newAtom)
   {
     if (!m_historyActive) return;
     MFM_API_ASSERT_STATE(m_makingEvent);
@@ -83,34 +243,18 @@ namespace MFM {
   {
     if (!m_historyActive) return;
     MFM_API_ASSERT_STATE(m_makingEvent);
-
-    if (m_itemsInEvent == 0) 
-    {
-      DeallocateCurrentStart(); 
-    } 
-    else
-    {
-      EventHistoryItem & s = m_historyBuffer[m_makingEventStart];
-      EventHistoryItem & e = AllocateNextItem();
-      ++m_itemsInEvent;
-      e.MakeEnd(s, m_itemsInEvent);
-      m_cursor = (s32) m_newestEventEnd;
-      s.mHeaderItem.m_count = m_itemsInEvent;  // Point start header back to us
-    }
+    FinishEvent();
     m_makingEvent = false;
   }
 
   template <class EC>
-  void EventHistoryBuffer<EC>::AddEventWindow(const EventWindow<EC> & ew) 
+  void EventHistoryBuffer<EC>::AddEventWindow(const EventWindow<EC> & ew)
   {
     if (!m_historyActive) return;
     const Tile<EC> & t = ew.GetTile();
 
     SPoint ctr = ew.GetCenterInTile();
-
-    EventHistoryItem & s = AllocateNextItem();
-    s.MakeStart(ctr, ++m_eventsAdded);
-    m_itemsInEvent = 0;
+    BeginEvent(ctr);
 
     const MDist<R> & md = MDist<R>::get();
 
@@ -121,97 +265,67 @@ namespace MFM {
     }
 
     RecordBaseChanges(t.GetSite(ctr).GetBase(), ew.GetBase());
-     if (m_itemsInEvent == 0) 
-     {
-       DeallocateCurrentStart(); // Fugedabowdit
-     } else
-     {
-       EventHistoryItem & e = AllocateNextItem();
-       ++m_itemsInEvent;
-       e.MakeEnd(s, m_itemsInEvent);
-       m_cursor = (s32) m_newestEventEnd;
-       s.mHeaderItem.m_count = m_itemsInEvent;  // Point start header back to us
-     }
-   }
-
-   template <class EC>
-   void EventHistoryBuffer<EC>::RecordAtomChanges(u32 siteInWindow, const T& oldAtom, const T& newAtom) 
-   {
-
-     for (u32 i = 0; i < 96/32; ++i) 
-     {
-       u32 oldw = oldAtom.GetBits().Read(i*32,32);
-       u32 neww = newAtom.GetBits().Read(i*32,32);
-       if (oldw != neww)
-       {
-         EventHistoryItem & item = AllocateNextItem();
-         ++m_itemsInEvent;
-         item.MakeDelta(siteInWindow, m_itemsInEvent, i, oldw, neww);
-       }
-     }
-   }
-
-   template <class EC>
-   void EventHistoryBuffer<EC>::RecordBaseChanges(const Base<AC>& oldBase, const Base<AC>& newBase) 
-   {
-     RecordAtomChanges(BASE_ATOM, oldBase.GetBaseAtom(), newBase.GetBaseAtom());
-     RecordSensorChanges(oldBase.GetSensory(), newBase.GetSensory());
-     if (oldBase.GetPaint() != newBase.GetPaint())
-     {
-       EventHistoryItem & item = AllocateNextItem();
-       ++m_itemsInEvent;
-       item.MakeDelta(BASE_PAINT, m_itemsInEvent, 0, oldBase.GetPaint(), newBase.GetPaint());
-     }
-   }
-
-   template <class EC>
-   void EventHistoryBuffer<EC>::RecordSensorChanges(const SiteSensors& oldSense, const SiteSensors& newSense) 
-   {
-     if (oldSense.m_touchSensor.m_touchType != newSense.m_touchSensor.m_touchType) 
-     {
-       EventHistoryItem & item = AllocateNextItem();
-       ++m_itemsInEvent;
-       item.MakeDelta(SITE_SENSORS, m_itemsInEvent, 0, oldSense.m_touchSensor.m_touchType, newSense.m_touchSensor.m_touchType);
-     }
-     u64 oldec = oldSense.m_touchSensor.m_lastTouchEventCount;
-     u64 newec = newSense.m_touchSensor.m_lastTouchEventCount;
-     for (u32 i = 0; i < 2; ++i) 
-     {
-       u32 o32 = (u32) (oldec>>(i*32));
-       u32 n32 = (u32) (newec>>(i*32));
-       if (o32 != n32) 
-       {
-         EventHistoryItem & item = AllocateNextItem();
-         ++m_itemsInEvent;
-         item.MakeDelta(SITE_SENSORS, m_itemsInEvent, i+1, o32, n32);
-       }
-     }
-   }
-
-   template <class EC>
-   void EventHistoryBuffer<EC>::Print(ByteSink& bs)  const
-   {
-     bs.Printf("[EventHistoryBuffer(%p)", (void*) this);
-     bs.Printf(",active=%d", m_historyActive);
-     if (m_historyActive)
-     {
-       for (u32 i = m_oldestEventStart; i != m_newestEventEnd; )
-       {
-         EventHistoryItem & item = m_historyBuffer[i];
-         bs.Printf("\n %d: ", i);
-         item.Print(bs);
-         if (item.IsStart())
-         {
-           s32 next = EndOfEventStartedHere(i);
-           if (next >= 0)
-           {
-             i = (u32) next;
-           }
-         }
-         i = GetWrappedIndex(i + 1);
-       }
-     }
-     bs.Printf("]\n");
-   }
+    FinishEvent();
+  }
+
+  template <class EC>
+  void EventHistoryBuffer<EC>::RecordAtomChanges(u32 siteInWindow, const T& oldAtom, const T& newAtom)
+  {
+    for (u32 i = 0; i < WORDS_PER_ATOM; ++i)
+    {
+      RecordDelta(siteInWindow, i, oldAtom.GetBits().Read(i*32,32), newAtom.GetBits().Read(i*32,32));
+    }
+  }
+
+  template <class EC>
+  void EventHistoryBuffer<EC>::RecordBaseChanges(const Base<AC>& oldBase, const Base<AC>& newBase)
+  {
+    RecordAtomChanges(BASE_ATOM, oldBase.GetBaseAtom(), newBase.GetBaseAtom());
+    RecordSensorChanges(oldBase.GetSensory(), newBase.GetSensory());
+    RecordDelta(BASE_PAINT, 0, oldBase.GetPaint(), newBase.GetPaint());
+  }
+
+  template <class EC>
+  void EventHistoryBuffer<EC>::RecordSensorChanges(const SiteSensors& oldSense, const SiteSensors& newSense)
+  {
+    RecordDelta(SITE_SENSORS, 0, oldSense.m_touchSensor.m_touchType, newSense.m_touchSensor.m_touchType);
+    u64 oldec = oldSense.m_touchSensor.m_lastTouchEventCount;
+    u64 newec = newSense.m_touchSensor.m_lastTouchEventCount;
+    for (u32 i = 0; i < 2; ++i)
+    {
+      RecordDelta(SITE_SENSORS, i+1, (u32) (oldec>>(i*32)), (u32) (newec>>(i*32)));
+    }
+  }
+
+  template <class EC>
+  void EventHistoryBuffer<EC>::Print(ByteSink& bs)  const
+  {
+    bs.Printf("[EventHistoryBuffer(%p)", (void*) this);
+    bs.Printf(",active=%d", m_historyActive);
+    if (m_historyActive)
+    {
+      bs.Printf(",events=%d,bytes=%d,spilled=%d/%d",
+                m_memory.GetRecordCount(), m_memory.GetUsedBytes(),
+                m_spill.GetRecordCount(), m_spill.GetUsedBytes());
+      u8 payload[MAX_EVENT_BYTES];
+      for (u32 start = m_memory.GetOldestStart(); ; )
+      {
+        const u32 len = m_memory.ReadPayload(start, payload, MAX_EVENT_BYTES);
+        u32 pos = 0;
+        const SPoint ctr = GetCenter(payload, pos);
+        bs.Printf("\n %d: (%d,%d)", start, ctr.GetX(), ctr.GetY());
+        while (pos < len)
+        {
+          u32 code, word;
+          const u32 xorValue = GetDelta(payload, pos, code, word);
+          bs.Printf(" %d.%d^%08x", code, word, xorValue);
+        }
+        const u32 end = m_memory.EndOf(start);
+        if (end == m_memory.GetNewestEnd()) break;
+        start = m_memory.StartAfter(end);
+      }
+    }
+    bs.Printf("]\n");
+  }
 
 } /* namespace MFM */
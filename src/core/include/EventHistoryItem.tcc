@@ -1,5 +0,0 @@
-/* -*- C++ -*- */
-
-namespace MFM {
-
-} /* namespace MFM */
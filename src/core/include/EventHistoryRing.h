@@ -0,0 +1,251 @@
+/*                                              -*- mode:C++ -*-
+  EventHistoryRing.h Ring of variable-length event history records
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file EventHistoryRing.h Ring of variable-length event history records
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef EVENTHISTORYRING_H
+#define EVENTHISTORYRING_H
+
+#include <stdio.h>
+#include "itype.h"
+#include "Fail.h"
+
+namespace MFM
+{
+  /**
+     An EventHistoryRing is a byte ring holding whole event records,
+     oldest first, either in caller-supplied memory or in a file.
+     The ring knows only how records are framed; their payloads are
+     EventHistoryBuffer's business.  Each record is
+
+       START tag, span (2 bytes, little-endian), check byte
+       payload
+       END tag, span, check byte
+
+     where span is the distance in bytes from the START tag to the END
+     tag, so a record can be walked from either end, and the check
+     byte (the low byte of the event number) must agree at both ends.
+     Records are referred to by the ring offset of their START tag
+     ('start') or of their END tag ('end').  Appending a record evicts
+     as many of the oldest records as needed to make room, optionally
+     handing them to an EventHistorySpill -- which is how older
+     history spills from memory to disk.
+   */
+  class EventHistorySpill; // FORWARD
+
+  class EventHistoryRing
+  {
+  public:
+    enum
+    {
+      TAG_START = 0xe5,
+      TAG_END = 0xed,
+      FRAME_BYTES = 4,            //< Bytes in a START or END frame
+      MAX_PAYLOAD_BYTES = 4096,   //< Default largest payload a record may carry
+      MAX_SPAN = 0xffff           //< Largest span the frames can express
+    };
+
+    EventHistoryRing()
+      : m_bytes(0)
+      , m_file(0)
+      , m_capacity(0)
+      , m_maxPayload(0)
+    {
+      Clear();
+    }
+
+    ~EventHistoryRing()
+    {
+      Close();
+    }
+
+    /**
+       Use \c capacity bytes at \c bytes as the ring, discarding any
+       records held.  Payloads may be up to \c maxPayload bytes, and
+       \c capacity must hold at least two of the largest records.
+     */
+    void InitInMemory(u8 * bytes, u32 capacity, u32 maxPayload = MAX_PAYLOAD_BYTES) ;
+
+    /**
+       Use up to \c capacity bytes of a file created (or truncated) at
+       \c path as the ring, discarding any records held.  Returns
+       false, leaving the ring closed, if the file cannot be opened.
+     */
+    bool OpenFile(const char * path, u32 capacity, u32 maxPayload = MAX_PAYLOAD_BYTES) ;
+
+    /**
+       Take the first \c used bytes of this in-memory ring as \c
+       records whole records laid end to end from offset zero, as
+       Clear followed by Appends that evict nothing leaves them.
+     */
+    void AdoptRecords(u32 used, u32 records) ;
+
+    /**
+       Release the ring's storage, discarding any records held.
+     */
+    void Close() ;
+
+    bool IsOpen() const { return m_capacity > 0; }
+
+    bool IsInFile() const { return m_file != 0; }
+
+    void Clear()
+    {
+      m_oldest = 0;
+      m_free = 0;
+      m_used = 0;
+      m_records = 0;
+    }
+
+    bool IsEmpty() const { return m_records == 0; }
+
+    u32 GetRecordCount() const { return m_records; }
+
+    u32 GetUsedBytes() const { return m_used; }
+
+    u32 GetCapacity() const { return m_capacity; }
+
+    u32 GetMaxPayload() const { return m_maxPayload; }
+
+    /**
+       True if a record carrying \c len payload bytes fits without
+       evicting anything
+     */
+    bool HasRoomFor(u32 len) const
+    {
+      return m_capacity - m_used >= len + 2 * FRAME_BYTES;
+    }
+
+    /**
+       The start of the oldest record held.  Fails if empty.
+     */
+    u32 GetOldestStart() const
+    {
+      MFM_API_ASSERT_STATE(!IsEmpty());
+      return m_oldest;
+    }
+
+    /**
+       The end of the newest record held.  Fails if empty.
+     */
+    u32 GetNewestEnd() const
+    {
+      MFM_API_ASSERT_STATE(!IsEmpty());
+      return Wrap(m_free + m_capacity - FRAME_BYTES);
+    }
+
+    /**
+       The end of the record before the one starting at \c start,
+       which must not be the oldest record.
+     */
+    u32 EndBefore(u32 start) const
+    {
+      MFM_API_ASSERT_ARG(start != m_oldest);
+      return Wrap(start + m_capacity - FRAME_BYTES);
+    }
+
+    /**
+       The start of the record after the one ending at \c end, which
+       must not be the newest record.
+     */
+    u32 StartAfter(u32 end) const
+    {
+      MFM_API_ASSERT_ARG(end != GetNewestEnd());
+      return Wrap(end + FRAME_BYTES);
+    }
+
+    /**
+       The end of the record starting at \c start.  Fails if the
+       framing there is inconsistent.
+     */
+    u32 EndOf(u32 start) const ;
+
+    /**
+       The start of the record ending at \c end.  Fails if the framing
+       there is inconsistent.
+     */
+    u32 StartOf(u32 end) const ;
+
+    /**
+       Copy the payload of the record starting at \c start into \c
+       dest, which has room for \c maxLen bytes, and return its
+       length.
+     */
+    u32 ReadPayload(u32 start, u8 * dest, u32 maxLen) const ;
+
+    /**
+       Copy up to \c len leading payload bytes of the record starting
+       at \c start into \c dest, and return how many were copied.
+     */
+    u32 PeekPayload(u32 start, u8 * dest, u32 len) const ;
+
+    /**
+       Append a record holding \c len payload bytes from \c payload,
+       with \c check as its check byte.  Records evicted to make room
+       are appended to \c spill, if it is non-null and open.  Returns
+       the end of the new record.
+     */
+    u32 Append(const u8 * payload, u32 len, u8 check, EventHistorySpill * spill) ;
+
+    /**
+       Drop the oldest record.  Fails if empty.
+     */
+    void DropOldest()
+    {
+      EvictOldest(0);
+    }
+
+  private:
+    u8 * m_bytes;        //< Memory storage, or null
+    FILE * m_file;       //< File storage, or null
+    u32 m_capacity;
+    u32 m_maxPayload;
+    u32 m_oldest;        //< Start of the oldest record
+    u32 m_free;          //< Offset just past the newest record
+    u32 m_used;
+    u32 m_records;
+
+    u32 Wrap(u32 offset) const
+    {
+      return offset >= m_capacity ? offset - m_capacity : offset;
+    }
+
+    void Read(u32 offset, u8 * dest, u32 len) const ;
+
+    void Write(u32 offset, const u8 * src, u32 len) ;
+
+    void ReadFrame(u32 offset, u8 & tag, u32 & span, u8 & check) const ;
+
+    /**
+       Drop the oldest record, first appending it to \c spill if that
+       is non-null and open.
+     */
+    void EvictOldest(EventHistorySpill * spill) ;
+
+    EventHistoryRing(const EventHistoryRing &) ;  // Not implemented
+    EventHistoryRing & operator=(const EventHistoryRing &) ;  // Not implemented
+  };
+
+} /* namespace MFM */
+
+#endif /* EVENTHISTORYRING_H */
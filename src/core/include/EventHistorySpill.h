@@ -0,0 +1,182 @@
+/*                                              -*- mode:C++ -*-
+  EventHistorySpill.h Compressed on-disk ring of older event history
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file EventHistorySpill.h Compressed on-disk ring of older event history
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef EVENTHISTORYSPILL_H
+#define EVENTHISTORYSPILL_H
+
+#include "itype.h"
+#include "EventHistoryRing.h"
+
+namespace MFM
+{
+  /**
+     An EventHistorySpill keeps event records evicted from an
+     in-memory EventHistoryRing, compressed, in a ring in a file.
+
+     Records collect in an open segment -- an in-memory ring of
+     SEGMENT_BYTES -- until the next one would not fit.  Then the
+     open segment's bytes are deflated (zlib) into a single record of
+     the file ring, whose payload is
+
+       record count (2 bytes, little-endian)
+       the deflated segment
+
+     and the open segment starts over empty.  When the file ring is
+     full, its oldest segments are dropped whole.
+
+     Records are read back through a view: either the open segment
+     itself, or one file segment inflated into memory.  Offsets into
+     GetView() are EventHistoryRing offsets, good until the view
+     moves or anything more is appended.
+   */
+  class EventHistorySpill
+  {
+  public:
+    enum
+    {
+      SEGMENT_BYTES = 32768,      //< Uncompressed bytes per segment
+      COUNT_BYTES = 2,            //< Record count heading a file segment
+      MAX_SEGMENT_PAYLOAD =       //< Bound on a deflated segment (see zlib's compressBound)
+        COUNT_BYTES + SEGMENT_BYTES + (SEGMENT_BYTES >> 12) + (SEGMENT_BYTES >> 14) + 13
+    };
+
+    EventHistorySpill()
+      : m_openBytes(0)
+      , m_viewBytes(0)
+      , m_packed(0)
+      , m_fileRecords(0)
+      , m_segmentsWritten(0)
+      , m_viewingOpen(true)
+      , m_viewStart(0)
+    { }
+
+    ~EventHistorySpill()
+    {
+      Close();
+    }
+
+    /**
+       Keep up to \c capacity bytes of compressed segments in a file
+       created (or truncated) at \c path, discarding anything spilled
+       so far.  Returns false, leaving the spill closed, if the file
+       cannot be opened.
+     */
+    bool Open(const char * path, u32 capacity) ;
+
+    /**
+       Release the file and segment buffers, discarding everything
+       spilled.
+     */
+    void Close() ;
+
+    bool IsOpen() const { return m_file.IsOpen(); }
+
+    bool IsEmpty() const { return m_open.IsEmpty() && m_file.IsEmpty(); }
+
+    /**
+       Records spilled and still held, in the open segment and the
+       file
+     */
+    u32 GetRecordCount() const { return m_open.GetRecordCount() + m_fileRecords; }
+
+    /**
+       Bytes held: the open segment's uncompressed, and the file's
+       compressed
+     */
+    u32 GetUsedBytes() const { return m_open.GetUsedBytes() + m_file.GetUsedBytes(); }
+
+    /**
+       Bytes of the file ring holding compressed segments
+     */
+    u32 GetFileBytes() const { return m_file.GetUsedBytes(); }
+
+    /**
+       Append a record holding \c len payload bytes from \c payload,
+       with \c check as its check byte.  May compress the open segment
+       into the file first.
+     */
+    void Append(const u8 * payload, u32 len, u8 check) ;
+
+    /**
+       The segment currently viewed.  Empty only if the spill is.
+     */
+    const EventHistoryRing & GetView() const
+    {
+      return m_viewingOpen ? m_open : m_view;
+    }
+
+    /**
+       View the segment holding the newest records spilled.  Returns
+       false if nothing has been spilled.
+     */
+    bool ViewNewest() ;
+
+    /**
+       View the segment before the one viewed.  Returns false, leaving
+       the view alone, if the viewed segment is the oldest.
+     */
+    bool ViewOlder() ;
+
+    /**
+       View the segment after the one viewed.  Returns false, leaving
+       the view alone, if the viewed segment is the newest.
+     */
+    bool ViewNewer() ;
+
+  private:
+    EventHistoryRing m_file;     //< Compressed segments
+    EventHistoryRing m_open;     //< Uncompressed segment being filled
+    EventHistoryRing m_view;     //< A file segment, inflated
+    u8 * m_openBytes;            //< SEGMENT_BYTES for m_open
+    u8 * m_viewBytes;            //< SEGMENT_BYTES for m_view
+    u8 * m_packed;               //< MAX_SEGMENT_PAYLOAD for a file record
+    u32 m_fileRecords;           //< Records in the file's segments
+    u32 m_segmentsWritten;       //< Low byte checks file segments
+    bool m_viewingOpen;
+    u32 m_viewStart;             //< File start of m_view's segment
+
+    /**
+       The number of records in the file segment starting at \c start
+     */
+    u32 CountAt(u32 start) const ;
+
+    /**
+       Compress the open segment into the file and empty it.
+     */
+    void Flush() ;
+
+    /**
+       Inflate the file segment starting at \c start into m_view, and
+       view it.
+     */
+    void Inflate(u32 start) ;
+
+    EventHistorySpill(const EventHistorySpill &) ;  // Not implemented
+    EventHistorySpill & operator=(const EventHistorySpill &) ;  // Not implemented
+  };
+
+} /* namespace MFM */
+
+#endif /* EVENTHISTORYSPILL_H */
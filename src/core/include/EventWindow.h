@@ -37,6 +37,7 @@
 #include "Base.h"
 #include "ByteSink.h"
 #include "BitStorage.h"
+#include "ElementProfile.h"
 
 namespace MFM
 {
@@ -56,6 +57,12 @@ namespace MFM
        its owned region, and calls EventWindow::TryEventAt, using its
        (one and only) EventWindow.
 
+     - If the atom at that coord belongs to an inert Element (see
+       Element::SetInert), the tile calls TryInertEventAt instead,
+       which applies the same RejectOnRecency filtering and counts the
+       event, but does no locking, loading, behavior, or storing,
+       since the event could not change anything anyway.
+
      - TryEventAt first does filtering for the desired degree of
        spatial flatness (RejectOnRecency).  Then it goes to
        InitForEvent, which attempts to acquire all necessary locks.
@@ -111,6 +118,13 @@ namespace MFM
     u64 m_eventWindowsAttempted;
     u64 m_eventWindowsExecuted;
     u64 m_eventWindowSitesAccessed; // Sum of within-boundary sites
+    u64 m_inertEventsExecuted;      // Included in m_eventWindowsExecuted
+
+    /**
+     * Ticks spent in each ElementProfile::Phase of the current timed
+     * event.  Phases the event did not reach stay zero.
+     */
+    u64 m_phaseTicks[ElementProfile::PHASE_COUNT];
 
     void RecordEventAtTileCoord(const SPoint tcoord) ;
 
@@ -123,6 +137,13 @@ namespace MFM
     AtomBitStorage<EC>  m_atomBuffer[SITE_COUNT];
     bool m_isLiveSite[SITE_COUNT];
 
+    /**
+     * The window as LoadFromTile found it, laid out like
+     * m_atomBuffer so StoreToTile can find the changed sites with one
+     * BitVector::FindChanged pass.
+     */
+    AtomBitStorage<EC>  m_loadedAtoms[SITE_COUNT];
+
     Base<AC> m_centerBase;
 
     SPoint m_center;
@@ -156,6 +177,13 @@ namespace MFM
     };
     State m_ewState;
 
+    /**
+     * When set, ExecuteBehavior enters the full unwind_protect
+     * instead of unwind_protect_light.  Only for measuring the
+     * difference; see SetFullFailBoundaryForTesting.
+     */
+    bool m_fullFailBoundary;
+
     /**
      * Produce the absolute tile location for a given
      * eventwindow-relative coordinate loc.  Maps loc through the
@@ -185,14 +213,54 @@ namespace MFM
      */
     bool TryEventAt(const SPoint & center) ;
 
+    /**
+     * Attempt an event at \c center, whose atom the caller has
+     * established belongs to an inert Element.  Subject to
+     * RejectOnRecency, count the event, without locking or touching
+     * the event window.
+     *
+     * @returns true if the event was counted.
+     */
+    bool TryInertEventAt(const SPoint & center) ;
+
+    /**
+     * Count \c events inert events that did not actually happen
+     * anywhere in particular, to account for sites that a sampling
+     * strategy skipped over.  See Tile::SetSiteSampling.
+     */
+    void CreditInertEvents(u32 events)
+    {
+      m_eventWindowsAttempted += events;
+      m_eventWindowsExecuted += events;
+      m_inertEventsExecuted += events;
+    }
+
     bool RejectOnRecency(const SPoint tcoord) ;
 
-    void ExecuteEvent() ;
+    /**
+     * Run the behavior and write back the results.  If \c timed, the
+     * ticks spent in each are left in m_phaseTicks.
+     */
+    void ExecuteEvent(bool timed = false) ;
+
+    /**
+     * The rest of TryEventAt, for an event whose phases are timed:
+     * for the Tile's counters if \c counted, and for its
+     * ElementProfile if \c profiled.
+     */
+    bool TryTimedEventAt(const SPoint & tcenter, bool counted, bool profiled) ;
 
     void PrintEventSite(ByteSink & bs) ;
 
     void ExecuteBehavior() ;
 
+    /**
+     * Count, log, and clean up after a Behavior that FAILed with \c
+     * failCode at \c failFile : \c lineno.
+     */
+    void BehaviorFailed(int failCode, const char * failFile, unsigned lineno,
+                        void * const * backtraceArray, unsigned backtraceSize) ;
+
     void InitiateCommunications() ;
 
     void LoadFromTile() ;
@@ -240,6 +308,17 @@ namespace MFM
       return TryEventAt(center);
     }
 
+    /**
+     * Make ExecuteBehavior guard each Behavior with the full
+     * unwind_protect (\c full true) rather than the default
+     * unwind_protect_light, so the two can be timed on the same
+     * events.
+     */
+    void SetFullFailBoundaryForTesting(bool full)
+    {
+      m_fullFailBoundary = full;
+    }
+
     /**
      * Stripped down event execution for performance testing
      *
@@ -249,11 +328,12 @@ namespace MFM
     /**
      * Set up for an event at center, which represented in full,
      * untransformed Tile coordinates.  Public primarily for ulam
-     * element testing.
+     * element testing.  If \c timed, the ticks spent acquiring locks
+     * and loading the window are left in m_phaseTicks.
      */
-    bool InitForEvent(const SPoint & center) ;
+    bool InitForEvent(const SPoint & center, bool timed = false) ;
 
-    const Site<AC> & GetSite() const
+    ConstSiteRef<AC> GetSite() const
     {
       return GetTile().GetSite(m_center);
     }
@@ -278,11 +358,47 @@ namespace MFM
       return m_eventWindowsExecuted;
     }
 
+    /**
+     * Read the executed event count from a thread other than the one
+     * running events here.  There is only one writer and the count is
+     * naturally aligned, so on our 64-bit platforms a volatile load
+     * gets a consistent (if stale) value without any locking.
+     */
+    u64 SampleEventWindowsExecuted() const
+    {
+      return *(const volatile u64 *) &m_eventWindowsExecuted;
+    }
+
+    /**
+     * Like SampleEventWindowsExecuted, for the attempted count
+     */
+    u64 SampleEventWindowsAttempted() const
+    {
+      return *(const volatile u64 *) &m_eventWindowsAttempted;
+    }
+
     u64 GetSitesAccessed() const
     {
       return m_eventWindowSitesAccessed;
     }
 
+    /**
+     * Gets how many of the GetEventWindowsExecuted() events took the
+     * inert fast path.
+     */
+    u64 GetInertEventsExecuted() const
+    {
+      return m_inertEventsExecuted;
+    }
+
+    /**
+     * Like SampleEventWindowsExecuted, for the inert count
+     */
+    u64 SampleInertEventsExecuted() const
+    {
+      return *(const volatile u64 *) &m_inertEventsExecuted;
+    }
+
     void SetEventWindowsAttempted(u64 attempts)
     {
       m_eventWindowsAttempted = attempts;
@@ -6,6 +6,7 @@
 #include "PacketIO.h"
 #include "EventHistoryBuffer.h"
 #include "CacheProcessor.h"
+#include "TileCounters.h"
 #include <execinfo.h> /* for backtrace_symbols */
 
 namespace MFM {
@@ -54,13 +55,21 @@ namespace MFM {
                   tcenter.GetY(),
 		  t.GetLabel()));
 
-    ++m_eventWindowsAttempted;
+    const u64 attempt = m_eventWindowsAttempted++;
+    const bool timed = TileCounters::IsTimedEvent(attempt);
+    const bool profiled = t.GetElementProfile().IsSampled(attempt);
 
     if (RejectOnRecency(tcenter))
     {
+      t.GetCounters().Add(TileCounters::RECENCY_REJECTIONS);
       return false;
     }
 
+    if (timed || profiled)
+    {
+      return TryTimedEventAt(tcenter, timed, profiled);
+    }
+
     if (!InitForEvent(tcenter))
     {
       return false;
@@ -72,6 +81,66 @@ namespace MFM {
     return true;
   }
 
+  template <class EC>
+  bool EventWindow<EC>::TryTimedEventAt(const SPoint & tcenter, bool counted, bool profiled)
+  {
+    Tile<EC> & t = GetTile();
+
+    // Charge the event to whatever was at the center beforehand
+    const s32 slot = profiled ? t.GetElementTable().GetIndex(t.GetAtom(tcenter)->GetType()) : -1;
+
+    for (u32 i = 0; i < ElementProfile::PHASE_COUNT; ++i)
+    {
+      m_phaseTicks[i] = 0;
+    }
+
+    const bool executed = InitForEvent(tcenter, true);
+    if (executed)
+    {
+      RecordEventAtTileCoord(tcenter);
+      ExecuteEvent(true);
+    }
+
+    if (counted)
+    {
+      TileCounters & counters = t.GetCounters();
+      counters.Add(TileCounters::TIMED_EVENTS);
+      counters.Add(TileCounters::LOCK_TICKS, m_phaseTicks[ElementProfile::LOCK]);
+      counters.Add(TileCounters::BEHAVIOR_TICKS, m_phaseTicks[ElementProfile::BEHAVIOR]);
+    }
+
+    // An attempt that couldn't get its locks did nothing for the
+    // element, so it isn't a sample (TileCounters counts those)
+    if (slot >= 0 && executed)
+    {
+      t.GetElementProfile().AddSample((u32) slot, m_phaseTicks);
+    }
+
+    return executed;
+  }
+
+  template <class EC>
+  bool EventWindow<EC>::TryInertEventAt(const SPoint & tcenter)
+  {
+    MFM_LOG_DBG6(("EW::TryInertEventAt(%d,%d) %s",
+		  tcenter.GetX(),
+                  tcenter.GetY(),
+		  GetTile().GetLabel()));
+
+    ++m_eventWindowsAttempted;
+
+    if (RejectOnRecency(tcenter))
+    {
+      GetTile().GetCounters().Add(TileCounters::RECENCY_REJECTIONS);
+      return false;
+    }
+
+    RecordEventAtTileCoord(tcenter);
+    ++m_inertEventsExecuted;
+
+    return true;
+  }
+
   template <class EC>
   void EventWindow<EC>::RecordEventAtTileCoord(const SPoint tcoord)
   {
@@ -98,15 +167,28 @@ namespace MFM {
   }
 
   template <class EC>
-  void EventWindow<EC>::ExecuteEvent()
+  void EventWindow<EC>::ExecuteEvent(bool timed)
   {
 
     MFM_LOG_DBG6(("EW::ExecuteEvent %s", GetTile().GetLabel()));
     MFM_API_ASSERT_STATE(m_ewState == COMPUTE);
 
-    ExecuteBehavior();
-
-    InitiateCommunications();
+    if (timed)
+    {
+      u64 start = TileCounters::ReadTicks();
+      ExecuteBehavior();
+      u64 end = TileCounters::ReadTicks();
+      m_phaseTicks[ElementProfile::BEHAVIOR] = end - start;
+
+      start = end;
+      InitiateCommunications();
+      m_phaseTicks[ElementProfile::STORE] = TileCounters::ReadTicks() - start;
+    }
+    else
+    {
+      ExecuteBehavior();
+      InitiateCommunications();
+    }
   }
 
   template <class EC>
@@ -138,55 +220,79 @@ namespace MFM {
 
     MFM_LOG_DBG6(("EW::ExecuteBehavior %s",t.GetLabel()));
 
-    unwind_protect(
+    if (__builtin_expect(m_fullFailBoundary,0))
     {
-      OString256 buff;
-      PrintEventSite(buff);
-      buff.Printf(":");
-
-      const char * failFile = MFMThrownFromFile;
-      const unsigned lineno = MFMThrownFromLineNo;
-      const char * failMsg = MFMFailCodeReason(MFMThrownFailCode);
-      if(!GetCenterAtomDirect().IsSane())
+      unwind_protect(
       {
-        MFM_LOG_DBG4(("%s FE(INSANE)",buff.GetZString()));
-      }
-      else if (failMsg)
+        BehaviorFailed(MFMThrownFailCode, MFMThrownFromFile, MFMThrownFromLineNo,
+                       MFMThrownBacktraceArray, MFMThrownBacktraceSize);
+      },
       {
-        MFM_LOG_DBG3(("%s behave() failed at %s:%d: %s (site type 0x%04x)",
+        MFM_LOG_DBG6(("ET::Execute %s",t.GetLabel()));
+        m_element->Behavior(*this);
+      });
+      return;
+    }
+
+    // Entered once per event, so use the cheaper boundary
+    unwind_protect_light(
+    {
+      BehaviorFailed(MFMThrownFailCode, MFMThrownFromFile, MFMThrownFromLineNo,
+                     MFMThrownBacktraceArray, MFMThrownBacktraceSize);
+    },
+    {
+      MFM_LOG_DBG6(("ET::Execute %s",t.GetLabel()));
+      m_element->Behavior(*this);
+    });
+  }
+
+  template <class EC>
+  void EventWindow<EC>::BehaviorFailed(int failCode, const char * failFile, unsigned lineno,
+                                       void * const * backtraceArray, unsigned backtraceSize)
+  {
+    Tile<EC> & t = GetTile();
+    t.GetCounters().Add(TileCounters::BEHAVIOR_FAILURES);
+
+    OString256 buff;
+    PrintEventSite(buff);
+    buff.Printf(":");
+
+    const char * failMsg = MFMFailCodeReason(failCode);
+    if(!GetCenterAtomDirect().IsSane())
+    {
+      MFM_LOG_DBG4(("%s FE(INSANE)",buff.GetZString()));
+    }
+    else if (failMsg)
+    {
+      MFM_LOG_DBG3(("%s behave() failed at %s:%d: %s (site type 0x%04x)",
 		      buff.GetZString(),
 		      failFile,
 		      lineno,
 		      failMsg,
 		      GetCenterAtomDirect().GetType()));
-      }
-      else
-      {
-        MFM_LOG_DBG3(("%s behave() failed at %s:%d: fail(%d/0x%08x) (site type 0x%04x)",
+    }
+    else
+    {
+      MFM_LOG_DBG3(("%s behave() failed at %s:%d: fail(%d/0x%08x) (site type 0x%04x)",
 		      buff.GetZString(),
 		      failFile,
 		      lineno,
-		      MFMThrownFailCode,
-		      MFMThrownFailCode,
+		      failCode,
+		      failCode,
 		      GetCenterAtomDirect().GetType()));
-      }
-      {
-        OverflowableCharBufferByteSink<4096 + 2> bt;
-        char ** strings = backtrace_symbols (MFMThrownBacktraceArray, MFMThrownBacktraceSize);
+    }
+    {
+      OverflowableCharBufferByteSink<4096 + 2> bt;
+      char ** strings = backtrace_symbols (backtraceArray, backtraceSize);
 
-        for (u32 i = 0; i < MFMThrownBacktraceSize; i++)
-          bt.Printf("%s\n", strings[i]);
-        free (strings);
+      for (u32 i = 0; i < backtraceSize; i++)
+        bt.Printf("%s\n", strings[i]);
+      free (strings);
 
-        LOG.Message("BACKTRACE %s",bt.GetZString());
-      }
+      LOG.Message("BACKTRACE %s",bt.GetZString());
+    }
 
-      SetCenterAtomDirect(t.GetEmptyAtom());
-    },
-    {
-      MFM_LOG_DBG6(("ET::Execute %s",t.GetLabel()));
-      m_element->Behavior(*this);
-    });
+    SetCenterAtomDirect(t.GetEmptyAtom());
   }
 
   template <class EC>
@@ -214,7 +320,7 @@ namespace MFM {
     T us = window.GetCenterAtomDirect();
     T other = window.GetRelativeAtomDirect(sp);
     const Element<EC> * ourElt = tile.GetElement(us.GetType());
-    const Element<EC> * elt = tile.GetElement(other.GetType());
+    const Element<EC> * elt;
 
     if (!other.IsSane() || !(elt = tile.GetElement(other.GetType())))
       return;       // Any confusion, let the engine sort it out first
@@ -236,7 +342,7 @@ namespace MFM {
   }
 
   template <class EC>
-  bool EventWindow<EC>::InitForEvent(const SPoint & center)
+  bool EventWindow<EC>::InitForEvent(const SPoint & center, bool timed)
   {
     Tile<EC> & tile = GetTile();
     MFM_API_ASSERT_STATE(!tile.IsDummyTile()); //sanity
@@ -273,17 +379,26 @@ namespace MFM {
     }
 
     u32 type = atom.GetType();
-    m_element  = tile.GetElementTable().Lookup(type);
+    const typename ElementTable<EC>::ElementEntry & entry = tile.GetElementTable().LookupEntry(type);
+    m_element = entry.m_element;
     if (m_element == 0) // If no element of that type
     {
       tile.PlaceAtom(tile.GetEmptyAtom(), center);  // You must die
       return false;
     }
 
-    SetBoundary(m_element->GetEventWindowBoundary());
+    SetBoundary(entry.m_boundary);
 
-    if (!AcquireAllLocks(center, m_eventWindowBoundary))
+    const u64 lockStart = timed ? TileCounters::ReadTicks() : 0;
+    const bool locked = AcquireAllLocks(center, m_eventWindowBoundary);
+    if (timed)
     {
+      m_phaseTicks[ElementProfile::LOCK] = TileCounters::ReadTicks() - lockStart;
+    }
+
+    if (!locked)
+    {
+      tile.GetCounters().Add(TileCounters::LOCK_FAILURES);
       MFM_LOG_DBG6(("EW::InitForEvent (%d,%d) %s - abandoned",
 		    center.GetX(),center.GetY(),
 		    tile.GetLabel()));
@@ -295,7 +410,16 @@ namespace MFM {
     m_ewState = COMPUTE;
     m_sym = PSYM_NORMAL;
 
-    LoadFromTile();
+    if (timed)
+    {
+      const u64 loadStart = TileCounters::ReadTicks();
+      LoadFromTile();
+      m_phaseTicks[ElementProfile::LOAD] = TileCounters::ReadTicks() - loadStart;
+    }
+    else
+    {
+      LoadFromTile();
+    }
     return true;
   }
 
@@ -322,6 +446,7 @@ namespace MFM {
 
     if (!cp.IsIdle())
     {
+      ewtile.GetCounters().Add(dir, TileCounters::DIR_LOCK_FAILURES);
       MFM_API_ASSERT_STATE(!cp.IsUnclaimed()); //since it's connected
       MFM_LOG_DBG6(("EW::AcquireRegionLocks %s - fail: %s cp not idle",
 		    ewtile.GetLabel(),
@@ -332,6 +457,7 @@ namespace MFM {
     bool locked = cp.TryLock(neededLocks, lockRegions);
     if (!locked)
     {
+      ewtile.GetCounters().Add(dir, TileCounters::DIR_LOCK_FAILURES);
       MFM_LOG_DBG6(("EW::AcquireRegionLocks %s - fail: didn't get %s lock",
 		    ewtile.GetLabel(),
                     Dirs::GetName(dir)));
@@ -500,9 +626,11 @@ namespace MFM {
     , m_eventWindowsAttempted(0)
     , m_eventWindowsExecuted(0)
     , m_eventWindowSitesAccessed(0)
+    , m_inertEventsExecuted(0)
     , m_center(0,0)
     , m_sym(PSYM_NORMAL)
     , m_ewState(FREE)
+    , m_fullFailBoundary(false)
   {
     m_cpli.Shuffle(GetRandom());
 
@@ -510,6 +638,8 @@ namespace MFM {
 
     for (u32 i = 0; i < MAX_CACHES_TO_UPDATE; m_cacheProcessorsLocked[i++] = 0);
 
+    for (u32 i = 0; i < ElementProfile::PHASE_COUNT; m_phaseTicks[i++] = 0);
+
   }
 
   template <class EC>
@@ -540,13 +670,17 @@ namespace MFM {
     Tile<EC> & tile = GetTile();
 
     m_centerBase = tile.GetSite(m_center).GetBase();
-    const MDist<R> & md = MDist<R>::get();
+
+    // Only owned centers keep the whole window inside the tile
+    MFM_API_ASSERT_ARG(tile.IsOwnedSite(m_center));
+    const u32 centerSiteNumber = tile.GetSiteInTileNumber(m_center);
+    const s32 * offsets = tile.GetWindowSiteOffsets();
     for (u32 i = 0; i < m_boundedSiteCount; ++i)
     {
-      const SPoint & pt = md.GetPoint(i) + m_center;
-      //m_atomBuffer[i] = tile.GetAtomForEventWindow(pt);
-      m_atomBuffer[i].WriteAtom(tile.GetAtomForEventWindow(pt));
-      m_isLiveSite[i] = tile.IsLiveSite(pt);
+      const u32 sn = centerSiteNumber + offsets[i];
+      m_atomBuffer[i].WriteAtom(tile.GetAtomForEventWindow(sn));
+      m_loadedAtoms[i].m_atom = m_atomBuffer[i].GetAtom();
+      m_isLiveSite[i] = tile.IsLiveSiteNumber(sn);
     }
   }
 
@@ -581,16 +715,25 @@ namespace MFM {
     // Write back base changes if any
     tile.GetSite(m_center).GetBase() = m_centerBase;
 
+    // The tile's window hasn't changed since LoadFromTile (we hold
+    // its locks), so compare against the loaded copy all at once
+    bool changed[SITE_COUNT];
+    BitVector<AC::BITS_PER_ATOM>::FindChanged(&m_loadedAtoms[0].GetAtom().GetBits(),
+                                              &m_atomBuffer[0].GetAtom().GetBits(),
+                                              m_boundedSiteCount, changed,
+                                              sizeof(m_atomBuffer[0]));
+
+    const u32 centerSiteNumber = tile.GetSiteInTileNumber(m_center);
+    const s32 * offsets = tile.GetWindowSiteOffsets();
     for (u32 i = 0; i < m_boundedSiteCount; ++i)
     {
-      const SPoint & pt = md.GetPoint(i) + m_center;
       bool dirty = false;
       if (m_isLiveSite[i])
       {
-        //if (m_atomBuffer[i] != *tile.GetAtom(pt))
-	if (m_atomBuffer[i].GetAtom() != *tile.GetAtom(pt))
+        const T & tileAtom = tile.GetAtomAtSiteNumber(centerSiteNumber + offsets[i]);
+        if (changed[i])
         {
-          tile.PlaceAtom(m_atomBuffer[i].GetAtom(), pt);
+          tile.PlaceAtom(m_atomBuffer[i].GetAtom(), md.GetPoint(i) + m_center);
           dirty = true;
         }
 
@@ -599,7 +742,7 @@ namespace MFM {
         {
           if (m_cacheProcessorsLocked[j] != 0)
           {
-            m_cacheProcessorsLocked[j]->MaybeSendAtom( *tile.GetAtom(pt), dirty, i);
+            m_cacheProcessorsLocked[j]->MaybeSendAtom(tileAtom, dirty, i);
           }
         }
       }
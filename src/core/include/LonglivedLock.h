@@ -36,19 +36,13 @@
 namespace MFM
 {
   /**
-   * An LonglivedLock mediates long-duration locking between a set of
-   * possible owners
+   * Results shared by the LonglivedLock implementations.
    */
-  class LonglivedLock
+  struct LonglivedLockBase
   {
-  private:
-    Mutex m_shortLivedLock;
-    void * m_longlivedLockOwner;
-    void * m_lastLonglivedLockOwner;
-
     enum ThreeWayResult { RESULT_TRUE, RESULT_FALSE, RESULT_FAIL };
 
-    bool DecodeResult(ThreeWayResult res)
+    static bool DecodeResult(ThreeWayResult res)
     {
       switch(res)
       {
@@ -61,6 +55,27 @@ namespace MFM
       }
     }
 
+    static void CheckOwner(void * who)
+    {
+      MFM_API_ASSERT_NONNULL(who);
+      MFM_API_ASSERT(who != (void*) (intptr_t) -1,ILLEGAL_ARGUMENT);
+    }
+  };
+
+  /**
+   * A MutexLonglivedLock mediates long-duration locking between a set
+   * of possible owners, using a pthread mutex to guard the owner.
+   * This was the original LonglivedLock implementation; it is kept
+   * for comparison and selected by defining MFM_MUTEX_LONGLIVED_LOCK.
+   */
+  class MutexLonglivedLock : public LonglivedLockBase
+  {
+  private:
+    Mutex m_shortLivedLock;
+    void * m_longlivedLockOwner;
+    void * m_lastLonglivedLockOwner;
+    u64 m_contentionCount;
+
     ThreeWayResult TryLockInternal(void * arg)
     {
       Mutex::ScopeLock scopeLock(m_shortLivedLock);
@@ -77,6 +92,7 @@ namespace MFM
         return RESULT_FAIL;
       }
 
+      ++m_contentionCount;
       return RESULT_FALSE;
     }
 
@@ -96,16 +112,18 @@ namespace MFM
   public:
 
     /**
-     * Initialize this LonglivedLock.
+     * Initialize this MutexLonglivedLock.
      */
-    LonglivedLock()
+    MutexLonglivedLock()
       : m_longlivedLockOwner(0)
+      , m_lastLonglivedLockOwner(0)
+      , m_contentionCount(0)
     { }
 
     /**
-     * Destroys this LonglivedLock.
+     * Destroys this MutexLonglivedLock.
      */
-    ~LonglivedLock()
+    ~MutexLonglivedLock()
     { }
 
     /**
@@ -121,6 +139,16 @@ namespace MFM
       return m_longlivedLockOwner;
     }
 
+    /**
+     * Get the number of TryLock calls that have failed because the
+     * lock was held by some other owner.
+     */
+    u64 GetContentionCount()
+    {
+      Mutex::ScopeLock scopeLock(m_shortLivedLock);
+      return m_contentionCount;
+    }
+
     /**
      * Atomically attempt to capture the lock on behalf of ownerIndex.
      * If the lock is available, change its ownder to ownerIndex and
@@ -130,8 +158,7 @@ namespace MFM
      */
     bool TryLock(void * who)
     {
-      MFM_API_ASSERT_NONNULL(who);
-      MFM_API_ASSERT(who != (void*) (intptr_t) -1,ILLEGAL_ARGUMENT);
+      CheckOwner(who);
       return DecodeResult(TryLockInternal(who));
     }
 
@@ -143,11 +170,126 @@ namespace MFM
      */
     bool Unlock(void * who)
     {
-      MFM_API_ASSERT_NONNULL(who);
-      MFM_API_ASSERT(who != (void*) (intptr_t) -1,ILLEGAL_ARGUMENT);
+      CheckOwner(who);
       return DecodeResult(UnlockInternal(who));
     }
   };
+
+  /**
+   * A CASLonglivedLock provides the same semantics as a
+   * MutexLonglivedLock, but claims and releases the owner with a
+   * single atomic compare-and-swap, so an uncontended TryLock or
+   * Unlock never enters the kernel or touches a pthread mutex.
+   *
+   * The GCC __sync builtins used here are full memory barriers, so
+   * everything the previous owner wrote before Unlock is visible to
+   * the next owner after its successful TryLock.
+   */
+  class CASLonglivedLock : public LonglivedLockBase
+  {
+  private:
+    void * volatile m_longlivedLockOwner;
+    void * m_lastLonglivedLockOwner;
+    volatile u64 m_contentionCount;
+
+    ThreeWayResult TryLockInternal(void * arg)
+    {
+      void * prev = __sync_val_compare_and_swap(&m_longlivedLockOwner, (void *) 0, arg);
+
+      if (prev == 0)
+      {
+        m_lastLonglivedLockOwner = arg;
+        return RESULT_TRUE;
+      }
+
+      if (prev == arg)
+      {
+        return RESULT_FAIL;
+      }
+
+      __sync_fetch_and_add(&m_contentionCount, 1);
+      return RESULT_FALSE;
+    }
+
+    ThreeWayResult UnlockInternal(void * arg)
+    {
+      if (__sync_bool_compare_and_swap(&m_longlivedLockOwner, arg, (void *) 0))
+      {
+        return RESULT_TRUE;
+      }
+
+      return RESULT_FAIL;
+    }
+
+  public:
+
+    /**
+     * Initialize this CASLonglivedLock.
+     */
+    CASLonglivedLock()
+      : m_longlivedLockOwner(0)
+      , m_lastLonglivedLockOwner(0)
+      , m_contentionCount(0)
+    { }
+
+    /**
+     * Destroys this CASLonglivedLock.
+     */
+    ~CASLonglivedLock()
+    { }
+
+    /**
+     * Get the current lock owner if any.  The result is only advisory
+     * (i.e., it may have changed by the time caller looks at it)
+     * unless the caller owns the channel.
+     *
+     * \returns 0 if the lock was free, or non-zero for owner index
+     */
+    void * GetOwnerIndex()
+    {
+      return m_longlivedLockOwner;
+    }
+
+    /**
+     * Get the number of TryLock calls that have failed because the
+     * lock was held by some other owner.  Advisory only.
+     */
+    u64 GetContentionCount()
+    {
+      return m_contentionCount;
+    }
+
+    /**
+     * Atomically attempt to capture the lock on behalf of who.  If
+     * the lock is available, change its owner to who and return true.
+     * If the lock is currently held by who, FAILS with LOCK_FAILURE to
+     * discourage stupidity.  If the lock held by some other owner,
+     * change nothing and return false.
+     */
+    bool TryLock(void * who)
+    {
+      CheckOwner(who);
+      return DecodeResult(TryLockInternal(who));
+    }
+
+    /**
+     * Atomically check and possibly update the long-lived lock as
+     * follows: If the lock is currently held by who, unlock the
+     * long-lived lock and return true.  Otherwise FAILS with
+     * LOCK_FAILURE.
+     */
+    bool Unlock(void * who)
+    {
+      CheckOwner(who);
+      return DecodeResult(UnlockInternal(who));
+    }
+  };
+
+#ifdef MFM_MUTEX_LONGLIVED_LOCK
+  typedef MutexLonglivedLock LonglivedLock;
+#else
+  typedef CASLonglivedLock LonglivedLock;
+#endif
 }
 
 #endif /* LONGLIVEDLOCK_H */
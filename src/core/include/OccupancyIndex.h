@@ -0,0 +1,148 @@
+/*                                              -*- mode:C++ -*-
+  OccupancyIndex.h Constant-time set of occupied site numbers
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file OccupancyIndex.h Constant-time set of occupied site numbers
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef OCCUPANCYINDEX_H
+#define OCCUPANCYINDEX_H
+
+#include "itype.h"
+#include "Fail.h"
+#include "Random.h"
+
+namespace MFM
+{
+  /**
+     How a Tile chooses the center of its next event.
+   */
+  enum SiteSampling
+  {
+    /** Every owned site equally likely, the traditional way */
+    SITE_SAMPLING_UNIFORM,
+
+    /** Only occupied owned sites, with the events the skipped empty
+        sites would have had credited statistically */
+    SITE_SAMPLING_OCCUPIED
+  };
+
+  /**
+     A set of site numbers, 0..sites-1, supporting constant-time
+     insertion, removal, membership, and uniform random selection.
+     Members are kept densely packed in one array, and each site's
+     position in that array is kept in another, so a removal can
+     swap the last member into the hole.  Storage is supplied by the
+     owner, as 2 * sites u32s.
+   */
+  class OccupancyIndex
+  {
+  public:
+    enum { ABSENT = U32_MAX };
+
+    OccupancyIndex(u32 * storage, const u32 sites)
+      : m_members(storage)
+      , m_positions(storage + sites)
+      , m_sites(sites)
+      , m_count(0)
+    {
+      MFM_API_ASSERT_NONNULL(storage);
+      Clear();
+    }
+
+    void Clear()
+    {
+      for (u32 i = 0; i < m_sites; ++i)
+      {
+        m_positions[i] = ABSENT;
+      }
+      m_count = 0;
+    }
+
+    u32 GetCount() const
+    {
+      return m_count;
+    }
+
+    bool Contains(const u32 site) const
+    {
+      MFM_API_ASSERT_ARG(site < m_sites);
+      return m_positions[site] != ABSENT;
+    }
+
+    void Insert(const u32 site)
+    {
+      if (Contains(site))
+      {
+        return;
+      }
+      m_positions[site] = m_count;
+      m_members[m_count++] = site;
+    }
+
+    void Remove(const u32 site)
+    {
+      if (!Contains(site))
+      {
+        return;
+      }
+      const u32 pos = m_positions[site];
+      const u32 last = m_members[--m_count];
+      m_members[pos] = last;
+      m_positions[last] = pos;
+      m_positions[site] = ABSENT;
+    }
+
+    void Update(const u32 site, const bool occupied)
+    {
+      if (occupied)
+      {
+        Insert(site);
+      }
+      else
+      {
+        Remove(site);
+      }
+    }
+
+    /**
+       Return a member chosen uniformly at random.  Fails if the set
+       is empty.
+     */
+    u32 Pick(Random & random) const
+    {
+      MFM_API_ASSERT_STATE(m_count > 0);
+      return m_members[random.Create(m_count)];
+    }
+
+  private:
+    u32 * const m_members;    // m_count site numbers, in no particular order
+    u32 * const m_positions;  // Index in m_members of each site, or ABSENT
+    const u32 m_sites;
+    u32 m_count;
+
+    OccupancyIndex(const OccupancyIndex &) ;  // Not implemented
+    OccupancyIndex & operator=(const OccupancyIndex &) ;  // Not implemented
+  };
+
+} /* namespace MFM */
+
+#endif /* OCCUPANCYINDEX_H */
@@ -36,9 +36,15 @@ namespace MFM
 {
 
   /**
-     The type of variable that can contain a raw, unparsed Packet
+     The type of variable that can contain a raw, unparsed Packet.
+     Must be big enough to hold an entire UPDATE_FRAME.
    */
-  typedef OString128 PacketBuffer;
+  typedef OString1024 PacketBuffer;
+
+  /**
+     The largest packet length that can be framed on a channel.
+   */
+  enum { MAX_PACKET_LENGTH = 1024 };
 
   /**
      The type of a variable that can contain a PacketType value
@@ -78,6 +84,16 @@ namespace MFM
      */
     static const u8 UPDATE_END = 'e';
 
+    /**
+     * The PacketType when an updater is sending an entire cache
+     * update at once, equivalent to an UPDATE_BEGIN, COUNT UPDATE or
+     * CHECK packets, and an UPDATE_END.  Each atom's site number
+     * is sent as is, in the low seven bits of a byte whose high bit
+     * is set for a CHECK.  Format: UPDATE_FRAME + s16:CX + s16:CY +
+     * u8:COUNT + COUNT * (u8:SITE|CHECKBIT + T:ATOM)
+     */
+    static const u8 UPDATE_FRAME = 'f';
+
     /**
      * The PacketType when an updatee has received an UPDATE_END.
      * Format: UPDATE_ACK + u8:CONSISTENT_ATOM_COUNT
@@ -39,7 +39,35 @@ namespace MFM
 
   class PacketIO {
     PacketBuffer m_buffer;
+    u32 m_frameCount;       // Atoms still to be added to the UPDATE_FRAME in m_buffer
   public:
+    PacketIO()
+      : m_frameCount(0)
+    { }
+
+    /**
+       Start building an UPDATE_FRAME packet in our buffer, for an
+       event at localCenter, that will contain atomCount atoms.
+       Follow with exactly atomCount calls to AddFrameAtom, and then
+       ShipUpdateFrame as many times as necessary to get it sent.
+       Each atom goes as a site byte -- the site number, with the top
+       bit set for a CHECK -- followed by the atom's bytes.
+     */
+    template <class EC>
+    void StartUpdateFrame(CacheProcessor<EC> & cxn, const SPoint & localCenter, u32 atomCount) ;
+
+    template <class EC>
+    void AddFrameAtom(PacketTypeCode ptype, CacheProcessor<EC> & cxn,
+                      u16 siteNumber, const typename EC::ATOM_CONFIG::ATOM_TYPE & atom) ;
+
+    /**
+       Try to ship the UPDATE_FRAME packet built by StartUpdateFrame
+       and AddFrameAtom.  Return false if there wasn't room for it on
+       the channel, in which case it can be retried later.
+     */
+    template <class EC>
+    bool ShipUpdateFrame(CacheProcessor<EC> & cxn) ;
+
     template <class EC>
     bool SendUpdateBegin(CacheProcessor<EC> & cxn, const SPoint & localCenter) ;
 
@@ -70,6 +98,9 @@ namespace MFM
     template <class EC>
     bool ReceiveUpdateEnd(CacheProcessor<EC> & cxn, ByteSource & buf) ;
 
+    template <class EC>
+    bool ReceiveUpdateFrame(CacheProcessor<EC> & cxn, ByteSource & buf) ;
+
     template <class EC>
     bool ReceiveReply(CacheProcessor<EC> & cxn, ByteSource & buf) ;
 
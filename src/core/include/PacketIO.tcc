@@ -2,6 +2,7 @@
 
 #include "CacheProcessor.h"
 #include "CharBufferByteSource.h"
+#include "MDist.h"  /* for EVENT_WINDOW_SITES */
 
 namespace MFM
 {
@@ -86,6 +87,92 @@ namespace MFM
     return true;
   }
 
+  template <class EC>
+  void PacketIO::StartUpdateFrame(CacheProcessor<EC> & cxn, const SPoint & localCenter, u32 atomCount)
+  {
+    enum { R = EC::EVENT_WINDOW_RADIUS };
+    enum { ATOM_BYTES = 4 * BitVector<EC::ATOM_CONFIG::BITS_PER_ATOM>::ARRAY_LENGTH };
+    enum { MAX_FRAME_LENGTH = 6 + EVENT_WINDOW_SITES(R) * (1 + ATOM_BYTES) };
+
+    // Site numbers get seven bits, and a whole window must fit in one packet
+    COMPILATION_REQUIREMENT< EVENT_WINDOW_SITES(R) <= 128 >();
+    COMPILATION_REQUIREMENT< (u32) MAX_FRAME_LENGTH <= (u32) MAX_PACKET_LENGTH >();
+
+    MFM_API_ASSERT_ARG(atomCount <= EVENT_WINDOW_SITES(R));
+
+    SPoint center = cxn.LocalToRemote(localCenter);
+    m_buffer.Reset();
+    m_buffer.Printf("%c%h%h%c", PacketType::UPDATE_FRAME, center.GetX(), center.GetY(), atomCount);
+    m_frameCount = atomCount;
+  }
+
+  template <class EC>
+  void PacketIO::AddFrameAtom(PacketTypeCode ptype,
+                              CacheProcessor<EC> & cxn,
+                              u16 siteNumber,
+                              const typename EC::ATOM_CONFIG::ATOM_TYPE & atom)
+  {
+    MFM_API_ASSERT_STATE(m_frameCount > 0);
+    MFM_API_ASSERT_ARG(ptype == PacketType::UPDATE || ptype == PacketType::CHECK);
+
+    u8 siteByte = (u8) siteNumber;
+    if (ptype == PacketType::CHECK)
+    {
+      siteByte |= 0x80;
+    }
+    m_buffer.Print((u32) siteByte, Format::BYTE);
+    Element<EC>::GetBits(atom).PrintBytes(m_buffer);
+
+    --m_frameCount;
+  }
+
+  template <class EC>
+  bool PacketIO::ShipUpdateFrame(CacheProcessor<EC> & cxn)
+  {
+    MFM_API_ASSERT_STATE(m_frameCount == 0);
+    return cxn.ShipBufferAsPacket(m_buffer);
+  }
+
+  template <class EC>
+  bool PacketIO::ReceiveUpdateFrame(CacheProcessor<EC> & cxn, ByteSource & bs)
+  {
+    u8 ptype;
+    s16 cx, cy;
+    u8 count;
+    if (bs.Scanf("%c%h%h%c", &ptype, &cx, &cy, &count) != 4 || ptype != PacketType::UPDATE_FRAME)
+    {
+      return false;
+    }
+
+    cxn.BeginUpdate(SPoint(cx, cy));
+
+    for (u32 i = 0; i < count; ++i)
+    {
+      s32 siteByte = bs.Read();
+      if (siteByte < 0)
+      {
+        return false;
+      }
+
+      typename EC::ATOM_CONFIG::ATOM_TYPE atom;
+      if (!Element<EC>::GetBits(atom).ReadBytes(bs))
+      {
+        return false;
+      }
+
+      cxn.ReceiveAtom((siteByte & 0x80) == 0, siteByte & 0x7f, atom);
+    }
+
+    // OK, need EOF now
+    if (bs.Read() >= 0)
+    {
+      return false;
+    }
+
+    cxn.ReceiveUpdateEnd();
+    return true;
+  }
+
   template <class EC>
   bool PacketIO::SendReply(u8 consistentCount, CacheProcessor<EC> & cxn)
   {
@@ -124,6 +211,9 @@ namespace MFM
     case PacketType::UPDATE_END:
       return ReceiveUpdateEnd(cxn, cbs);
 
+    case PacketType::UPDATE_FRAME:
+      return ReceiveUpdateFrame(cxn, cbs);
+
     case PacketType::UPDATE_ACK:
       return ReceiveReply(cxn, cbs);
 
@@ -0,0 +1,106 @@
+/*                                              -*- mode:C++ -*-
+  RandXoshiro.h The xoshiro256** pseudorandom number generator
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file RandXoshiro.h The xoshiro256** pseudorandom number generator
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef RANDXOSHIRO_H
+#define RANDXOSHIRO_H
+
+#include "itype.h"
+#include "Util.h"  /* For HexU64 */
+
+namespace MFM
+{
+  /**
+   * Blackman and Vigna's xoshiro256**: 256 bits of state, period
+   * 2**256-1, and a handful of shifts, rotates, and multiplies per
+   * draw, with no periodic reload like the Mersenne Twister's.  The
+   * state is seeded by running SplitMix64 over the seed, as its
+   * authors recommend.
+   */
+  class RandXoshiro
+  {
+  public:
+    RandXoshiro()
+    {
+      Seed(1);
+    }
+
+    void Seed(u32 seed)
+    {
+      u64 x = seed;
+      for (u32 i = 0; i < 4; ++i)
+      {
+        m_s[i] = SplitMix64(x);
+      }
+    }
+
+    /**
+     * Advance x and return the next SplitMix64 output from it.  Also
+     * used on its own to derive well-separated seeds.
+     */
+    static u64 SplitMix64(u64 & x)
+    {
+      x += HexU64(0x9e3779b9, 0x7f4a7c15);
+      u64 z = x;
+      z = (z ^ (z >> 30)) * HexU64(0xbf58476d, 0x1ce4e5b9);
+      z = (z ^ (z >> 27)) * HexU64(0x94d049bb, 0x133111eb);
+      return z ^ (z >> 31);
+    }
+
+    inline u64 Next64()
+    {
+      const u64 result = Rotl(m_s[1] * 5, 7) * 9;
+      const u64 t = m_s[1] << 17;
+
+      m_s[2] ^= m_s[0];
+      m_s[3] ^= m_s[1];
+      m_s[1] ^= m_s[2];
+      m_s[0] ^= m_s[3];
+
+      m_s[2] ^= t;
+      m_s[3] = Rotl(m_s[3], 45);
+
+      return result;
+    }
+
+    /**
+     * The high half of Next64, whose bits are the best mixed
+     */
+    inline u32 Next32()
+    {
+      return (u32) (Next64() >> 32);
+    }
+
+  private:
+    u64 m_s[4];
+
+    static inline u64 Rotl(const u64 x, const u32 k)
+    {
+      return (x << k) | (x >> (64 - k));
+    }
+  };
+
+} /* namespace MFM */
+
+#endif /* RANDXOSHIRO_H */
@@ -33,6 +33,7 @@
 
 #include "itype.h"
 #include "RandMT.h"
+#include "RandXoshiro.h"
 #include "BitVector.h"
 #include "FXP.h"
 #include "Fail.h"
@@ -43,6 +44,12 @@ namespace MFM
 
   /**
    * An interface for easy PRNG interaction.
+   *
+   * The generator behind it is chosen at compile time: the Mersenne
+   * Twister (RandMT) by default, or xoshiro256** (RandXoshiro) when
+   * MFM_RANDOM_XOSHIRO is defined -- e.g., by building with
+   * MFM_RANDOM=xoshiro.  The two give different streams for the
+   * same seed, but each is fully determined by its seed.
    */
   class Random
   {
@@ -73,7 +80,37 @@ namespace MFM
      */
     inline u32 Create()
     {
+#ifdef MFM_RANDOM_XOSHIRO
+      return _generator.Next32();
+#else
       return _generator.randomMT();
+#endif
+    }
+
+    /**
+     * Fills dest with count values, exactly as count calls to
+     * Create() would have, in one loop that can keep the generator
+     * state in registers.
+     */
+    void Fill(u32 * dest, u32 count)
+    {
+      for (u32 i = 0; i < count; ++i)
+      {
+        dest[i] = Create();
+      }
+    }
+
+    /**
+     * Fills dest with count values, exactly as count calls to
+     * Create(maxval) would have.  FAILs ILLEGAL_ARGUMENT if
+     * maxval==0.
+     */
+    void FillBelow(u32 * dest, u32 count, u32 maxval)
+    {
+      for (u32 i = 0; i < count; ++i)
+      {
+        dest[i] = Create(maxval);
+      }
     }
 
     /**
@@ -199,14 +236,39 @@ namespace MFM
      */
     void SetSeed(u32 seed)
     {
+#ifdef MFM_RANDOM_XOSHIRO
+      _generator.Seed(seed);
+#else
       _generator.seedMT_MFM(seed);
+#endif
       _bitsRemaining = 0;
+      _bitBuffer = 0;
+    }
+
+    /**
+     * Derives the seed for numbered stream \a stream of a run seeded
+     * with \a seed.  The result depends on nothing else, so, e.g., a
+     * tile seeded with GetStreamSeed(seed, tileNumber) sees the same
+     * stream however many other tiles there are or in what order
+     * they were seeded.  Distinct streams get well-separated seeds
+     * (SplitMix64 of the pair), and the result is never 0.
+     */
+    static u32 GetStreamSeed(u32 seed, u32 stream)
+    {
+      u64 x = (((u64) seed) << 32) | stream;
+      const u64 mixed = RandXoshiro::SplitMix64(x);
+      const u32 ret = (u32) (mixed >> 32);
+      return ret ? ret : 1;
     }
 
   private:
     s32 _bitsRemaining;
     u32 _bitBuffer;
+#ifdef MFM_RANDOM_XOSHIRO
+    RandXoshiro _generator;
+#else
     RandMT _generator;
+#endif
 
   };
 
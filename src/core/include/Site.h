@@ -1,6 +1,6 @@
 /*                                              -*- mode:C++ -*-
   Site.h A location for a single atom and associated state
-  Copyright (C) 2015 The Regents of the University of New Mexico.  All rights reserved.
+  Copyright (C) 2015, 2026 The Regents of the University of New Mexico.  All rights reserved.
 
   This library is free software; you can redistribute it and/or
   modify it under the terms of the GNU Lesser General Public
@@ -21,7 +21,7 @@
 /**
   \file Site.h A location for a single atom and associated state
   \author David H. Ackley.
-  \date (C) 2015 All rights reserved.
+  \date (C) 2015, 2026 All rights reserved.
   \lgpl
  */
 #ifndef SITE_H
@@ -36,61 +36,82 @@ namespace MFM
 {
 
   /**
-     A Site holds a Base and an Atom, and all information associated
-     with that Atom, such as access times, ages, and so forth.  It is
-     a template depending only on an AtomConfig (AC).
+     How a Tile arranges its sites in memory.  In
+     SITE_LAYOUT_ARRAY_OF_STRUCTS, the sites are stored as one array of
+     Site; in SITE_LAYOUT_STRUCT_OF_ARRAYS, the atoms, bases, and
+     SiteMetadata of all the sites are kept in three separate arrays,
+     so that code which only touches atoms (such as loading an event
+     window) touches far less memory.
    */
-  template <class AC>
-  class Site
+  enum SiteLayout
   {
-  public:
-    /**
-       Present the AtomConfig in use
-     */
-    typedef AC ATOM_CONFIG;
-
-    // Extract short names for parameter types
-    typedef typename ATOM_CONFIG::ATOM_TYPE T;
+    SITE_LAYOUT_ARRAY_OF_STRUCTS,
+    SITE_LAYOUT_STRUCT_OF_ARRAYS
+  };
 
-  private:
-    T m_atom;
-    Base<AC> m_base;
+  /**
+     The per-event bookkeeping of a site.
+   */
+  struct SiteMetadata
+  {
     u64 m_eventCount;
     u64 m_lastChangedEventCount;  // in units of Site event count
     u64 m_lastEventNumber;        // in units of total tile events
     bool m_isLiveSite;
 
-  public:
-    Site()
+    SiteMetadata()
       : m_eventCount(0)
       , m_lastChangedEventCount(0)
       , m_lastEventNumber(0)
       , m_isLiveSite(true)
     { }
+  };
 
+  /**
+     The operations on a site, given its atom, Base, and SiteMetadata.
+     Shared by Site, which holds those parts itself, and by SiteRef
+     and ConstSiteRef, which refer to them wherever a Tile keeps them.
+     IMPL provides AtomPart(), BasePart(), and MetadataPart().
+   */
+  template <class AC, class IMPL>
+  class SiteOperations
+  {
+  public:
+    typedef typename AC::ATOM_TYPE T;
+
+  private:
+    IMPL & Impl() { return static_cast<IMPL &>(*this); }
+    const IMPL & Impl() const { return static_cast<const IMPL &>(*this); }
+
+    SiteMetadata & Metadata() { return Impl().MetadataPart(); }
+    const SiteMetadata & Metadata() const { return Impl().MetadataPart(); }
+
+  public:
     void RecordEventAtSite(u64 eventNumber)
     {
-      ++m_eventCount;
-      m_lastEventNumber = eventNumber;
+      SiteMetadata & md = Metadata();
+      ++md.m_eventCount;
+      md.m_lastEventNumber = eventNumber;
     }
 
     void SaveConfig(ByteSink& bs, AtomTypeFormatter<AC> & atf) const
     {
-      bs.Printf(",%D", m_isLiveSite);
+      const SiteMetadata & md = Metadata();
+      bs.Printf(",%D", md.m_isLiveSite);
       // 64 bit stuff not yet exposed via Printf..
-      bs.Print(m_eventCount, Format::LXX64);
-      bs.Print(m_lastChangedEventCount, Format::LXX64);
-      bs.Print(m_lastEventNumber, Format::LXX64);
+      bs.Print(md.m_eventCount, Format::LXX64);
+      bs.Print(md.m_lastChangedEventCount, Format::LXX64);
+      bs.Print(md.m_lastEventNumber, Format::LXX64);
 
       {
-        T tmp = m_atom;
+        T tmp = GetAtom();
         bs.Printf(",");
         atf.PrintAtomType(tmp, bs);
         AtomSerializer<AC> as(tmp);
         bs.Printf(",%@", &as);
       }
 
-      m_base.SaveConfig(bs, atf);
+      GetBase().SaveConfig(bs, atf);
     }
 
     bool LoadConfig(LineCountingByteSource& bs, AtomTypeFormatter<AC> & atf)
@@ -126,22 +147,34 @@ namespace MFM
         }
       }
 
-      if (!m_base.LoadConfig(bs, atf))
+      if (!GetBase().LoadConfig(bs, atf))
         return false;
 
-      m_atom = defaultAtom;
+      GetAtom() = defaultAtom;
 
-      m_isLiveSite = tmp_m_isLiveSite;
-      m_eventCount = tmp_m_eventCount;
-      m_lastChangedEventCount = tmp_m_lastChangedEventCount;
-      m_lastEventNumber = tmp_m_lastEventNumber;
+      SiteMetadata & md = Metadata();
+      md.m_isLiveSite = tmp_m_isLiveSite;
+      md.m_eventCount = tmp_m_eventCount;
+      md.m_lastChangedEventCount = tmp_m_lastChangedEventCount;
+      md.m_lastEventNumber = tmp_m_lastEventNumber;
 
       return true;
     }
 
+    /**
+       Copy the atom, base, and metadata of \c other into this site.
+     */
+    template <class OTHER>
+    void CopyFrom(const SiteOperations<AC, OTHER> & other)
+    {
+      GetAtom() = other.GetAtom();
+      GetBase() = other.GetBase();
+      Metadata() = other.GetMetadata();
+    }
+
     void Sense(SiteTouchType stt)
     {
-      m_base.GetSensory().Touch(stt, m_eventCount);
+      GetBase().GetSensory().Touch(stt, Metadata().m_eventCount);
     }
 
     bool InRecentProximity() const
@@ -151,7 +184,7 @@ namespace MFM
 
     u32 RecentTouch() const
     {
-      return m_base.GetSensory().RecentTouch(m_eventCount);
+      return GetBase().GetSensory().RecentTouch(Metadata().m_eventCount);
     }
 
     bool HasRecentLightTouch()
@@ -159,12 +192,14 @@ namespace MFM
       return TOUCH_TYPE_LIGHT == RecentTouch();
     }
 
-    void PutAtom(const T & newAtom) { m_atom = newAtom; }
-    T & GetAtom() { return m_atom; }
-    const T & GetAtom() const { return m_atom; }
+    void PutAtom(const T & newAtom) { GetAtom() = newAtom; }
+    T & GetAtom() { return Impl().AtomPart(); }
+    const T & GetAtom() const { return Impl().AtomPart(); }
+
+    Base<AC> & GetBase() { return Impl().BasePart(); }
+    const Base<AC> & GetBase() const { return Impl().BasePart(); }
 
-    Base<AC> & GetBase() { return m_base; }
-    const Base<AC> & GetBase() const { return m_base; }
+    const SiteMetadata & GetMetadata() const { return Metadata(); }
 
     u32 GetPaint() const {
       return GetBase().GetPaint();
@@ -175,33 +210,151 @@ namespace MFM
     }
 
     void Clear() {
-      m_atom.SetEmpty();
-      m_eventCount = 0;
-      m_lastChangedEventCount = 0;
-      m_base.GetSensory().Clear();
+      SiteMetadata & md = Metadata();
+      GetAtom().SetEmpty();
+      md.m_eventCount = 0;
+      md.m_lastChangedEventCount = 0;
+      GetBase().GetSensory().Clear();
     }
 
     u64 GetEventCount() const {
-      return m_eventCount;
+      return Metadata().m_eventCount;
     }
 
     u64 GetLastChangedEventCount() const {
-      return m_lastChangedEventCount;
+      return Metadata().m_lastChangedEventCount;
     }
 
     void MarkChanged() {
-      m_lastChangedEventCount = m_eventCount;
+      SiteMetadata & md = Metadata();
+      md.m_lastChangedEventCount = md.m_eventCount;
     }
 
     u64 GetWriteAge() const {
-      return m_eventCount - m_lastChangedEventCount;
+      const SiteMetadata & md = Metadata();
+      return md.m_eventCount - md.m_lastChangedEventCount;
     }
 
     u64 GetEventAge(u64 currentEventNumber) const {
-      return m_lastEventNumber - currentEventNumber;
+      return Metadata().m_lastEventNumber - currentEventNumber;
     }
+  };
 
+  /**
+     A Site holds a Base and an Atom, and all information associated
+     with that Atom, such as access times, ages, and so forth.  It is
+     a template depending only on an AtomConfig (AC).
+   */
+  template <class AC>
+  class Site : public SiteOperations<AC, Site<AC> >
+  {
+  public:
+    /**
+       Present the AtomConfig in use
+     */
+    typedef AC ATOM_CONFIG;
+
+    // Extract short names for parameter types
+    typedef typename ATOM_CONFIG::ATOM_TYPE T;
+
+  private:
+    friend class SiteOperations<AC, Site<AC> >;
+
+    T m_atom;
+    Base<AC> m_base;
+    SiteMetadata m_metadata;
+
+    T & AtomPart() { return m_atom; }
+    const T & AtomPart() const { return m_atom; }
+    Base<AC> & BasePart() { return m_base; }
+    const Base<AC> & BasePart() const { return m_base; }
+    SiteMetadata & MetadataPart() { return m_metadata; }
+    const SiteMetadata & MetadataPart() const { return m_metadata; }
+  };
+
+  /**
+     A reference to a site held in a Tile, whatever its SiteLayout.
+     Offers the same operations as a Site, and is returned by value
+     from Tile::GetSite.
+   */
+  template <class AC>
+  class SiteRef : public SiteOperations<AC, SiteRef<AC> >
+  {
+  public:
+    typedef AC ATOM_CONFIG;
+    typedef typename ATOM_CONFIG::ATOM_TYPE T;
+
+    SiteRef(T & atom, Base<AC> & base, SiteMetadata & metadata)
+      : m_atom(&atom)
+      , m_base(&base)
+      , m_metadata(&metadata)
+    { }
+
+    SiteRef(Site<AC> & site)
+      : m_atom(&site.GetAtom())
+      , m_base(&site.GetBase())
+      , m_metadata(&const_cast<SiteMetadata &>(site.GetMetadata()))
+    { }
+
+  private:
+    friend class SiteOperations<AC, SiteRef<AC> >;
+
+    T * m_atom;
+    Base<AC> * m_base;
+    SiteMetadata * m_metadata;
+
+    T & AtomPart() { return *m_atom; }
+    const T & AtomPart() const { return *m_atom; }
+    Base<AC> & BasePart() { return *m_base; }
+    const Base<AC> & BasePart() const { return *m_base; }
+    SiteMetadata & MetadataPart() { return *m_metadata; }
+    const SiteMetadata & MetadataPart() const { return *m_metadata; }
   };
+
+  /**
+     A read-only SiteRef.
+   */
+  template <class AC>
+  class ConstSiteRef : public SiteOperations<AC, ConstSiteRef<AC> >
+  {
+  public:
+    typedef AC ATOM_CONFIG;
+    typedef typename ATOM_CONFIG::ATOM_TYPE T;
+
+    ConstSiteRef(const T & atom, const Base<AC> & base, const SiteMetadata & metadata)
+      : m_atom(&atom)
+      , m_base(&base)
+      , m_metadata(&metadata)
+    { }
+
+    ConstSiteRef(const Site<AC> & site)
+      : m_atom(&site.GetAtom())
+      , m_base(&site.GetBase())
+      , m_metadata(&site.GetMetadata())
+    { }
+
+    ConstSiteRef(const SiteRef<AC> & ref)
+      : m_atom(&ref.GetAtom())
+      , m_base(&ref.GetBase())
+      , m_metadata(&ref.GetMetadata())
+    { }
+
+    // Hide the mutable accessors, even when this reference itself isn't const
+    const T & GetAtom() const { return *m_atom; }
+    const Base<AC> & GetBase() const { return *m_base; }
+
+  private:
+    friend class SiteOperations<AC, ConstSiteRef<AC> >;
+
+    const T * m_atom;
+    const Base<AC> * m_base;
+    const SiteMetadata * m_metadata;
+
+    const T & AtomPart() const { return *m_atom; }
+    const Base<AC> & BasePart() const { return *m_base; }
+    const SiteMetadata & MetadataPart() const { return *m_metadata; }
+  };
+
 } /* namespace MFM */
 
 #endif /*SITE_H*/
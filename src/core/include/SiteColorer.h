@@ -0,0 +1,125 @@
+/*                                              -*- mode:C++ -*-
+  SiteColorer.h Choosing the colors that sites are drawn in
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file SiteColorer.h Choosing the colors that sites are drawn in
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef SITECOLORER_H
+#define SITECOLORER_H
+
+#include "itype.h"
+#include "Tile.h"
+#include "Site.h"
+#include "AtomColorCache.h"
+
+namespace MFM
+{
+  /**
+     The part of site rendering that decides what color each site is,
+     with nothing to do with where or how it gets drawn.  TileRenderer
+     uses it to paint through a Drawing, and FrameRenderer to fill a
+     plain memory buffer with no display at all, so the two always
+     agree on colors.
+   */
+  template <class EC>
+  class SiteColorer
+  {
+  public:
+    typedef typename EC::ATOM_CONFIG AC;
+    typedef typename AC::ATOM_TYPE T;
+    typedef Tile<EC> OurTile;
+    typedef ConstSiteRef<AC> OurSite;
+
+    enum DrawSiteType {
+      DRAW_SITE_ELEMENT,         //< Static color of event layer atom
+      DRAW_SITE_ATOM_1,          //< Dynamic per-atom rendering type 1
+      DRAW_SITE_ATOM_2,          //< Dynamic per-atom rendering type 2
+      DRAW_SITE_BASE,            //< Static color of base atom
+      DRAW_SITE_BASE_1,          //< Dynamic base-atom rendering type 1
+      DRAW_SITE_BASE_2,          //< Dynamic base-atom rendering type 2
+      DRAW_SITE_LIGHT_TILE,      //< Light grey rendering of tile regions
+      DRAW_SITE_DARK_TILE,       //< Dark grey rendering of hidden regions
+      DRAW_SITE_CHANGE_AGE,      //< CubeHelix rendering of events-since-change
+      DRAW_SITE_PAINT,           //< Last color painted on site
+      DRAW_SITE_NONE,            //< Do not draw atoms at all
+      DRAW_SITE_BLACK,           //< Fill with black
+      DRAW_SITE_WHITE,           //< Fill with white
+      DRAW_SITE_TYPE_COUNT
+    };
+
+    /**
+       What GetSiteColor found
+     */
+    enum SiteColorResult {
+      SITE_COLOR_NONE,           //< Draw nothing for this site
+      SITE_COLOR_SET,            //< Draw the returned color
+      SITE_COLOR_BAD             //< The atom is insane or of unknown type
+    };
+
+    SiteColorer() ;
+
+    static const char * GetDrawSiteTypeName(DrawSiteType t) ;
+
+    static bool IsDrawBase(DrawSiteType t)
+    {
+      return t >= DRAW_SITE_BASE && t <= DRAW_SITE_BASE_2;
+    }
+
+    /**
+       True if \c t colors whole tile regions rather than sites one
+       at a time (or, for DRAW_SITE_NONE, colors nothing).
+     */
+    static bool IsWholeTileType(DrawSiteType t)
+    {
+      return t == DRAW_SITE_NONE || t == DRAW_SITE_DARK_TILE || t == DRAW_SITE_LIGHT_TILE;
+    }
+
+    /**
+       The color DRAW_SITE_LIGHT_TILE uses for tile region \c region
+     */
+    u32 GetRegionColor(u32 region) const
+    {
+      MFM_API_ASSERT_ARG(region < OurTile::REGION_COUNT);
+      return m_regionColors[region];
+    }
+
+    /**
+       Choose the color \c site of \c tile is drawn in under \c
+       drawType, into \c color.  Whole-tile types (see
+       IsWholeTileType) and empty sites give SITE_COLOR_NONE.  If \c
+       eltp is non-null and the color came from an element, the
+       element is stored there, else null.  If \c cache is non-null,
+       dynamic atom colors are looked up in it before being computed.
+     */
+    SiteColorResult GetSiteColor(DrawSiteType drawType,
+                                 const OurSite & site, const OurTile & tile,
+                                 u32 & color, const Element<EC> ** eltp = 0,
+                                 AtomColorCache<EC> * cache = 0) const ;
+
+  private:
+    u32 m_regionColors[OurTile::REGION_COUNT];
+  };
+} /* namespace MFM */
+
+#include "SiteColorer.tcc"
+
+#endif /* SITECOLORER_H */
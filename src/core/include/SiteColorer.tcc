@@ -0,0 +1,132 @@
+/* -*- C++ -*- */
+#include <math.h>            /* For log10 */
+#include "Util.h"            /* For MIN, InterpolateColors */
+#include "ColorMap.h"        /* For CubeHelix */
+#include "Drawable.h"        /* For color names */
+
+namespace MFM
+{
+  template <class EC>
+  SiteColorer<EC>::SiteColorer()
+  {
+    m_regionColors[OurTile::REGION_CACHE] = InterpolateColors(Drawable::WHITE, Drawable::DARK_PURPLE, 100);
+    m_regionColors[OurTile::REGION_SHARED] = InterpolateColors(Drawable::WHITE, Drawable::DARK_PURPLE, 92);
+    m_regionColors[OurTile::REGION_VISIBLE] = InterpolateColors(Drawable::WHITE, Drawable::DARK_PURPLE, 84);
+    m_regionColors[OurTile::REGION_HIDDEN] = InterpolateColors(Drawable::WHITE, Drawable::DARK_PURPLE, 76);
+  }
+
+  template <class EC>
+  typename SiteColorer<EC>::SiteColorResult
+  SiteColorer<EC>::GetSiteColor(DrawSiteType drawType,
+                                const OurSite & site, const OurTile & tile,
+                                u32 & color, const Element<EC> ** eltp,
+                                AtomColorCache<EC> * cache) const
+  {
+    if (eltp) *eltp = 0;
+
+    u32 selector = 0;
+    bool fromBase = false;
+    switch (drawType)
+    {
+    default:
+      FAIL(ILLEGAL_STATE);
+
+    case DRAW_SITE_NONE:
+    case DRAW_SITE_DARK_TILE:
+    case DRAW_SITE_LIGHT_TILE:
+      // Flat backgrounds are handled per-tile..
+      return SITE_COLOR_NONE;
+
+    case DRAW_SITE_CHANGE_AGE:
+      {
+        const u32 writeAge = site.GetWriteAge();
+        const u32 MAX_IDX = 10000;       // Potential (interpolated) colors
+        const u32 AGE_PER_AEPS = 1; // Counting site events directly.., was: tile.GetSites();
+        const double MAX_EXPT = 4.0;     // 10**4.0 == 10kAEPS for fully black
+        const double LOG_SCALER = MAX_IDX/MAX_EXPT;
+        const double writeAgeAEPS = 1.0 * writeAge / AGE_PER_AEPS + 1;
+        const u32 colorIndex = MIN(MAX_IDX, (u32) (LOG_SCALER*log10(writeAgeAEPS)));
+        color =
+          ColorMap_CubeHelixRev::THE_INSTANCE.
+          GetInterpolatedColor(colorIndex,0,MAX_IDX,0xffff0000);
+      }
+      return SITE_COLOR_SET;
+
+    case DRAW_SITE_PAINT:
+      color = site.GetPaint();
+      return SITE_COLOR_SET;
+
+    case DRAW_SITE_BLACK:  color = 0xff000000; return SITE_COLOR_SET;
+    case DRAW_SITE_WHITE:  color = 0xffffffff; return SITE_COLOR_SET;
+    case DRAW_SITE_ELEMENT: break;
+    case DRAW_SITE_ATOM_1: selector = 1; break;
+    case DRAW_SITE_ATOM_2: selector = 2; break;
+
+    case DRAW_SITE_BASE: fromBase = true; break;
+    case DRAW_SITE_BASE_1: fromBase = true; selector = 1; break;
+    case DRAW_SITE_BASE_2: fromBase = true; selector = 2; break;
+    }
+
+    // Here if we need an atom-specific color
+
+    const T & atom = fromBase ? site.GetBase().GetBaseAtom() : site.GetAtom();
+    if (!atom.IsSane())
+    {
+      return SITE_COLOR_BAD;
+    }
+
+    u32 type = atom.GetType();
+
+    if (type == T::ATOM_EMPTY_TYPE) return SITE_COLOR_NONE;
+
+    const Element<EC> * elt = tile.GetElementTable().Lookup(type);
+    if (!elt)
+    {
+      return SITE_COLOR_BAD;
+    }
+
+    if (selector == 0)
+    {
+      color = elt->GetStaticColor();
+    }
+    else if (!cache)
+    {
+      color = elt->GetDynamicColor(tile.GetElementTable(), tile.GetUlamClassRegistry(), atom, selector);
+    }
+    else
+    {
+      if (!cache->Find(atom, selector, color))
+      {
+        color = elt->GetAtomColor(tile.GetElementTable(), tile.GetUlamClassRegistry(), atom, selector);
+        cache->Store(color);
+      }
+      color = elt->ModifyRenderColor(color);
+    }
+    if (eltp) *eltp = elt;
+    return SITE_COLOR_SET;
+  }
+
+  template <class EC>
+  const char * SiteColorer<EC>::GetDrawSiteTypeName(DrawSiteType t)
+  {
+    switch (t)
+    {
+    default:
+      FAIL(ILLEGAL_ARGUMENT);
+    case DRAW_SITE_BLACK:         return "Black";
+    case DRAW_SITE_WHITE:         return "White";
+    case DRAW_SITE_ELEMENT:       return "Element";
+    case DRAW_SITE_ATOM_1:        return "Atom #1";
+    case DRAW_SITE_ATOM_2:        return "Atom #2";
+    case DRAW_SITE_BASE:          return "Base";
+    case DRAW_SITE_BASE_1:        return "Base #1";
+    case DRAW_SITE_BASE_2:        return "Base #2";
+    case DRAW_SITE_LIGHT_TILE:    return "Light tile";
+    case DRAW_SITE_DARK_TILE:     return "Dark tile";
+    case DRAW_SITE_CHANGE_AGE:    return "Change age";
+    case DRAW_SITE_PAINT:         return "Site paint";
+    case DRAW_SITE_NONE:          return "None";
+    }
+  }
+
+} /* namespace MFM */
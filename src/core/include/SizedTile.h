@@ -48,6 +48,9 @@ namespace MFM
     enum { TILE_WIDTH = WIDTH };
     enum { TILE_HEIGHT = HEIGHT };
     enum { TILE_SITES = TILE_WIDTH * TILE_HEIGHT };
+    enum { WRITE_BLOCKS =
+           ((TILE_WIDTH + Tile<EC>::WRITE_BLOCK_SIDE - 1) / Tile<EC>::WRITE_BLOCK_SIDE) *
+           ((TILE_HEIGHT + Tile<EC>::WRITE_BLOCK_SIDE - 1) / Tile<EC>::WRITE_BLOCK_SIDE) };
 
     static void SetGridLayoutPattern(GridLayoutPattern layout){ m_ctorLayoutPattern = layout; }
 
@@ -55,11 +58,14 @@ namespace MFM
 
     static bool IsGridLayoutPatternStaggered() { return (m_ctorLayoutPattern == GRID_LAYOUT_STAGGERED); }
 
-    SizedTile(): Tile<EC>(TILE_WIDTH, TILE_HEIGHT, m_ctorLayoutPattern, m_sites, EVENTHISTORYSIZE, m_items) { }
+    SizedTile(): Tile<EC>(TILE_WIDTH, TILE_HEIGHT, m_ctorLayoutPattern, m_sites, m_liveSites, m_occupancy, m_writeGenerations, EVENTHISTORYSIZE, m_items) { }
 
 
   private:
-    SITE m_sites[TILE_SITES];
+    SITE m_sites[TILE_SITES + 1];  // +1 for SITE_LAYOUT_STRUCT_OF_ARRAYS slack
+    bool m_liveSites[TILE_SITES];
+    u32 m_occupancy[2 * TILE_SITES];
+    u32 m_writeGenerations[WRITE_BLOCKS];
     EventHistoryItem m_items[EVENTHISTORYSIZE];
     static GridLayoutPattern m_ctorLayoutPattern;
 
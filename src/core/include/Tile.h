@@ -38,12 +38,15 @@
 #include "Point.h"
 #include "Element.h"
 #include "Site.h"
+#include "MDist.h"   /* for EVENT_WINDOW_SITES */
 #include "EventWindow.h"
 #include "EventHistoryItem.h"
 #include "ElementTable.h"
 #include "CacheProcessor.h"
 #include "UlamClassRegistry.h"
 #include "LonglivedLock.h"
+#include "OccupancyIndex.h"
+#include "TileCounters.h"
 #include "OverflowableCharBufferByteSink.h"  /* for OString16 */
 #include "LineCountingByteSource.h"
 
@@ -90,6 +93,13 @@ namespace MFM
     typedef typename AC::ATOM_TYPE T;
     typedef typename EC::SITE S;
 
+    /**
+     * What GetSite returns: a proxy for a site, valid in either
+     * SiteLayout.  Copies refer to the same site.
+     */
+    typedef SiteRef<AC> SiteReference;
+    typedef ConstSiteRef<AC> ConstSiteReference;
+
     // Promote some parameter names
     enum { EVENT_WINDOW_RADIUS = EC::EVENT_WINDOW_RADIUS };
 
@@ -99,6 +109,29 @@ namespace MFM
      */
     enum { ELEMENT_TABLE_SIZE = 1u<<AC::ATOM_TYPE_BITS };
 
+    /**
+     * The number of sites in a full-radius event window.
+     */
+    enum { EVENT_WINDOW_SITE_COUNT = EVENT_WINDOW_SITES(EVENT_WINDOW_RADIUS) };
+
+    /**
+     * The side length, in sites, of the square blocks whose writes
+     * are tracked by write generation.  See GetWriteGeneration.
+     */
+    enum { WRITE_BLOCK_SIDE = 8 };
+
+    /**
+     * The number of write-tracking blocks in a tile of \c tileWidth
+     * by \c tileHeight sites, with partial blocks at the right and
+     * bottom edges counting as whole ones.
+     */
+    static u32 GetWriteBlockCount(u32 tileWidth, u32 tileHeight)
+    {
+      return
+        ((tileWidth + WRITE_BLOCK_SIDE - 1) / WRITE_BLOCK_SIDE) *
+        ((tileHeight + WRITE_BLOCK_SIDE - 1) / WRITE_BLOCK_SIDE);
+    }
+
     /**
      * The length of a side of this Tile in sites.
      */
@@ -137,7 +170,19 @@ namespace MFM
       REGION_COUNT
     };
 
-    Tile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, S * sites, const u32 eventbuffersize, EventHistoryItem * items) ;
+    /**
+     * Construct a Tile of \c tileWidth by \c tileHeight sites, held in
+     * \c sites, which must have room for tileWidth * tileHeight + 1
+     * sites -- the extra one providing alignment slack for
+     * SITE_LAYOUT_STRUCT_OF_ARRAYS.  The tile starts out in
+     * SITE_LAYOUT_ARRAY_OF_STRUCTS.  \c liveSites must have room for
+     * tileWidth * tileHeight flags, and is used to remember which
+     * sites are live.  \c occupancy must have room for 2 * tileWidth
+     * * tileHeight u32s, for the OccupancyIndex used by
+     * SITE_SAMPLING_OCCUPIED.  \c writeGenerations must have room for
+     * GetWriteBlockCount(tileWidth, tileHeight) u32s.
+     */
+    Tile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, S * sites, bool * liveSites, u32 * occupancy, u32 * writeGenerations, const u32 eventbuffersize, EventHistoryItem * items) ;
 
     ~Tile() ;
 
@@ -187,9 +232,9 @@ namespace MFM
        tile, \e including the caches, so index ranges from
        0..TILE_WIDTH-1 in x, and 0..TILE_HEIGHT-1 in y
      */
-    const S & GetSite(const SPoint index) const
+    ConstSiteReference GetSite(const SPoint index) const
     {
-      return m_sites[GetSiteInTileNumber(index)];
+      return GetSiteByNumber(GetSiteInTileNumber(index));
     }
 
     /**
@@ -197,9 +242,9 @@ namespace MFM
        tile, \e including the caches, so index ranges from
        0..TILE_WIDTH-1 in x, and 0..TILE_HEIGHT-1 in y
      */
-    S & GetSite(const SPoint index)
+    SiteReference GetSite(const SPoint index)
     {
-      return const_cast<S &>(static_cast<const Tile<EC>*>(this)->GetSite(index));
+      return GetSiteByNumber(GetSiteInTileNumber(index));
     }
 
     /**
@@ -207,7 +252,7 @@ namespace MFM
        tile, \e excluding the caches, so index ranges from
        0..OWNED_WIDTH-1 in x, and 0..OWNED_HEIGHT-1 in y
      */
-    const S & GetUncachedSite(const SPoint index) const
+    ConstSiteReference GetUncachedSite(const SPoint index) const
     {
       return GetSite(index + SPoint(EVENT_WINDOW_RADIUS,EVENT_WINDOW_RADIUS));
     }
@@ -217,11 +262,25 @@ namespace MFM
        tile, \e excluding the caches, so index ranges from
        0..OWNED_WIDTH-1 in x, and 0..OWNED_HEIGHT-1 in y
      */
-    S & GetUncachedSite(const SPoint index)
+    SiteReference GetUncachedSite(const SPoint index)
     {
       return GetSite(index + SPoint(EVENT_WINDOW_RADIUS,EVENT_WINDOW_RADIUS));
     }
 
+    /**
+       Get the SiteLayout currently used by this tile's site storage.
+     */
+    SiteLayout GetSiteLayout() const
+    {
+      return m_siteLayout;
+    }
+
+    /**
+       Rearrange this tile's site storage into \c layout, preserving
+       the contents of every site.  Tile must not be running.
+     */
+    void SetSiteLayout(SiteLayout layout) ;
+
     /**
        Get the coordinate of a randomly selected 'owned' site in this
        tile.  An owned site is one that can be at the center of an
@@ -232,6 +291,41 @@ namespace MFM
       return OwnedCoordToTile(SPoint(GetRandom(), OWNED_WIDTH, OWNED_HEIGHT));
     }
 
+    /**
+       Get the coordinate of a randomly selected occupied (non-Empty)
+       owned site in this tile, or of a random owned site, as by
+       GetRandomOwnedCoord, if there are none.  Maintains the
+       occupancy index, rebuilding it first if needed.
+     */
+    SPoint GetRandomOccupiedCoord() ;
+
+    /**
+       Get the number of occupied (non-Empty) owned sites in this
+       tile, rebuilding the occupancy index first if needed.
+     */
+    u32 GetOccupiedSiteCount() ;
+
+    /**
+       Get how this tile chooses its event centers.
+     */
+    SiteSampling GetSiteSampling() const
+    {
+      return m_siteSampling;
+    }
+
+    /**
+       Set how this tile chooses its event centers.  With
+       SITE_SAMPLING_OCCUPIED, AdvanceComputation draws only occupied
+       owned sites, and each event that occurs at one is followed by
+       a credit of inert events, averaging (empty sites / occupied
+       sites), standing in for the events the skipped empty sites
+       would have received under SITE_SAMPLING_UNIFORM.  AEPS is thus
+       comparable between the two, and occupied sites still go
+       through RejectOnRecency, but the credited events are not
+       recorded in the empty sites themselves.
+     */
+    void SetSiteSampling(SiteSampling sampling) ;
+
     u32 GetAtomCount(ElementType atomType) const
     {
       return m_cdata.GetAtomCount(atomType);
@@ -294,6 +388,115 @@ namespace MFM
 
     S * const m_sites;
 
+    /** How m_sites is currently arranged */
+    SiteLayout m_siteLayout;
+
+    /** Where the atoms, bases, and metadata of site number 0 are, and
+        the distance in bytes from each to that of the next site
+        number.  In SITE_LAYOUT_ARRAY_OF_STRUCTS these all point into
+        m_sites[0], with stride sizeof(S); in
+        SITE_LAYOUT_STRUCT_OF_ARRAYS they are three packed arrays
+        carved out of m_sites. */
+    u8 * m_atoms;
+    u8 * m_bases;
+    u8 * m_metadata;
+    u32 m_atomStride;
+    u32 m_baseStride;
+    u32 m_metadataStride;
+
+    const T & AtomAt(u32 siteNumber) const
+    {
+      return *reinterpret_cast<const T *>(m_atoms + siteNumber * m_atomStride);
+    }
+
+    ConstSiteReference GetSiteByNumber(u32 siteNumber) const
+    {
+      return ConstSiteReference(AtomAt(siteNumber),
+                                *reinterpret_cast<const Base<AC> *>(m_bases + siteNumber * m_baseStride),
+                                *reinterpret_cast<const SiteMetadata *>(m_metadata + siteNumber * m_metadataStride));
+    }
+
+    SiteReference GetSiteByNumber(u32 siteNumber)
+    {
+      return SiteReference(*reinterpret_cast<T *>(m_atoms + siteNumber * m_atomStride),
+                           *reinterpret_cast<Base<AC> *>(m_bases + siteNumber * m_baseStride),
+                           *reinterpret_cast<SiteMetadata *>(m_metadata + siteNumber * m_metadataStride));
+    }
+
+    /** Whether each site, by site-in-tile number, is live.  Depends
+        only on tile geometry and connectivity, so is recomputed by
+        InitLiveSites whenever the tile is connected. */
+    bool * const m_liveSites;
+
+    /** See GetWindowSiteOffsets */
+    s32 m_windowSiteOffsets[EVENT_WINDOW_SITE_COUNT];
+
+    /** How AdvanceComputation picks event centers */
+    SiteSampling m_siteSampling;
+
+    /** The occupied owned sites, by site-in-tile number.  Only
+        maintained while m_occupancyValid. */
+    OccupancyIndex m_occupancy;
+
+    /** false when m_occupancy must be rebuilt before use.  Mutable,
+        like m_cdata, so NeedAtomRecount can clear it. */
+    mutable bool m_occupancyValid;
+
+    /** The write generation of each WRITE_BLOCK_SIDE square block of
+        sites, row by row.  See GetWriteGeneration. */
+    u32 * const m_writeGenerations;
+
+    /** Bumped for each site write.  Mutable, like m_cdata, so
+        NeedAtomRecount can bump it. */
+    mutable u32 m_writeGeneration;
+
+    u32 GetWriteBlocksWide() const
+    {
+      return (TILE_WIDTH + WRITE_BLOCK_SIDE - 1) / WRITE_BLOCK_SIDE;
+    }
+
+    /**
+       Stamp the block holding \c site, in tile coordinates, with a
+       new write generation
+     */
+    void NoteSiteWritten(const SPoint & site)
+    {
+      m_writeGenerations[(site.GetY() / WRITE_BLOCK_SIDE) * GetWriteBlocksWide() +
+                         site.GetX() / WRITE_BLOCK_SIDE] = ++m_writeGeneration;
+    }
+
+    /**
+       Stamp every block with a new write generation
+     */
+    void NoteAllSitesWritten() const ;
+
+    /**
+       Rebuild m_occupancy by scanning the owned sites.
+     */
+    void RebuildOccupancy() ;
+
+    /**
+       Credit the events that the empty owned sites would have had,
+       under SITE_SAMPLING_UNIFORM, for one event at an occupied site.
+     */
+    void CreditSkippedEvents() ;
+
+    /**
+       Recompute m_liveSites from the current connectivity.
+     */
+    void InitLiveSites() ;
+
+    /**
+       The uncached computation behind IsLiveSite.
+     */
+    bool ComputeIsLiveSite(const SPoint & location) const ;
+
+    /**
+       Point m_atoms, m_bases, and m_metadata at freshly-constructed
+       site storage in m_sites, arranged according to \c layout.
+     */
+    void InitSiteStorage(SiteLayout layout) ;
+
     /**
      * A brief name or label for this Tile, for reporting and debugging
      */
@@ -366,11 +569,21 @@ namespace MFM
     const UlamClassRegistry<EC> & GetUlamClassRegistry() const { return m_ucr; }
 
     /**
-     * A minimal iterator over the Sites of a tile.  Access via Tile::begin().
+     * A minimal iterator over the Sites of a tile.  Access via
+     * Tile::begin().  Dereferencing yields a SiteReference (or
+     * ConstSiteReference) by value.
      */
     template <class SITETYPE, class TILETYPE>
     class TileIterator
     {
+      /** Holds the site reference that operator-> points into */
+      struct Arrow
+      {
+        SITETYPE m_ref;
+        Arrow(const SITETYPE & ref) : m_ref(ref) { }
+        SITETYPE * operator->() { return &m_ref; }
+      };
+
       TILETYPE & t;
       const u32 INDENT;
       s32 i;
@@ -410,14 +623,14 @@ namespace MFM
       }
       */
 
-      SITETYPE & operator*() const
+      SITETYPE operator*() const
       {
         return t.GetSite(AtSite());
       }
 
-      SITETYPE * operator->() const
+      Arrow operator->() const
       {
-        return &t.GetSite(AtSite());
+        return Arrow(t.GetSite(AtSite()));
       }
 
       /* AtSite() etc methods are always absolute full Tile coords */
@@ -432,8 +645,8 @@ namespace MFM
 
     };
 
-    typedef TileIterator< S, Tile<EC> > iterator_type;
-    typedef TileIterator< const S, const Tile<EC> > const_iterator_type;
+    typedef TileIterator< SiteReference, Tile<EC> > iterator_type;
+    typedef TileIterator< ConstSiteReference, const Tile<EC> > const_iterator_type;
 
     iterator_type beginAll() {
       return iterator_type(*this, 0, 0, 0);
@@ -491,12 +704,15 @@ namespace MFM
     struct CountData {
       CountData(const Tile& t)
         : m_tile(t)
+        , m_illegalAtomCount(0)
+        , m_needRecount(true)
       { }
 
       const Tile & m_tile;
 
-      /** A cache of the number of each type of Atom currently held
-          within this Tile.  */
+      /** The number of each type of Atom currently held within the
+          owned sites of this Tile, kept up to date as atoms are
+          placed, and rebuilt by RecountAtoms after bulk changes.  */
       u32 m_atomCount[ELEMENT_TABLE_SIZE];
 
       u32 m_illegalAtomCount;
@@ -506,6 +722,30 @@ namespace MFM
 
       void RecountAtoms() ;
 
+      /**
+         Rescan the owned sites and compare with the counts, which are
+         rebuilt if they disagree.  Returns true if they agreed.
+       */
+      bool CheckCounts() ;
+
+      /**
+         Account for an owned site changing from an atom of \c
+         oldType to one of \c newType
+       */
+      void NoteTypeChange(u32 oldType, u32 newType)
+      {
+        if (m_needRecount || oldType == newType)
+        {
+          return;
+        }
+        const s32 oldIdx = m_tile.m_elementTable.GetIndex(oldType);
+        const s32 newIdx = m_tile.m_elementTable.GetIndex(newType);
+        if (oldIdx < 0) --m_illegalAtomCount;
+        else --m_atomCount[oldIdx];
+        if (newIdx < 0) ++m_illegalAtomCount;
+        else ++m_atomCount[newIdx];
+      }
+
       void RecountIfNeeded()
       {
         if (m_needRecount)
@@ -540,6 +780,12 @@ namespace MFM
     /** Total times we successfully acquired a lock in this Tile */
     u64 m_lockAttemptsSucceeded;
 
+    /** Hot-path instrumentation, written only by this Tile's thread */
+    TileCounters m_counters;
+
+    /** Sampled event costs by element, written likewise */
+    ElementProfile m_elementProfile;
+
     /**
      * The coord of the last event (the one that caused
      * m_lastEventEventNumber to change most recently).
@@ -653,6 +899,23 @@ namespace MFM
     bool AdvanceCommunication() ;
 
    public:
+    /**
+       Attempt an event centered at owned tile coordinate \c pt, as
+       AdvanceComputation does.  If the atom there belongs to an inert
+       Element, the event is just counted (see
+       EventWindow::TryInertEventAt); otherwise it is run in full.
+       Return true if an event occurred.
+     */
+    bool TryEventAt(const SPoint & pt) ;
+
+    /**
+       Pick an event center as GetSiteSampling() dictates and
+       TryEventAt it, crediting skipped events as needed.  This is
+       the whole of AdvanceComputation, once the tile is known to be
+       active and enabled.  Return true if an event occurred.
+     */
+    bool TryRandomEvent() ;
+
     void SetBackgroundRadiationEnabled(bool value);
 
     void SetForegroundRadiationEnabled(bool value);
@@ -694,11 +957,59 @@ namespace MFM
     }
 
     /**
-     * Flag that the atom counts in this tile may have changed
+     * Flag that the atom counts in this tile may have changed.
+     * PlaceAtom keeps them current on its own; this is for changes
+     * made behind its back, like XRay, or writes through
+     * GetWritableAtom.
      */
     void NeedAtomRecount() const
     {
       m_cdata.NeedAtomRecount();
+      m_occupancyValid = false;
+      NoteAllSitesWritten();
+    }
+
+    /**
+     * Get this tile's current write generation, a counter bumped by
+     * every change to the contents of a site, through PlaceAtom or
+     * (for all sites at once) NeedAtomRecount.  Each
+     * WRITE_BLOCK_SIDE square block of sites remembers the generation
+     * of its latest write, so a renderer that notes the generation
+     * when it paints the tile can later repaint just the blocks that
+     * IsBlockWrittenSince then.
+     */
+    u32 GetWriteGeneration() const
+    {
+      return m_writeGeneration;
+    }
+
+    /**
+     * Has any site in the write-tracking block at \c blockX, \c
+     * blockY (in blocks, from the tile's top left, caches included)
+     * been written since this tile's write generation was \c
+     * generation?  Blocks outside the tile never have been.
+     */
+    bool IsBlockWrittenSince(s32 blockX, s32 blockY, u32 generation) const
+    {
+      const s32 blocksWide = (s32) GetWriteBlocksWide();
+      const s32 blocksHigh = (s32) ((TILE_HEIGHT + WRITE_BLOCK_SIDE - 1) / WRITE_BLOCK_SIDE);
+      if (blockX < 0 || blockY < 0 || blockX >= blocksWide || blockY >= blocksHigh)
+      {
+        return false;
+      }
+      // Compared by difference so the counter can wrap
+      return (s32) (m_writeGenerations[blockY * blocksWide + blockX] - generation) > 0;
+    }
+
+    /**
+     * Debug check: rescan this tile's owned sites and compare with
+     * its incrementally maintained atom counts, logging and repairing
+     * any disagreement.  Returns true if they agreed (or were due for
+     * a recount anyway).
+     */
+    bool CheckAtomCounts() const
+    {
+      return m_cdata.CheckCounts();
     }
 
     CacheProcessor<EC> & GetCacheProcessor(Dir toCache) ;
@@ -770,11 +1081,68 @@ namespace MFM
       return m_window.GetEventWindowsExecuted();
     }
 
+    /**
+     * Like GetEventsExecuted, but may be called from threads other
+     * than the one running this Tile, without pausing it.  The result
+     * may be slightly stale.
+     */
+    u64 SampleEventsExecuted() const
+    {
+      return m_window.SampleEventWindowsExecuted();
+    }
+
     u64 GetSitesAccessed() const
     {
       return m_window.GetSitesAccessed();
     }
 
+    /**
+     * Gets how many of the GetEventsExecuted() events were on atoms
+     * of inert Elements, and so were counted without being run.
+     */
+    u64 GetInertEventsExecuted() const
+    {
+      return m_window.GetInertEventsExecuted();
+    }
+
+    /**
+     * The hot-path instrumentation counters of this Tile, for the
+     * code advancing it to update.
+     */
+    TileCounters & GetCounters()
+    {
+      return m_counters;
+    }
+
+    /**
+     * The sampling profile of this Tile's event costs by element,
+     * indexed by ElementTable index.  Disabled until given a sampling
+     * rate.
+     */
+    ElementProfile & GetElementProfile()
+    {
+      return m_elementProfile;
+    }
+
+    const ElementProfile & GetElementProfile() const
+    {
+      return m_elementProfile;
+    }
+
+    /**
+     * Copy this Tile's instrumentation counters, including the event
+     * totals kept by its EventWindow, into \c into.  Like
+     * SampleEventsExecuted, may be called from other threads without
+     * pausing this Tile.
+     */
+    void SampleCounters(TileCounters & into) const
+    {
+      m_counters.Sample(into);
+      into.Set(TileCounters::EVENTS_ATTEMPTED, m_window.SampleEventWindowsAttempted());
+      into.Set(TileCounters::EVENTS_EXECUTED, m_window.SampleEventWindowsExecuted());
+      into.Set(TileCounters::FAST_PATH_EVENTS, m_window.SampleInertEventsExecuted());
+    }
+
     EventWindow<EC> & GetEventWindow()
     {
       return m_window;
@@ -1052,6 +1420,38 @@ namespace MFM
      */
     bool IsLiveSite(const SPoint & location) const;
 
+    /**
+     * Like IsLiveSite, but taking a site-in-tile number (see
+     * GetSiteInTileNumber) rather than a location.
+     */
+    bool IsLiveSiteNumber(u32 siteNumber) const
+    {
+      MFM_API_ASSERT_ARG(siteNumber < TILE_WIDTH * TILE_HEIGHT);
+      return m_liveSites[siteNumber];
+    }
+
+    /**
+     * Get the atom at a site-in-tile number (see
+     * GetSiteInTileNumber).
+     */
+    const T & GetAtomAtSiteNumber(u32 siteNumber) const
+    {
+      MFM_API_ASSERT_ARG(siteNumber < TILE_WIDTH * TILE_HEIGHT);
+      return AtomAt(siteNumber);
+    }
+
+    /**
+     * Get the offsets from the site-in-tile number of an event
+     * window's center to those of each of its sites, indexed by event
+     * window site number.  Adding offset \c i to the site number of
+     * an owned site gives the site number of the site at
+     * MDist<R>::GetPoint(i) from it.
+     */
+    const s32 * GetWindowSiteOffsets() const
+    {
+      return m_windowSiteOffsets;
+    }
+
     /**
      * Checks to see if a specified local point is a site that
      * currently might receive cache protocol updates in this
@@ -1181,7 +1581,7 @@ namespace MFM
 
     const T* GetAtomInSite(bool getFromBase, const SPoint & pt) const
     {
-      const S & site = GetSite(pt);
+      ConstSiteReference site = GetSite(pt);
       if (getFromBase)
         return &site.GetBase().GetBaseAtom();
       else
@@ -1201,8 +1601,22 @@ namespace MFM
      */
     const T GetAtomForEventWindow(const SPoint & pt) const
     {
-      const S & site = GetSite(pt);
-      T atom = site.GetAtom();
+      T atom = AtomAt(GetSiteInTileNumber(pt));
+      if (m_foregroundRadiationEnabled)
+      {
+        FAIL(INCOMPLETE_CODE);
+      }
+      return atom;
+    }
+
+    /**
+     * Like GetAtomForEventWindow(const SPoint &), but taking a
+     * site-in-tile number (see GetSiteInTileNumber) rather than a
+     * location.
+     */
+    const T GetAtomForEventWindow(u32 siteNumber) const
+    {
+      T atom = GetAtomAtSiteNumber(siteNumber);
       if (m_foregroundRadiationEnabled)
       {
         FAIL(INCOMPLETE_CODE);
@@ -1226,8 +1640,7 @@ namespace MFM
      */
     T* GetWritableAtom(const SPoint & pt)
     {
-      S & site = GetSite(pt);
-      return &site.GetAtom();
+      return const_cast<T *>(&AtomAt(GetSiteInTileNumber(pt)));
     }
 
     /**
@@ -1507,6 +1920,7 @@ namespace MFM
     void RegisterElement(const Element<EC> & anElement)
     {
       m_elementTable.RegisterElement(anElement);
+      NeedAtomRecount();  // Atoms of its type were being counted as illegal
     }
 
   public:
@@ -6,11 +6,12 @@
 #include "EventHistoryBuffer.h"
 
 #include "Util.h"
+#include <new>  /* For placement new */
 
 namespace MFM
 {
   template <class EC>
-  Tile<EC>::Tile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, S * sites, const u32 eventbuffersize, EventHistoryItem * items)
+  Tile<EC>::Tile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, S * sites, bool * liveSites, u32 * occupancy, u32 * writeGenerations, const u32 eventbuffersize, EventHistoryItem * items)
     : TILE_WIDTH(tileWidth)
     , TILE_HEIGHT(tileHeight)
     , OWNED_WIDTH(TILE_WIDTH - 2 * EVENT_WINDOW_RADIUS)  // This OWNED_SIDE computation is duplicated in Grid.h!
@@ -18,6 +19,19 @@ namespace MFM
     , GRID_LAYOUT(gridlayout)
     , DUMMY_TILE(false)
     , m_sites(sites)
+    , m_siteLayout(SITE_LAYOUT_ARRAY_OF_STRUCTS)
+    , m_atoms(0)
+    , m_bases(0)
+    , m_metadata(0)
+    , m_atomStride(0)
+    , m_baseStride(0)
+    , m_metadataStride(0)
+    , m_liveSites(liveSites)
+    , m_siteSampling(SITE_SAMPLING_UNIFORM)
+    , m_occupancy(occupancy, tileWidth * tileHeight)
+    , m_occupancyValid(false)
+    , m_writeGenerations(writeGenerations)
+    , m_writeGeneration(0)
     , m_cdata(*this)
     , m_lockAttempts(0)
     , m_lockAttemptsSucceeded(0)
@@ -33,12 +47,29 @@ namespace MFM
   {
     // TILE sides can't be too small, and we must apparently have sites, but not necessarily hidden ones.
     // Effort to avoid simultaneous locks in opposite directions (e.g. East and West);
-    MFM_API_ASSERT_ARG(TILE_WIDTH >= 6*EVENT_WINDOW_RADIUS && TILE_HEIGHT >= 6*EVENT_WINDOW_RADIUS && m_sites != 0);
+    MFM_API_ASSERT_ARG(TILE_WIDTH >= 6*EVENT_WINDOW_RADIUS && TILE_HEIGHT >= 6*EVENT_WINDOW_RADIUS && m_sites != 0 && m_liveSites != 0 && m_writeGenerations != 0);
+
+    // Every ElementTable index needs an ElementProfile slot
+    COMPILATION_REQUIREMENT<(ElementTable<EC>::SIZE < (u32) ElementProfile::SLOTS)>();
 
     // Require even TILE side dimensions.
     MFM_API_ASSERT_ARG(2 * TILE_WIDTH / 2 == TILE_WIDTH);
     MFM_API_ASSERT_ARG(2 * TILE_HEIGHT / 2 == TILE_HEIGHT);
 
+    InitSiteStorage(SITE_LAYOUT_ARRAY_OF_STRUCTS);
+
+    for (u32 i = GetWriteBlockCount(TILE_WIDTH, TILE_HEIGHT); i-- > 0; )
+    {
+      m_writeGenerations[i] = 0;
+    }
+
+    const MDist<EVENT_WINDOW_RADIUS> & md = MDist<EVENT_WINDOW_RADIUS>::get();
+    for (u32 i = 0; i < EVENT_WINDOW_SITE_COUNT; ++i)
+    {
+      const SPoint & offset = md.GetPoint(i);
+      m_windowSiteOffsets[i] = offset.GetY() * (s32) TILE_WIDTH + offset.GetX();
+    }
+
     //staggered grid layout ignores NORTH & SOUTH directions
     if(IsTileGridLayoutStaggered())
       {
@@ -57,12 +88,73 @@ namespace MFM
 	MFM_API_ASSERT_STATE(counter == m_dirIterator.GetLimit());
       }
 
+    InitLiveSites();
     Init();
   }
 
   template <class EC>
   Tile<EC>::~Tile() {/* defined to avoid inline error */}
 
+  template <class EC>
+  void Tile<EC>::InitSiteStorage(SiteLayout layout)
+  {
+    const u32 sites = TILE_WIDTH * TILE_HEIGHT;
+    if (layout == SITE_LAYOUT_ARRAY_OF_STRUCTS)
+    {
+      S * s = new (m_sites) S[sites];
+      m_atoms = (u8 *) &s[0].GetAtom();
+      m_bases = (u8 *) &s[0].GetBase();
+      m_metadata = (u8 *) &s[0].GetMetadata();
+      m_atomStride = m_baseStride = m_metadataStride = sizeof(S);
+    }
+    else
+    {
+      MFM_API_ASSERT_ARG(layout == SITE_LAYOUT_STRUCT_OF_ARRAYS);
+
+      // Carve three arrays out of the storage for sites+1 Sites,
+      // each aligned well enough for anything a Site holds
+      const u32 ALIGN = 8;
+      const u32 atomOffset = 0;
+      const u32 baseOffset = (atomOffset + sites * sizeof(T) + ALIGN - 1) & ~(ALIGN - 1);
+      const u32 metadataOffset = (baseOffset + sites * sizeof(Base<AC>) + ALIGN - 1) & ~(ALIGN - 1);
+      const u32 end = metadataOffset + sites * sizeof(SiteMetadata);
+      MFM_API_ASSERT_STATE(end <= (sites + 1) * sizeof(S));
+
+      u8 * storage = (u8 *) m_sites;
+      m_atoms = (u8 *) new (storage + atomOffset) T[sites];
+      m_bases = (u8 *) new (storage + baseOffset) Base<AC>[sites];
+      m_metadata = (u8 *) new (storage + metadataOffset) SiteMetadata[sites];
+      m_atomStride = sizeof(T);
+      m_baseStride = sizeof(Base<AC>);
+      m_metadataStride = sizeof(SiteMetadata);
+    }
+    m_siteLayout = layout;
+  }
+
+  template <class EC>
+  void Tile<EC>::SetSiteLayout(SiteLayout layout)
+  {
+    if (layout == m_siteLayout)
+    {
+      return;
+    }
+
+    const u32 sites = TILE_WIDTH * TILE_HEIGHT;
+    S * saved = new S[sites];
+    for (u32 sn = 0; sn < sites; ++sn)
+    {
+      saved[sn].CopyFrom(GetSiteByNumber(sn));
+    }
+
+    InitSiteStorage(layout);
+
+    for (u32 sn = 0; sn < sites; ++sn)
+    {
+      GetSiteByNumber(sn).CopyFrom(saved[sn]);
+    }
+    delete [] saved;
+  }
+
   template <class EC>
   void Tile<EC>::SaveTile(ByteSink & to) const
   {
@@ -127,9 +219,20 @@ namespace MFM
 
   }
 
+  template <class EC>
+  void Tile<EC>::NoteAllSitesWritten() const
+  {
+    const u32 generation = ++m_writeGeneration;
+    for (u32 i = GetWriteBlockCount(TILE_WIDTH, TILE_HEIGHT); i-- > 0; )
+    {
+      m_writeGenerations[i] = generation;
+    }
+  }
+
   template <class EC>
   const Element<EC> * Tile<EC>::ReplaceEmptyElement(const Element<EC>& newEmptyElement)
   {
+    NeedAtomRecount();
     return m_elementTable.ReplaceEmptyElement(newEmptyElement);
   }
 
@@ -144,6 +247,7 @@ namespace MFM
   {
     Random & random = GetRandom();
     GetWritableAtom(at)->XRay(random, bitOdds);
+    NeedAtomRecount();
   }
 
   template <class EC>
@@ -154,6 +258,7 @@ namespace MFM
       if (random.OneIn(siteOdds))
         i->GetAtom().XRay(random, bitOdds);
     }
+    NeedAtomRecount();
   }
 
   template <class EC>
@@ -164,6 +269,7 @@ namespace MFM
       if (random.OneIn(siteOdds))
         i->Clear();
     }
+    NeedAtomRecount();
   }
 
   template <class EC>
@@ -183,6 +289,85 @@ namespace MFM
     MFM_API_ASSERT_STATE(!cxn.IsConnected());
 
     cxn.ClaimCacheProcessor(*this, channel, lock, toCache);
+
+    InitLiveSites();  // Cache sites may have come alive
+  }
+
+  template <class EC>
+  void Tile<EC>::InitLiveSites()
+  {
+    for (u32 sn = 0; sn < TILE_WIDTH * TILE_HEIGHT; ++sn)
+    {
+      m_liveSites[sn] = ComputeIsLiveSite(GetCoordOfSiteInTileNumber(sn));
+    }
+    m_occupancyValid = false;
+  }
+
+  template <class EC>
+  void Tile<EC>::RebuildOccupancy()
+  {
+    m_occupancy.Clear();
+    for (u32 y = 0; y < OWNED_HEIGHT; ++y)
+    {
+      for (u32 x = 0; x < OWNED_WIDTH; ++x)
+      {
+        const SPoint pt = OwnedCoordToTile(SPoint(x, y));
+        if (IsLiveSite(pt) && GetAtom(pt)->GetType() != T::ATOM_EMPTY_TYPE)
+        {
+          m_occupancy.Insert(GetSiteInTileNumber(pt));
+        }
+      }
+    }
+    m_occupancyValid = true;
+  }
+
+  template <class EC>
+  u32 Tile<EC>::GetOccupiedSiteCount()
+  {
+    if (!m_occupancyValid)
+    {
+      RebuildOccupancy();
+    }
+    return m_occupancy.GetCount();
+  }
+
+  template <class EC>
+  SPoint Tile<EC>::GetRandomOccupiedCoord()
+  {
+    if (GetOccupiedSiteCount() == 0)
+    {
+      return GetRandomOwnedCoord();
+    }
+    return GetCoordOfSiteInTileNumber(m_occupancy.Pick(m_random));
+  }
+
+  template <class EC>
+  void Tile<EC>::CreditSkippedEvents()
+  {
+    // Under uniform sampling, with O occupied of N owned sites, each
+    // event at an occupied site comes with (N - O) / O events at
+    // empty ones on average.  Credit that many, rounding the
+    // fraction up or down at random so the mean is exact.
+    const u32 occupied = m_occupancy.GetCount();
+    const u32 owned = GetSites();
+    if (occupied == 0 || occupied >= owned)
+    {
+      return;
+    }
+    const u32 empty = owned - occupied;
+    u32 credit = empty / occupied;
+    if (m_random.OddsOf(empty % occupied, occupied))
+    {
+      ++credit;
+    }
+    m_window.CreditInertEvents(credit);
+  }
+
+  template <class EC>
+  void Tile<EC>::SetSiteSampling(SiteSampling sampling)
+  {
+    m_siteSampling = sampling;
+    m_occupancyValid = false;
   }
 
   template <class EC>
@@ -233,6 +418,40 @@ namespace MFM
     }
   }
 
+  template <class EC>
+  bool Tile<EC>::CountData::CheckCounts()
+  {
+    if (m_needRecount)
+    {
+      return true;
+    }
+
+    u32 counts[ELEMENT_TABLE_SIZE];
+    u32 illegal = m_illegalAtomCount;
+    for (u32 i = 0; i < ELEMENT_TABLE_SIZE; ++i)
+    {
+      counts[i] = m_atomCount[i];
+    }
+    RecountAtoms();
+
+    bool consistent = illegal == m_illegalAtomCount;
+    for (u32 i = 0; i < ELEMENT_TABLE_SIZE; ++i)
+    {
+      if (counts[i] != m_atomCount[i])
+      {
+        LOG.Error("Tile %s: element index %d count %d, but rescan finds %d",
+                  m_tile.GetLabel(), i, counts[i], m_atomCount[i]);
+        consistent = false;
+      }
+    }
+    if (illegal != m_illegalAtomCount)
+    {
+      LOG.Error("Tile %s: illegal atom count %d, but rescan finds %d",
+                m_tile.GetLabel(), illegal, m_illegalAtomCount);
+    }
+    return consistent;
+  }
+
   template <class EC>
   u32 Tile<EC>::GetUncachedWriteAge32(const SPoint site) const
   {
@@ -504,7 +723,7 @@ namespace MFM
       return;
     }
 
-    Site<AC> & site = GetSite(pt);
+    SiteReference site = GetSite(pt);
     T & oldAtom = placeInBase ? site.GetBase().GetBaseAtom() : site.GetAtom();
     T newAtom = atom;
     unwind_protect(
@@ -540,11 +759,22 @@ namespace MFM
 	    }
 	  else
 	    {
-	      NeedAtomRecount();
 	      if (owned)
+	      {
 		site.MarkChanged();
+		if (!placeInBase)
+		{
+		  m_cdata.NoteTypeChange(oldAtom.GetType(), newAtom.GetType());
+		}
+		if (m_occupancyValid && !placeInBase)
+		{
+		  m_occupancy.Update(GetSiteInTileNumber(pt),
+				     newAtom.GetType() != T::ATOM_EMPTY_TYPE);
+		}
+	      }
 
 	      oldAtom = newAtom;
+	      NoteSiteWritten(pt);
 	    }
 	}
     });
@@ -598,6 +828,16 @@ namespace MFM
 
   template <class EC>
   bool Tile<EC>::IsLiveSite(const SPoint & location) const
+  {
+    if (!IsInTile(location))
+    {
+      return false;
+    }
+    return m_liveSites[GetSiteInTileNumber(location)];
+  }
+
+  template <class EC>
+  bool Tile<EC>::ComputeIsLiveSite(const SPoint & location) const
   {
     if (!IsInTile(location))
     {
@@ -780,16 +1020,58 @@ namespace MFM
     }
 
     //INITIATE_EVENT,
+    return TryRandomEvent();
+  }
+
+  template <class EC>
+  bool Tile<EC>::TryRandomEvent()
+  {
+    if (m_siteSampling == SITE_SAMPLING_OCCUPIED)
+    {
+      SPoint pt = GetRandomOccupiedCoord();
+      if (!TryEventAt(pt))
+      {
+        return false;
+      }
+      CreditSkippedEvents();
+      return true;
+    }
+
     SPoint pt = GetRandomOwnedCoord(); //adjusted to range (0..Tile_Width, 0...Tile_Height)
     if (RegionIn(pt) == REGION_CACHE)
       FAIL(ILLEGAL_STATE);
 
+    return TryEventAt(pt);
+  }
+
+  template <class EC>
+  bool Tile<EC>::TryEventAt(const SPoint & pt)
+  {
+    // Empty needs no lookup; insane atoms go the long way, to be
+    // repaired or erased
+    const T & atom = *GetAtom(pt);
+    const u32 type = atom.GetType();
+    if (atom.IsSane())
+    {
+      if (type == T::ATOM_EMPTY_TYPE)
+      {
+        return m_window.TryInertEventAt(pt);
+      }
+
+      if (m_elementTable.LookupEntry(type).m_isInert)
+      {
+        return m_window.TryInertEventAt(pt);
+      }
+    }
     return m_window.TryEventAt(pt);
   }
 
   template <class EC>
   bool Tile<EC>::AdvanceCommunication()
   {
+    const bool timed = m_counters.StartCommPass();
+    const u64 start = timed ? TileCounters::ReadTicks() : 0;
+
     bool didWork = false;
     for (m_dirIterator.ShuffleOrReset(m_random); m_dirIterator.HasNext(); )
     {
@@ -799,6 +1081,12 @@ namespace MFM
       if(cp.IsConnected())
 	didWork |= cp.Advance();
     }
+
+    if (timed)
+    {
+      m_counters.Add(TileCounters::TIMED_COMM_PASSES);
+      m_counters.Add(TileCounters::COMM_TICKS, TileCounters::ReadTicks() - start);
+    }
     return didWork;
   }
 
@@ -819,6 +1107,7 @@ namespace MFM
 
     LOG.Log(level,"  ==Tile %s Events==", m_label.GetZString());
     LOG.Log(level,"   Events: %dM (total)", (u32) (GetEventsExecuted() / 1000000));
+    LOG.Log(level,"   Inert events: %dM (total)", (u32) (GetInertEventsExecuted() / 1000000));
 
     for (u32 d = Dirs::NORTH; d <= Dirs::NORTHWEST; ++d)
     {
@@ -0,0 +1,237 @@
+/*                                              -*- mode:C++ -*-
+  TileCounters.h Per-tile hot-path instrumentation counters
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file TileCounters.h Per-tile hot-path instrumentation counters
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef TILECOUNTERS_H
+#define TILECOUNTERS_H
+
+#include <time.h>  /* For clock_gettime */
+#include "itype.h"
+#include "Dirs.h"
+#include "ByteSink.h"
+
+namespace MFM
+{
+  /**
+     Cumulative counts of what a Tile's event and cache machinery has
+     been doing, kept to find out which tiles -- and which of their
+     edges -- are holding the AER down.
+
+     Only the thread currently advancing a Tile ever writes its
+     counters, so they are plain, unlocked increments.  Other threads
+     may take a (possibly slightly stale) copy at any time with
+     Sample.  The counters are padded out to whole cache lines on
+     both sides, so those increments never share a line with fields
+     that other threads touch.
+
+     Timing is sampled: one event window in every 2^TIMING_SHIFT, and
+     one communication pass in every 2^TIMING_SHIFT, has its phases
+     timed with ReadTicks, and the ticks are summed alongside the
+     number of samples.  Ticks are TSC cycles on x86, nanoseconds
+     elsewhere; only their ratios are meant to be compared.
+   */
+  class TileCounters
+  {
+  public:
+    enum
+    {
+      CACHE_LINE_BYTES = 64,
+      TIMING_SHIFT = 6,
+      TIMING_MASK = (1 << TIMING_SHIFT) - 1
+    };
+
+    /**
+       Counts for the tile as a whole.  The first three are kept by
+       the EventWindow and filled in by Tile::SampleCounters.
+     */
+    enum TileCounter
+    {
+      EVENTS_ATTEMPTED,
+      EVENTS_EXECUTED,
+      FAST_PATH_EVENTS,     //< Inert events counted without running
+      RECENCY_REJECTIONS,
+      LOCK_FAILURES,        //< Events abandoned for want of a lock
+      BEHAVIOR_FAILURES,
+      TIMED_EVENTS,
+      LOCK_TICKS,
+      BEHAVIOR_TICKS,
+      COMM_PASSES,
+      TIMED_COMM_PASSES,
+      COMM_TICKS,
+      TILE_COUNTER_COUNT
+    };
+
+    /**
+       Counts kept separately for each cache direction
+     */
+    enum DirCounter
+    {
+      DIR_LOCK_FAILURES,
+      PACKETS_SENT,
+      BYTES_SENT,
+      PACKETS_RECEIVED,
+      BYTES_RECEIVED,
+      CHECK_FAILURES,
+      DIR_COUNTER_COUNT
+    };
+
+    enum
+    {
+      COUNTER_COUNT = TILE_COUNTER_COUNT + Dirs::DIR_COUNT * DIR_COUNTER_COUNT
+    };
+
+    TileCounters()
+    {
+      Reset();
+    }
+
+    void Reset()
+    {
+      for (u32 i = 0; i < TILE_COUNTER_COUNT; ++i)
+      {
+        m_tile[i] = 0;
+      }
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        for (u32 i = 0; i < DIR_COUNTER_COUNT; ++i)
+        {
+          m_dir[d][i] = 0;
+        }
+      }
+    }
+
+    void Add(TileCounter which, u64 amount = 1)
+    {
+      m_tile[which] += amount;
+    }
+
+    void Add(Dir dir, DirCounter which, u64 amount = 1)
+    {
+      m_dir[dir][which] += amount;
+    }
+
+    void Set(TileCounter which, u64 value)
+    {
+      m_tile[which] = value;
+    }
+
+    u64 Get(TileCounter which) const
+    {
+      return m_tile[which];
+    }
+
+    u64 Get(Dir dir, DirCounter which) const
+    {
+      return m_dir[dir][which];
+    }
+
+    /**
+       Copy these counters into \c into, from a thread that need not
+       be the one writing them.  Each count is naturally aligned, so
+       on our 64-bit platforms each volatile load is consistent, if
+       stale; the set of them as a whole is not a snapshot.
+     */
+    void Sample(TileCounters & into) const
+    {
+      const volatile u64 * tile = m_tile;
+      for (u32 i = 0; i < TILE_COUNTER_COUNT; ++i)
+      {
+        into.m_tile[i] = tile[i];
+      }
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        const volatile u64 * dir = m_dir[d];
+        for (u32 i = 0; i < DIR_COUNTER_COUNT; ++i)
+        {
+          into.m_dir[d][i] = dir[i];
+        }
+      }
+    }
+
+    /**
+       Count a communication pass, and return true if this one should
+       be timed.
+     */
+    bool StartCommPass()
+    {
+      return (m_tile[COMM_PASSES]++ & TIMING_MASK) == 0;
+    }
+
+    /**
+       Return true if an event window numbered \c attempt (counting
+       from zero) should have its phases timed.
+     */
+    static bool IsTimedEvent(u64 attempt)
+    {
+      return (attempt & TIMING_MASK) == 0;
+    }
+
+    /**
+       A cheap, monotonic, per-core tick count
+     */
+    static u64 ReadTicks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      u32 lo, hi;
+      __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+      return (((u64) hi) << 32) | lo;
+#else
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ((u64) ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+    }
+
+    static const char * GetName(TileCounter which) ;
+
+    static const char * GetName(DirCounter which) ;
+
+    /**
+       Print the CSV column names for rows written by WriteCSVRow,
+       \c prefix first, then a newline.
+     */
+    static void WriteCSVHeader(ByteSink & to, const char * prefix) ;
+
+    /**
+       Print these counters as comma-separated values, \c prefix
+       (which should end with a comma) first, then a newline.
+     */
+    void WriteCSVRow(ByteSink & to, const char * prefix) const ;
+
+    /**
+       Print these counters as a single JSON object, with per-direction
+       counts nested under their direction codes.
+     */
+    void WriteJSON(ByteSink & to) const ;
+
+  private:
+    u8 m_padBefore[CACHE_LINE_BYTES];
+    u64 m_tile[TILE_COUNTER_COUNT];
+    u64 m_dir[Dirs::DIR_COUNT][DIR_COUNTER_COUNT];
+    u8 m_padAfter[CACHE_LINE_BYTES];
+  };
+
+} /* namespace MFM */
+
+#endif /* TILECOUNTERS_H */
@@ -147,6 +147,22 @@ namespace MFM {
     typedef typename AC::ATOM_TYPE T;
     const UlamElementInfo<EC> * m_info;
 
+    /**
+       Where this element's behave() lives, and the UlamRef geometry
+       to call it with, as resolved through the vtable on its first
+       event.  An element's vtable can't change at runtime, so the
+       resolution is done once per element type rather than once per
+       event.  m_behaveUsage holds an UlamRef<EC>::UsageType.
+     */
+    mutable VfuncPtr m_behaveFunc;
+    mutable u32 m_behavePos;
+    mutable u32 m_behaveLen;
+    mutable u32 m_behavePosToEff;
+    mutable u32 m_behaveUsage;
+    mutable volatile bool m_behaveResolved;
+
+    void ResolveBehaviorDispatch(const UlamContext<EC> & uc, BitStorage<EC> & stg) const ;
+
   public:
 
     enum SpecialVirtualVTableIndices {
@@ -155,7 +171,16 @@ namespace MFM {
       RENDERGRAPHICS_VOWNED_INDEX = 2 /* ==Uq_10106UrSelf10<EC>::VOWNED_IDX_Uf_9214renderGraphics10 */
     };
 
-    UlamElement(const UUID & uuid) : Element<EC>(uuid) { }
+    UlamElement(const UUID & uuid)
+      : Element<EC>(uuid)
+      , m_info(0)
+      , m_behaveFunc(0)
+      , m_behavePos(0)
+      , m_behaveLen(0)
+      , m_behavePosToEff(0)
+      , m_behaveUsage(0)
+      , m_behaveResolved(false)
+    { }
 
     virtual ~UlamElement() { }
 
@@ -178,8 +203,23 @@ namespace MFM {
       this->SetAtomicSymbol(m_info->GetSymbol());
     }
 
+    /**
+       Run this element's ulam behave() on the center of window.
+       After the first event, the vtable lookups are skipped and the
+       UlamRef for the call is built directly from the cached
+       resolution, since the effective self is always this element.
+     */
     virtual void Behavior(EventWindow<EC>& window) const ;
 
+    /**
+       Return true once the behave() entry point of this element has
+       been resolved and cached.
+     */
+    bool IsBehaviorDispatchResolved() const
+    {
+      return m_behaveResolved;
+    }
+
     virtual u32 GetEventWindowBoundary() const ;
 
     virtual bool GetPlaceable() const
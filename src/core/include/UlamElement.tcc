@@ -19,6 +19,26 @@ namespace MFM {
     return m_info->GetEventWindowBoundary();
   }
 
+  template <class EC>
+  void UlamElement<EC>::ResolveBehaviorDispatch(const UlamContext<EC> & uc, BitStorage<EC> & stg) const
+  {
+    UlamRef<EC> ur(T::ATOM_FIRST_STATE_BIT, this->GetClassLength(), stg, this, UlamRef<EC>::ELEMENTAL, uc);
+
+    // how to do an ulam virtual function call in c++
+    VfuncPtr vfuncptr;
+    UlamRef<EC> vfur(ur, BEHAVE_VOWNED_INDEX, 0u, true, vfuncptr);
+
+    m_behaveFunc = vfuncptr;
+    m_behavePos = vfur.GetPos();
+    m_behaveLen = vfur.GetLen();
+    m_behavePosToEff = (u32) vfur.GetPosToEffectiveSelf();
+    m_behaveUsage = (u32) vfur.GetUsage();
+
+    // Racing tiles all store the same values; just publish them last
+    __sync_synchronize();
+    m_behaveResolved = true;
+  }
+
   template <class EC>
   void UlamElement<EC>::Behavior(EventWindow<EC>& window) const
   {
@@ -30,13 +50,18 @@ namespace MFM {
     u32 sym = m_info ? m_info->GetSymmetry(uc) : (u32) PSYM_DEG000L;
     window.SetSymmetry((PointSymmetry) sym);
 
-    UlamRef<EC> ur(T::ATOM_FIRST_STATE_BIT, this->GetClassLength(), window.GetCenterAtomBitStorage(), this, UlamRef<EC>::ELEMENTAL, uc);
+    BitStorage<EC> & stg = window.GetCenterAtomBitStorage();
+    if (!m_behaveResolved)
+    {
+      ResolveBehaviorDispatch(uc, stg);
+    }
 
-    // how to do an ulam virtual function call in c++
-    VfuncPtr vfuncptr;
-    UlamRef<EC> vfur(ur, BEHAVE_VOWNED_INDEX, 0u, true, vfuncptr);
+    // The effective self is this element, so build the override's
+    // ref directly rather than deriving it from an elemental ref
+    UlamRef<EC> vfur(m_behavePos, m_behaveLen, m_behavePosToEff, stg, this,
+                     (typename UlamRef<EC>::UsageType) m_behaveUsage, uc);
     typedef void (* Uf_6behave) (const UlamContext<EC>&, UlamRef<EC>& );
-    ((Uf_6behave) vfuncptr) (uc, vfur);
+    ((Uf_6behave) m_behaveFunc) (uc, vfur);
   }
 
   template <class EC>
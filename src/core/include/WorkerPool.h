@@ -0,0 +1,118 @@
+/*                                              -*- mode:C++ -*-
+  WorkerPool.h A pool of threads that share out each job handed to it
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file WorkerPool.h A pool of threads that share out each job handed to it
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <pthread.h>
+#include "itype.h"
+#include "Fail.h"
+
+namespace MFM
+{
+  /**
+     A set of long-lived threads for splitting a job -- typically
+     painting a frame, tile by tile -- across cores.  Run calls the
+     job's Work on every thread, the caller's included, and returns
+     once all of those calls have.  The workers are started by the
+     first Run (and restarted if the thread count changes) and sleep
+     between jobs.  How the work gets divided is up to the job; the
+     usual way is for each Work call to claim items from a shared
+     counter with __sync_fetch_and_add until none are left.
+   */
+  class WorkerPool
+  {
+  public:
+    enum
+    {
+      MAX_THREADS = 64
+    };
+
+    class Job
+    {
+    public:
+      /**
+         Do a share of the job.  \c thread is 0 for the thread that
+         called Run, and 1 up to one less than its thread count for
+         the workers, so per-thread state can be kept in an array.
+       */
+      virtual void Work(u32 thread) = 0;
+
+      virtual ~Job() { }
+    };
+
+    WorkerPool() ;
+
+    ~WorkerPool() ;
+
+    /**
+       Have \c threads threads in all, 1 to MAX_THREADS, counting the
+       caller, do \c job, and wait until they have.  If any thread's
+       Work FAILs, the rest still finish, and then Run FAILs with the
+       same code (the caller's, if it failed too).
+     */
+    void Run(Job & job, u32 threads) ;
+
+    /**
+       The number of threads used by the last Run, or 0 if none yet
+     */
+    u32 GetThreads() const
+    {
+      return m_runs ? m_workerCount + 1 : 0;
+    }
+
+  private:
+    void StartWorkers(u32 count) ;
+
+    void StopWorkers() ;
+
+    static void * RunWorker(void * arg) ;
+
+    void WorkerLoop(u32 me) ;
+
+    Job * m_job;               // The job being run
+    u32 m_runs;
+
+    pthread_mutex_t m_lock;
+    pthread_cond_t m_changed;
+    pthread_t m_workers[MAX_THREADS];
+    u32 m_workerCount;
+    u32 m_workersArrived;      // Claimed with __sync_fetch_and_add
+    u32 m_startGeneration;     // m_generation when the workers started
+    MFMErrorEnvironmentPointer_t m_errorStackTops[MAX_THREADS];
+
+    /* Guarded by m_lock */
+    u32 m_generation;          // Bumped for each job, and to exit
+    u32 m_busyWorkers;
+    bool m_exiting;
+
+    int m_workerFailCode;      // First worker failure of this Run, or 0
+
+    WorkerPool(const WorkerPool &) ;  // Not implemented
+    WorkerPool & operator=(const WorkerPool &) ;  // Not implemented
+  };
+}
+
+#endif /* WORKERPOOL_H */
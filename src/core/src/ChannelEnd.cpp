@@ -1,5 +1,6 @@
 #include "ChannelEnd.h"
 #include "PacketIO.h"
+#include "Util.h"  // For MIN
 
 namespace MFM
 {
@@ -12,29 +13,50 @@ namespace MFM
     LOG.Log(level,"     Pending length: %d", m_packetBuffer.GetLength());
   }
 
+  bool ChannelEnd::SendPacket(const PacketBuffer & pb)
+  {
+    MFM_API_ASSERT(!pb.HasOverflowed(), OUT_OF_ROOM);
+
+    u32 plen = pb.GetLength();
+    MFM_API_ASSERT(plen <= MAX_PACKET_LENGTH, OUT_OF_ROOM);
+
+    u8 len[2] = { (u8) (plen >> 8), (u8) plen };
+    if (CanWrite() < plen + sizeof(len))
+    {
+      return false;
+    }
+
+    Write(len, sizeof(len));  // Packet length, then data
+    Write((const u8 *) pb.GetBuffer(), plen);
+    return true;
+  }
+
   PacketBuffer * ChannelEnd::ReceivePacket()
   {
     // Step 1: If a packet has not been started, try to start it
     if (m_packetLength < 0)
     {
-      s32 byte = ReadByte();
-      if (byte < 0)
+      u8 len[2];
+      if (CanRead() < sizeof(len))
       {
-        return 0;              // Nothing there..
+        return 0;              // Nothing (or not enough) there..
       }
-      m_packetLength = byte;   // OK, packet started!
+      Read(len, sizeof(len));
+      m_packetLength = (len[0] << 8) | len[1];   // OK, packet started!
       m_packetBuffer.Reset();
     }
 
     // Step 2: If a packet is not yet finished, try to read enough to finish it
     while (m_packetBuffer.GetLength() < (u32) m_packetLength)
     {
-      s32 byte = ReadByte();
-      if (byte < 0)
+      u8 chunk[256];
+      u32 want = MIN((u32) sizeof(chunk), m_packetLength - m_packetBuffer.GetLength());
+      u32 got = Read(chunk, want);
+      if (got == 0)
       {
         return 0;              // Split packet.  Well damn.  Later.
       }
-      m_packetBuffer.Print((u32) byte, Format::BYTE);
+      m_packetBuffer.WriteBytes(chunk, got);
     }
 
     // Step 3: Privately mark packet done; let caller see what we got
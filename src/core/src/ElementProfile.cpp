@@ -0,0 +1,36 @@
+#include "ElementProfile.h"
+#include "Fail.h"
+
+namespace MFM
+{
+  void ElementProfile::SetSampling(u32 oneIn)
+  {
+    MFM_API_ASSERT_ARG(oneIn <= MAX_SAMPLING && (oneIn & (oneIn - 1)) == 0);
+    m_enabled = oneIn > 0;
+    m_sampleMask = m_enabled ? oneIn - 1 : 0;
+  }
+
+  void ElementProfile::SampleSlot(u32 slot, Slot & into) const
+  {
+    MFM_API_ASSERT_ARG(slot < SLOTS);
+    const volatile Slot & s = m_slots[slot];
+    into.m_samples = s.m_samples;
+    for (u32 i = 0; i < PHASE_COUNT; ++i)
+    {
+      into.m_ticks[i] = s.m_ticks[i];
+    }
+  }
+
+  const char * ElementProfile::GetPhaseName(Phase phase)
+  {
+    switch (phase)
+    {
+    case LOCK: return "lock";
+    case LOAD: return "load";
+    case BEHAVIOR: return "behave";
+    case STORE: return "store";
+    default: FAIL(ILLEGAL_ARGUMENT);
+    }
+  }
+
+} /* namespace MFM */
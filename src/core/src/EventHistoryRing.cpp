@@ -0,0 +1,226 @@
+#include <string.h>
+#include "EventHistoryRing.h"
+#include "EventHistorySpill.h"
+
+namespace MFM
+{
+  void EventHistoryRing::InitInMemory(u8 * bytes, u32 capacity, u32 maxPayload)
+  {
+    MFM_API_ASSERT_NONNULL(bytes);
+    MFM_API_ASSERT_ARG(maxPayload + FRAME_BYTES <= MAX_SPAN);
+    MFM_API_ASSERT_ARG(capacity >= 2 * (maxPayload + 2 * FRAME_BYTES));
+    Close();
+    m_bytes = bytes;
+    m_capacity = capacity;
+    m_maxPayload = maxPayload;
+  }
+
+  bool EventHistoryRing::OpenFile(const char * path, u32 capacity, u32 maxPayload)
+  {
+    MFM_API_ASSERT_NONNULL(path);
+    MFM_API_ASSERT_ARG(maxPayload + FRAME_BYTES <= MAX_SPAN);
+    MFM_API_ASSERT_ARG(capacity >= 2 * (maxPayload + 2 * FRAME_BYTES));
+    Close();
+    m_file = fopen(path, "w+b");
+    if (!m_file)
+    {
+      return false;
+    }
+    m_capacity = capacity;
+    m_maxPayload = maxPayload;
+    return true;
+  }
+
+  void EventHistoryRing::AdoptRecords(u32 used, u32 records)
+  {
+    MFM_API_ASSERT_STATE(m_bytes != 0);
+    MFM_API_ASSERT_ARG(used <= m_capacity && (used == 0) == (records == 0));
+    m_oldest = 0;
+    m_free = used;
+    m_used = used;
+    m_records = records;
+    if (records == 0)
+    {
+      Clear();
+    }
+  }
+
+  void EventHistoryRing::Close()
+  {
+    if (m_file)
+    {
+      fclose(m_file);
+      m_file = 0;
+    }
+    m_bytes = 0;
+    m_capacity = 0;
+    m_maxPayload = 0;
+    Clear();
+  }
+
+  void EventHistoryRing::Read(u32 offset, u8 * dest, u32 len) const
+  {
+    MFM_API_ASSERT_STATE(IsOpen());
+    while (len > 0)
+    {
+      u32 chunk = m_capacity - offset;
+      if (chunk > len)
+      {
+        chunk = len;
+      }
+      if (m_file)
+      {
+        if (fseek(m_file, offset, SEEK_SET) != 0 || fread(dest, 1, chunk, m_file) != chunk)
+        {
+          FAIL(IO_ERROR);
+        }
+      }
+      else
+      {
+        memcpy(dest, m_bytes + offset, chunk);
+      }
+      dest += chunk;
+      len -= chunk;
+      offset = Wrap(offset + chunk);
+    }
+  }
+
+  void EventHistoryRing::Write(u32 offset, const u8 * src, u32 len)
+  {
+    MFM_API_ASSERT_STATE(IsOpen());
+    while (len > 0)
+    {
+      u32 chunk = m_capacity - offset;
+      if (chunk > len)
+      {
+        chunk = len;
+      }
+      if (m_file)
+      {
+        if (fseek(m_file, offset, SEEK_SET) != 0 || fwrite(src, 1, chunk, m_file) != chunk)
+        {
+          FAIL(IO_ERROR);
+        }
+      }
+      else
+      {
+        memcpy(m_bytes + offset, src, chunk);
+      }
+      src += chunk;
+      len -= chunk;
+      offset = Wrap(offset + chunk);
+    }
+  }
+
+  void EventHistoryRing::ReadFrame(u32 offset, u8 & tag, u32 & span, u8 & check) const
+  {
+    u8 frame[FRAME_BYTES];
+    Read(offset, frame, FRAME_BYTES);
+    tag = frame[0];
+    span = frame[1] | (frame[2] << 8);
+    check = frame[3];
+  }
+
+  u32 EventHistoryRing::EndOf(u32 start) const
+  {
+    u8 tag, check, endTag, endCheck;
+    u32 span, endSpan;
+    ReadFrame(start, tag, span, check);
+    MFM_API_ASSERT_STATE(tag == TAG_START && span < m_capacity);
+    const u32 end = Wrap(start + span);
+    ReadFrame(end, endTag, endSpan, endCheck);
+    MFM_API_ASSERT_STATE(endTag == TAG_END && endSpan == span && endCheck == check);
+    return end;
+  }
+
+  u32 EventHistoryRing::StartOf(u32 end) const
+  {
+    u8 tag, check, startTag, startCheck;
+    u32 span, startSpan;
+    ReadFrame(end, tag, span, check);
+    MFM_API_ASSERT_STATE(tag == TAG_END && span < m_capacity);
+    const u32 start = Wrap(end + m_capacity - span);
+    ReadFrame(start, startTag, startSpan, startCheck);
+    MFM_API_ASSERT_STATE(startTag == TAG_START && startSpan == span && startCheck == check);
+    return start;
+  }
+
+  u32 EventHistoryRing::ReadPayload(u32 start, u8 * dest, u32 maxLen) const
+  {
+    const u32 end = EndOf(start);
+    const u32 len = Wrap(end + m_capacity - start) - FRAME_BYTES;
+    MFM_API_ASSERT_ARG(len <= maxLen);
+    Read(Wrap(start + FRAME_BYTES), dest, len);
+    return len;
+  }
+
+  u32 EventHistoryRing::PeekPayload(u32 start, u8 * dest, u32 len) const
+  {
+    u8 tag, check;
+    u32 span;
+    ReadFrame(start, tag, span, check);
+    MFM_API_ASSERT_STATE(tag == TAG_START && span >= FRAME_BYTES);
+    if (len > span - FRAME_BYTES)
+    {
+      len = span - FRAME_BYTES;
+    }
+    Read(Wrap(start + FRAME_BYTES), dest, len);
+    return len;
+  }
+
+  void EventHistoryRing::EvictOldest(EventHistorySpill * spill)
+  {
+    MFM_API_ASSERT_STATE(!IsEmpty());
+    const u32 end = EndOf(m_oldest);
+    if (spill && spill->IsOpen())
+    {
+      u8 payload[MAX_PAYLOAD_BYTES];
+      u8 tag, check;
+      u32 span;
+      ReadFrame(end, tag, span, check);
+      const u32 len = ReadPayload(m_oldest, payload, MAX_PAYLOAD_BYTES);
+      spill->Append(payload, len, check);
+    }
+    const u32 next = Wrap(end + FRAME_BYTES);
+    m_used -= Wrap(next + m_capacity - m_oldest);
+    m_oldest = next;
+    if (--m_records == 0)
+    {
+      Clear();
+    }
+  }
+
+  u32 EventHistoryRing::Append(const u8 * payload, u32 len, u8 check, EventHistorySpill * spill)
+  {
+    MFM_API_ASSERT_STATE(IsOpen());
+    MFM_API_ASSERT_ARG(len <= m_maxPayload);
+    const u32 recordBytes = len + 2 * FRAME_BYTES;
+    while (m_capacity - m_used < recordBytes)
+    {
+      EvictOldest(spill);
+    }
+
+    const u32 span = len + FRAME_BYTES;
+    u8 frame[FRAME_BYTES];
+    frame[0] = TAG_START;
+    frame[1] = (u8) span;
+    frame[2] = (u8) (span >> 8);
+    frame[3] = check;
+
+    const u32 start = m_free;
+    Write(start, frame, FRAME_BYTES);
+    Write(Wrap(start + FRAME_BYTES), payload, len);
+    const u32 end = Wrap(start + span);
+    frame[0] = TAG_END;
+    Write(end, frame, FRAME_BYTES);
+
+    if (m_records++ == 0)
+    {
+      m_oldest = start;
+    }
+    m_free = Wrap(end + FRAME_BYTES);
+    m_used += recordBytes;
+    return end;
+  }
+
+} /* namespace MFM */
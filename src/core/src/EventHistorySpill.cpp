@@ -0,0 +1,151 @@
+#include <zlib.h>
+#include "EventHistorySpill.h"
+
+namespace MFM
+{
+  bool EventHistorySpill::Open(const char * path, u32 capacity)
+  {
+    Close();
+    if (!m_file.OpenFile(path, capacity, MAX_SEGMENT_PAYLOAD))
+    {
+      return false;
+    }
+    m_openBytes = new u8[SEGMENT_BYTES];
+    m_viewBytes = new u8[SEGMENT_BYTES];
+    m_packed = new u8[MAX_SEGMENT_PAYLOAD];
+    m_open.InitInMemory(m_openBytes, SEGMENT_BYTES);
+    m_view.InitInMemory(m_viewBytes, SEGMENT_BYTES);
+    return true;
+  }
+
+  void EventHistorySpill::Close()
+  {
+    m_file.Close();
+    m_open.Close();
+    m_view.Close();
+    delete [] m_openBytes;
+    delete [] m_viewBytes;
+    delete [] m_packed;
+    m_openBytes = 0;
+    m_viewBytes = 0;
+    m_packed = 0;
+    m_fileRecords = 0;
+    m_viewingOpen = true;
+  }
+
+  void EventHistorySpill::Append(const u8 * payload, u32 len, u8 check)
+  {
+    MFM_API_ASSERT_STATE(IsOpen());
+    if (!m_open.HasRoomFor(len))
+    {
+      Flush();
+    }
+    m_open.Append(payload, len, check, 0);
+  }
+
+  u32 EventHistorySpill::CountAt(u32 start) const
+  {
+    u8 count[COUNT_BYTES];
+    const u32 len = m_file.PeekPayload(start, count, COUNT_BYTES);
+    MFM_API_ASSERT_STATE(len == COUNT_BYTES);
+    return count[0] | (count[1] << 8);
+  }
+
+  void EventHistorySpill::Flush()
+  {
+    const u32 records = m_open.GetRecordCount();
+    if (records == 0) return;
+
+    uLongf packedLen = MAX_SEGMENT_PAYLOAD - COUNT_BYTES;
+    if (compress2(m_packed + COUNT_BYTES, &packedLen, m_openBytes, m_open.GetUsedBytes(),
+                  Z_BEST_SPEED) != Z_OK)
+    {
+      FAIL(OUT_OF_RESOURCES);
+    }
+    m_packed[0] = (u8) records;
+    m_packed[1] = (u8) (records >> 8);
+    const u32 len = COUNT_BYTES + packedLen;
+
+    while (!m_file.HasRoomFor(len))
+    {
+      m_fileRecords -= CountAt(m_file.GetOldestStart());
+      m_file.DropOldest();
+    }
+    m_file.Append(m_packed, len, (u8) ++m_segmentsWritten, 0);
+    m_fileRecords += records;
+
+    m_open.Clear();
+    m_viewingOpen = true;
+  }
+
+  void EventHistorySpill::Inflate(u32 start)
+  {
+    const u32 len = m_file.ReadPayload(start, m_packed, MAX_SEGMENT_PAYLOAD);
+    MFM_API_ASSERT_STATE(len > COUNT_BYTES);
+    uLongf used = SEGMENT_BYTES;
+    if (uncompress(m_viewBytes, &used, m_packed + COUNT_BYTES, len - COUNT_BYTES) != Z_OK)
+    {
+      FAIL(IO_ERROR);
+    }
+    m_view.AdoptRecords(used, m_packed[0] | (m_packed[1] << 8));
+    m_viewingOpen = false;
+    m_viewStart = start;
+  }
+
+  bool EventHistorySpill::ViewNewest()
+  {
+    if (!IsOpen() || IsEmpty())
+    {
+      return false;
+    }
+    if (!m_open.IsEmpty())
+    {
+      m_viewingOpen = true;
+    }
+    else
+    {
+      Inflate(m_file.StartOf(m_file.GetNewestEnd()));
+    }
+    return true;
+  }
+
+  bool EventHistorySpill::ViewOlder()
+  {
+    if (m_file.IsEmpty())
+    {
+      return false;
+    }
+    if (m_viewingOpen)
+    {
+      Inflate(m_file.StartOf(m_file.GetNewestEnd()));
+      return true;
+    }
+    if (m_viewStart == m_file.GetOldestStart())
+    {
+      return false;
+    }
+    Inflate(m_file.StartOf(m_file.EndBefore(m_viewStart)));
+    return true;
+  }
+
+  bool EventHistorySpill::ViewNewer()
+  {
+    if (m_viewingOpen)
+    {
+      return false;
+    }
+    const u32 end = m_file.EndOf(m_viewStart);
+    if (end != m_file.GetNewestEnd())
+    {
+      Inflate(m_file.StartAfter(end));
+      return true;
+    }
+    if (m_open.IsEmpty())
+    {
+      return false;
+    }
+    m_viewingOpen = true;
+    return true;
+  }
+
+} /* namespace MFM */
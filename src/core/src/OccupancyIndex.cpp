@@ -0,0 +1 @@
+#include "OccupancyIndex.h"
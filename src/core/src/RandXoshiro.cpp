@@ -0,0 +1 @@
+#include "RandXoshiro.h"
@@ -0,0 +1,100 @@
+#include "TileCounters.h"
+#include "Fail.h"
+
+namespace MFM
+{
+  const char * TileCounters::GetName(TileCounter which)
+  {
+    switch (which)
+    {
+    case EVENTS_ATTEMPTED: return "eventsAttempted";
+    case EVENTS_EXECUTED: return "eventsExecuted";
+    case FAST_PATH_EVENTS: return "fastPathEvents";
+    case RECENCY_REJECTIONS: return "recencyRejections";
+    case LOCK_FAILURES: return "lockFailures";
+    case BEHAVIOR_FAILURES: return "behaviorFailures";
+    case TIMED_EVENTS: return "timedEvents";
+    case LOCK_TICKS: return "lockTicks";
+    case BEHAVIOR_TICKS: return "behaviorTicks";
+    case COMM_PASSES: return "commPasses";
+    case TIMED_COMM_PASSES: return "timedCommPasses";
+    case COMM_TICKS: return "commTicks";
+    default: FAIL(ILLEGAL_ARGUMENT);
+    }
+  }
+
+  const char * TileCounters::GetName(DirCounter which)
+  {
+    switch (which)
+    {
+    case DIR_LOCK_FAILURES: return "lockFailures";
+    case PACKETS_SENT: return "packetsSent";
+    case BYTES_SENT: return "bytesSent";
+    case PACKETS_RECEIVED: return "packetsReceived";
+    case BYTES_RECEIVED: return "bytesReceived";
+    case CHECK_FAILURES: return "checkFailures";
+    default: FAIL(ILLEGAL_ARGUMENT);
+    }
+  }
+
+  void TileCounters::WriteCSVHeader(ByteSink & to, const char * prefix)
+  {
+    to.Print(prefix);
+    for (u32 i = 0; i < TILE_COUNTER_COUNT; ++i)
+    {
+      to.Printf("%s%s", i > 0 ? "," : "", GetName((TileCounter) i));
+    }
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      for (u32 i = 0; i < DIR_COUNTER_COUNT; ++i)
+      {
+        to.Printf(",%s_%s", Dirs::GetCode(d), GetName((DirCounter) i));
+      }
+    }
+    to.Println();
+  }
+
+  void TileCounters::WriteCSVRow(ByteSink & to, const char * prefix) const
+  {
+    to.Print(prefix);
+    for (u32 i = 0; i < TILE_COUNTER_COUNT; ++i)
+    {
+      if (i > 0)
+      {
+        to.WriteByte(',');
+      }
+      to.Print(m_tile[i]);
+    }
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      for (u32 i = 0; i < DIR_COUNTER_COUNT; ++i)
+      {
+        to.WriteByte(',');
+        to.Print(m_dir[d][i]);
+      }
+    }
+    to.Println();
+  }
+
+  void TileCounters::WriteJSON(ByteSink & to) const
+  {
+    to.WriteByte('{');
+    for (u32 i = 0; i < TILE_COUNTER_COUNT; ++i)
+    {
+      to.Printf("%s\"%s\":", i > 0 ? "," : "", GetName((TileCounter) i));
+      to.Print(m_tile[i]);
+    }
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      to.Printf(",\"%s\":{", Dirs::GetCode(d));
+      for (u32 i = 0; i < DIR_COUNTER_COUNT; ++i)
+      {
+        to.Printf("%s\"%s\":", i > 0 ? "," : "", GetName((DirCounter) i));
+        to.Print(m_dir[d][i]);
+      }
+      to.WriteByte('}');
+    }
+    to.WriteByte('}');
+  }
+
+} /* namespace MFM */
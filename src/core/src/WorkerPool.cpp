@@ -0,0 +1,173 @@
+#include "WorkerPool.h"
+#include "Logger.h"
+
+namespace MFM
+{
+  WorkerPool::WorkerPool()
+    : m_job(0)
+    , m_runs(0)
+    , m_workerCount(0)
+    , m_workersArrived(0)
+    , m_startGeneration(0)
+    , m_generation(0)
+    , m_busyWorkers(0)
+    , m_exiting(false)
+    , m_workerFailCode(0)
+  {
+    MFM_API_ASSERT(!pthread_mutex_init(&m_lock, NULL), LOCK_FAILURE);
+    MFM_API_ASSERT(!pthread_cond_init(&m_changed, NULL), LOCK_FAILURE);
+    for (u32 i = 0; i < MAX_THREADS; ++i)
+    {
+      m_errorStackTops[i] = 0;
+    }
+  }
+
+  WorkerPool::~WorkerPool()
+  {
+    StopWorkers();
+    pthread_cond_destroy(&m_changed);
+    pthread_mutex_destroy(&m_lock);
+  }
+
+  void WorkerPool::StartWorkers(u32 count)
+  {
+    MFM_API_ASSERT_STATE(m_workerCount == 0);
+    m_exiting = false;
+    m_workersArrived = 0;
+    m_startGeneration = m_generation;
+    for (u32 i = 0; i < count; ++i)
+    {
+      if (pthread_create(&m_workers[i], NULL, RunWorker, this))
+      {
+        FAIL(ILLEGAL_STATE);
+      }
+      ++m_workerCount;
+    }
+  }
+
+  void WorkerPool::StopWorkers()
+  {
+    if (m_workerCount == 0)
+    {
+      return;
+    }
+
+    MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+    m_exiting = true;
+    ++m_generation;
+    MFM_API_ASSERT(!pthread_cond_broadcast(&m_changed), LOCK_FAILURE);
+    MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+
+    for (u32 i = 0; i < m_workerCount; ++i)
+    {
+      pthread_join(m_workers[i], NULL);
+    }
+    m_workerCount = 0;
+  }
+
+  void * WorkerPool::RunWorker(void * arg)
+  {
+    WorkerPool & pool = *(WorkerPool *) arg;
+
+    const u32 me = __sync_fetch_and_add(&pool.m_workersArrived, 1);
+    MFMPtrToErrEnvStackPtr = &pool.m_errorStackTops[me];
+
+    pool.WorkerLoop(me);
+    return NULL;
+  }
+
+  void WorkerPool::WorkerLoop(u32 me)
+  {
+    // Not m_generation, which Run may already have bumped for this
+    // worker's first job
+    u32 seen = m_startGeneration;
+
+    while (true)
+    {
+      MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+      while (m_generation == seen)
+      {
+        MFM_API_ASSERT(!pthread_cond_wait(&m_changed, &m_lock), LOCK_FAILURE);
+      }
+      seen = m_generation;
+      bool exiting = m_exiting;
+      MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+
+      if (exiting)
+      {
+        return;
+      }
+
+      // A failure ends only this worker's share; Run re-FAILs it on
+      // the caller's thread once every share is done
+      unwind_protect(
+      {
+        LOG.Warning("WorkerPool thread %d failed: %s (%s:%d)", me + 1,
+                    MFMFailCodeReason(MFMThrownFailCode),
+                    MFMThrownFromFile, MFMThrownFromLineNo);
+        __sync_bool_compare_and_swap(&m_workerFailCode, 0, MFMThrownFailCode);
+      },
+      {
+        m_job->Work(me + 1);
+      });
+
+      MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+      if (--m_busyWorkers == 0)
+      {
+        MFM_API_ASSERT(!pthread_cond_broadcast(&m_changed), LOCK_FAILURE);
+      }
+      MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+    }
+  }
+
+  void WorkerPool::Run(Job & job, u32 threads)
+  {
+    MFM_API_ASSERT_ARG(threads > 0 && threads <= MAX_THREADS);
+    MFM_API_ASSERT_STATE(!m_job);
+
+    if (m_workerCount + 1 != threads)
+    {
+      StopWorkers();
+      StartWorkers(threads - 1);
+    }
+
+    m_job = &job;
+
+    MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+    m_busyWorkers = m_workerCount;
+    ++m_generation;
+    MFM_API_ASSERT(!pthread_cond_broadcast(&m_changed), LOCK_FAILURE);
+    MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+
+    // Even if our share fails, the workers may still be using job,
+    // so wait for them before passing the failure on
+    int failCode = 0;
+    unwind_protect(
+    {
+      failCode = MFMThrownFailCode;
+    },
+    {
+      job.Work(0);
+    });
+
+    MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+    while (m_busyWorkers > 0)
+    {
+      MFM_API_ASSERT(!pthread_cond_wait(&m_changed, &m_lock), LOCK_FAILURE);
+    }
+    MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+
+    m_job = 0;
+    ++m_runs;
+
+    if (failCode == 0)
+    {
+      failCode = m_workerFailCode;
+    }
+    m_workerFailCode = 0;
+    if (failCode != 0)
+    {
+      FAIL_BY_NUMBER(failCode);
+    }
+  }
+}
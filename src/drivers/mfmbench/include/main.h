@@ -0,0 +1,6 @@
+#ifndef MAIN_H
+#define MAIN_H
+
+#include "Benchmarks.h"
+
+#endif  /* MAIN_H */
@@ -0,0 +1,30 @@
+#include "main.h"
+#include <string.h>  /* For strcmp */
+
+using namespace MFM;
+
+#define BENCH(className)                                      \
+  do {                                                        \
+    if (argc <= 1 || !strcmp(argv[1], # className)) {         \
+      MFM::BenchOutput().Printf("%s\n", # className);         \
+      className::Bench_RunBenchmarks();                       \
+    }                                                         \
+  } while (0)
+
+/**
+   Run all the micro-benchmarks, or just the one named by argv[1]
+ */
+int main(int argc, char** argv)
+{
+  BENCH(LonglivedLock_Bench);
+  BENCH(GridSnapshot_Bench);
+  BENCH(EventWindow_Bench);
+  BENCH(BitVector_Bench);
+  BENCH(Fail_Bench);
+  BENCH(UlamElement_Bench);
+  BENCH(Random_Bench);
+  BENCH(EventHistoryBuffer_Bench);
+  BENCH(FrameRenderer_Bench);
+
+  return 0;
+}
@@ -15,7 +15,7 @@ override INCLUDES += -I $(BASEDIR)/src/core/include -I $(BASEDIR)/src/elements/i
 
 # What we need to link
 override LIBS += -L $(BASEDIR)/build/core/ -L $(BASEDIR)/build/elements/ -L $(BASEDIR)/build/sim/
-override LIBS += -lmfmsim -lmfmelements -Wl,--whole-archive -lmfmcore -Wl,--no-whole-archive -lm
+override LIBS += -lmfmsim -lmfmelements -Wl,--whole-archive -lmfmcore -Wl,--no-whole-archive -lpng -lm
 
 # Do the program thing
 include $(BASEDIR)/config/Makeprog.mk
@@ -0,0 +1,8 @@
+#ifndef MAIN_H
+#define MAIN_H
+
+#include "StatsLog.h"
+#include "FileByteSink.h"
+#include "Logger.h"
+
+#endif  /* MAIN_H */
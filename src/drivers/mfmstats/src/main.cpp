@@ -0,0 +1,24 @@
+#include "main.h"
+#include <stdio.h>  /* For fprintf */
+
+using namespace MFM;
+
+/**
+   Convert the statistics log named by argv[1] (such as a run's
+   tbd/stats.mfstats) to CSV on standard output
+ */
+int main(int argc, char** argv)
+{
+  if (argc != 2)
+  {
+    fprintf(stderr, "Usage: %s LOG.mfstats > LOG.csv\n", argv[0]);
+    return 1;
+  }
+
+  LOG.SetByteSink(STDERR);
+  LOG.SetLevel(LOG.WARNING);
+
+  bool ok = StatsLog::WriteCSV(argv[1], STDOUT);
+  STDOUT.Flush();
+  return ok ? 0 : 1;
+}
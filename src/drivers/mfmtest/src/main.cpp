@@ -55,11 +55,20 @@ int main(int argc, char** argv)
 #endif
 
   TEST(EventWindow_Test);
+  TEST(ElementTable_Test);
   TEST(Tile_Test);
+  TEST(EventHistoryBuffer_Test);
 
   Grid_Test::Test_gridPlaceAtom();
+  Grid_Test::Test_gridSchedulerWorkers();
+  Grid_Test::Test_gridElementProfile();
+  Grid_Test::Test_gridFrameRenderer();
 
   TEST(ExternalConfig_Test);
+  TEST(LonglivedLock_Test);
+  TEST(StatsLog_Test);
+  TEST(WorkerPool_Test);
+  TEST(AsyncGridSaver_Test);
 
   return 0;
 }
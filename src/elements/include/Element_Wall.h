@@ -61,6 +61,7 @@ namespace MFM
     {
       Element<EC>::SetAtomicSymbol("W");
       Element<EC>::SetName("Wall");
+      Element<EC>::SetInert();
     }
 
     virtual const T & GetDefaultAtom() const
@@ -394,6 +394,7 @@ namespace MFM
 
     void KeyboardUpdate(SDL_KeyboardEvent & key, OurGrid& grid, const SPoint where)
     {
+      m_gridPanel.NeedFullRepaint();  // Keys can change how anything looks
       {
         KeyboardEvent kbe(key, where);
         if (m_rootPanel.Dispatch(kbe,
@@ -600,6 +601,7 @@ namespace MFM
       m_gridPanel.SetBorder(Drawing::BLACK);
       m_gridPanel.SetGrid(&Super::GetGrid());
       m_gridPanel.SetTileRenderer(&m_tileRenderer);
+      m_statisticsPanel.SetGridPanel(&m_gridPanel);
 
 #if 0
       m_statisticsPanel.SetGrid(&Super::GetGrid());
@@ -1067,6 +1069,23 @@ namespace MFM
       driver->m_desiredScreenHeight = out;
     }
 
+    static void SetPaintThreadsFromArgs(const char* str, void* driverptr)
+    {
+      AbstractGUIDriver* driver = (AbstractGUIDriver<GC>*)driverptr;
+      VArguments& args = driver->m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(str, out, 0, GridPanel<GC>::MAX_PAINT_THREADS);
+      if (errmsg)
+      {
+        args.Die("Paint thread count '%s' not in 0..%d: %s",
+                 str, GridPanel<GC>::MAX_PAINT_THREADS, errmsg);
+      }
+
+      driver->m_gridPanel.SetPaintThreads(out == 0 ? GridPanel<GC>::GetDefaultPaintThreads() : (u32) out);
+    }
+
     static void SetScreenSizeFixed(const char* str, void* driverptr)
     {
       AbstractGUIDriver* driver = (AbstractGUIDriver<GC>*)driverptr;
@@ -1133,6 +1152,9 @@ namespace MFM
       this->RegisterArgument("Request a fixed-size (non-resizable) window.",
                              "--screenfixed|--sf", &SetScreenSizeFixed, this, false);
 
+      this->RegisterArgument("Paint the grid with ARG threads (0 -> one per CPU, up to 8)",
+                             "--paintthreads", &SetPaintThreadsFromArgs, this, true);
+
       this->RegisterArgument("Record a png per epoch for playback at ARG fps",
                              "-p|--pngs", &SetRecordScreenshotPerAEPSFromArgs, this, true);
 
@@ -1269,6 +1291,9 @@ namespace MFM
 
           mousebuttondispatch:
             {
+              // Tools, buttons, and parameter sliders can all change
+              // how sites look without writing them
+              m_gridPanel.NeedFullRepaint();
               MouseButtonEvent mbe(keyboardModifiers, event);
               m_rootPanel.Dispatch(mbe,
                                    Rect(SPoint(),
@@ -1279,6 +1304,10 @@ namespace MFM
           case SDL_MOUSEMOTION:
           {
             lastKnownMousePosition.Set(event.motion.x, event.motion.y);
+            if (mouseButtonsDown)
+            {
+              m_gridPanel.NeedFullRepaint();  // Dragging, as above
+            }
             MouseMotionEvent mme(keyboardModifiers, event,
                                  mouseButtonsDown, dragStartPositions);
             m_rootPanel.Dispatch(mme,
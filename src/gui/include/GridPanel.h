@@ -37,7 +37,10 @@
 #include "Sense.h"
 #include "TileRenderer.h"
 #include "Util.h"
+#include "WorkerPool.h"
 #include <math.h> /* for sqrt */
+#include <time.h> /* for clock_gettime */
+#include <unistd.h> /* for sysconf */
 #include "GUIConstants.h"
 
 namespace MFM
@@ -56,7 +59,7 @@ namespace MFM
    * A template class for displaying the Grid in a Panel.
    */
   template <class GC>
-  class GridPanel : public Panel
+  class GridPanel : public Panel, private WorkerPool::Job
   {
     typedef Panel Super;
    public:
@@ -170,6 +173,58 @@ namespace MFM
 
     u32 GetAtomDit() const { return GetTileRenderer().GetAtomSizeDit(); }
 
+    enum { MAX_PAINT_THREADS = 8 };
+
+    /**
+       One painting thread per CPU, up to MAX_PAINT_THREADS
+     */
+    static u32 GetDefaultPaintThreads()
+    {
+      long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+      return (u32) MAX(1L, MIN(cpus, (long) MAX_PAINT_THREADS));
+    }
+
+    /**
+       Paint the tiles with \c threads threads in all, 1 to
+       MAX_PAINT_THREADS, counting the GUI thread.  Takes effect at
+       the next frame.
+     */
+    void SetPaintThreads(u32 threads)
+    {
+      MFM_API_ASSERT_ARG(threads > 0 && threads <= MAX_PAINT_THREADS);
+      m_paintThreads = threads;
+    }
+
+    u32 GetPaintThreads() const
+    {
+      return m_paintThreads;
+    }
+
+    /**
+       Milliseconds taken to paint the tiles of a frame, averaged over
+       roughly the last PAINT_TIME_FRAMES frames, or 0 if none have
+       been painted (or there's no backing surface to paint them into)
+     */
+    double GetPaintMillis() const
+    {
+      return m_paintMillis;
+    }
+
+    /**
+       The color cache hit rate over all the painting threads
+     */
+    double GetColorCacheHitPercent() const
+    {
+      u64 hits = GetTileRenderer().GetColorCache().GetHits();
+      u64 misses = GetTileRenderer().GetColorCache().GetMisses();
+      for (u32 i = 0; i < m_paintHelpers; ++i)
+      {
+        hits += m_paintRenderers[i].GetColorCache().GetHits();
+        misses += m_paintRenderers[i].GetColorCache().GetMisses();
+      }
+      return hits + misses ? 100.0 * hits / (hits + misses) : 0;
+    }
+
     void PaintSelectedTileMarkers(Drawing & drawing)
     {
       OurGrid & grid = GetGrid();
@@ -267,6 +322,16 @@ namespace MFM
       m_selectedTiles.Clear();
     }
 
+    /**
+       Repaint every tile next frame, not just what's been written.
+       For changes to how sites look that write no sites -- from
+       tools, element parameters, and so on.
+     */
+    void NeedFullRepaint()
+    {
+      m_repaintAll = true;
+    }
+
    private:
     OurTileRenderer * m_tileRenderer;
     void SetAtomDit(u32 newdit) { GetTileRenderer().SetAtomSizeDit(newdit); }
@@ -295,6 +360,34 @@ namespace MFM
     bool m_recheckTileSelections;
     EventHistoryStrategy m_eventHistoryStrategy;
 
+    enum {
+      /* Repaint everything at least this often, to catch changes
+         that write no sites, like element color parameters */
+      FULL_REPAINT_FRAMES = 64,
+
+      /* GetPaintMillis averages over about this many frames */
+      PAINT_TIME_FRAMES = 16
+    };
+
+    /* The tiles as last painted, which PaintTilesBacked updates */
+    SDL_Surface * m_backing;
+    bool m_repaintAll;
+    u32 m_framesSinceRepaintAll;
+    u32 m_paintedSettingsStamp;
+    SPoint m_paintedGridOriginDit;
+    u32 m_paintedGenerations[MAX_TILES_IN_GRID];  // By ToTileSelectIndex
+    bool m_paintedEnabled[MAX_TILES_IN_GRID];     // Not bits: threads write them
+
+    /* Painting the tiles of a frame in parallel; see PaintTilesBacked */
+    WorkerPool m_paintPool;
+    u32 m_paintThreads;
+    OurTileRenderer * m_paintRenderers;           // For threads 1 and up
+    SDL_Surface * m_paintSurfaces[MAX_PAINT_THREADS];  // Views of m_backing, likewise
+    u32 m_paintHelpers;                           // Threads 1 and up
+    const Drawing * m_paintDrawing;               // The frame's drawing on m_backing
+    u32 m_nextPaintTile;                          // Claimed with __sync_fetch_and_add
+    double m_paintMillis;
+
 
     u32 ToTileSelectIndex(UPoint positionInGrid)
     {
@@ -421,6 +514,17 @@ namespace MFM
       , m_selectedTiles()
       , m_recheckTileSelections(true)
       , m_eventHistoryStrategy(EVENT_HISTORY_STRATEGY_SELECTED)
+      , m_backing(0)
+      , m_repaintAll(true)
+      , m_framesSinceRepaintAll(0)
+      , m_paintedSettingsStamp(0)
+      , m_paintedGridOriginDit(0,0)
+      , m_paintThreads(GetDefaultPaintThreads())
+      , m_paintRenderers(0)
+      , m_paintHelpers(0)
+      , m_paintDrawing(0)
+      , m_nextPaintTile(0)
+      , m_paintMillis(0)
     {
       SetName("GridPanel");
       SetDimensions(SCREEN_INITIAL_WIDTH,
@@ -442,7 +546,14 @@ namespace MFM
       }
     }
 
-    virtual ~GridPanel() { } //avoid inline error
+    virtual ~GridPanel()
+    {
+      FreePaintHelpers();
+      if (m_backing)
+      {
+        SDL_FreeSurface(m_backing);
+      }
+    }
 
     void Init() { }
 
@@ -609,6 +720,7 @@ namespace MFM
     void PaintTiles(Drawing & drawing)
     {
       GetTileRenderer().SetDrawBases(m_currentGridTool && m_currentGridTool->IsSiteEdit());
+      GetTileRenderer().BeginFrame();
       for (typename Grid<GC>::iterator_type i = m_mainGrid->begin(); i != m_mainGrid->end(); ++i)
       {
         SPoint tileCoord = i.At();
@@ -625,6 +737,257 @@ namespace MFM
       }
     }
 
+    /**
+       Make sure m_backing is a surface like the screen, of \c size,
+       forcing a full repaint if it had to be (re)made.  Return false
+       if there's no screen to be like.
+     */
+    bool UpdateBacking(const UPoint size)
+    {
+      if (m_backing && (u32) m_backing->w == size.GetX() && (u32) m_backing->h == size.GetY())
+      {
+        return true;
+      }
+
+      FreePaintHelpers();
+      if (m_backing)
+      {
+        SDL_FreeSurface(m_backing);
+        m_backing = 0;
+      }
+
+      const SDL_Surface * screen = SDL_GetVideoSurface();
+      if (!screen || size.GetX() == 0 || size.GetY() == 0)
+      {
+        return false;
+      }
+
+      const SDL_PixelFormat & fmt = *screen->format;
+      m_backing = SDL_CreateRGBSurface(SDL_SWSURFACE, size.GetX(), size.GetY(), fmt.BitsPerPixel,
+                                       fmt.Rmask, fmt.Gmask, fmt.Bmask, fmt.Amask);
+      if (!m_backing)
+      {
+        LOG.Warning("Can't make %dx%d grid backing surface; painting directly",
+                    size.GetX(), size.GetY());
+        return false;
+      }
+      m_repaintAll = true;
+      return true;
+    }
+
+    void FreePaintHelpers()
+    {
+      for (u32 i = 0; i < m_paintHelpers; ++i)
+      {
+        SDL_FreeSurface(m_paintSurfaces[i]);
+      }
+      delete [] m_paintRenderers;
+      m_paintRenderers = 0;
+      m_paintHelpers = 0;
+    }
+
+    /**
+       Make sure each painting thread but the GUI's own has a
+       TileRenderer and a surface of its own, the latter sharing the
+       pixels of m_backing: Drawing clips through its surface, so
+       threads can't share one.
+     */
+    void UpdatePaintHelpers()
+    {
+      if (m_paintHelpers == m_paintThreads - 1)
+      {
+        return;
+      }
+
+      FreePaintHelpers();
+      if (m_paintThreads == 1)
+      {
+        return;
+      }
+
+      const SDL_PixelFormat & fmt = *m_backing->format;
+      m_paintRenderers = new OurTileRenderer[m_paintThreads - 1];
+      while (m_paintHelpers < m_paintThreads - 1)
+      {
+        SDL_Surface * view =
+          SDL_CreateRGBSurfaceFrom(m_backing->pixels, m_backing->w, m_backing->h,
+                                   fmt.BitsPerPixel, m_backing->pitch,
+                                   fmt.Rmask, fmt.Gmask, fmt.Bmask, fmt.Amask);
+        if (!view)
+        {
+          LOG.Warning("Can't make grid painting surface; painting with %d threads",
+                      m_paintHelpers + 1);
+          m_paintThreads = m_paintHelpers + 1;
+          break;
+        }
+        m_paintSurfaces[m_paintHelpers++] = view;
+      }
+    }
+
+    static double GetMonotonicMillis()
+    {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+    }
+
+    /**
+       Paint the tiles via m_backing, which holds them as painted last
+       frame: after a pan, zoom, settings change, or NeedFullRepaint,
+       repaint every tile, but otherwise only the blocks of each
+       written since (see Tile::GetWriteGeneration).  Then copy
+       it all to \c drawing.  Return false, having painted nothing,
+       if there's no backing to use.
+
+       The tiles are shared out among GetPaintThreads() threads, each
+       with its own TileRenderer (copying the draw settings of
+       GetTileRenderer(), which the GUI thread uses) and clipping each
+       tile to its own part of m_backing.  The copy to \c drawing, and
+       everything after, stays on the GUI thread.
+     */
+    bool PaintTilesBacked(Drawing & drawing)
+    {
+      const double start = GetMonotonicMillis();
+
+      Rect window;
+      drawing.GetWindow(window);
+      if (!UpdateBacking(window.GetSize()))
+      {
+        return false;
+      }
+      UpdatePaintHelpers();
+
+      OurTileRenderer & tr = GetTileRenderer();
+      tr.SetDrawBases(m_currentGridTool && m_currentGridTool->IsSiteEdit());
+      tr.BeginFrame();
+      for (u32 i = 0; i < m_paintHelpers; ++i)
+      {
+        m_paintRenderers[i].CopyDrawSettingsFrom(tr);
+        m_paintRenderers[i].BeginFrame();
+      }
+
+      const u32 settingsStamp = tr.GetDrawSettingsStamp();
+      if (settingsStamp != m_paintedSettingsStamp ||
+          m_gridOriginDit != m_paintedGridOriginDit ||
+          !tr.CanPaintChangesOnly() ||
+          ++m_framesSinceRepaintAll >= FULL_REPAINT_FRAMES)
+      {
+        m_repaintAll = true;
+      }
+
+      Drawing backing(m_backing, drawing.GetFont());
+      backing.SetForeground(drawing.GetForeground());
+      backing.SetBackground(drawing.GetBackground());
+      if (m_repaintAll)
+      {
+        backing.Clear();
+        m_framesSinceRepaintAll = 0;
+      }
+
+      m_paintDrawing = &backing;
+      m_nextPaintTile = 0;
+      m_paintPool.Run(*this, m_paintHelpers + 1);
+      m_paintDrawing = 0;
+
+      m_repaintAll = false;
+      m_paintedSettingsStamp = settingsStamp;
+      m_paintedGridOriginDit = m_gridOriginDit;
+
+      drawing.BlitImage(m_backing, SPoint(0, 0), window.GetSize());
+
+      const double millis = GetMonotonicMillis() - start;
+      m_paintMillis = m_paintMillis == 0 ? millis :
+        m_paintMillis + (millis - m_paintMillis) / PAINT_TIME_FRAMES;
+      return true;
+    }
+
+    /**
+       Claim and paint tiles until none are left, as painting thread
+       \c thread of PaintTilesBacked
+     */
+    virtual void Work(u32 thread)
+    {
+      OurTileRenderer & tr = thread == 0 ? GetTileRenderer() : m_paintRenderers[thread - 1];
+      Drawing drawing(thread == 0 ? m_backing : m_paintSurfaces[thread - 1], m_paintDrawing->GetFont());
+      drawing.SetForeground(m_paintDrawing->GetForeground());
+      drawing.SetBackground(m_paintDrawing->GetBackground());
+
+      const OurGrid & grid = GetGrid();
+      const u32 gridWidth = grid.GetWidth();
+      const u32 tiles = gridWidth * grid.GetHeight();
+      while (true)
+      {
+        const u32 claim = __sync_fetch_and_add(&m_nextPaintTile, 1);
+        if (claim >= tiles)
+        {
+          return;
+        }
+
+        const SPoint tileCoord(claim % gridWidth, claim / gridWidth);
+        if (!grid.IsLegalTileIndex(tileCoord) || grid.GetTile(tileCoord).IsDummyTile())
+        {
+          continue;
+        }
+        PaintTileBacked(drawing, tr, grid.GetTile(tileCoord), tileCoord);
+      }
+    }
+
+    void PaintTileBacked(Drawing & drawing, OurTileRenderer & tr,
+                         const OurTile & tile, const SPoint tileCoord)
+    {
+      const u32 index = ToTileSelectIndex(MakeUnsigned(tileCoord));
+      const u32 generation = tile.GetWriteGeneration();
+      const bool enabled = tile.IsEnabled();
+      const bool all = m_repaintAll || enabled != m_paintedEnabled[index];
+
+      if (all || generation != m_paintedGenerations[index])
+      {
+        // Clip to the half-open pixel range [Floor(min), Floor(max)),
+        // plus one pixel for the grid line on each far edge -- but
+        // never reaching the next tile's first pixel, so each pixel
+        // belongs to exactly one tile and one painting thread
+        const Rect screenDitForTile = MapTileInGridToScreenDit(tile, tileCoord);
+        const SPoint ditMin = screenDitForTile.GetPosition();
+        const SPoint ditMax = ditMin + MakeSigned(screenDitForTile.GetSize());
+        const SPoint pixMin(Drawing::MapDitToPixFloor(ditMin.GetX()), Drawing::MapDitToPixFloor(ditMin.GetY()));
+        SPoint pixMax(Drawing::MapDitToPixFloor(ditMax.GetX()) + 1,
+                      Drawing::MapDitToPixFloor(ditMax.GetY()) + 1);
+
+        const OurGrid & grid = GetGrid();
+        if ((u32) tileCoord.GetX() + 1 < grid.GetWidth())
+        {
+          const SPoint next = MapTileInGridToScreenDit(tile, tileCoord + SPoint(1, 0)).GetPosition();
+          pixMax.SetX(MIN(pixMax.GetX(), Drawing::MapDitToPixFloor(next.GetX())));
+        }
+        if ((u32) tileCoord.GetY() + 1 < grid.GetHeight())
+        {
+          const SPoint next = MapTileInGridToScreenDit(tile, tileCoord + SPoint(0, 1)).GetPosition();
+          pixMax.SetY(MIN(pixMax.GetY(), Drawing::MapDitToPixFloor(next.GetY())));
+        }
+
+        Rect window;
+        drawing.GetWindow(window);
+        Rect clip(window.GetPosition() + pixMin, MakeUnsigned(pixMax - pixMin));
+        clip.IntersectWith(window);
+        if (clip.GetWidth() > 0 && clip.GetHeight() > 0)
+        {
+          const SPoint ditOrigin = ditMin - Drawing::MapPixToDit(clip.GetPosition() - window.GetPosition());
+          drawing.SetWindow(clip);
+          if (all)
+          {
+            tr.PaintTileAtDit(drawing, ditOrigin, tile);
+          }
+          else
+          {
+            tr.PaintTileChangesAtDit(drawing, ditOrigin, tile, m_paintedGenerations[index]);
+          }
+          drawing.SetWindow(window);
+        }
+      }
+      m_paintedGenerations[index] = generation;
+      m_paintedEnabled[index] = enabled;
+    }
+
     void PaintAtomViewCallouts(Drawing & d, OurAtomViewPanel & avp)
     {
       if (!avp.IsVisible() || !avp.HasGridCoord()) return;
@@ -695,9 +1058,12 @@ namespace MFM
     {
       RecheckTileSelections();
 
-      this->Super::PaintComponent(drawing);
+      if (!this->PaintTilesBacked(drawing))
+      {
+        this->Super::PaintComponent(drawing);
 
-      this->PaintTiles(drawing);
+        this->PaintTiles(drawing);
+      }
 
       this->PaintGridOverlays(drawing);
     }
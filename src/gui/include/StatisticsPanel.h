@@ -32,6 +32,7 @@
 #include "GUIConstants.h"
 #include "Grid.h"
 #include "AbstractDriver.h"
+#include "GridPanel.h"
 
 namespace MFM
 {
@@ -58,8 +59,9 @@ namespace MFM
       , m_displayVersionLine(1)
       , m_displayTimestampLine(1)
       , m_displayAEPS(1)
-      , m_maxDisplayAER(5)
+      , m_maxDisplayAER(6)
       , m_screenshotTargetFPS(-1)
+      , m_gridPanel(0)
         //      , m_registeredButtons(0)
       , m_drawPoint(10,0)
     {
@@ -303,6 +305,8 @@ namespace MFM
 
     s32 m_screenshotTargetFPS;
 
+    const GridPanel<GC> * m_gridPanel;
+
 #if 0 // Mon Jun 29 12:11:56 2015  WTF?  Prehistory?
     static const u32 MAX_BUTTONS = 16;
     AbstractButton* m_buttons[MAX_BUTTONS];
@@ -369,6 +373,15 @@ namespace MFM
       m_screenshotTargetFPS = fps;
     }
 
+    /**
+       Report the color cache hit rate and paint time of \c gp, at
+       the highest DisplayAER level
+     */
+    void SetGridPanel(const GridPanel<GC> * gp)
+    {
+      m_gridPanel = gp;
+    }
+
     void SetDisplayAER(u32 displayAER)
     {
       m_displayAER = displayAER % (m_maxDisplayAER + 1);
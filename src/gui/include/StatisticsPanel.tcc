@@ -158,6 +158,26 @@ namespace MFM {
         break;
       }
 
+      if (m_gridPanel)
+      {
+        sprintf(strBuffer, "%0.1f %%color hit", m_gridPanel->GetColorCacheHitPercent());
+        size = drawing.GetTextSize(strBuffer);
+        loc = SPoint(MAX(0, ((s32) dims.GetX())-size.GetX())/2, baseY);
+        drawing.BlitText(strBuffer,
+                         loc,
+                         UPoint(dims.GetX(), ROW_HEIGHT));
+        baseY += DETAIL_ROW_HEIGHT;
+
+        sprintf(strBuffer, "%0.2f ms paint/%d", m_gridPanel->GetPaintMillis(),
+                m_gridPanel->GetPaintThreads());
+        size = drawing.GetTextSize(strBuffer);
+        loc = SPoint(MAX(0, ((s32) dims.GetX())-size.GetX())/2, baseY);
+        drawing.BlitText(strBuffer,
+                         loc,
+                         UPoint(dims.GetX(), ROW_HEIGHT));
+        baseY += DETAIL_ROW_HEIGHT;
+      }
+
     } while (0);
 
     if (m_displayAER > 0)
@@ -32,7 +32,9 @@
 
 #include "Tile.h"
 #include "Site.h"
+#include "SiteColorer.h"
 #include "Drawing.h"
+#include "Mutex.h"
 #include "UlamContextRestricted.h"
 
 namespace MFM
@@ -46,7 +48,7 @@ namespace MFM
     typedef typename AC::ATOM_TYPE T;
     typedef typename EC::SITE S;
     typedef Tile<EC> OurTile;
-    typedef Site<AC> OurSite;
+    typedef ConstSiteRef<AC> OurSite;
 
     enum { EWR = EC::EVENT_WINDOW_RADIUS };
 
@@ -56,22 +58,8 @@ namespace MFM
       MAXIMUM_ATOM_SIZE_DIT = 1024 * Drawing::DIT_PER_PIX
     };
 
-    enum DrawSiteType {
-      DRAW_SITE_ELEMENT,         //< Static color of event layer atom
-      DRAW_SITE_ATOM_1,          //< Dynamic per-atom rendering type 1
-      DRAW_SITE_ATOM_2,          //< Dynamic per-atom rendering type 2
-      DRAW_SITE_BASE,            //< Static color of base atom
-      DRAW_SITE_BASE_1,          //< Dynamic base-atom rendering type 1
-      DRAW_SITE_BASE_2,          //< Dynamic base-atom rendering type 2
-      DRAW_SITE_LIGHT_TILE,      //< Light grey rendering of tile regions
-      DRAW_SITE_DARK_TILE,       //< Dark grey rendering of hidden regions
-      DRAW_SITE_CHANGE_AGE,      //< CubeHelix rendering of events-since-change
-      DRAW_SITE_PAINT,           //< Last color painted on site
-      DRAW_SITE_NONE,            //< Do not draw atoms at all
-      DRAW_SITE_BLACK,           //< Fill with black
-      DRAW_SITE_WHITE,           //< Fill with white
-      DRAW_SITE_TYPE_COUNT
-    };
+    typedef SiteColorer<EC> OurSiteColorer;
+    typedef typename OurSiteColorer::DrawSiteType DrawSiteType;
 
     enum DrawSiteShape {
       DRAW_SHAPE_FILL,           //< Flood fill site entirely (square)
@@ -99,7 +87,33 @@ namespace MFM
       return GetDrawSiteTypeName(m_drawForegroundType);
     }
 
-    static const char * GetDrawSiteTypeName(DrawSiteType t) ;
+    static const char * GetDrawSiteTypeName(DrawSiteType t)
+    {
+      return OurSiteColorer::GetDrawSiteTypeName(t);
+    }
+
+    /**
+       Call before painting the tiles of each frame, so cached atom
+       colors are refreshed now and then (see AtomColorCache).
+     */
+    void BeginFrame()
+    {
+      m_colorCache.BeginFrame();
+    }
+
+    const AtomColorCache<EC> & GetColorCache() const
+    {
+      return m_colorCache;
+    }
+
+    /**
+       Draw as \c other does, taking all its draw settings but keeping
+       our own color cache, so several TileRenderers can paint the
+       tiles of one frame on different threads.  Labels and icons come
+       from the global fonts and images, so painting them is serialized
+       across all TileRenderers; everything else they do is independent.
+     */
+    void CopyDrawSettingsFrom(const TileRenderer & other) ;
 
     /**
        How much space will it currently take to draw this whole tile?
@@ -138,6 +152,34 @@ namespace MFM
     void PaintTileAtDit(Drawing & drawing,
                         const SPoint ditOrigin, const OurTile & tile) ;
 
+    /**
+       Repaint just the write-tracking blocks of \c tile, drawn at \c
+       ditOrigin, that have been written since the tile's write
+       generation was \c since (see Tile::GetWriteGeneration),
+       assuming \c drawing still holds the rest of the tile as it was
+       painted then, with the same settings.  Each block is repainted
+       clipped to its own screen area.  Custom graphics can spill past
+       their sites, so when they are drawn the blocks around each
+       written one are repainted as well.
+     */
+    void PaintTileChangesAtDit(Drawing & drawing,
+                               const SPoint ditOrigin, const OurTile & tile, u32 since) ;
+
+    /**
+       False if the current settings draw something that changes
+       without any site being written -- like DRAW_SITE_CHANGE_AGE,
+       or a site's base or paint -- so PaintTileChangesAtDit would
+       miss it.
+     */
+    bool CanPaintChangesOnly() const ;
+
+    /**
+       A number that changes (almost surely) whenever any setting
+       affecting how tiles are drawn does, so callers keeping painted
+       tiles around know when to start over.
+     */
+    u32 GetDrawSettingsStamp() const ;
+
     void PaintSites(Drawing & drawing,
                     const DrawSiteType drawType, const DrawSiteShape shape,
                     const SPoint ditOrigin, const OurTile & tile) ;
@@ -213,17 +255,17 @@ namespace MFM
 
     u32 NextDrawBackgroundType()
     {
-      return m_drawBackgroundType = (DrawSiteType) ((m_drawBackgroundType + 1) % DRAW_SITE_TYPE_COUNT);
+      return m_drawBackgroundType = (DrawSiteType) ((m_drawBackgroundType + 1) % OurSiteColorer::DRAW_SITE_TYPE_COUNT);
     }
 
     u32 NextDrawMidgroundType()
     {
-      return m_drawMidgroundType = (DrawSiteType) ((m_drawMidgroundType + 1) % DRAW_SITE_TYPE_COUNT);
+      return m_drawMidgroundType = (DrawSiteType) ((m_drawMidgroundType + 1) % OurSiteColorer::DRAW_SITE_TYPE_COUNT);
     }
 
     u32 NextDrawForegroundType()
     {
-      return m_drawForegroundType = (DrawSiteType) ((m_drawForegroundType + 1) % DRAW_SITE_TYPE_COUNT);
+      return m_drawForegroundType = (DrawSiteType) ((m_drawForegroundType + 1) % OurSiteColorer::DRAW_SITE_TYPE_COUNT);
     }
 
     u32 GetAtomSizeDit() const
@@ -244,17 +286,27 @@ namespace MFM
                             AtomBitStorage<EC> & abs) ;
 
 
-    static bool IsDrawBase(DrawSiteType t)
-    {
-      return t >= DRAW_SITE_BASE && t <= DRAW_SITE_BASE_2;
-    }
+    /**
+       Set \c min and \c max (exclusive), in full tile coordinates, to
+       the corners of the sites of \c tile that the Paint methods
+       should visit: all those being drawn, or, within
+       PaintTileChangesAtDit, those of the block being repainted plus
+       \c margin sites around it.
+     */
+    void GetSitesToPaint(const OurTile & tile, u32 margin, SPoint & min, SPoint & max) const ;
+
+    /**
+       True if sites drawn as \c type only change looks when the
+       site's atom is written, so PaintTileChangesAtDit sees them.
+     */
+    static bool ChangesOnlyWithSiteWrites(DrawSiteType type) ;
 
     bool IsBaseVisible()
     {
       return
-        IsDrawBase(m_drawBackgroundType) ||
-        IsDrawBase(m_drawMidgroundType) ||
-        IsDrawBase(m_drawForegroundType);
+        OurSiteColorer::IsDrawBase(m_drawBackgroundType) ||
+        OurSiteColorer::IsDrawBase(m_drawMidgroundType) ||
+        OurSiteColorer::IsDrawBase(m_drawForegroundType);
     }
 
     DrawSiteType m_drawBackgroundType;
@@ -277,7 +329,17 @@ namespace MFM
 
     u32 m_gridLineColor;
 
-    u32 m_regionColors[Tile<EC>::REGION_COUNT];
+    OurSiteColorer m_siteColorer;
+
+    AtomColorCache<EC> m_colorCache;
+
+    /* Held while using fonts and icons, which aren't thread safe */
+    static Mutex m_assetLock;
+
+    /* The block PaintTileChangesAtDit is repainting, if any */
+    bool m_paintingBlock;
+    SPoint m_paintBlockMin;
+    SPoint m_paintBlockMax;
 
     /* XXX
     u32 m_selectedHiddenColor;
@@ -1,6 +1,5 @@
 /* -*- C++ -*- */
 #include "Util.h"            /* for MIN and MAX */
-#include "ColorMap.h"        /* for CubeHelix */
 #include "DrawableSDL.h"     /* for DrawableSDL, EventWindowRendererSDL, UlamContextRestrictedSDL */
 #include "UlamRef.h"         /* for UlamRef */
 
@@ -8,9 +7,9 @@ namespace MFM
 {
   template <class EC>
   TileRenderer<EC>::TileRenderer()
-    : m_drawBackgroundType(DRAW_SITE_DARK_TILE)
-    , m_drawMidgroundType(DRAW_SITE_ATOM_1)
-    , m_drawForegroundType(DRAW_SITE_NONE)
+    : m_drawBackgroundType(OurSiteColorer::DRAW_SITE_DARK_TILE)
+    , m_drawMidgroundType(OurSiteColorer::DRAW_SITE_ATOM_1)
+    , m_drawForegroundType(OurSiteColorer::DRAW_SITE_NONE)
     , m_drawEventWindow(false)
     , m_drawGridLines(true)
     , m_drawCacheSites(true)
@@ -19,11 +18,79 @@ namespace MFM
     , m_drawLabels(-1)
     , m_atomSizeDit(DEFAULT_ATOM_SIZE_DIT)
     , m_gridLineColor(Drawing::GREY30)
+    , m_paintingBlock(false)
+  { }
+
+  template <class EC>
+  Mutex TileRenderer<EC>::m_assetLock;
+
+  template <class EC>
+  void TileRenderer<EC>::CopyDrawSettingsFrom(const TileRenderer & other)
   {
-    m_regionColors[OurTile::REGION_CACHE] = InterpolateColors(Drawing::WHITE, Drawing::DARK_PURPLE, 100);
-    m_regionColors[OurTile::REGION_SHARED] = InterpolateColors(Drawing::WHITE, Drawing::DARK_PURPLE, 92);
-    m_regionColors[OurTile::REGION_VISIBLE] = InterpolateColors(Drawing::WHITE, Drawing::DARK_PURPLE, 84);
-    m_regionColors[OurTile::REGION_HIDDEN] = InterpolateColors(Drawing::WHITE, Drawing::DARK_PURPLE, 76);
+    m_drawBackgroundType = other.m_drawBackgroundType;
+    m_drawMidgroundType = other.m_drawMidgroundType;
+    m_drawForegroundType = other.m_drawForegroundType;
+    m_drawEventWindow = other.m_drawEventWindow;
+    m_drawGridLines = other.m_drawGridLines;
+    m_drawCacheSites = other.m_drawCacheSites;
+    m_drawBases = other.m_drawBases;
+    m_drawCustom = other.m_drawCustom;
+    m_drawLabels = other.m_drawLabels;
+    m_atomSizeDit = other.m_atomSizeDit;
+    m_gridLineColor = other.m_gridLineColor;
+  }
+
+  template <class EC>
+  void TileRenderer<EC>::GetSitesToPaint(const Tile<EC> & tile, u32 margin, SPoint & min, SPoint & max) const
+  {
+    const s32 indent = m_drawCacheSites ? 0 : EWR;
+    min = SPoint(indent, indent);
+    max = SPoint(tile.TILE_WIDTH - indent, tile.TILE_HEIGHT - indent);
+    if (m_paintingBlock)
+    {
+      const s32 m = (s32) margin;
+      min.Set(MAX(min.GetX(), m_paintBlockMin.GetX() - m), MAX(min.GetY(), m_paintBlockMin.GetY() - m));
+      max.Set(MIN(max.GetX(), m_paintBlockMax.GetX() + m), MIN(max.GetY(), m_paintBlockMax.GetY() + m));
+    }
+  }
+
+  template <class EC>
+  bool TileRenderer<EC>::ChangesOnlyWithSiteWrites(DrawSiteType type)
+  {
+    // Change ages grow with every event, and bases and site paint are
+    // written without stamping the tile's write generations
+    return
+      type != OurSiteColorer::DRAW_SITE_CHANGE_AGE &&
+      type != OurSiteColorer::DRAW_SITE_PAINT &&
+      !OurSiteColorer::IsDrawBase(type);
+  }
+
+  template <class EC>
+  bool TileRenderer<EC>::CanPaintChangesOnly() const
+  {
+    return
+      ChangesOnlyWithSiteWrites(m_drawBackgroundType) &&
+      ChangesOnlyWithSiteWrites(m_drawMidgroundType) &&
+      ChangesOnlyWithSiteWrites(m_drawForegroundType) &&
+      !m_drawBases &&
+      !m_drawEventWindow;
+  }
+
+  template <class EC>
+  u32 TileRenderer<EC>::GetDrawSettingsStamp() const
+  {
+    const u32 settings[] =
+    {
+      m_drawBackgroundType, m_drawMidgroundType, m_drawForegroundType,
+      m_drawEventWindow, m_drawGridLines, m_drawCacheSites, m_drawBases,
+      m_drawCustom, (u32) m_drawLabels, m_atomSizeDit, m_gridLineColor
+    };
+    u32 stamp = 0;
+    for (u32 i = 0; i < sizeof(settings) / sizeof(settings[0]); ++i)
+    {
+      stamp = (stamp ^ settings[i]) * 0x9e3779b1;
+    }
+    return stamp;
   }
 
   template <class EC>
@@ -48,11 +115,11 @@ namespace MFM
     {
     default: break;  // Deal with illegal or non-floodable below
 
-    case DRAW_SITE_NONE:
+    case OurSiteColorer::DRAW_SITE_NONE:
       // That was easy
       return;
 
-    case DRAW_SITE_DARK_TILE:
+    case OurSiteColorer::DRAW_SITE_DARK_TILE:
       {
         Rect r(ditOrigin + ComputeDrawInsetDit(tile, OurTile::REGION_VISIBLE),
                MakeUnsigned(ComputeDrawSizeDit(tile, OurTile::REGION_VISIBLE)));
@@ -60,7 +127,7 @@ namespace MFM
       }
       return;
 
-    case DRAW_SITE_LIGHT_TILE:
+    case OurSiteColorer::DRAW_SITE_LIGHT_TILE:
       {
         for (u32 i = OurTile::REGION_CACHE; i <= OurTile::REGION_HIDDEN; ++i)
         {
@@ -68,19 +135,25 @@ namespace MFM
 
           Rect r(ditOrigin + ComputeDrawInsetDit(tile, i),
                  MakeUnsigned(ComputeDrawSizeDit(tile, i)));
-          drawing.FillRectDit(r, m_regionColors[i]);
+          drawing.FillRectDit(r, m_siteColorer.GetRegionColor(i));
         }
       }
       return;
     }
 
-    // Here we need to iterate over the sites
-    typename OurTile::const_iterator_type end = tile.end(m_drawCacheSites);
-    for (typename OurTile::const_iterator_type i = tile.begin(m_drawCacheSites); i != end; ++i)
+    // Here we need to iterate over the sites.  One more all around
+    // a block, in case a site straddles a pixel on its edge
+    SPoint min, max;
+    GetSitesToPaint(tile, 1, min, max);
+    const s32 indent = m_drawCacheSites ? 0 : EWR;
+    for (s32 y = min.GetY(); y < max.GetY(); ++y)
     {
-      SPoint siteInTileCoord = i.At();
-      SPoint screenDitForSite = ditOrigin + siteInTileCoord * m_atomSizeDit;
-      PaintSiteAtDit(drawing, drawType, shape, screenDitForSite, *i, tile);
+      for (s32 x = min.GetX(); x < max.GetX(); ++x)
+      {
+        SPoint siteInTile(x, y);
+        SPoint screenDitForSite = ditOrigin + (siteInTile - SPoint(indent, indent)) * m_atomSizeDit;
+        PaintSiteAtDit(drawing, drawType, shape, screenDitForSite, tile.GetSite(siteInTile), tile);
+      }
     }
   }
 
@@ -137,14 +210,21 @@ namespace MFM
     EventWindowRendererSDL<EC> ewrs(drawable);
     UlamContextRestrictedSDL<EC> ucrs(ewrs, tile);
 
-    // Here we need to iterate over the sites
-    typename OurTile::const_iterator_type end = tile.end(m_drawCacheSites);
-    for (typename OurTile::const_iterator_type i = tile.begin(m_drawCacheSites); i != end; ++i)
+    // Here we need to iterate over the sites.  Graphics may spill
+    // into a block from sites a whole block away
+    SPoint min, max;
+    GetSitesToPaint(tile, OurTile::WRITE_BLOCK_SIDE, min, max);
+    const s32 indent = m_drawCacheSites ? 0 : EWR;
+    const s32 width = MAX(0, max.GetX() - min.GetX());
+    const s32 sites = width * MAX(0, max.GetY() - min.GetY());
+    for (s32 i = 0; i < sites; ++i)
     {
-      SPoint siteInTileCoord = i.At();
+      const s32 x = min.GetX() + i % width;
+      const s32 y = min.GetY() + i / width;
+      SPoint siteInTileCoord = SPoint(x, y) - SPoint(indent, indent);
       SPoint siteOriginDit = tileDitOrigin + siteInTileCoord * m_atomSizeDit + SPoint(m_atomSizeDit/2,m_atomSizeDit/2); // Center of site
 
-      AtomBitStorage<EC> abs(i->GetAtom());
+      AtomBitStorage<EC> abs(tile.GetSite(SPoint(x, y)).GetAtom());
       const T& atom = abs.GetAtom();
       if (!atom.IsSane()) continue;
 
@@ -200,7 +280,7 @@ namespace MFM
         return;
     }
     PaintSites(drawing,
-               (m_drawBases && !IsBaseVisible()) ? DRAW_SITE_BASE : m_drawBackgroundType,
+               (m_drawBases && !IsBaseVisible()) ? OurSiteColorer::DRAW_SITE_BASE : m_drawBackgroundType,
                DRAW_SHAPE_FILL, ditOrigin, tile);
     PaintUnderlays(drawing, ditOrigin, tile);  // E.g. an event window
 
@@ -214,6 +294,62 @@ namespace MFM
     PaintOverlays(drawing, ditOrigin, tile);   // E.g., a tool footprint
   }
 
+  template <class EC>
+  void TileRenderer<EC>::PaintTileChangesAtDit(Drawing & drawing, const SPoint ditOrigin, const Tile<EC> & tile, u32 since)
+  {
+    const s32 B = OurTile::WRITE_BLOCK_SIDE;
+    const s32 blocksWide = (tile.TILE_WIDTH + B - 1) / B;
+    const s32 blocksHigh = (tile.TILE_HEIGHT + B - 1) / B;
+    const s32 spill = m_drawCustom ? 1 : 0;  // Blocks away that a write can show
+    const s32 indent = m_drawCacheSites ? 0 : EWR;
+
+    Rect window;
+    drawing.GetWindow(window);
+
+    for (s32 by = 0; by < blocksHigh; ++by)
+    {
+      for (s32 bx = 0; bx < blocksWide; ++bx)
+      {
+        bool written = false;
+        for (s32 dy = -spill; !written && dy <= spill; ++dy)
+        {
+          for (s32 dx = -spill; !written && dx <= spill; ++dx)
+          {
+            written = tile.IsBlockWrittenSince(bx + dx, by + dy, since);
+          }
+        }
+        if (!written) continue;
+
+        // The block's sites that are drawn at all
+        m_paintBlockMin.Set(MAX(bx * B, indent), MAX(by * B, indent));
+        m_paintBlockMax.Set(MIN((bx + 1) * B, (s32) tile.TILE_WIDTH - indent),
+                            MIN((by + 1) * B, (s32) tile.TILE_HEIGHT - indent));
+        if (m_paintBlockMin.GetX() >= m_paintBlockMax.GetX() ||
+            m_paintBlockMin.GetY() >= m_paintBlockMax.GetY())
+          continue;
+
+        // Their screen area, rounded out to whole pixels
+        const SPoint ditMin = ditOrigin + (m_paintBlockMin - SPoint(indent, indent)) * m_atomSizeDit;
+        const SPoint ditMax = ditOrigin + (m_paintBlockMax - SPoint(indent, indent)) * m_atomSizeDit;
+        const SPoint pixMin(Drawing::MapDitToPixFloor(ditMin.GetX()), Drawing::MapDitToPixFloor(ditMin.GetY()));
+        const SPoint pixMax(Drawing::MapDitToPixCeiling(ditMax.GetX()), Drawing::MapDitToPixCeiling(ditMax.GetY()));
+
+        Rect clip(window.GetPosition() + pixMin, MakeUnsigned(pixMax - pixMin));
+        clip.IntersectWith(window);
+        if (clip.GetWidth() == 0 || clip.GetHeight() == 0) continue;
+
+        // Paint the whole tile as usual, but shifted to the clip's
+        // origin and only visiting the block's sites
+        drawing.SetWindow(clip);
+        m_paintingBlock = true;
+        PaintTileAtDit(drawing, ditOrigin - Drawing::MapPixToDit(clip.GetPosition() - window.GetPosition()), tile);
+        m_paintingBlock = false;
+      }
+    }
+
+    drawing.SetWindow(window);
+  }
+
   template <class EC>
   void TileRenderer<EC>::OutlineEventWindowInTile(Drawing & drawing, const SPoint ditOrigin, const Tile<EC> & tile, SPoint site, u32 color)
   {
@@ -253,87 +389,34 @@ namespace MFM
                                         const DrawSiteType drawType,
                                         const DrawSiteShape shape,
                                         const SPoint ditOrigin,
-                                        const Site<AC> & site,
+                                        const OurSite & site,
                                         const Tile<EC> & inTile)
   {
-    u32 selector = 0;
     u32 drawColor;
-    bool specifiedDrawColor = false;
-    bool fromBase = false;
-    switch (drawType)
+    const Element<EC> * elt;
+    switch (m_siteColorer.GetSiteColor(drawType, site, inTile, drawColor, &elt, &m_colorCache))
     {
     default:
       FAIL(ILLEGAL_STATE);
 
-    case DRAW_SITE_NONE:
-    case DRAW_SITE_DARK_TILE:
-    case DRAW_SITE_LIGHT_TILE:
-      // Flat backgrounds were handled per-tile..
+    case OurSiteColorer::SITE_COLOR_NONE:
       return;
 
-    case DRAW_SITE_CHANGE_AGE:
-      {
-        const u32 writeAge = site.GetWriteAge();
-        const u32 MAX_IDX = 10000;       // Potential (interpolated) colors
-        const u32 AGE_PER_AEPS = 1; // Counting site events directly.., was: tile.GetSites();
-        const double MAX_EXPT = 4.0;     // 10**4.0 == 10kAEPS for fully black
-        const double LOG_SCALER = MAX_IDX/MAX_EXPT;
-        const double writeAgeAEPS = 1.0 * writeAge / AGE_PER_AEPS + 1;
-        const u32 colorIndex = MIN(MAX_IDX, (u32) (LOG_SCALER*log10(writeAgeAEPS)));
-        const u32 color =
-          ColorMap_CubeHelixRev::THE_INSTANCE.
-          GetInterpolatedColor(colorIndex,0,MAX_IDX,0xffff0000);
-
-        PaintShapeForSite(drawing, shape, ditOrigin, color);
-      }
-      return;
-
-    case DRAW_SITE_PAINT:
-      {
-        PaintShapeForSite(drawing, shape, ditOrigin, site.GetPaint());
-      }
-      return;
-
-    case DRAW_SITE_BLACK:  drawColor = 0xff000000; specifiedDrawColor = true; break;
-    case DRAW_SITE_WHITE:  drawColor = 0xffffffff; specifiedDrawColor = true; break;
-    case DRAW_SITE_ELEMENT: break;
-    case DRAW_SITE_ATOM_1: selector = 1; break;
-    case DRAW_SITE_ATOM_2: selector = 2; break;
-
-    case DRAW_SITE_BASE: fromBase = true; break;
-    case DRAW_SITE_BASE_1: fromBase = true; selector = 1; break;
-    case DRAW_SITE_BASE_2: fromBase = true; selector = 2; break;
-
-    }
-
-    if (specifiedDrawColor) {
-      PaintShapeForSite(drawing, shape, ditOrigin, drawColor);
-      return;
-    }
-
-    // Here if we need to do atom-specific painting
-
-    const char * elementLabel  = 0;
-
-    const T & atom = fromBase ? site.GetBase().GetBaseAtom() : site.GetAtom();
-    if(!atom.IsSane())
-    {
+    case OurSiteColorer::SITE_COLOR_BAD:
       // XXX HANDLE INSANE SHAPE?
       PaintBadAtomAtDit(drawing, ditOrigin);
       return;
+
+    case OurSiteColorer::SITE_COLOR_SET:
+      break;
     }
 
-    u32 type = atom.GetType();
+    PaintShapeForSite(drawing, shape, ditOrigin, drawColor);
 
-    if (type == T::ATOM_EMPTY_TYPE) return;
+    // Only element colors get labels
+    if (!elt) return;
 
-    const Element<EC> * elt = inTile.GetElementTable().Lookup(type);
-    if (!elt)
-    {
-      // XXX HANDLE INSANE SHAPE? DITTO
-      PaintBadAtomAtDit(drawing, ditOrigin);
-      return;
-    }
+    const char * elementLabel  = 0;
 
     const u32 LABEL_ATOM_SIZE_DIT = Drawing::MapPixToDit(25);
     if (m_drawLabels > 0 || (m_drawLabels < 0 && m_atomSizeDit >= LABEL_ATOM_SIZE_DIT))
@@ -341,16 +424,6 @@ namespace MFM
       elementLabel = elt->GetAtomicSymbol();
     }
 
-    if (selector == 0)
-    {
-      drawColor = elt->GetStaticColor();
-    }
-    else
-    {
-      drawColor = elt->GetDynamicColor(inTile.GetElementTable(), inTile.GetUlamClassRegistry(), atom, selector);
-    }
-    PaintShapeForSite(drawing, shape, ditOrigin, drawColor);
-
     const u32 atomDit = m_atomSizeDit;
 
     UPoint pixSize = Drawing::MapDitToPix(UPoint(atomDit, atomDit));
@@ -358,6 +431,7 @@ namespace MFM
 
     if (elementLabel && shape == DRAW_SHAPE_CIRCLE)
     {
+      Mutex::ScopeLock lock(m_assetLock);
       drawing.SetFont(FONT_ASSET_ELEMENT);
       const SPoint size = drawing.GetTextSize(elementLabel);
       u32 ditSize = 5u*m_atomSizeDit/Drawing::MapPixToDit(1u);
@@ -408,32 +482,10 @@ namespace MFM
     Rect r(Drawing::MapDitToPix(ditOrigin), Drawing::MapDitToPix(UPoint(m_atomSizeDit, m_atomSizeDit)));
     IconAsset ia;
     ia.SetIconSlot(ZSLOT_ICON_ERROR);
+    Mutex::ScopeLock lock(m_assetLock);
     drawing.BlitIconAsset(ia, r.GetHeight(), r.GetPosition());
   }
 
-  template <class EC>
-  const char * TileRenderer<EC>::GetDrawSiteTypeName(DrawSiteType t)
-  {
-    switch (t)
-    {
-    default:
-      FAIL(ILLEGAL_ARGUMENT);
-    case DRAW_SITE_BLACK:         return "Black";
-    case DRAW_SITE_WHITE:         return "White";
-    case DRAW_SITE_ELEMENT:       return "Element";
-    case DRAW_SITE_ATOM_1:        return "Atom #1";
-    case DRAW_SITE_ATOM_2:        return "Atom #2";
-    case DRAW_SITE_BASE:          return "Base";
-    case DRAW_SITE_BASE_1:        return "Base #1";
-    case DRAW_SITE_BASE_2:        return "Base #2";
-    case DRAW_SITE_LIGHT_TILE:    return "Light tile";
-    case DRAW_SITE_DARK_TILE:     return "Dark tile";
-    case DRAW_SITE_CHANGE_AGE:    return "Change age";
-    case DRAW_SITE_PAINT:         return "Site paint";
-    case DRAW_SITE_NONE:          return "None";
-    }
-  }
-
   template <class EC>
   void TileRenderer<EC>::TileRendererSaveDetails(ByteSink & sink) const
   {
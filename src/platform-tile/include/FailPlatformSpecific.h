@@ -11,6 +11,8 @@ typedef struct MFMErrorEnvironment * volatile MFMErrorEnvironmentPointer_t;
 #define MAX_BACKTRACE_LEVELS 25
 struct MFMErrorEnvironment {
   jmp_buf buffer;               /* the system state as of the unwind_protect entry */
+  void * lightBuffer[5];        /* or as of unwind_protect_light, via __builtin_setjmp */
+  volatile int isLight;         /* nonzero if lightBuffer, not buffer, is in use */
   volatile const char * file;   /* the file name of the original failure */
   volatile int lineno;          /* the line number of the original failure */
   volatile int thrown;          /* Return value(s) from setjmp call */
@@ -30,6 +32,7 @@ extern "C" void MFMPrintError(FILE * stream, const char * file, const int line,
 
 extern "C" void MFMFailHere(const char * file, const int line, const int code) __attribute__ ((noreturn));
 extern "C" void MFMLongJmpHere(jmp_buf buffer, const int toThrow) __attribute__ ((noreturn));
+extern "C" void MFMUnwindHere(MFMErrorEnvironmentPointer_t errenv, const int toThrow) __attribute__ ((noreturn));
 extern "C" const char * MFMFailCodeReason(int failCode) ;
 
 #define MFM_FAIL_CODE_NUMBER(code) (MFM_FAIL_CODE_REASON_##code)
@@ -44,8 +47,7 @@ extern "C" const char * MFMFailCodeReason(int failCode) ;
     (*MFMPtrToErrEnvStackPtr)->backtraceSize =                     \
       backtrace((*MFMPtrToErrEnvStackPtr)->backtraceArray,         \
                 MAX_BACKTRACE_LEVELS),                             \
-    MFMLongJmpHere((*MFMPtrToErrEnvStackPtr)->buffer,              \
-                   number),0) :                                    \
+    MFMUnwindHere(*MFMPtrToErrEnvStackPtr, number),0) :            \
    (MFMFailHere(__FILE__,__LINE__,                                 \
                 number),0))
 
@@ -102,6 +104,7 @@ extern "C" const char * MFMFailCodeReason(int failCode) ;
 #define unwind_protect(cleanup,block)                                         \
 do {									      \
   MFMErrorEnvironment unwindProtect_errorEnvironment;			      \
+  unwindProtect_errorEnvironment.isLight = 0;                                 \
   unwindProtect_errorEnvironment.prev = (*MFMPtrToErrEnvStackPtr);	      \
   (*MFMPtrToErrEnvStackPtr) = &unwindProtect_errorEnvironment;                \
   unwindProtect_errorEnvironment.thrown = setjmp(unwindProtect_errorEnvironment.buffer); \
@@ -127,4 +130,46 @@ do {									      \
 } while (0)
 
 
+/**
+   Like unwind_protect, with the same 'cleanup' semantics and the same
+   MFMThrown* variables available in it, but cheaper to enter: it
+   saves only what the compiler's __builtin_setjmp needs -- the frame
+   and stack pointers and a resume address -- rather than the full
+   register set saved by setjmp.  Meant for hot paths such as running
+   an element behavior once per event.
+
+   Everything in the unwind_protect warning applies here too, with
+   one more restriction: as the compiler spills all live registers
+   around __builtin_setjmp, the enclosing function should do little
+   besides the unwind_protect_light itself.
+ */
+#define unwind_protect_light(cleanup,block)                                   \
+do {									      \
+  MFMErrorEnvironment unwindProtect_errorEnvironment;			      \
+  unwindProtect_errorEnvironment.isLight = 1;                                 \
+  unwindProtect_errorEnvironment.thrown = 0;                                  \
+  unwindProtect_errorEnvironment.prev = (*MFMPtrToErrEnvStackPtr);	      \
+  (*MFMPtrToErrEnvStackPtr) = &unwindProtect_errorEnvironment;                \
+  if (__builtin_expect(__builtin_setjmp(unwindProtect_errorEnvironment.lightBuffer),0)) { \
+    /* something FAILed; MFMUnwindHere stored the code in thrown */          \
+  } else {                                                                    \
+    {block}								      \
+  }                                                                           \
+  (*MFMPtrToErrEnvStackPtr) = (*MFMPtrToErrEnvStackPtr)->prev;                \
+  if (__builtin_expect(unwindProtect_errorEnvironment.thrown,0)) {            \
+    int MFMThrownFailCode __attribute__ ((unused)) =                          \
+      unwindProtect_errorEnvironment.thrown;                                  \
+    const char * MFMThrownFromFile __attribute__ ((unused)) =                 \
+      (const char *) unwindProtect_errorEnvironment.file;                     \
+    unsigned MFMThrownFromLineNo __attribute__ ((unused)) =                   \
+      unwindProtect_errorEnvironment.lineno;                                  \
+    void * const * MFMThrownBacktraceArray __attribute__ ((unused)) =         \
+      unwindProtect_errorEnvironment.backtraceArray;                          \
+    unsigned MFMThrownBacktraceSize __attribute__ ((unused)) =                \
+      unwindProtect_errorEnvironment.backtraceSize;                           \
+    {cleanup}	                                                              \
+  }                                                                           \
+} while (0)
+
+
 #endif /*FAILPLATFORMSPECIFIC_H*/
@@ -48,6 +48,14 @@ extern "C" {
     longjmp(buffer,toThrow);
   }
 
+  void MFMUnwindHere(MFMErrorEnvironmentPointer_t errenv, const int toThrow) {
+    if (errenv->isLight) {
+      errenv->thrown = toThrow;
+      __builtin_longjmp(errenv->lightBuffer, 1);
+    }
+    longjmp(errenv->buffer,toThrow);
+  }
+
   //  MFMErrorEnvironment * volatile MFMErrorEnvironmentStackTop = 0;
 
 }
@@ -34,14 +34,18 @@
 #include <sys/time.h>  /* for gettimeofday */
 #include <sys/types.h> /* for mkdir */
 #include <errno.h>     /* for errno */
+#include <unistd.h>    /* for sysconf */
 #include "Util.h"
 #include "Utils.h"     /* for GetDateTimeNow, Sleep */
 #include "ExternalConfig.h"
 #include "ExternalConfigSectionDriver.h"
 #include "ExternalConfigSectionGrid.h"
+#include "GridSnapshot.h"
+#include "AsyncGridSaver.h"
 #include "OverflowableCharBufferByteSink.h"
 #include "FileByteSource.h"
 #include "FileByteSink.h"
+#include "StatsLog.h"
 #include "TeeByteSink.h"
 #include "itype.h"
 #include "Grid.h"
@@ -122,6 +126,11 @@ namespace MFM
      */
     enum { EVENT_WINDOW_RADIUS = EC::EVENT_WINDOW_RADIUS};
 
+    /**
+     * How many elements each epoch's --profile report lists
+     */
+    enum { PROFILE_TOP_ELEMENTS = 20 };
+
     /**
      * The width of the Grid used by this simulation.
      */
@@ -156,75 +165,254 @@ namespace MFM
       m_neededElements[m_neededElementCount++] = element;
     }
 
-    virtual void WriteTimeBasedCustomHeader(FileByteSink& fp)
-    { }
-
-    virtual void WriteTimeBasedCustomData(FileByteSink& fp)
+    /**
+     * Add any statistics of a subclass's own to each row of the
+     * statistics log, as more columns of \c log.
+     */
+    virtual void WriteTimeBasedCustomData(StatsLog& log)
     { }
 
-    void WriteTimeBasedData(FileByteSink& fp, bool exists)
+    /**
+     * Add this epoch's statistics, as a row, to \c log: AEPS, AER,
+     * overhead, cache redundancy, the latest save's timings, each
+     * needed element's atom count, and each tile's events per
+     * second since the previous row.  Everything here comes from
+     * per-tile totals, so costs nothing per site.
+     */
+    void WriteTimeBasedData(StatsLog& log)
     {
+      log.Add("AEPS", GetAEPS());
+      log.Add("AEPSPerFrame", GetAEPSPerFrame());
+      log.Add("AER", GetAER());
+      log.Add("RecentAER", GetRecentAER());
+      log.Add("OverheadPercent", GetOverheadPercent());
+      log.Add("CacheRedundancy", m_grid.GetAverageCacheRedundancy());
+
+      // Of the most recent autosave; an async save's latency shows
+      // up once it has finished
+      log.Add("SavePauseUS", m_asyncSave ? m_asyncSaver.GetLastPauseUsec() : m_lastSavePauseUsec);
+      log.Add("SaveLatencyUS", m_asyncSave ? m_asyncSaver.GetLastLatencyUsec() : m_lastSaveLatencyUsec);
+      log.Add("InertEvents", m_grid.GetTotalInertEventsExecuted());
 
-      if(!exists)
+      for(u32 i = 0; i < m_neededElementCount; i++)
       {
-        fp.Printf("# AEPS AEPS/Frame AER100 Overhead100");
-        for(u32 i = 0; i < m_neededElementCount; i++)
+        log.Add(m_neededElements[i]->GetName(),
+                m_grid.GetAtomCount(m_neededElements[i]->GetType()));
+      }
+
+      const u32 tiles = m_grid.GetWidth() * m_grid.GetHeight();
+      if (m_lastTileEventsCount != tiles)
+      {
+        delete [] m_lastTileEvents;
+        m_lastTileEvents = new u64[tiles];
+        m_lastTileEventsCount = tiles;
+        m_lastTileSampleMS = 0;
+      }
+
+      u64 nowMS = GetTicksSinceEpoch();
+      u64 elapsedMS = nowMS - m_lastTileSampleMS;
+      bool first = m_lastTileSampleMS == 0;
+      m_lastTileSampleMS = nowMS;
+
+      for (u32 y = 0; y < m_grid.GetHeight(); ++y)
+      {
+        for (u32 x = 0; x < m_grid.GetWidth(); ++x)
         {
-          fp.WriteByte(' ');
-          for(const char* p = m_neededElements[i]->GetName(); *p; p++)
+          if (!m_grid.IsLegalTileIndex(SPoint(x, y)))
           {
-            if(isspace(*p))
-            {
-              fp.WriteByte('_');
-            }
-            else
-            {
-              fp.WriteByte(*p);
-            }
+            continue;
+          }
+
+          u64 & last = m_lastTileEvents[y * m_grid.GetWidth() + x];
+          u64 events = m_grid.GetTile(x, y).SampleEventsExecuted();
+          u64 eps = 0;
+          if (!first && elapsedMS > 0)
+          {
+            eps = (events - last) * 1000 / elapsedMS;
           }
+          last = events;
+
+          OString32 name;
+          name.Printf("T%d_%d_EPS", x, y);
+          log.Add(name.GetZString(), eps);
         }
-        WriteTimeBasedCustomHeader(fp);
-        fp.Println();
       }
 
-      fp.Print((u64)GetAEPS());
-      fp.WriteByte(' ');
-      fp.Print(GetAEPSPerFrame());
-      fp.WriteByte(' ');
-      fp.Print((u64)(100.0 * GetAER()));
-      fp.WriteByte(' ');
-      fp.Print((u64)(100.0 * GetOverheadPercent()));
+      WriteTimeBasedCustomData(log);
+    }
 
-      for(u32 i = 0; i < m_neededElementCount; i++)
+    /**
+     * Append per-worker event rates, in events per second since the
+     * previous call, to tbd/workers.dat.  Does nothing unless the
+     * grid is running on scheduler workers.
+     */
+    void WriteWorkerData()
+    {
+      const u32 workers = m_grid.GetSchedulerWorkers();
+      if (workers == 0)
       {
-        fp.WriteByte(' ');
-        fp.Print((u32)GetGrid().GetAtomCount(m_neededElements[i]->GetType()));
+        return;
       }
 
-      WriteTimeBasedCustomData(fp);
-      fp.Println();
-    }
+      u64 nowMS = GetTicksSinceEpoch();
+      u64 elapsedMS = nowMS - m_lastWorkerSampleMS;
+      bool first = m_lastWorkerSampleMS == 0;
+      m_lastWorkerSampleMS = nowMS;
 
-    void WriteTimeBasedData()
-    {
-      const char* path = GetSimDirPathTemporary("tbd/data.dat");
-      bool exists = true;
+      const char* path = GetSimDirPathTemporary("tbd/workers.dat");
+      FILE* fp = fopen(path, "a");
+      FileByteSink fbs(fp);
+
+      if (first)
       {
-        FILE* fp = fopen(path, "r");
-        if (!fp)
+        fbs.Printf("# AEPS");
+        for (u32 w = 0; w < workers; ++w)
         {
-          exists = false;
+          fbs.Printf(" W%d", w);
         }
-        else
+        fbs.Println();
+      }
+
+      u64 totalEPS = 0;
+      fbs.Print((u64)GetAEPS());
+      for (u32 w = 0; w < workers; ++w)
+      {
+        u64 events = m_grid.GetWorkerEventsExecuted(w);
+        u64 eps = 0;
+        if (!first && elapsedMS > 0)
         {
-          fclose(fp);
+          eps = (events - m_lastWorkerEvents[w]) * 1000 / elapsedMS;
         }
+        m_lastWorkerEvents[w] = events;
+        totalEPS += eps;
+
+        fbs.WriteByte(' ');
+        fbs.Print(eps);
       }
+      fbs.Println();
+      fclose(fp);
+
+      LOG.Debug("%d workers: %d events/sec", workers, (u32) totalEPS);
+    }
+
+    /**
+     * Append every tile's cumulative TileCounters, as of epoch \c
+     * epochAEPS, to tbd/tilecounters.csv or, as one JSON object per
+     * line, to tbd/tilecounters.json.  Does nothing unless
+     * --tilecounters was given.  Counters are sampled without pausing
+     * the tiles, so totals from different tiles may be a few events
+     * apart.
+     */
+    void WriteTileCounters(u32 epochAEPS)
+    {
+      if (m_tileCountersFormat == TILE_COUNTERS_NONE)
+      {
+        return;
+      }
+
+      const bool csv = m_tileCountersFormat == TILE_COUNTERS_CSV;
+      const char* path = GetSimDirPathTemporary(csv ? "tbd/tilecounters.csv" : "tbd/tilecounters.json");
+      bool first = m_tileCountersWritten == 0;
       FILE* fp = fopen(path, "a");
+      if (!fp)
+      {
+        LOG.Error("Can't append tile counters to '%s'", path);
+        return;
+      }
       FileByteSink fbs(fp);
 
-      WriteTimeBasedData(fbs, exists);
+      if (csv && first)
+      {
+        TileCounters::WriteCSVHeader(fbs, "epochAEPS,tileX,tileY,");
+      }
+      else if (!csv)
+      {
+        fbs.Printf("{\"epochAEPS\":%d,\"tiles\":[", epochAEPS);
+      }
+
+      TileCounters counters;
+      bool firstTile = true;
+      for (u32 y = 0; y < m_grid.GetHeight(); ++y)
+      {
+        for (u32 x = 0; x < m_grid.GetWidth(); ++x)
+        {
+          if (!m_grid.IsLegalTileIndex(SPoint(x, y)))
+          {
+            continue;
+          }
+          m_grid.GetTile(x, y).SampleCounters(counters);
+          if (csv)
+          {
+            OString32 prefix;
+            prefix.Printf("%d,%d,%d,", epochAEPS, x, y);
+            counters.WriteCSVRow(fbs, prefix.GetZString());
+          }
+          else
+          {
+            fbs.Printf("%s{\"tileX\":%d,\"tileY\":%d,\"counters\":",
+                       firstTile ? "" : ",", x, y);
+            counters.WriteJSON(fbs);
+            fbs.WriteByte('}');
+          }
+          firstTile = false;
+        }
+      }
+
+      if (!csv)
+      {
+        fbs.Println("]}");
+      }
       fclose(fp);
+      ++m_tileCountersWritten;
+    }
+
+    /**
+     * Append the grid's top elements by sampled event cost, as of
+     * epoch \c epochAEPS, to tbd/elementprofile.txt.  Does nothing
+     * unless --profile was given.
+     */
+    void WriteElementProfile(u32 epochAEPS)
+    {
+      if (m_grid.GetElementProfiling() == 0)
+      {
+        return;
+      }
+
+      const char* path = GetSimDirPathTemporary("tbd/elementprofile.txt");
+      FILE* fp = fopen(path, "a");
+      if (!fp)
+      {
+        LOG.Error("Can't append element profile to '%s'", path);
+        return;
+      }
+      FileByteSink fbs(fp);
+      fbs.Printf("# Epoch AEPS %d\n", epochAEPS);
+      m_grid.WriteElementProfile(fbs, PROFILE_TOP_ELEMENTS);
+      fbs.Println();
+      fclose(fp);
+    }
+
+    /**
+     * Add this epoch's row to tbd/stats.mfstats, opening it first if
+     * need be.  Rows reach the disk a block at a time (see StatsLog);
+     * FlushTimeBasedData writes out any still pending.
+     */
+    void WriteTimeBasedData()
+    {
+      if (!m_statsLog.IsOpen() &&
+          (m_statsLogFailed || !m_statsLog.Open(GetSimDirPathTemporary("tbd/stats.mfstats"))))
+      {
+        m_statsLogFailed = true;
+        return;
+      }
+
+      WriteTimeBasedData(m_statsLog);
+      m_statsLog.EndRow();
+    }
+
+    void FlushTimeBasedData()
+    {
+      m_statsLog.Flush();
     }
 
     void XXXCHECKCACHES() { m_grid.CheckCaches(); }
@@ -235,25 +423,40 @@ namespace MFM
      * before pausing. This also learns about how long an AEPS takes
      * to elapse, making subsequent calls more accurate in duration.
      *
+     * If SetPauseEachFrame(false) has been called, the grid is not
+     * paused at the end of the frame; statistics are sampled while
+     * it keeps running, and it is paused only for epoch processing,
+     * saves, and the like.
+     *
      * @param grid The Grid which is updated during this call.
      */
     void UpdateGrid(OurGrid& grid)
     {
-      grid.Unpause();  // pausing and unpausing should be overhead!
+      bool wasRunning = !m_pauseEachFrame && grid.IsGridRunning();
+      if (!wasRunning)
+      {
+        grid.Unpause();  // pausing and unpausing should be overhead!
+      }
 
       u64 startMS = GetTicks();  // So get the ticks after unpausing
-      if (m_ticksLastStopped != 0)
-        m_msSpentOverhead += startMS - m_ticksLastStopped;
-      else
+      u64 periodStartMS = startMS;
+      if (m_ticksLastStopped == 0)
         m_msSpentOverhead = 0;
+      else if (wasRunning)
+        periodStartMS = m_ticksLastStopped; // Never stopped, no overhead
+      else
+        m_msSpentOverhead += startMS - m_ticksLastStopped;
 
       SleepUsec(m_microsSleepPerFrame);
 
       m_ticksLastStopped = GetTicks(); // and before pausing
 
-      grid.Pause();
+      if (m_pauseEachFrame)
+      {
+        grid.Pause();
+      }
 
-      u32 thisPeriodMS = m_ticksLastStopped - startMS;
+      u32 thisPeriodMS = m_ticksLastStopped - periodStartMS;
       m_msSpentRunning += thisPeriodMS;
 
       if (thisPeriodMS == 0) {
@@ -280,7 +483,8 @@ namespace MFM
       {
         // Traditional event-based statistics, whether that event hit
         // one site or forty-one.
-        u64 totalEvents = grid.GetTotalEventsExecuted();
+        u64 totalEvents = grid.IsGridRunning() ?
+          grid.SampleTotalEventsExecuted() : grid.GetTotalEventsExecuted();
         u32 totalSites = grid.GetTotalSites();
         m_AEPS = totalEvents / ((double) totalSites);
         m_AER = 1000 * (m_AEPS / m_msSpentRunning);
@@ -470,6 +674,13 @@ namespace MFM
         }
       }
 
+      if (m_historySpillMB > 0 &&
+          !m_grid.SetHistorySpill(GetSimDirPathTemporary("tbd/"), m_historySpillMB << 20))
+      {
+        args.Die("Couldn't create event history spill files in '%s'",
+                 GetSimDirPathTemporary("tbd/"));
+      }
+
       m_elementRegistry.Init(m_grid.GetUlamClassRegistry());
       u32 dlcount = m_elementRegistry.GetRegisteredElementCount();
       for (u32 i = 0; i < dlcount; ++i)
@@ -497,21 +708,25 @@ namespace MFM
     }
 
     virtual bool RunHelperExiter() {
-      double full = m_grid.GetFullSitePercentage();
+      // Atom counts are only trustworthy while the grid is paused,
+      // which, if not pausing each frame, means after an epoch
+      bool countsValid = !m_grid.IsGridRunning();
+      double full = countsValid ? m_grid.GetFullSitePercentage() : -1.0;
       if((m_haltAfterAEPS > 0 && m_AEPS > m_haltAfterAEPS)
          || (m_haltOnEmpty && full == 0.0)
          || (m_haltOnFull && full == 1.0)
-         || (m_AEPS > 0 && m_haltOnExtinctionOf &&
+         || (countsValid && m_AEPS > 0 && m_haltOnExtinctionOf &&
              m_grid.GetAtomCountFromSymbol(GetHaltAfterExinctionOfSymbol())==0)
          )
       {
         // Free final save if halting on --halt*.  Hope for good-looking corpse.
         {
           const char* filename =
-            GetSimDirPathTemporary("save/final-%D-%D.mfs", m_epochCount, (u32) m_AEPS);
+            GetSimDirPathTemporary("save/final-%D-%D.%s", m_epochCount, (u32) m_AEPS, m_saveSuffix);
           SaveGrid(filename);
         }
         WriteTimeBasedData();
+        FlushTimeBasedData();
         m_grid.ShutdownTileThreads();
         return false;
       }
@@ -800,6 +1015,31 @@ namespace MFM
       ((AbstractDriver*)driver)->m_haltOnFull = 1;
     }
 
+    static void SetAsyncSave(const char* not_needed, void* driver)
+    {
+      ((AbstractDriver*)driver)->m_asyncSave = true;
+    }
+
+    static void SetSaveFormatFromArgs(const char* format, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      if (!strcmp(format, "mfs") || !strcmp(format, "mfb"))
+      {
+        driver.m_saveSuffix = format;
+      }
+      else
+      {
+        args.Die("Save format '%s' is not 'mfs' or 'mfb'", format);
+      }
+    }
+
+    static void SetConvertPathFromArgs(const char* path, void* driverptr)
+    {
+      ((AbstractDriver*)driverptr)->m_convertPath = path;
+    }
+
     static void SetNoStdFromArgs(const char* not_needed, void* driver)
     {
       LOG.Message("--no-std is now the only option, so does not need to appear on the command line");
@@ -961,6 +1201,161 @@ namespace MFM
       driver.m_grid.SetWarpFactor(out);
     }
 
+    static void SetSchedulerWorkersFromArgs(const char* ws, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(ws, out, 0, OurGrid::MAX_SCHEDULER_WORKERS);
+      if (errmsg)
+      {
+        args.Die("Worker count '%s' not in 0..%d: %s",
+                 ws, OurGrid::MAX_SCHEDULER_WORKERS, errmsg);
+      }
+
+      if (out == 0)
+      {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        out = (s32) MAX(1L, MIN(cpus, (long) OurGrid::MAX_SCHEDULER_WORKERS));
+      }
+
+      driver.m_grid.SetSchedulerWorkers((u32) out);
+    }
+
+    static void SetTransceiverBufferSizeFromArgs(const char* bs, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(bs, out,
+                                                GridTransceiver::MIN_BUFFER_SIZE,
+                                                GridTransceiver::MAX_BUFFER_SIZE);
+      if (!errmsg && (out & (out - 1)) != 0)
+      {
+        errmsg = "Not a power of two";
+      }
+      if (errmsg)
+      {
+        args.Die("Transceiver buffer size '%s' not a power of two in %d..%d: %s",
+                 bs, GridTransceiver::MIN_BUFFER_SIZE, GridTransceiver::MAX_BUFFER_SIZE,
+                 errmsg);
+      }
+
+      driver.m_grid.SetTransceiverBufferSize((u32) out);
+    }
+
+    static void SetTransceiverDataRateFromArgs(const char* rs, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(rs, out, 0, S32_MAX);
+      if (errmsg)
+      {
+        args.Die("Transceiver data rate '%s' not a non-negative number: %s", rs, errmsg);
+      }
+
+      driver.m_grid.SetTransceiverDataRate((u32) out);
+    }
+
+    static void SetSiteLayoutFromArgs(const char* layout, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      if (!strcmp(layout, "aos"))
+      {
+        driver.m_grid.SetSiteLayout(SITE_LAYOUT_ARRAY_OF_STRUCTS);
+      }
+      else if (!strcmp(layout, "soa"))
+      {
+        driver.m_grid.SetSiteLayout(SITE_LAYOUT_STRUCT_OF_ARRAYS);
+      }
+      else
+      {
+        args.Die("Site layout '%s' is not 'aos' or 'soa'", layout);
+      }
+    }
+
+    static void SetSiteSamplingFromArgs(const char* sampling, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      if (!strcmp(sampling, "uniform"))
+      {
+        driver.m_grid.SetSiteSampling(SITE_SAMPLING_UNIFORM);
+      }
+      else if (!strcmp(sampling, "occupied"))
+      {
+        driver.m_grid.SetSiteSampling(SITE_SAMPLING_OCCUPIED);
+      }
+      else
+      {
+        args.Die("Site sampling '%s' is not 'uniform' or 'occupied'", sampling);
+      }
+    }
+
+    static void SetHistorySpillFromArgs(const char* mb, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(mb, out, 1, 4095);
+      if (errmsg)
+      {
+        args.Die("Bad history spill size '%s' MB: %s", mb, errmsg);
+      }
+
+      driver.m_historySpillMB = (u32) out;
+    }
+
+    static void SetElementProfilingFromArgs(const char* oneIn, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(oneIn, out, 1, ElementProfile::MAX_SAMPLING);
+      if (!errmsg && (out & (out - 1)) != 0)
+      {
+        errmsg = "Not a power of two";
+      }
+      if (errmsg)
+      {
+        args.Die("Bad profile sampling '%s': %s", oneIn, errmsg);
+      }
+
+      driver.m_grid.SetElementProfiling((u32) out);
+    }
+
+    static void SetTileCountersFromArgs(const char* format, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      if (!strcmp(format, "csv"))
+      {
+        driver.m_tileCountersFormat = TILE_COUNTERS_CSV;
+      }
+      else if (!strcmp(format, "json"))
+      {
+        driver.m_tileCountersFormat = TILE_COUNTERS_JSON;
+      }
+      else
+      {
+        args.Die("Tile counters format '%s' is not 'csv' or 'json'", format);
+      }
+    }
+
     static void LoadFromConfigFile(const char* path, void* driverptr)
     {
       AbstractDriver& driver = *((AbstractDriver*)driverptr);
@@ -982,6 +1377,12 @@ namespace MFM
       {
         if (m_AEPS >= m_nextEpochAEPS)
         {
+          if (grid.IsGridRunning())
+          {
+            // Epoch processing wants a still grid.  UpdateGrid will
+            // restart it next frame.
+            grid.Pause();
+          }
           DoEpochEvents(grid, m_epochCount, m_nextEpochAEPS);
           m_nextEpochAEPS += m_AEPSPerEpoch;
           ++m_epochCount;
@@ -1141,8 +1542,22 @@ namespace MFM
     void AutosaveGrid(u32 epochs)
     {
       const char* filename =
-        GetSimDirPathTemporary("autosave/%D-%D.mfs", epochs, (u32) m_AEPS);
+        GetSimDirPathTemporary("autosave/%D-%D.%s", epochs, (u32) m_AEPS, m_saveSuffix);
+
+      if (m_asyncSave)
+      {
+        if (m_grid.IsGridRunning())
+        {
+          m_grid.Pause();  // UpdateGrid will restart it
+        }
+        LOG.Message("Saving to: %s (in background)", filename);
+        m_asyncSaver.Save(filename);
+        return;
+      }
+
+      u64 startUsec = AsyncGridSaver<GC>::GetUsec();
       SaveGrid(filename);
+      m_lastSavePauseUsec = m_lastSaveLatencyUsec = (u32) (AsyncGridSaver<GC>::GetUsec() - startUsec);
     }
 
     ExternalConfig<GC> & GetExternalConfig()
@@ -1150,10 +1565,28 @@ namespace MFM
       return m_externalConfig;
     }
 
+    AsyncGridSaver<GC> & GetAsyncGridSaver()
+    {
+      return m_asyncSaver;
+    }
+
     void SaveGrid(const char* filename)
     {
+      m_asyncSaver.WaitUntilIdle();
+
+      if (m_grid.IsGridRunning())
+      {
+        m_grid.Pause();  // UpdateGrid will restart it
+      }
 
       LOG.Message("Saving to: %s", filename);
+      if (GridSnapshot<GC>::IsSnapshotPath(filename))
+      {
+        GridSnapshot<GC> snapshot(m_externalConfig, m_externalConfigSectionGrid);
+        snapshot.Write(filename);
+        return;
+      }
+
       FILE* fp = fopen(filename, "w");
       FileByteSink fs(fp);
 
@@ -1198,6 +1631,19 @@ namespace MFM
 
       LOG.Message("Loading configuration '%s'", buf.GetZString());
 
+      m_asyncSaver.WaitUntilIdle();
+
+      if (GridSnapshot<GC>::IsSnapshotPath(buf.GetZString()))
+      {
+        GridSnapshot<GC> snapshot(m_externalConfig, m_externalConfigSectionGrid);
+        if (snapshot.Read(buf.GetZString()))
+        {
+          LOG.Message("Loaded snapshot '%s'", buf.GetZString());
+          return true;
+        }
+        return false;
+      }
+
       FileByteSource fs(buf.GetZString());
       if (fs.IsOpen())
       {
@@ -1225,6 +1671,12 @@ namespace MFM
 
       WriteTimeBasedData();
 
+      WriteWorkerData();
+
+      WriteTileCounters(epochAEPS);
+
+      WriteElementProfile(epochAEPS);
+
       if (m_gridImages)
       {
         const char * path = GetSimDirPathTemporary("eps/%010d.ppm", epochAEPS);
@@ -1278,9 +1730,18 @@ namespace MFM
       , m_suppressStdElements(true)
       , m_includeUEDemos(false)
       , m_includeCPPDemos(false)
+      , m_asyncSave(false)
+      , m_historySpillMB(0)
+      , m_tileCountersFormat(TILE_COUNTERS_NONE)
+      , m_tileCountersWritten(0)
+      , m_lastSavePauseUsec(0)
+      , m_lastSaveLatencyUsec(0)
+      , m_saveSuffix("mfs")
+      , m_convertPath(0)
       , m_msSpentRunning(0)
       , m_msSpentOverhead(0)
       , m_microsSleepPerFrame(1000)
+      , m_pauseEachFrame(true)
       , m_overheadPercent(0.0)
       , m_lastFrameAEPS(INITIAL_AEPS_PER_FRAME)
       , m_aepsPerFrame(INITIAL_AEPS_PER_FRAME)
@@ -1298,17 +1759,31 @@ namespace MFM
       , m_lastTotalEvents(0)
       , m_nextEpochAEPS(0)
       , m_epochCount(0)
+      , m_lastWorkerSampleMS(0)
+      , m_lastTileEvents(0)
+      , m_lastTileEventsCount(0)
+      , m_lastTileSampleMS(0)
+      , m_statsLogFailed(false)
       , m_configurationPathCount(0)
       , m_currentConfigurationPath(U32_MAX)
       , m_simDirBasePathLength(0)
       , m_externalConfig(*this)
       , m_externalConfigSectionDriver(m_externalConfig, *this)
       , m_externalConfigSectionGrid(m_externalConfig, m_grid)
+      , m_asyncSaver(m_externalConfig, m_externalConfigSectionGrid)
     {
       InitTicks(0); // Overwritten later on -cp load
+
+      for (u32 w = 0; w < OurGrid::MAX_SCHEDULER_WORKERS; ++w)
+      {
+        m_lastWorkerEvents[w] = 0;
+      }
     }
 
-    virtual ~AbstractDriver() {} //avoid inline error
+    virtual ~AbstractDriver()
+    {
+      delete [] m_lastTileEvents;
+    }
 
     virtual void RegisterExternalConfigSections()
     {
@@ -1419,6 +1894,12 @@ namespace MFM
       RegisterArgument("Autosave grid every ARG epochs (default 10; 0 for never)",
                        "-a|--autosave", &SetAutosavePerEpochsFromArgs, this, true);
 
+      RegisterArgument("Write autosaves and final saves as ARG: mfs (text, default) or mfb (binary)",
+                       "--saveformat", &SetSaveFormatFromArgs, this, true);
+
+      RegisterArgument("Save the -cp configuration to ARG (format by extension), then exit",
+                       "--convert", &SetConvertPathFromArgs, this, true);
+
       RegisterArgument("Increase the epoch length every ARG epochs",
                              "--accelerate",
                              &SetPicturesPerRateFromArgs, this, true);
@@ -1479,6 +1960,35 @@ namespace MFM
       RegisterArgument("Command line comment, logged but otherwise ignored (string)",
                        "-#|--comment", &IgnoreComment, this, true);
 
+      RegisterArgumentSection("Performance switches");
+
+      RegisterArgument("Run tiles on a pool of ARG worker threads (0 -> one per CPU)",
+                       "--workers", &SetSchedulerWorkersFromArgs, this, true);
+
+      RegisterArgument("Set intertile transceiver buffers to ARG bytes (power of two)",
+                       "--xcvrbuffer", &SetTransceiverBufferSizeFromArgs, this, true);
+
+      RegisterArgument("Throttle intertile transceivers to ARG bytes/sec (0 -> unthrottled)",
+                       "--xcvrrate", &SetTransceiverDataRateFromArgs, this, true);
+
+      RegisterArgument("Copy the grid for autosaves and write the copy in the background",
+                       "--asyncsave", &SetAsyncSave, this, false);
+
+      RegisterArgument("Store tile sites as one array of structs (aos, default) or as separate atom, base, and metadata arrays (soa)",
+                       "--sitelayout", &SetSiteLayoutFromArgs, this, true);
+
+      RegisterArgument("Pick event centers from all owned sites (uniform, default) or only occupied ones, crediting the skipped empty sites' events (occupied)",
+                       "--sitesampling", &SetSiteSamplingFromArgs, this, true);
+
+      RegisterArgument("Spill event history evicted from memory to a ring of ARG MB per tile on disk, so replay can rewind further",
+                       "--historyspill", &SetHistorySpillFromArgs, this, true);
+
+      RegisterArgument("Time the phases of one event in ARG (a power of two), and each epoch append the top elements by cost to tbd/elementprofile.txt",
+                       "--profile", &SetElementProfilingFromArgs, this, true);
+
+      RegisterArgument("Each epoch, append every tile's event, lock, cache, and timing counters to tbd/tilecounters.ARG (ARG is csv or json)",
+                       "--tilecounters", &SetTileCountersFromArgs, this, true);
+
     }
 
 
@@ -1574,6 +2084,22 @@ namespace MFM
       m_grid.SetSeed(seed);
     }
 
+    /**
+     * Choose whether UpdateGrid pauses the grid at the end of every
+     * frame (the default), or leaves it running between frames.  Any
+     * driver that edits or renders the grid between frames needs the
+     * default.
+     */
+    void SetPauseEachFrame(bool pauseEachFrame)
+    {
+      m_pauseEachFrame = pauseEachFrame;
+    }
+
+    bool IsPauseEachFrame() const
+    {
+      return m_pauseEachFrame;
+    }
+
     void Init()
     {
       m_lastFrameAEPS = 0;
@@ -1597,6 +2123,13 @@ namespace MFM
 
       m_grid.SetGridRunning(false);
 
+      if (m_convertPath)
+      {
+        SaveGrid(m_convertPath);
+        m_grid.ShutdownTileThreads();
+        exit(0);
+      }
+
     }
 
     void Run()
@@ -1609,6 +2142,7 @@ namespace MFM
        },
        {
          RunHelper();
+         FlushTimeBasedData();
          LOG.Message("Simulation driver exiting");
        });
     }
@@ -1638,10 +2172,20 @@ namespace MFM
     bool m_suppressStdElements;
     bool m_includeUEDemos;
     bool m_includeCPPDemos;
+    bool m_asyncSave;            // Autosave via m_asyncSaver
+    u32 m_historySpillMB;        // Per tile, or 0 to keep event history in memory only
+    enum TileCountersFormat { TILE_COUNTERS_NONE, TILE_COUNTERS_CSV, TILE_COUNTERS_JSON };
+    TileCountersFormat m_tileCountersFormat;  // Of per-epoch tile counter dumps
+    u32 m_tileCountersWritten;   // Epochs dumped so far
+    u32 m_lastSavePauseUsec;     // Of the most recent synchronous autosave
+    u32 m_lastSaveLatencyUsec;
+    const char * m_saveSuffix;   // "mfs" or "mfb", for autosaves and final saves
+    const char * m_convertPath;  // If non-null, save here after loading, then exit
 
     u64 m_msSpentRunning;
     u64 m_msSpentOverhead;
     s32 m_microsSleepPerFrame;
+    bool m_pauseEachFrame;
     double m_overheadPercent;
     double m_lastFrameAEPS;
     u32 m_aepsPerFrame;
@@ -1677,6 +2221,24 @@ namespace MFM
     u32 m_nextEpochAEPS;
     u32 m_epochCount;
 
+    /**
+     * Scheduler worker event totals as of the last WriteWorkerData,
+     * and when that was
+     */
+    u64 m_lastWorkerEvents[OurGrid::MAX_SCHEDULER_WORKERS];
+    u64 m_lastWorkerSampleMS;
+
+    /**
+     * Per-tile event totals (indexed y * width + x) as of the last
+     * statistics row, and when that was
+     */
+    u64 * m_lastTileEvents;
+    u32 m_lastTileEventsCount;
+    u64 m_lastTileSampleMS;
+
+    StatsLog m_statsLog;
+    bool m_statsLogFailed;     // Don't keep trying to open it
+
     VArguments m_varguments;
     OString1024 m_commandLineArguments;
 
@@ -1690,6 +2252,7 @@ namespace MFM
     ExternalConfig<GC> m_externalConfig;
     ExternalConfigSectionDriver<GC> m_externalConfigSectionDriver;
     ExternalConfigSectionGrid<GC> m_externalConfigSectionGrid;
+    AsyncGridSaver<GC> m_asyncSaver;
 
   public:
     bool IsLoadDriverSection() const { return m_externalConfigSectionDriver.IsEnabled(); }
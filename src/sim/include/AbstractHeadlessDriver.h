@@ -37,6 +37,8 @@
 #include "Element_Empty.h" /* Need common elements */
 #include "VArguments.h"
 #include "AbstractDriver.h"
+#include "FrameRenderer.h"
+#include "FrameWriter.h"
 
 namespace MFM
 {
@@ -49,16 +51,98 @@ namespace MFM
   {
   private: typedef AbstractDriver<GC> Super;
 
+    enum { DEFAULT_FRAME_SITE_PIXELS = 2 };
+
   protected:
     typedef typename Super::OurGrid OurGrid;
 
-    AbstractHeadlessDriver(u32 gridWidth, u32 gridHeight)
-      : AbstractDriver<GC>(gridWidth, gridHeight)
-    { }
+    AbstractHeadlessDriver(u32 gridWidth, u32 gridHeight, GridLayoutPattern gridLayout)
+      : AbstractDriver<GC>(gridWidth, gridHeight, gridLayout)
+      , m_writeFramePNGs(false)
+    {
+      // Nobody's watching between frames, so let the grid run
+      // through them and only pause when we must
+      Super::SetPauseEachFrame(false);
+
+      m_frameRenderer.SetSitePixels(DEFAULT_FRAME_SITE_PIXELS);
+      m_frameRenderer.SetThreads(GetThreadPerCPUCount());
+    }
+
+    static u32 GetThreadPerCPUCount()
+    {
+      long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+      return (u32) MAX(1L, MIN(cpus, (long) FrameRenderer<GC>::MAX_THREADS));
+    }
+
+    static void SetPauseEachFrameFromArgs(const char* not_used, void* driverptr)
+    {
+      AbstractHeadlessDriver& driver = *((AbstractHeadlessDriver*)driverptr);
+      driver.SetPauseEachFrame(true);
+    }
+
+    static void SetFramePNGsFromArgs(const char* not_used, void* driverptr)
+    {
+      AbstractHeadlessDriver& driver = *((AbstractHeadlessDriver*)driverptr);
+      driver.m_writeFramePNGs = true;
+    }
+
+    static void SetFramePipeFromArgs(const char* command, void* driverptr)
+    {
+      AbstractHeadlessDriver& driver = *((AbstractHeadlessDriver*)driverptr);
+      driver.m_frameWriter.OpenPipe(command);
+    }
+
+    static void SetFrameScaleFromArgs(const char* scale, void* driverptr)
+    {
+      AbstractHeadlessDriver& driver = *((AbstractHeadlessDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(scale, out, 1, FrameRenderer<GC>::MAX_SITE_PIXELS);
+      if (errmsg)
+      {
+        args.Die("Bad frame scale '%s': %s", scale, errmsg);
+      }
+
+      driver.m_frameRenderer.SetSitePixels((u32) out);
+    }
+
+    static void SetFrameThreadsFromArgs(const char* threads, void* driverptr)
+    {
+      AbstractHeadlessDriver& driver = *((AbstractHeadlessDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg =
+        AbstractDriver<GC>::GetNumberFromString(threads, out, 0, FrameRenderer<GC>::MAX_THREADS);
+      if (errmsg)
+      {
+        args.Die("Frame thread count '%s' not in 0..%d: %s",
+                 threads, FrameRenderer<GC>::MAX_THREADS, errmsg);
+      }
+
+      driver.m_frameRenderer.SetThreads(out == 0 ? GetThreadPerCPUCount() : (u32) out);
+    }
 
     virtual void AddDriverArguments()
     {
       Super::AddDriverArguments();
+
+      this->RegisterArgument("Pause the grid every frame, as GUI drivers do",
+                             "--pauseframes", &SetPauseEachFrameFromArgs, this, false);
+
+      this->RegisterArgument("Each epoch, render the grid and save it as vid/AEPS.png",
+                             "--frames", &SetFramePNGsFromArgs, this, false);
+
+      this->RegisterArgument("Each epoch, render the grid and pipe it as raw RGBA video to shell command ARG ('-' for stdout; %S in ARG becomes WIDTHxHEIGHT)",
+                             "--framepipe", &SetFramePipeFromArgs, this, true);
+
+      this->RegisterArgument("Render each site as ARG by ARG pixels (default 2)",
+                             "--framescale", &SetFrameScaleFromArgs, this, true);
+
+      this->RegisterArgument("Render frames with ARG threads (default 0, meaning one per CPU)",
+                             "--framethreads", &SetFrameThreadsFromArgs, this, true);
     }
 
     virtual void OnceOnly(VArguments& args)
@@ -66,10 +150,49 @@ namespace MFM
       Super::OnceOnly(args);
     }
 
+    virtual void DoEpochEvents(OurGrid& grid, u32 epochs, u32 epochAEPS)
+    {
+      Super::DoEpochEvents(grid, epochs, epochAEPS);
+
+      WriteFrame(grid, epochAEPS);
+    }
+
+    /**
+       Render and save or pipe a frame of the (paused) grid, if asked to
+     */
+    void WriteFrame(OurGrid& grid, u32 epochAEPS)
+    {
+      if (!m_writeFramePNGs && !m_frameWriter.IsPipeOpen())
+      {
+        return;
+      }
+
+      m_frameRenderer.Render(grid);
+      const u8 * pixels = m_frameRenderer.GetPixels();
+      const u32 width = m_frameRenderer.GetWidth();
+      const u32 height = m_frameRenderer.GetHeight();
+
+      if (m_writeFramePNGs)
+      {
+        const char * path = Super::GetSimDirPathTemporary("vid/%D.png", epochAEPS);
+        FrameWriter::WritePNG(path, pixels, width, height);
+      }
+
+      if (m_frameWriter.IsPipeOpen())
+      {
+        m_frameWriter.WriteToPipe(pixels, width, height);
+      }
+    }
+
     virtual void PostUpdate()
     {
       LOG.Debug("AEPS: %d", (u32)Super::GetAEPS());
     }
+
+  private:
+    FrameRenderer<GC> m_frameRenderer;
+    FrameWriter m_frameWriter;
+    bool m_writeFramePNGs;
   };
 }
 
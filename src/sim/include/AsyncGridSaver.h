@@ -0,0 +1,137 @@
+/*                                              -*- mode:C++ -*-
+  AsyncGridSaver.h Save grid copies on a background thread
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file AsyncGridSaver.h Save grid copies on a background thread
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef ASYNCGRIDSAVER_H
+#define ASYNCGRIDSAVER_H
+
+#include <pthread.h>
+#include "itype.h"
+#include "Fail.h"
+#include "OverflowableCharBufferByteSink.h"  /* For OString512 */
+#include "GridSnapshot.h"
+
+namespace MFM
+{
+  /**
+     Saves a grid without keeping it paused for the whole save.
+     Save copies the (paused) grid into memory with
+     GridSnapshot::Capture and returns, so the grid can be restarted
+     at once; a background thread then writes the copy out, as .mfs
+     text or an .mfb snapshot according to the path.
+
+     The copy is written uncompressed.  LoadMFS reads only plain .mfs
+     text and .mfb snapshots, so a compressed autosave couldn't be
+     reloaded.
+
+     At most one save is in flight.  Save refuses, and counts a
+     skipped save, if the previous one hasn't finished, so the
+     simulation never waits on the disk and at most one grid copy is
+     held in memory.
+
+     The background thread only reads the copy plus the grid's
+     geometry and element types, so anything that changes those --
+     loading a configuration, say -- must call WaitUntilIdle first.
+   */
+  template <class GC>
+  class AsyncGridSaver
+  {
+  public:
+    AsyncGridSaver(ExternalConfig<GC> & ec, ExternalConfigSectionGrid<GC> & ecsg) ;
+
+    ~AsyncGridSaver() ;
+
+    /**
+       Copy the grid, which must not be running, and start saving the
+       copy to \c path in the background.  Return false, having saved
+       nothing, if a save is already in flight or the copy failed.
+     */
+    bool Save(const char * path) ;
+
+    /**
+       Return once no save is in flight.
+     */
+    void WaitUntilIdle() ;
+
+    /**
+       Microseconds the grid was held for the most recent Save's copy.
+     */
+    u32 GetLastPauseUsec() const
+    {
+      return m_lastPauseUsec;
+    }
+
+    /**
+       Microseconds from the start of the most recently finished save
+       until its file was closed, or 0 if none has finished yet.
+     */
+    u32 GetLastLatencyUsec() ;
+
+    /**
+       Number of Save calls refused because a save was in flight.
+     */
+    u32 GetSkippedSaves() const
+    {
+      return m_skippedSaves;
+    }
+
+    /**
+       Microseconds on the monotonic clock save timings are taken from
+     */
+    static u64 GetUsec() ;
+
+  private:
+    static void * Run(void * arg) ;
+
+    void RunSaves() ;
+
+    GridSnapshot<GC> m_snapshot;
+
+    pthread_mutex_t m_lock;
+    pthread_cond_t m_changed;
+    pthread_t m_thread;
+    bool m_threadStarted;
+    MFMErrorEnvironmentPointer_t m_errorStackTop;
+
+    /* Guarded by m_lock */
+    bool m_pending;               // m_image and m_path hold an unfinished save
+    bool m_exiting;
+    u32 m_lastLatencyUsec;
+
+    /* Only touched by the background thread while m_pending */
+    GridSnapshotImage m_image;
+    OString512 m_path;
+    u64 m_startUsec;
+
+    u32 m_lastPauseUsec;
+    u32 m_skippedSaves;
+
+    AsyncGridSaver(const AsyncGridSaver &) ;  // Not implemented
+    AsyncGridSaver & operator=(const AsyncGridSaver &) ;  // Not implemented
+  };
+}
+
+#include "AsyncGridSaver.tcc"
+
+#endif /* ASYNCGRIDSAVER_H */
@@ -0,0 +1,151 @@
+/* -*- C++ -*- */
+#include "Logger.h"
+#include <time.h>  /* For clock_gettime */
+
+namespace MFM
+{
+  template <class GC>
+  AsyncGridSaver<GC>::AsyncGridSaver(ExternalConfig<GC> & ec, ExternalConfigSectionGrid<GC> & ecsg)
+    : m_snapshot(ec, ecsg)
+    , m_threadStarted(false)
+    , m_errorStackTop(0)
+    , m_pending(false)
+    , m_exiting(false)
+    , m_lastLatencyUsec(0)
+    , m_startUsec(0)
+    , m_lastPauseUsec(0)
+    , m_skippedSaves(0)
+  {
+    MFM_API_ASSERT(!pthread_mutex_init(&m_lock, NULL), LOCK_FAILURE);
+    MFM_API_ASSERT(!pthread_cond_init(&m_changed, NULL), LOCK_FAILURE);
+  }
+
+  template <class GC>
+  AsyncGridSaver<GC>::~AsyncGridSaver()
+  {
+    if (m_threadStarted)
+    {
+      MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+      m_exiting = true;
+      MFM_API_ASSERT(!pthread_cond_broadcast(&m_changed), LOCK_FAILURE);
+      MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+      pthread_join(m_thread, NULL);
+    }
+    pthread_cond_destroy(&m_changed);
+    pthread_mutex_destroy(&m_lock);
+  }
+
+  template <class GC>
+  u64 AsyncGridSaver<GC>::GetUsec()
+  {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((u64) now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+  }
+
+  template <class GC>
+  bool AsyncGridSaver<GC>::Save(const char * path)
+  {
+    MFM_API_ASSERT_NONNULL(path);
+
+    MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+    bool busy = m_pending;
+    MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+
+    if (busy)
+    {
+      ++m_skippedSaves;
+      LOG.Warning("Previous save still in progress; skipping save to %s", path);
+      return false;
+    }
+
+    // Not pending, so the background thread won't touch these
+    const u64 start = GetUsec();
+    if (!m_snapshot.Capture(m_image))
+    {
+      return false;
+    }
+    m_lastPauseUsec = (u32) (GetUsec() - start);
+    m_startUsec = start;
+    m_path.Reset();
+    m_path.Printf("%s", path);
+
+    if (!m_threadStarted)
+    {
+      if (pthread_create(&m_thread, NULL, Run, this))
+      {
+        FAIL(ILLEGAL_STATE);
+      }
+      m_threadStarted = true;
+    }
+
+    MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+    m_pending = true;
+    MFM_API_ASSERT(!pthread_cond_broadcast(&m_changed), LOCK_FAILURE);
+    MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+
+    return true;
+  }
+
+  template <class GC>
+  void AsyncGridSaver<GC>::WaitUntilIdle()
+  {
+    MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+    while (m_pending)
+    {
+      MFM_API_ASSERT(!pthread_cond_wait(&m_changed, &m_lock), LOCK_FAILURE);
+    }
+    MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+  }
+
+  template <class GC>
+  u32 AsyncGridSaver<GC>::GetLastLatencyUsec()
+  {
+    MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+    u32 ret = m_lastLatencyUsec;
+    MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+    return ret;
+  }
+
+  template <class GC>
+  void * AsyncGridSaver<GC>::Run(void * arg)
+  {
+    AsyncGridSaver<GC> & saver = *(AsyncGridSaver<GC> *) arg;
+    MFMPtrToErrEnvStackPtr = &saver.m_errorStackTop;
+    saver.RunSaves();
+    return NULL;
+  }
+
+  template <class GC>
+  void AsyncGridSaver<GC>::RunSaves()
+  {
+    while (true)
+    {
+      MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+      while (!m_pending && !m_exiting)
+      {
+        MFM_API_ASSERT(!pthread_cond_wait(&m_changed, &m_lock), LOCK_FAILURE);
+      }
+      bool exiting = !m_pending;
+      MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+
+      if (exiting)
+      {
+        return;
+      }
+
+      if (m_snapshot.Save(m_image, m_path.GetZString()))
+      {
+        LOG.Message("Saved %s in background", m_path.GetZString());
+      }
+      m_image.Clear();
+      u32 latency = (u32) (GetUsec() - m_startUsec);
+
+      MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+      m_lastLatencyUsec = latency;
+      m_pending = false;
+      MFM_API_ASSERT(!pthread_cond_broadcast(&m_changed), LOCK_FAILURE);
+      MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+    }
+  }
+}
@@ -171,6 +171,34 @@ namespace MFM
       return m_grid;
     }
 
+    /**
+     * Choose whether WriteSection includes the Site(..) lines.  Binary
+     * snapshots turn them off, since they store the sites themselves.
+     */
+    void SetWriteSites(bool writeSites)
+    {
+      m_writeSites = writeSites;
+    }
+
+    bool IsWriteSites() const
+    {
+      return m_writeSites;
+    }
+
+    typedef void (*SkippedSitesFunc)(void * arg);
+
+    /**
+     * When not writing sites, have WriteSection call \c func(arg) at
+     * the point in its output where the Site(..) lines would have
+     * gone, so a caller capturing the output can splice them in
+     * later.  Pass a null \c func to stop.
+     */
+    void SetSkippedSitesCallback(SkippedSitesFunc func, void * arg)
+    {
+      m_skippedSitesFunc = func;
+      m_skippedSitesArg = arg;
+    }
+
   private:
 
     /**
@@ -178,6 +206,10 @@ namespace MFM
      */
     Grid<GC>& m_grid;
 
+    bool m_writeSites;
+    SkippedSitesFunc m_skippedSitesFunc;
+    void * m_skippedSitesArg;
+
     static const u32 MAX_REGISTERED_ELEMENTS = 100;
     ByteSink * m_errorsTo;
 
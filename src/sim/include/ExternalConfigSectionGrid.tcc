@@ -271,6 +271,9 @@ namespace MFM
   ExternalConfigSectionGrid<GC>::ExternalConfigSectionGrid(ExternalConfig<GC>& ec, Grid<GC>& grid)
     : ExternalConfigSection<GC>(ec)
     , m_grid(grid)
+    , m_writeSites(true)
+    , m_skippedSitesFunc(0)
+    , m_skippedSitesArg(0)
     , m_errorsTo(0)
     , m_registeredElementCount(0)
     , m_elementRegistry(grid.GetElementRegistry())
@@ -357,6 +360,16 @@ namespace MFM
 	byteSink.Printf(")\n");
       }
 
+    if (!m_writeSites)
+    {
+      if (m_skippedSitesFunc)
+      {
+        m_skippedSitesFunc(m_skippedSitesArg);
+      }
+      byteSink.WriteNewline();
+      return;
+    }
+
     /* Then, write ALL the damn sites, */
     /* and GA all live atoms. */
 
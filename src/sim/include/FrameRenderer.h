@@ -0,0 +1,213 @@
+/*                                              -*- mode:C++ -*-
+  FrameRenderer.h Render a grid into a memory buffer, with no display
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file FrameRenderer.h Render a grid into a memory buffer, with no display
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef FRAMERENDERER_H
+#define FRAMERENDERER_H
+
+#include <string.h>  /* For memcpy */
+#include "itype.h"
+#include "Fail.h"
+#include "Grid.h"
+#include "SiteColorer.h"
+#include "WorkerPool.h"
+
+namespace MFM
+{
+  /**
+     Paints the owned sites of every tile of a Grid into a plain
+     buffer of RGBA pixels, for recording runs with no display.  Site
+     colors come from a SiteColorer, so frames match what
+     TileRenderer shows in the GUI: a background type (by default
+     DRAW_SITE_DARK_TILE) under a foreground type (by default
+     DRAW_SITE_ATOM_1), each site a filled square of GetSitePixels()
+     pixels on a side.  There are no grid lines, labels, or custom
+     ulam graphics.
+
+     Tiles are painted in parallel: Render hands them out, through a
+     WorkerPool, to GetThreads() - 1 worker threads plus the calling
+     thread, and returns once all are done.  Each painting thread has
+     its own AtomColorCache, so unchanged atoms aren't recolored
+     frame after frame.
+
+     Render only reads the grid, but the grid should be paused for
+     the frame to be a consistent snapshot.
+   */
+  template <class GC>
+  class FrameRenderer : private WorkerPool::Job
+  {
+  public:
+    typedef typename GC::EVENT_CONFIG EC;
+    typedef Grid<GC> OurGrid;
+    typedef Tile<EC> OurTile;
+    typedef SiteColorer<EC> OurSiteColorer;
+    typedef typename OurSiteColorer::DrawSiteType DrawSiteType;
+
+    enum
+    {
+      R = EC::EVENT_WINDOW_RADIUS,
+      BYTES_PER_PIXEL = 4,
+      MAX_SITE_PIXELS = 32,
+      MAX_THREADS = WorkerPool::MAX_THREADS
+    };
+
+    FrameRenderer() ;
+
+    ~FrameRenderer() ;
+
+    /**
+       Draw each site as a \c pixels by \c pixels square, 1 to
+       MAX_SITE_PIXELS.
+     */
+    void SetSitePixels(u32 pixels)
+    {
+      MFM_API_ASSERT_ARG(pixels > 0 && pixels <= MAX_SITE_PIXELS);
+      m_sitePixels = pixels;
+    }
+
+    u32 GetSitePixels() const
+    {
+      return m_sitePixels;
+    }
+
+    /**
+       Paint with \c threads threads in all, 1 to MAX_THREADS,
+       counting the one calling Render.  Takes effect at the next
+       Render.
+     */
+    void SetThreads(u32 threads) ;
+
+    u32 GetThreads() const
+    {
+      return m_threads;
+    }
+
+    void SetBackgroundType(DrawSiteType type)
+    {
+      m_backgroundType = type;
+    }
+
+    void SetForegroundType(DrawSiteType type)
+    {
+      m_foregroundType = type;
+    }
+
+    /**
+       Paint all of \c grid into the buffer, resizing it first if the
+       grid or the site size has changed.
+     */
+    void Render(const OurGrid & grid) ;
+
+    /**
+       The frame, GetHeight() rows of GetWidth() pixels, each pixel
+       four bytes R, G, B, A, with no padding anywhere.  Null before
+       the first Render.
+     */
+    const u8 * GetPixels() const
+    {
+      return (const u8 *) m_pixels;
+    }
+
+    u32 GetWidth() const
+    {
+      return m_width;
+    }
+
+    u32 GetHeight() const
+    {
+      return m_height;
+    }
+
+    u32 GetFramesRendered() const
+    {
+      return m_frames;
+    }
+
+    /**
+       Total color cache hits and misses, over all threads
+     */
+    u64 GetColorCacheHits() const ;
+
+    u64 GetColorCacheMisses() const ;
+
+    /**
+       The RGBA pixel (as GetPixels lays them out) for the ARGB color
+       \c argb used everywhere else
+     */
+    static u32 ToPixel(u32 argb)
+    {
+      u8 bytes[BYTES_PER_PIXEL];
+      bytes[0] = (u8) (argb >> 16);
+      bytes[1] = (u8) (argb >> 8);
+      bytes[2] = (u8) argb;
+      bytes[3] = (u8) (argb >> 24);
+      u32 pixel;
+      memcpy(&pixel, bytes, sizeof(pixel));
+      return pixel;
+    }
+
+  private:
+    void Resize(u32 width, u32 height) ;
+
+    /**
+       Claim and paint tiles of m_grid until none are left
+     */
+    virtual void Work(u32 thread) ;
+
+    void PaintTile(u32 tileX, u32 tileY, AtomColorCache<EC> & cache) ;
+
+    u32 GetBackgroundColor(const OurTile & tile, const SPoint & owned,
+                           AtomColorCache<EC> & cache) const ;
+
+    void FillSite(u32 * at, u32 pixel) ;
+
+    OurSiteColorer m_siteColorer;
+    DrawSiteType m_backgroundType;
+    DrawSiteType m_foregroundType;
+    u32 m_sitePixels;
+    u32 m_threads;
+
+    /* One per thread; [0] is the Render caller's */
+    AtomColorCache<EC> * m_colorCaches;
+    u32 m_colorCacheCount;
+
+    u32 * m_pixels;
+    u32 m_width;
+    u32 m_height;
+    u32 m_frames;
+
+    /* The frame being rendered */
+    const OurGrid * m_grid;
+    u32 m_nextTile;            // Claimed with __sync_fetch_and_add
+
+    WorkerPool m_pool;
+
+    FrameRenderer(const FrameRenderer &) ;  // Not implemented
+    FrameRenderer & operator=(const FrameRenderer &) ;  // Not implemented
+  };
+}
+
+#include "FrameRenderer.tcc"
+
+#endif /* FRAMERENDERER_H */
@@ -0,0 +1,203 @@
+/* -*- C++ -*- */
+#include <stdlib.h>  /* For calloc, free */
+#include "Drawable.h"  /* For color names */
+
+namespace MFM
+{
+  template <class GC>
+  FrameRenderer<GC>::FrameRenderer()
+    : m_backgroundType(OurSiteColorer::DRAW_SITE_DARK_TILE)
+    , m_foregroundType(OurSiteColorer::DRAW_SITE_ATOM_1)
+    , m_sitePixels(1)
+    , m_threads(1)
+    , m_colorCaches(0)
+    , m_colorCacheCount(0)
+    , m_pixels(0)
+    , m_width(0)
+    , m_height(0)
+    , m_frames(0)
+    , m_grid(0)
+    , m_nextTile(0)
+  { }
+
+  template <class GC>
+  FrameRenderer<GC>::~FrameRenderer()
+  {
+    delete [] m_colorCaches;
+    free(m_pixels);
+  }
+
+  template <class GC>
+  void FrameRenderer<GC>::SetThreads(u32 threads)
+  {
+    MFM_API_ASSERT_ARG(threads > 0 && threads <= MAX_THREADS);
+    m_threads = threads;
+  }
+
+  template <class GC>
+  u64 FrameRenderer<GC>::GetColorCacheHits() const
+  {
+    u64 hits = 0;
+    for (u32 i = 0; i < m_colorCacheCount; ++i)
+    {
+      hits += m_colorCaches[i].GetHits();
+    }
+    return hits;
+  }
+
+  template <class GC>
+  u64 FrameRenderer<GC>::GetColorCacheMisses() const
+  {
+    u64 misses = 0;
+    for (u32 i = 0; i < m_colorCacheCount; ++i)
+    {
+      misses += m_colorCaches[i].GetMisses();
+    }
+    return misses;
+  }
+
+  template <class GC>
+  void FrameRenderer<GC>::Resize(u32 width, u32 height)
+  {
+    free(m_pixels);
+    m_pixels = (u32 *) calloc(width * height, sizeof(m_pixels[0]));
+    MFM_API_ASSERT(m_pixels, OUT_OF_RESOURCES);
+    m_width = width;
+    m_height = height;
+  }
+
+  template <class GC>
+  void FrameRenderer<GC>::Render(const OurGrid & grid)
+  {
+    const u32 width = grid.GetWidthSites() * m_sitePixels;
+    const u32 height = grid.GetHeightSites() * m_sitePixels;
+    if (!m_pixels || width != m_width || height != m_height)
+    {
+      Resize(width, height);
+    }
+
+    if (m_colorCacheCount != m_threads)
+    {
+      // Caches are per thread, so start over with the new threads
+      delete [] m_colorCaches;
+      m_colorCaches = new AtomColorCache<EC>[m_threads];
+      m_colorCacheCount = m_threads;
+    }
+
+    for (u32 i = 0; i < m_colorCacheCount; ++i)
+    {
+      m_colorCaches[i].BeginFrame();
+    }
+
+    m_grid = &grid;
+    m_nextTile = 0;
+    m_pool.Run(*this, m_threads);
+
+    m_grid = 0;
+    ++m_frames;
+  }
+
+  template <class GC>
+  void FrameRenderer<GC>::Work(u32 thread)
+  {
+    AtomColorCache<EC> & cache = m_colorCaches[thread];
+    const u32 gridWidth = m_grid->GetWidth();
+    const u32 tiles = gridWidth * m_grid->GetHeight();
+    while (true)
+    {
+      const u32 index = __sync_fetch_and_add(&m_nextTile, 1);
+      if (index >= tiles)
+      {
+        return;
+      }
+      PaintTile(index % gridWidth, index / gridWidth, cache);
+    }
+  }
+
+  template <class GC>
+  u32 FrameRenderer<GC>::GetBackgroundColor(const OurTile & tile, const SPoint & owned,
+                                            AtomColorCache<EC> & cache) const
+  {
+    switch (m_backgroundType)
+    {
+    case OurSiteColorer::DRAW_SITE_NONE:
+      return Drawable::BLACK;
+
+    case OurSiteColorer::DRAW_SITE_DARK_TILE:
+      return Drawable::GREY20;
+
+    case OurSiteColorer::DRAW_SITE_LIGHT_TILE:
+      {
+        // Regions nest inward from the owned edge, R sites apiece
+        const s32 edge = MIN(MIN(owned.GetX(), (s32) OurGrid::OWNED_WIDTH - 1 - owned.GetX()),
+                             MIN(owned.GetY(), (s32) OurGrid::OWNED_HEIGHT - 1 - owned.GetY()));
+        const u32 region = MIN((u32) OurTile::REGION_HIDDEN, (u32) (OurTile::REGION_SHARED + edge / R));
+        return m_siteColorer.GetRegionColor(region);
+      }
+
+    default:
+      {
+        u32 color;
+        switch (m_siteColorer.GetSiteColor(m_backgroundType, tile.GetUncachedSite(owned),
+                                              tile, color, 0, &cache))
+        {
+        case OurSiteColorer::SITE_COLOR_SET: return color;
+        case OurSiteColorer::SITE_COLOR_BAD: return Drawable::RED;
+        default: return Drawable::BLACK;
+        }
+      }
+    }
+  }
+
+  template <class GC>
+  void FrameRenderer<GC>::FillSite(u32 * at, u32 pixel)
+  {
+    for (u32 y = 0; y < m_sitePixels; ++y, at += m_width)
+    {
+      for (u32 x = 0; x < m_sitePixels; ++x)
+      {
+        at[x] = pixel;
+      }
+    }
+  }
+
+  template <class GC>
+  void FrameRenderer<GC>::PaintTile(u32 tileX, u32 tileY, AtomColorCache<EC> & cache)
+  {
+    const OurTile & tile = m_grid->GetTile(tileX, tileY);
+    if (tile.IsDummyTile())
+    {
+      return;
+    }
+
+    const bool staggered = m_grid->IsGridLayoutStaggered() && (tileY % 2) > 0;
+    const u32 originX = tileX * OurGrid::OWNED_WIDTH + (staggered ? OurGrid::OWNED_WIDTH / 2 : 0);
+    const u32 originY = tileY * OurGrid::OWNED_HEIGHT;
+    const bool enabled = tile.IsEnabled();
+
+    for (u32 y = 0; y < OurGrid::OWNED_HEIGHT; ++y)
+    {
+      u32 * row = m_pixels + (originY + y) * m_sitePixels * m_width + originX * m_sitePixels;
+      for (u32 x = 0; x < OurGrid::OWNED_WIDTH; ++x, row += m_sitePixels)
+      {
+        u32 color = Drawable::GREY10;  // As TileRenderer shows disabled tiles
+        if (enabled)
+        {
+          const SPoint owned(x, y);
+          color = GetBackgroundColor(tile, owned, cache);
+
+          u32 front;
+          switch (m_siteColorer.GetSiteColor(m_foregroundType, tile.GetUncachedSite(owned),
+                                            tile, front, 0, &cache))
+          {
+          case OurSiteColorer::SITE_COLOR_SET: color = front; break;
+          case OurSiteColorer::SITE_COLOR_BAD: color = Drawable::RED; break;
+          default: break;
+          }
+        }
+        FillSite(row, ToPixel(color));
+      }
+    }
+  }
+
+} /* namespace MFM */
@@ -0,0 +1,101 @@
+/*                                              -*- mode:C++ -*-
+  FrameWriter.h Save rendered frames as PNGs or stream them to an encoder
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file FrameWriter.h Save rendered frames as PNGs or stream them to an encoder
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef FRAMEWRITER_H
+#define FRAMEWRITER_H
+
+#include <stdio.h>  /* For FILE */
+#include "itype.h"
+#include "OverflowableCharBufferByteSink.h"  /* For OString512 */
+
+namespace MFM
+{
+  /**
+     Gets frames of tightly-packed RGBA pixels, as FrameRenderer makes
+     them, out of the process: each one into a PNG file, or all of
+     them as raw video down a pipe to an external encoder.
+   */
+  class FrameWriter
+  {
+  public:
+    FrameWriter() ;
+
+    ~FrameWriter() ;
+
+    /**
+       Write \c height rows of \c width RGBA pixels to a PNG file at
+       \c path, favoring speed over size.  Return false, having
+       logged why, if the file couldn't be written.
+     */
+    static bool WritePNG(const char * path, const u8 * rgba, u32 width, u32 height) ;
+
+    /**
+       Send every frame given to WriteToPipe to the standard input of
+       the shell command \c command, or to our standard output if \c
+       command is "-".  The command is started with the first frame,
+       with each "%S" in it replaced by that frame's size as
+       WIDTHxHEIGHT, so, e.g.,
+
+         ffmpeg -f rawvideo -pix_fmt rgba -s %S -r 30 -i - run.mp4
+
+       encodes a video.  Every frame must then be the same size.
+     */
+    void OpenPipe(const char * command) ;
+
+    bool IsPipeOpen() const
+    {
+      return m_command.GetLength() > 0;
+    }
+
+    /**
+       Send one frame down the pipe.  Return false, and close the
+       pipe, if the encoder has gone away.
+     */
+    bool WriteToPipe(const u8 * rgba, u32 width, u32 height) ;
+
+    /**
+       Close the pipe, if open, and wait for its command to finish
+     */
+    void ClosePipe() ;
+
+    u32 GetFramesPiped() const
+    {
+      return m_framesPiped;
+    }
+
+  private:
+    OString512 m_command;
+    FILE * m_pipe;
+    bool m_pipeIsStdout;
+    u32 m_pipeWidth;
+    u32 m_pipeHeight;
+    u32 m_framesPiped;
+
+    FrameWriter(const FrameWriter &) ;  // Not implemented
+    FrameWriter & operator=(const FrameWriter &) ;  // Not implemented
+  };
+}
+
+#endif /* FRAMEWRITER_H */
@@ -37,6 +37,8 @@
 #include "Sense.h"
 #include "GridConfig.h"
 #include "GridTransceiver.h"
+#include "TileWorkQueue.h"
+#include "GridControlBarrier.h"
 #include "ElementRegistry.h"
 #include "Logger.h"
 #include "LineCountingByteSource.h"
@@ -57,6 +59,7 @@ namespace MFM {
     typedef typename AC::ATOM_TYPE T;
 
     enum { MAX_TILES_SUPPORTED = 500 };  // Yeah right.  Used for sizing m_rgi
+    enum { MAX_SCHEDULER_WORKERS = 64 }; // Upper limit for SetSchedulerWorkers
 
     enum { R = EC::EVENT_WINDOW_RADIUS};
     enum { TILE_WIDTH = GC::TILE_WIDTH};
@@ -149,6 +152,53 @@ namespace MFM {
     bool m_threadsInitted;
     static void * TileDriverRunner(void *) ;
 
+    /**
+       Advance td's transceivers and then its tile by one step.
+       Return false if the tile accomplished nothing.  Must be called
+       only by the thread currently responsible for td.
+     */
+    static bool AdvanceTileDriver(TileDriver & td) ;
+
+    /**
+       A scheduler worker thread.  Used instead of one thread per
+       TileDriver when SetSchedulerWorkers has selected a worker pool.
+     */
+    struct TileWorker {
+      u32 m_index;
+      Grid* m_gridPtr;
+      pthread_t m_threadId;
+      TileWorkQueue m_queue;
+      Random m_random;
+      volatile u64 m_eventsExecuted;
+      volatile u64 m_steals;
+
+      TileWorker()
+        : m_index(0)
+        , m_gridPtr(0)
+        , m_eventsExecuted(0)
+        , m_steals(0)
+      { }
+
+      ~TileWorker() {} //avoid inline error
+    };
+
+    enum { TILE_WORKER_QUANTUM = 16 }; // Max Advances per tile per turn
+
+    TileWorker * m_tileWorkers;
+    u32 m_schedulerWorkers;  // 0 means one thread per tile
+
+    Mutex m_liveTileLock;
+    u32 m_liveTiles;         // Tiles not yet dropped on EXIT_REQUEST
+
+    u32 m_transceiverBufferSize;
+    u32 m_transceiverDataRate; // 0 means unthrottled
+
+    void InitWorkerThreads() ;
+    static void * TileWorkerRunner(void *) ;
+    bool TakeTileForWorker(TileWorker & tw, u32 & tileIndex) ;
+    void DropExitingTile() ;
+    u32 GetLiveTiles() ;
+
     bool m_backgroundRadiationEnabled; // shadows value pushed to tiles
     bool m_foregroundRadiationEnabled; // shadows value pushed to tiles
 
@@ -242,7 +292,10 @@ namespace MFM {
       virtual void MakeRequest(TileDriver & td)
       {
         Tile<EC> & tile = td.GetTile();
-        tile.NeedAtomRecount();
+        if (LOG.IfLog(Logger::DEBUG))
+        {
+          tile.CheckAtomCounts();
+        }
         tile.RequestStateActive();
       }
       virtual bool CheckIfReady(TileDriver & td)
@@ -271,6 +324,17 @@ namespace MFM {
      */
     void DoTileDriverControl(TileDriverControl & tc);
 
+    enum { CONTROL_WAIT_USEC = 1000 };     // Backstop for missed wakeups
+    enum { CONTROL_WAIT_LIMIT = 100000 };  // Waits before complaining
+
+    /**
+     * Lets DoTileDriverControl and paused tile drivers sleep until
+     * something changes, instead of spinning.
+     */
+    GridControlBarrier m_controlBarrier;
+
+    bool m_gridRunning;  // Last value passed to SetGridRunning
+
   public:
     struct GridTouchEvent {
       SiteTouchType m_touchType;
@@ -322,6 +386,14 @@ namespace MFM {
 
     friend class GridRenderer;
 
+    /**
+       Set the master seed, which takes effect at the next Init().
+       By default the tiles are then seeded, in iteration order, from
+       a Random seeded with \c seed, as always.  In an xoshiro build
+       (MFM_RANDOM=xoshiro) the tile at (x,y) is instead seeded with
+       Random::GetStreamSeed(seed, (x << 16) | y), so a given seed
+       reproduces each tile's stream whatever the grid's size.
+     */
     void SetSeed(u32 seed);
 
     Grid(ElementRegistry<EC>& elts, u32 width, u32 height, GridLayoutPattern layout)
@@ -334,10 +406,16 @@ namespace MFM {
       , m_intertileLocks(new LonglivedLock[m_width * m_height * MAX_LOCKS_OWNED_PER_TILE])
       , m_tileDrivers(new TileDriver[m_width * m_height * MAX_LOCKS_OWNED_PER_TILE])
       , m_threadsInitted(false)
+      , m_tileWorkers(0)
+      , m_schedulerWorkers(0)
+      , m_liveTiles(0)
+      , m_transceiverBufferSize(GridTransceiver::DEFAULT_BUFFER_SIZE)
+      , m_transceiverDataRate(0)
       , m_backgroundRadiationEnabled(false)
       , m_foregroundRadiationEnabled(false)
       , m_er(elts)
       , m_xraySiteOdds(100)
+      , m_gridRunning(false)
       , m_rgi(m_width * m_height)
     {
       //dummy tiles not set for iterator use!!! avoid illegal tile coord.
@@ -360,11 +438,99 @@ namespace MFM {
      */
     void InitThreads();
 
+    /**
+       Select how InitThreads will run the tiles.  With \c workers of
+       0 (the default), each tile gets its own thread.  Otherwise, a
+       pool of \c workers threads shares all the tiles, pulling them
+       from per-worker queues and stealing from each other when they
+       run dry.  Must be called before InitThreads.
+     */
+    void SetSchedulerWorkers(u32 workers)
+    {
+      MFM_API_ASSERT_STATE(!m_threadsInitted);
+      MFM_API_ASSERT_ARG(workers <= MAX_SCHEDULER_WORKERS);
+      m_schedulerWorkers = workers;
+    }
+
+    /**
+       Get the number of scheduler worker threads, or 0 if each tile
+       is run by its own thread.
+     */
+    u32 GetSchedulerWorkers() const
+    {
+      return m_schedulerWorkers;
+    }
+
+    /**
+       Set the per-direction buffer size, in bytes, of the
+       GridTransceivers connecting the tiles.  Must be a power of two
+       acceptable to GridTransceiver::SetBufferSize, and must be
+       called before Init.
+     */
+    void SetTransceiverBufferSize(u32 bytes)
+    {
+      MFM_API_ASSERT_ARG(bytes >= GridTransceiver::MIN_BUFFER_SIZE &&
+                         bytes <= GridTransceiver::MAX_BUFFER_SIZE &&
+                         (bytes & (bytes - 1)) == 0);
+      m_transceiverBufferSize = bytes;
+    }
+
+    u32 GetTransceiverBufferSize() const
+    {
+      return m_transceiverBufferSize;
+    }
+
+    /**
+       Set the data rate, in bytes per second, of the modeled
+       transmission lines connecting the tiles.  With \c bytesPerSecond
+       of 0 (the default), the transceivers are unthrottled, and
+       intertile packets are readable as soon as they are written.
+       Must be called before Init.
+     */
+    void SetTransceiverDataRate(u32 bytesPerSecond)
+    {
+      m_transceiverDataRate = bytesPerSecond;
+    }
+
+    u32 GetTransceiverDataRate() const
+    {
+      return m_transceiverDataRate;
+    }
+
+    /**
+       Get the total number of events executed by scheduler worker \c
+       worker since InitThreads.  Only approximate while the grid is
+       running.
+     */
+    u64 GetWorkerEventsExecuted(u32 worker) const
+    {
+      MFM_API_ASSERT_ARG(worker < m_schedulerWorkers);
+      return m_tileWorkers[worker].m_eventsExecuted;
+    }
+
+    /**
+       Get the number of tiles scheduler worker \c worker has stolen
+       from other workers since InitThreads.
+     */
+    u64 GetWorkerSteals(u32 worker) const
+    {
+      MFM_API_ASSERT_ARG(worker < m_schedulerWorkers);
+      return m_tileWorkers[worker].m_steals;
+    }
+
     /**
        Enable or disable the tiles and the transceivers.
      */
     void SetGridRunning(bool running) ;
 
+    /**
+       True if the grid was last unpaused rather than paused.
+     */
+    bool IsGridRunning() const
+    {
+      return m_gridRunning;
+    }
+
     const Tile<EC> & Get00Tile() const {
       return _getTile(0,0);
     }
@@ -495,6 +661,7 @@ namespace MFM {
       delete [] m_tiles;
       delete [] m_intertileLocks;
       delete [] m_tileDrivers;
+      delete [] m_tileWorkers;
     }
 
     /**
@@ -802,8 +969,21 @@ namespace MFM {
 
     u64 GetTotalEventsExecuted() const;
 
+    /**
+     * Like GetTotalEventsExecuted, but safe to call while the grid is
+     * running, at the price of being slightly stale.
+     */
+    u64 SampleTotalEventsExecuted() const;
+
     u64 GetTotalSitesAccessed() const;
 
+    /**
+     * Gets how many of the GetTotalEventsExecuted() events were on
+     * atoms of inert Elements, and so took the fast path that counts
+     * them without running them.
+     */
+    u64 GetTotalInertEventsExecuted() const;
+
     void WriteEPSImage(ByteSink & outstrm) const;
 
     void WriteEPSAverageImage(ByteSink & outstrm) const;
@@ -867,6 +1047,69 @@ namespace MFM {
       return m_foregroundRadiationEnabled;
     }
 
+    /**
+     * Rearranges the site storage of every Tile in this Grid into \c
+     * layout, preserving their contents.  Grid must be paused.
+     */
+    void SetSiteLayout(SiteLayout layout);
+
+    /**
+     * Gets the SiteLayout the Tiles of this Grid are using.
+     */
+    SiteLayout GetSiteLayout() const
+    {
+      return GetTile(0,0).GetSiteLayout();
+    }
+
+    /**
+     * Sets how every Tile in this Grid chooses its event centers.
+     * See Tile::SetSiteSampling.
+     */
+    void SetSiteSampling(SiteSampling sampling);
+
+    /**
+     * Has every Tile in this Grid spill event history evicted from
+     * memory to a ring of up to \c bytesPerTile bytes in a file
+     * "history-X-Y.dat" in the directory \c dirPath (which must end
+     * in '/').  Returns false if any file could not be created.  See
+     * EventHistoryBuffer::SetSpillFile.
+     */
+    bool SetHistorySpill(const char * dirPath, u32 bytesPerTile);
+
+    /**
+     * Gets how the Tiles of this Grid choose their event centers.
+     */
+    SiteSampling GetSiteSampling() const
+    {
+      return GetTile(0,0).GetSiteSampling();
+    }
+
+    /**
+     * Has every Tile in this Grid profile one event in every \c oneIn
+     * by element, or stop profiling if \c oneIn is 0.  See
+     * ElementProfile::SetSampling.
+     */
+    void SetElementProfiling(u32 oneIn);
+
+    /**
+     * Gets one in how many events the Tiles of this Grid profile, or
+     * 0 if they are not profiling.
+     */
+    u32 GetElementProfiling() const
+    {
+      return Get00Tile().GetElementProfile().GetSampling();
+    }
+
+    /**
+     * Merges the ElementProfiles of all Tiles by element, and prints
+     * the \c topN elements by sampled ticks to \c to: one line each,
+     * giving their share of all sampled ticks and their mean ticks per
+     * sample in each phase, after '#' comment lines with the totals
+     * and the column names.  Tiles are sampled while they run, so the
+     * totals may be slightly stale.
+     */
+    void WriteElementProfile(ByteSink & to, u32 topN) const;
+
     /**
      * Randomly flips bits in randomly selected sites in this grid.
      */
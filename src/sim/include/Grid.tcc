@@ -3,6 +3,7 @@
 #include "Grid.h"
 #include "Utils.h"   /* For Sleep */
 #include "FileByteSink.h"
+#include <sched.h>   /* For sched_yield */
 
 #define XRAY_BIT_ODDS 100
 
@@ -165,9 +166,15 @@ namespace MFM {
 	    ctile.Connect(gt, ctl, d);
 	    otile.Connect(gt, otl, odir);
 
+	    if (!gt.IsEnabled())
+	      {
+		gt.SetBufferSize(m_transceiverBufferSize);
+		gt.SetThrottled(m_transceiverDataRate != 0);
+		if (m_transceiverDataRate != 0)
+		  gt.SetDataRate(m_transceiverDataRate);
+		gt.SetMaxInFlight(0);
+	      }
 	    gt.SetEnabled(true);
-	    gt.SetDataRate(100000000);
-	    gt.SetMaxInFlight(0);
 	  } //direction loop
       } //tile loop
   } //Init
@@ -181,7 +188,7 @@ namespace MFM {
     {
       for(u32 y = 0; y < m_height; y++)
       {
-	if(!IsLegalTileIndex(x,y))
+	if(!IsLegalTileIndex(SPoint(x,y)))
 	  continue;
 
         const Tile<EC> & tile = GetTile(x,y);
@@ -232,6 +239,13 @@ namespace MFM {
       FAIL(ILLEGAL_STATE);
     }
 
+    if (m_schedulerWorkers > 0)
+    {
+      InitWorkerThreads();
+      m_threadsInitted = true;
+      return;
+    }
+
     /* Init the tile thread drivers */
     for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
@@ -253,6 +267,211 @@ namespace MFM {
     m_threadsInitted = true;
   }
 
+  template <class GC>
+  void Grid<GC>::InitWorkerThreads()
+  {
+    MFM_API_ASSERT_STATE(m_schedulerWorkers > 0 && m_schedulerWorkers <= MAX_SCHEDULER_WORKERS);
+    MFM_API_ASSERT_STATE(m_width * m_height <= TileWorkQueue::CAPACITY);
+
+    m_tileWorkers = new TileWorker[m_schedulerWorkers];
+    for (u32 w = 0; w < m_schedulerWorkers; ++w)
+    {
+      TileWorker & tw = m_tileWorkers[w];
+      tw.m_index = w;
+      tw.m_gridPtr = this;
+      tw.m_random.SetSeed(m_random.Create());
+    }
+
+    /* Init the tile drivers and deal them out to the workers */
+    u32 dealt = 0;
+    for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
+    {
+      SPoint tpt = IteratorIndexToCoord(m_rgi.Next());
+      MFM_API_ASSERT_STATE(IsLegalTileIndex(tpt));
+
+      TileDriver & td = _getTileDriver(tpt.GetX(),tpt.GetY());
+      td.m_loc = tpt; //init m_loc before a GetTile call
+      td.m_gridPtr = this;
+      td.SetState(TileDriver::PAUSED);
+
+      Tile<EC> & ctile = td.GetTile();
+      MFM_API_ASSERT_STATE(!ctile.IsDummyTile());
+      ctile.RequestStatePassive();
+
+      u32 tileIndex = tpt.GetX() * m_height + tpt.GetY(); // as in _getTileDriver
+      m_tileWorkers[dealt % m_schedulerWorkers].m_queue.PushBottom(tileIndex);
+      ++dealt;
+    }
+
+    {
+      Mutex::ScopeLock lock(m_liveTileLock);
+      m_liveTiles = dealt;
+    }
+
+    LOG.Message("Scheduling %d tiles on %d worker threads", dealt, m_schedulerWorkers);
+
+    for (u32 w = 0; w < m_schedulerWorkers; ++w)
+    {
+      TileWorker & tw = m_tileWorkers[w];
+      if (pthread_create(&tw.m_threadId, NULL, TileWorkerRunner, &tw))
+      {
+        FAIL(ILLEGAL_STATE);
+      }
+    }
+  }
+
+  template <class GC>
+  void Grid<GC>::DropExitingTile()
+  {
+    Mutex::ScopeLock lock(m_liveTileLock);
+    MFM_API_ASSERT_STATE(m_liveTiles > 0);
+    --m_liveTiles;
+  }
+
+  template <class GC>
+  u32 Grid<GC>::GetLiveTiles()
+  {
+    Mutex::ScopeLock lock(m_liveTileLock);
+    return m_liveTiles;
+  }
+
+  template <class GC>
+  bool Grid<GC>::TakeTileForWorker(TileWorker & tw, u32 & tileIndex)
+  {
+    const u32 workers = m_schedulerWorkers;
+    if (workers > 1)
+    {
+      // Even things out if some other worker has clearly more than us
+      u32 victim = (tw.m_index + 1 + tw.m_random.Create(workers - 1)) % workers;
+      TileWorkQueue & vq = m_tileWorkers[victim].m_queue;
+      if (vq.GetCount() > tw.m_queue.GetCount() + 1 && vq.StealBottom(tileIndex))
+      {
+        ++tw.m_steals;
+        return true;
+      }
+    }
+
+    if (tw.m_queue.PopTop(tileIndex))
+    {
+      return true;
+    }
+
+    // We're out of work.  Check everybody else, starting at random
+    u32 start = tw.m_random.Create(workers);
+    for (u32 i = 0; i < workers; ++i)
+    {
+      u32 victim = (start + i) % workers;
+      if (victim != tw.m_index && m_tileWorkers[victim].m_queue.StealBottom(tileIndex))
+      {
+        ++tw.m_steals;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  template <class GC>
+  void* Grid<GC>::TileWorkerRunner(void * arg)
+  {
+    TileWorker & tw = *(TileWorker*) arg;
+    Grid & grid = *tw.m_gridPtr;
+
+    MFM_LOG_DBG4(("TileWorker %d init", tw.m_index));
+
+    u32 idleTurns = 0;    // Turns since any tile made progress
+    bool sawPaused = false;
+    u32 pauseUsec = 0;
+    while (true)
+    {
+      u32 tileIndex;
+      if (!grid.TakeTileForWorker(tw, tileIndex))
+      {
+        if (grid.GetLiveTiles() == 0)
+        {
+          break;
+        }
+        // All tiles are checked out by other workers
+        sched_yield();
+        continue;
+      }
+
+      TileDriver & td = grid.m_tileDrivers[tileIndex];
+      Tile<EC> & ctile = td.GetTile();
+
+      // Point the error stack at the tile we're about to run
+      MFMPtrToErrEnvStackPtr = ctile.GetErrorEnvironmentStackTop();
+
+      bool progress = false;
+      switch (td.GetState())
+      {
+      case TileDriver::EXIT_REQUEST:
+        grid.DropExitingTile();
+        continue;   // Tile is not requeued
+
+      case TileDriver::ADVANCING:
+      {
+        u64 eventsBefore = ctile.GetEventsExecuted();
+        for (u32 q = 0; q < TILE_WORKER_QUANTUM; ++q)
+        {
+          if (!AdvanceTileDriver(td))
+          {
+            break;
+          }
+          progress = true;
+          if (td.GetState() != TileDriver::ADVANCING)
+          {
+            break;
+          }
+        }
+        tw.m_eventsExecuted += ctile.GetEventsExecuted() - eventsBefore;
+        pauseUsec = 0;
+        break;
+      }
+
+      case TileDriver::PAUSED:
+        sawPaused = true;
+        break;
+
+      default:
+        FAIL(ILLEGAL_STATE);
+      }
+
+      tw.m_queue.PushBottom(tileIndex);
+
+      if (grid.m_controlBarrier.IsActive())
+      {
+        // Don't hog the cpu while the grid is being controlled
+        sched_yield();
+      }
+
+      if (progress)
+      {
+        idleTurns = 0;
+        sawPaused = false;
+      }
+      else if (++idleTurns >= grid.m_width * grid.m_height)
+      {
+        // A whole grid's worth of turns accomplished nothing
+        if (sawPaused)
+        {
+          // Sleep a little, or until the grid changes state
+          if (pauseUsec < 100000)
+            pauseUsec += tw.m_random.Between(10,100);
+          grid.m_controlBarrier.WaitForChange(grid.m_controlBarrier.GetGeneration(), pauseUsec);
+        }
+        else
+        {
+          // Let somebody else try
+          sched_yield();
+        }
+        idleTurns = 0;
+        sawPaused = false;
+      }
+    }
+    MFM_LOG_DBG4(("TileWorker %d exiting", tw.m_index));
+    return NULL;
+  }
+
   template <class GC>
   void Grid<GC>::SetGridRunning(bool running)
   {
@@ -267,6 +486,42 @@ namespace MFM {
 
       td.SetState(running? TileDriver::ADVANCING : TileDriver::PAUSED);
     }
+    m_gridRunning = running;
+
+    /* Wake any drivers sleeping while paused */
+    m_controlBarrier.Notify();
+  }
+
+  template <class GC>
+  bool Grid<GC>::AdvanceTileDriver(TileDriver & td)
+  {
+    // Drive this tile's transceivers, if they're modeling a data rate
+    if (td.m_gridPtr->m_transceiverDataRate != 0)
+    {
+      timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      for (u32 c = 0; c < 4; ++c)
+      {
+        if(td.m_channels[c].IsEnabled()) //esa
+          td.m_channels[c].AdvanceToTime(now);
+      }
+    }
+
+    // Drive the tile itself, waking any grid control waiting on it
+    Tile<EC> & ctile = td.GetTile();
+    GridControlBarrier & barrier = td.m_gridPtr->m_controlBarrier;
+    if (!barrier.IsActive())
+    {
+      return ctile.Advance();
+    }
+
+    typename Tile<EC>::State before = ctile.GetCurrentState();
+    bool ret = ctile.Advance();
+    if (ctile.GetCurrentState() != before)
+    {
+      barrier.Notify();
+    }
+    return ret;
   }
 
   template <class GC>
@@ -302,17 +557,7 @@ namespace MFM {
 
       case TileDriver::ADVANCING:
       {
-        // Drive this tile's transceivers
-        timespec now;
-        clock_gettime(CLOCK_MONOTONIC, &now);
-        for (u32 c = 0; c < 4; ++c)
-        {
-	  if(td->m_channels[c].IsEnabled()) //esa
-	    td->m_channels[c].AdvanceToTime(now);
-        }
-
-        // Drive the tile itself
-        if (!ctile.Advance())
+        if (!AdvanceTileDriver(*td))
         {
           // We accomplished nothing.  Let somebody else try
           pthread_yield();
@@ -322,11 +567,17 @@ namespace MFM {
       }
 
       case TileDriver::PAUSED:
-        // Sleep a little
+      {
+        // Sleep a little, or until the grid changes state
+        GridControlBarrier & barrier = td->m_gridPtr->m_controlBarrier;
+        u32 generation = barrier.GetGeneration();
+        if (td->GetState() != TileDriver::PAUSED)
+          break;
         if (pauseUsec < 100000)
           pauseUsec += ctile.GetRandom().Between(10,100);
-        SleepUsec(pauseUsec);
+        barrier.WaitForChange(generation, pauseUsec);
         break;
+      }
 
       default:
         FAIL(ILLEGAL_STATE);
@@ -351,8 +602,17 @@ namespace MFM {
     }
 
     m_random.SetSeed(m_seed);
+
+#ifdef MFM_RANDOM_XOSHIRO
+    // Each tile's stream depends only on the seed and the tile's
+    // position, never on the grid's size or seeding order
+    for (u32 x = 0; x < m_width; ++x)
+      for (u32 y = 0; y < m_height; ++y)
+        _getTile(x, y).GetRandom().SetSeed(Random::GetStreamSeed(m_seed, (x << 16) | y));
+#else
     for (iterator_type i = begin(); i != end(); ++i)
       i->GetRandom().SetSeed(m_random.Create());
+#endif
   }
 
 
@@ -505,7 +765,7 @@ namespace MFM {
     }
 
     Tile<EC> & owner = GetTile(tileInGrid);
-    Site<AC> & site = owner.GetSite(siteInTile);
+    typename Tile<EC>::SiteReference site = owner.GetSite(siteInTile);
 
     //////// NOTE WE ARE RACING AGAINST THE TILE THREADS HERE!
     //
@@ -742,6 +1002,7 @@ namespace MFM {
     }
 
     // Issue request to all
+    m_controlBarrier.Begin();
     for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
       SPoint i = IteratorIndexToCoord(m_rgi.Next());
@@ -754,58 +1015,57 @@ namespace MFM {
       tc.MakeRequest(td);
     }
 
-    // Wait until all acknowledge
-    u32 loops = 0;
-    u32 notReady = 0;
-    s32 sleepTimer = 100000000; // XXX m_random.Between(1000,10000);
-    do
+    // Wait until all acknowledge.  Rather than spinning, sleep until
+    // some tile changes state, and only recheck the tiles still
+    // pending.
+    u32 pending[MAX_TILES_SUPPORTED];
+    u32 pendingCount = 0;
+    for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
-      if (++loops >= 1000000)
-      {
-        LOG.Error("%s control looped %d times, but %d still not ready, killing",
-                  tc.GetName(), loops, notReady);
-        ReportGridStatus(Logger::ERROR);
-        LOG.Error("%s control: Sleeping", tc.GetName());
-        SleepUsec(60*1000000);  // 1 minute
-        LOG.Error("%s control: Resetting", tc.GetName());
-        loops = 0;
-      }
+      pending[pendingCount++] = m_rgi.Next();
+    }
 
-      if (--sleepTimer < 0)
+    u32 waits = 0;
+    while (true)
+    {
+      u32 generation = m_controlBarrier.GetGeneration();
+
+      u32 stillPending = 0;
+      for (u32 p = 0; p < pendingCount; ++p)
       {
-        SleepUsec(m_random.Between(10,1000));  // 0.01ms..1ms
-        sleepTimer = m_random.Create(10000);
+        SPoint i = IteratorIndexToCoord(pending[p]);
+        TileDriver & td = _getTileDriver(i.GetX(),i.GetY());
+        if (!tc.CheckIfReady(td))
+        {
+          pending[stillPending++] = pending[p];
+        }
       }
-      else
+      pendingCount = stillPending;
+
+      if (pendingCount == 0)
       {
-        pthread_yield();
+        break;
       }
 
-      notReady = 0;
-
-      for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
+      if (++waits >= CONTROL_WAIT_LIMIT)
       {
-        SPoint i = IteratorIndexToCoord(m_rgi.Next());
-	MFM_API_ASSERT_STATE(IsLegalTileIndex(i));
-
-        u32 x = i.GetX();
-        u32 y = i.GetY();
-        TileDriver & td = _getTileDriver(x,y);
-	MFM_API_ASSERT_STATE(!td.GetTile().IsDummyTile());
-
-        if (!tc.CheckIfReady(td))
-        {
-          ++notReady;
-          pthread_yield();
-        }
+        LOG.Error("%s control waited %d times, but %d still not ready, killing",
+                  tc.GetName(), waits, pendingCount);
+        ReportGridStatus(Logger::ERROR);
+        LOG.Error("%s control: Sleeping", tc.GetName());
+        SleepUsec(60*1000000);  // 1 minute
+        LOG.Error("%s control: Resetting", tc.GetName());
+        waits = 0;
       }
 
-    } while (notReady > 0);
+      m_controlBarrier.WaitForChange(generation, CONTROL_WAIT_USEC);
+    }
+    m_controlBarrier.End();
 
-    if (loops > 5000)
+    if (waits > 5000)
     {
-      LOG.Debug("%s control looped %d times",
-                tc.GetName(), loops);
+      LOG.Debug("%s control waited %d times",
+                tc.GetName(), waits);
     }
 
     // Release the hounds
@@ -842,6 +1102,16 @@ namespace MFM {
     return total;
   }
 
+  template <class GC>
+  u64 Grid<GC>::SampleTotalEventsExecuted() const
+  {
+    u64 total = 0;
+    for (const_iterator_type i = begin(); i != end(); ++i)
+      total += i->SampleEventsExecuted();
+
+    return total;
+  }
+
   template <class GC>
   u64 Grid<GC>::GetTotalSitesAccessed() const
   {
@@ -852,6 +1122,16 @@ namespace MFM {
     return total;
   }
 
+  template <class GC>
+  u64 Grid<GC>::GetTotalInertEventsExecuted() const
+  {
+    u64 total = 0;
+    for (const_iterator_type i = begin(); i != end(); ++i)
+      total += i->GetInertEventsExecuted();
+
+    return total;
+  }
+
   template <class GC>
   void Grid<GC>::WriteEPSImage(ByteSink & outstrm) const
   {
@@ -1033,6 +1313,123 @@ namespace MFM {
     m_foregroundRadiationEnabled = value;
   }
 
+  template <class GC>
+  void Grid<GC>::SetSiteLayout(SiteLayout layout)
+  {
+    for (iterator_type i = begin(); i != end(); ++i)
+      i->SetSiteLayout(layout);
+  }
+
+  template <class GC>
+  void Grid<GC>::SetSiteSampling(SiteSampling sampling)
+  {
+    for (iterator_type i = begin(); i != end(); ++i)
+      i->SetSiteSampling(sampling);
+  }
+
+  template <class GC>
+  void Grid<GC>::SetElementProfiling(u32 oneIn)
+  {
+    for (iterator_type i = begin(); i != end(); ++i)
+      i->GetElementProfile().SetSampling(oneIn);
+  }
+
+  template <class GC>
+  void Grid<GC>::WriteElementProfile(ByteSink & to, u32 topN) const
+  {
+    typedef ElementProfile::Slot Slot;
+    const u32 SLOTS = ElementProfile::SLOTS;
+
+    // Merge into the slots of the 00 tile's table, by element
+    const ElementTable<EC> & table = Get00Tile().GetElementTable();
+    Slot totals[SLOTS];
+    for (u32 s = 0; s < SLOTS; ++s)
+      totals[s].Clear();
+
+    Slot sample;
+    for (const_iterator_type i = begin(); i != end(); ++i)
+    {
+      const ElementTable<EC> & tileTable = i->GetElementTable();
+      const ElementProfile & profile = i->GetElementProfile();
+      for (u32 s = 0; s < tileTable.GetSize(); ++s)
+      {
+        const Element<EC> * elt = tileTable.GetEntryAtIndex(s).m_element;
+        if (!elt)
+          continue;
+        profile.SampleSlot(s, sample);
+        const s32 index = table.GetIndex(elt->GetType());
+        if (sample.m_samples > 0 && index >= 0)
+          totals[index].Add(sample);
+      }
+    }
+
+    Slot all;
+    all.Clear();
+    for (u32 s = 0; s < SLOTS; ++s)
+      all.Add(totals[s]);
+
+    to.Printf("# Element profile: 1 in %d events, %d samples\n",
+              GetElementProfiling(), (u32) all.m_samples);
+    to.Printf("# rank symbol name samples share%%");
+    for (u32 p = 0; p < ElementProfile::PHASE_COUNT; ++p)
+      to.Printf(" %s", ElementProfile::GetPhaseName((ElementProfile::Phase) p));
+    to.Printf("\n");
+
+    const u64 allTicks = all.GetTotalTicks();
+    bool listed[SLOTS];
+    for (u32 s = 0; s < SLOTS; ++s)
+      listed[s] = false;
+
+    for (u32 rank = 1; rank <= topN; ++rank)
+    {
+      s32 best = -1;
+      for (u32 s = 0; s < SLOTS; ++s)
+      {
+        if (!listed[s] && totals[s].m_samples > 0 &&
+            (best < 0 || totals[s].GetTotalTicks() > totals[best].GetTotalTicks()))
+          best = (s32) s;
+      }
+      if (best < 0)
+        break;
+      listed[best] = true;
+
+      const Slot & slot = totals[best];
+      const Element<EC> * elt = table.GetEntryAtIndex((u32) best).m_element;
+      const u32 permille = allTicks > 0 ? (u32) (slot.GetTotalTicks() * 1000 / allTicks) : 0;
+      to.Printf("%d %s %s %d %d.%d",
+                rank, elt->GetAtomicSymbol(), elt->GetName(),
+                (u32) slot.m_samples, permille / 10, permille % 10);
+      for (u32 p = 0; p < ElementProfile::PHASE_COUNT; ++p)
+        to.Printf(" %d", (u32) (slot.m_ticks[p] / slot.m_samples));
+      to.Printf("\n");
+    }
+  }
+
+  template <class GC>
+  bool Grid<GC>::SetHistorySpill(const char * dirPath, u32 bytesPerTile)
+  {
+    for (u32 x = 0; x < m_width; ++x)
+    {
+      for (u32 y = 0; y < m_height; ++y)
+      {
+        if (!IsLegalTileIndex(SPoint(x,y)))
+          continue;
+
+        Tile<EC> & tile = GetTile(x,y);
+        if (tile.IsDummyTile())
+          continue;
+
+        OString512 path;
+        path.Printf("%shistory-%d-%d.dat", dirPath, x, y);
+        if (!tile.GetEventHistoryBuffer().SetSpillFile(path.GetZString(), bytesPerTile))
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
   template <class GC>
   void Grid<GC>::XRay()
   {
@@ -0,0 +1,104 @@
+/*                                              -*- mode:C++ -*-
+  GridControlBarrier.h Wakeups for synchronized grid control
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file GridControlBarrier.h Wakeups for synchronized grid control
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef GRIDCONTROLBARRIER_H
+#define GRIDCONTROLBARRIER_H
+
+#include <pthread.h>
+#include "itype.h"
+
+namespace MFM
+{
+  /**
+    Lets the thread running a Grid control operation (such as Pause)
+    sleep until some tile changes state, rather than spinning and
+    polling every tile.
+
+    The controller calls Begin, then repeatedly takes GetGeneration,
+    checks the tiles, and calls WaitForChange with that generation
+    if they aren't all ready yet; then End.  While a control is in
+    progress, tile threads call Notify whenever their tile changes
+    state.  Because Notify bumps the generation, a change that lands
+    between the controller's check and its wait is not lost.
+
+    Tile threads check IsActive without locking, so they may miss the
+    start of a control operation briefly; WaitForChange therefore
+    always takes a timeout as a backstop.
+   */
+  class GridControlBarrier
+  {
+    pthread_mutex_t m_lock;
+    pthread_cond_t m_changed;
+    volatile u32 m_active;
+    volatile u32 m_generation;
+
+    GridControlBarrier(const GridControlBarrier &) ; // Declare away
+    GridControlBarrier & operator=(const GridControlBarrier &) ; // Declare away
+
+  public:
+    GridControlBarrier() ;
+
+    ~GridControlBarrier() ;
+
+    /**
+       Mark a control operation as in progress.
+     */
+    void Begin() ;
+
+    /**
+       Mark the current control operation as finished.
+     */
+    void End() ;
+
+    /**
+       True if a control operation is in progress.  Cheap enough to
+       call on every tile advance.
+     */
+    bool IsActive() const
+    {
+      return m_active != 0;
+    }
+
+    /**
+       Get the current change generation, to pass to WaitForChange.
+     */
+    u32 GetGeneration() ;
+
+    /**
+       Record that some tile has changed state, and wake the
+       controller.
+     */
+    void Notify() ;
+
+    /**
+       Sleep until Notify has been called since \c generation was
+       obtained, or until \c maxUsec microseconds have passed.
+       Return true if woken by a Notify.
+     */
+    bool WaitForChange(u32 generation, u32 maxUsec) ;
+  };
+}
+
+#endif /* GRIDCONTROLBARRIER_H */
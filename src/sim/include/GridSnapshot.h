@@ -0,0 +1,298 @@
+/*                                              -*- mode:C++ -*-
+  GridSnapshot.h Binary, memory-mappable grid snapshots
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file GridSnapshot.h Binary, memory-mappable grid snapshots
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef GRIDSNAPSHOT_H
+#define GRIDSNAPSHOT_H
+
+#include "itype.h"
+#include "ByteSink.h"
+#include "ExternalConfig.h"
+#include "ExternalConfigSectionGrid.h"
+#include <stdio.h>  /* For FILE */
+
+namespace MFM
+{
+  /**
+     A ByteSink that accumulates everything written to it in a
+     heap buffer that grows as needed.
+   */
+  class GrowableByteSink : public ByteSink
+  {
+  public:
+    GrowableByteSink()
+      : m_buffer(0)
+      , m_length(0)
+      , m_capacity(0)
+    { }
+
+    ~GrowableByteSink()
+    {
+      free(m_buffer);
+    }
+
+    virtual void WriteBytes(const u8 * data, const u32 len) ;
+
+    virtual s32 CanWrite()
+    {
+      return S32_MAX;
+    }
+
+    const u8 * GetBuffer() const
+    {
+      return m_buffer;
+    }
+
+    u32 GetLength() const
+    {
+      return m_length;
+    }
+
+  private:
+    u8 * m_buffer;
+    u32 m_length;
+    u32 m_capacity;
+
+    GrowableByteSink(const GrowableByteSink &) ;  // Not implemented
+    GrowableByteSink & operator=(const GrowableByteSink &) ;  // Not implemented
+  };
+
+  /**
+     An in-memory copy of a grid, taken by GridSnapshot::Capture, that
+     can be saved later -- possibly on another thread -- by
+     GridSnapshot::Save.  Owns its buffer.
+   */
+  class GridSnapshotImage
+  {
+  public:
+    GridSnapshotImage()
+      : m_buffer(0)
+      , m_length(0)
+      , m_sitesMark(0)
+    { }
+
+    ~GridSnapshotImage()
+    {
+      Clear();
+    }
+
+    void Clear()
+    {
+      free(m_buffer);
+      m_buffer = 0;
+      m_length = 0;
+      m_sitesMark = 0;
+    }
+
+    bool IsEmpty() const
+    {
+      return m_buffer == 0;
+    }
+
+    u32 GetLength() const
+    {
+      return m_length;
+    }
+
+    /**
+       Exchange contents with \c other, so an image can be handed off
+       without copying it.
+     */
+    void Swap(GridSnapshotImage & other) ;
+
+  private:
+    template <class GC> friend class GridSnapshot;
+
+    u8 * m_buffer;      // A complete snapshot file image
+    u32 m_length;
+    u32 m_sitesMark;    // Where, in the config text, the Site(..) lines go
+
+    GridSnapshotImage(const GridSnapshotImage &) ;  // Not implemented
+    GridSnapshotImage & operator=(const GridSnapshotImage &) ;  // Not implemented
+  };
+
+  /**
+     Reads and writes a Grid as a versioned binary snapshot, the
+     faster alternative to the text .mfs format.  A snapshot file
+     (conventionally '.mfb') holds:
+
+     - A fixed Header, identifying the format version and the
+       compiled-in sizes the raw site data depends on,
+
+     - An element table mapping each atom type used in the file to an
+       element UUID, so types can be remapped if the loading
+       simulator assigned them differently,
+
+     - The .mfs text of everything except the sites (driver state,
+       element registrations and parameters, tile settings), and
+
+     - For each tile, a TileHeader and a contiguous array of all its
+       sites, caches included, as raw Site structs -- whatever
+       SiteLayout the tiles happen to be using.
+
+     Writing assembles the whole file in memory and writes it at
+     once; reading maps the file and copies the site arrays straight
+     into the tiles.  The in-memory file image can also be kept, via
+     Capture, and written out later as either format via Save.  The raw site data is only meaningful to a
+     simulator built with the same Site struct, which the Header
+     checks.
+   */
+  template <class GC>
+  class GridSnapshot
+  {
+    typedef typename GC::EVENT_CONFIG EC;
+    typedef typename EC::ATOM_CONFIG AC;
+    typedef typename AC::ATOM_TYPE T;
+    typedef typename EC::SITE S;
+
+    enum { BPA = AC::BITS_PER_ATOM };
+
+  public:
+    // SNAPSHOT_VERSION = 1 (2026) Initial version
+    enum { SNAPSHOT_VERSION = 1 };
+
+    /**
+       The alignment, in bytes, of the config text and each tile
+       record within a snapshot file.
+     */
+    enum { SNAPSHOT_ALIGNMENT = 64 };
+
+    /**
+       Return true if \c path names a binary snapshot -- that is, if it
+       ends in '.mfb' -- rather than a text .mfs file.
+     */
+    static bool IsSnapshotPath(const char * path) ;
+
+    GridSnapshot(ExternalConfig<GC> & ec, ExternalConfigSectionGrid<GC> & ecsg)
+      : m_capturing(0)
+      , m_sitesMark(0)
+      , m_ec(ec)
+      , m_ecsg(ecsg)
+    { }
+
+    /**
+       Write the grid, and everything else an .mfs would contain, to a
+       binary snapshot at \c path.  Grid must not be running.  Return
+       false, having logged an error, if the file cannot be written.
+     */
+    bool Write(const char * path) ;
+
+    /**
+       Copy the grid, and everything else an .mfs would contain, into
+       \c image, as quickly as possible.  Grid must not be running,
+       but may be restarted as soon as this returns.  Return false,
+       having logged an error, if the grid cannot be snapshotted.
+     */
+    bool Capture(GridSnapshotImage & image) ;
+
+    /**
+       Save a previously captured \c image to \c path, as a binary
+       snapshot if IsSnapshotPath(path) and as .mfs text otherwise.
+       Touches only the image and the grid's fixed geometry and
+       element types, so it may run while the grid is running, but
+       not while a configuration is being loaded.  Return false,
+       having logged an error, if the file cannot be written.
+     */
+    bool Save(const GridSnapshotImage & image, const char * path) ;
+
+    /**
+       Replace the grid contents with the binary snapshot at \c path.
+       Grid must not be running.  Return false, having logged an
+       error, if the file cannot be read or was made by an
+       incompatible simulator.
+     */
+    bool Read(const char * path) ;
+
+  private:
+    struct Header
+    {
+      char m_magic[8];      // "MFMSNAP" plus a NUL
+      u32 m_version;        // SNAPSHOT_VERSION
+      u32 m_byteOrder;      // BYTE_ORDER_MARK as written
+      u32 m_siteBytes;      // sizeof(S)
+      u32 m_bitsPerAtom;
+      u32 m_tileWidth;      // Including caches
+      u32 m_tileHeight;
+      u32 m_gridWidth;      // In tiles
+      u32 m_gridHeight;
+      u32 m_tileCount;      // Tile records present
+      u32 m_elementCount;   // ElementEntries present
+      u32 m_elementsOffset;
+      u32 m_configOffset;
+      u32 m_configLength;
+      u32 m_tilesOffset;
+      u32 m_tileStride;     // Bytes per tile record, TileHeader included
+    };
+
+    struct ElementEntry
+    {
+      u32 m_type;           // Type as written
+      char m_uuid[124];     // NUL-terminated printed UUID
+    };
+
+    struct TileHeader
+    {
+      s32 m_x;
+      s32 m_y;
+      u32 m_siteCount;
+      u32 m_reserved;
+    };
+
+    enum { BYTE_ORDER_MARK = 0x01020304 };
+
+    static u32 Align(u32 offset)
+    {
+      return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(SNAPSHOT_ALIGNMENT - 1);
+    }
+
+    struct TypeMapping
+    {
+      u32 m_savedType;
+      const Element<EC> * m_element;  // Null if element is unknown here
+    };
+
+    /**
+       Change atom's type from one assigned by the simulator that
+       wrote the snapshot to the one this simulator uses for the same
+       element, keeping its state bits.  Atoms of unknown types become
+       empty.
+     */
+    static void RemapAtom(T & atom, const TypeMapping * map, u32 count) ;
+
+    static void MarkSites(void * arg) ;
+
+    bool SaveText(const GridSnapshotImage & image, FILE * fp) ;
+
+    GrowableByteSink * m_capturing;  // Config text being captured, if any
+    u32 m_sitesMark;                 // Its length when the sites were skipped
+
+    ExternalConfig<GC> & m_ec;
+    ExternalConfigSectionGrid<GC> & m_ecsg;
+  };
+
+} /* namespace MFM */
+
+#include "GridSnapshot.tcc"
+
+#endif /* GRIDSNAPSHOT_H */
@@ -0,0 +1,404 @@
+/* -*- C++ -*- */
+#include "CharBufferByteSource.h"
+#include "Logger.h"
+#include "FileByteSink.h"
+#include "Util.h"    /* For MIN */
+#include <stdio.h>     /* For fopen */
+#include <string.h>    /* For strlen, memcpy */
+#include <new>         /* For placement new */
+#include <fcntl.h>     /* For open */
+#include <unistd.h>    /* For close */
+#include <sys/mman.h>  /* For mmap */
+#include <sys/stat.h>  /* For fstat */
+
+namespace MFM
+{
+  template <class GC>
+  bool GridSnapshot<GC>::IsSnapshotPath(const char * path)
+  {
+    MFM_API_ASSERT_NONNULL(path);
+    const char * SUFFIX = ".mfb";
+    const u32 plen = strlen(path);
+    const u32 slen = strlen(SUFFIX);
+    return plen >= slen && !strcmp(path + plen - slen, SUFFIX);
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::Write(const char * path)
+  {
+    GridSnapshotImage image;
+    return Capture(image) && Save(image, path);
+  }
+
+  template <class GC>
+  void GridSnapshot<GC>::MarkSites(void * arg)
+  {
+    GridSnapshot<GC> & snapshot = *(GridSnapshot<GC> *) arg;
+    MFM_API_ASSERT_NONNULL(snapshot.m_capturing);
+    snapshot.m_sitesMark = snapshot.m_capturing->GetLength();
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::Capture(GridSnapshotImage & image)
+  {
+    Grid<GC> & grid = m_ecsg.GetGrid();
+    MFM_API_ASSERT_STATE(!grid.IsGridRunning());
+
+    // Everything but the sites, as .mfs text
+    GrowableByteSink config;
+    m_capturing = &config;
+    m_sitesMark = 0;
+    m_ecsg.SetWriteSites(false);
+    m_ecsg.SetSkippedSitesCallback(&MarkSites, this);
+    m_ec.Write(config);
+    m_ecsg.SetSkippedSitesCallback(0, 0);
+    m_ecsg.SetWriteSites(true);
+    m_capturing = 0;
+
+    // The element table
+    ElementRegistry<EC> & er = grid.GetElementRegistry();
+    const u32 entries = er.GetEntryCount();
+    u32 elementCount = 0;
+    for (u32 i = 0; i < entries; ++i)
+    {
+      if (er.GetEntryElement(i)) ++elementCount;
+    }
+
+    u32 tileCount = 0;
+    for (typename Grid<GC>::iterator_type i = grid.begin(); i != grid.end(); ++i)
+    {
+      ++tileCount;
+    }
+
+    const u32 tileSites = GC::TILE_WIDTH * GC::TILE_HEIGHT;
+
+    Header h;
+    memset(&h, 0, sizeof(h));
+    strcpy(h.m_magic, "MFMSNAP");
+    h.m_version = SNAPSHOT_VERSION;
+    h.m_byteOrder = BYTE_ORDER_MARK;
+    h.m_siteBytes = sizeof(S);
+    h.m_bitsPerAtom = BPA;
+    h.m_tileWidth = GC::TILE_WIDTH;
+    h.m_tileHeight = GC::TILE_HEIGHT;
+    h.m_gridWidth = grid.GetWidth();
+    h.m_gridHeight = grid.GetHeight();
+    h.m_tileCount = tileCount;
+    h.m_elementCount = elementCount;
+    h.m_elementsOffset = sizeof(Header);
+    h.m_configOffset = h.m_elementsOffset + elementCount * sizeof(ElementEntry);
+    h.m_configLength = config.GetLength();
+    h.m_tilesOffset = Align(h.m_configOffset + h.m_configLength);
+    h.m_tileStride = Align(sizeof(TileHeader) + tileSites * sizeof(S));
+
+    const u64 total = (u64) h.m_tilesOffset + (u64) tileCount * h.m_tileStride;
+    if (total > U32_MAX)
+    {
+      LOG.Error("Grid too big (%d MB) to snapshot", (u32) (total >> 20));
+      return false;
+    }
+
+    image.Clear();
+    u8 * buffer = (u8 *) calloc(1, (u32) total);
+    MFM_API_ASSERT_NONNULL(buffer);
+    image.m_buffer = buffer;
+    image.m_length = (u32) total;
+    image.m_sitesMark = m_sitesMark;
+
+    memcpy(buffer, &h, sizeof(h));
+
+    ElementEntry * ee = (ElementEntry *) (buffer + h.m_elementsOffset);
+    for (u32 i = 0; i < entries; ++i)
+    {
+      const Element<EC> * elt = er.GetEntryElement(i);
+      if (!elt) continue;
+
+      OString256 uuid;
+      er.GetEntryUUID(i).Print(uuid);
+      if (uuid.GetLength() >= sizeof(ee->m_uuid))
+      {
+        LOG.Error("UUID '%s' too long to snapshot", uuid.GetZString());
+        image.Clear();
+        return false;
+      }
+      ee->m_type = elt->GetType();
+      strcpy(ee->m_uuid, uuid.GetZString());
+      ++ee;
+    }
+
+    memcpy(buffer + h.m_configOffset, config.GetBuffer(), h.m_configLength);
+
+    u8 * tp = buffer + h.m_tilesOffset;
+    for (typename Grid<GC>::iterator_type i = grid.begin(); i != grid.end(); ++i, tp += h.m_tileStride)
+    {
+      Tile<EC> & tile = *i;
+      TileHeader * th = (TileHeader *) tp;
+      th->m_x = i.At().GetX();
+      th->m_y = i.At().GetY();
+      th->m_siteCount = tileSites;
+
+      S * sites = (S *) (tp + sizeof(TileHeader));
+      for (u32 sn = 0; sn < tileSites; ++sn)
+      {
+        S * site = new (&sites[sn]) S();
+        site->CopyFrom(tile.GetSite(tile.GetCoordOfSiteInTileNumber(sn)));
+      }
+    }
+    return true;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::SaveText(const GridSnapshotImage & image, FILE * fp)
+  {
+    const Grid<GC> & grid = m_ecsg.GetGrid();
+    Header h;
+    memcpy(&h, image.m_buffer, sizeof(h));
+    const char * config = (const char *) (image.m_buffer + h.m_configOffset);
+
+    // Index the tile records by tile coordinate
+    const u32 tileSlots = h.m_gridWidth * h.m_gridHeight;
+    const S ** tileSites = new const S * [tileSlots];
+    for (u32 t = 0; t < tileSlots; ++t)
+    {
+      tileSites[t] = 0;
+    }
+    const u8 * tp = image.m_buffer + h.m_tilesOffset;
+    for (u32 t = 0; t < h.m_tileCount; ++t, tp += h.m_tileStride)
+    {
+      const TileHeader * th = (const TileHeader *) tp;
+      tileSites[th->m_y * h.m_gridWidth + th->m_x] = (const S *) (tp + sizeof(TileHeader));
+    }
+
+    FileByteSink fs(fp);
+    fs.WriteBytes((const u8 *) config, image.m_sitesMark);
+
+    // The same Site(..) lines ExternalConfigSectionGrid would write
+    const u32 gridWidth = grid.GetWidthSites();
+    const u32 gridHeight = grid.GetHeightSites();
+    bool ok = true;
+    for (u32 y = 0; ok && y < gridHeight; y++)
+    {
+      for (u32 x = 0; x < gridWidth; x++)
+      {
+        SPoint siteInGrid(x,y);
+        if (!grid.IsGridCoord(siteInGrid)) continue;
+
+        SPoint tileInGrid, siteInTile;
+        if (!grid.MapGridToTile(siteInGrid, tileInGrid, siteInTile))
+        {
+          continue;
+        }
+
+        const S * sites = tileSites[tileInGrid.GetY() * h.m_gridWidth + tileInGrid.GetX()];
+        if (!sites)
+        {
+          LOG.Error("No tile (%d,%d) in captured grid", tileInGrid.GetX(), tileInGrid.GetY());
+          ok = false;
+          break;
+        }
+
+        fs.Printf("Site(%d,%d", x, y);
+        sites[siteInTile.GetY() * GC::TILE_WIDTH + siteInTile.GetX()].SaveConfig(fs, m_ecsg);
+        fs.Printf(")\n");
+      }
+    }
+
+    fs.WriteBytes((const u8 *) config + image.m_sitesMark, h.m_configLength - image.m_sitesMark);
+
+    delete [] tileSites;
+    return ok;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::Save(const GridSnapshotImage & image, const char * path)
+  {
+    MFM_API_ASSERT_STATE(!image.IsEmpty());
+
+    FILE * fp = fopen(path, "w");
+    if (!fp)
+    {
+      LOG.Error("Can't write '%s'", path);
+      return false;
+    }
+
+    bool ok;
+    if (IsSnapshotPath(path))
+    {
+      ok = fwrite(image.m_buffer, image.m_length, 1, fp) == 1;
+    }
+    else
+    {
+      ok = SaveText(image, fp);
+    }
+    ok = (fclose(fp) == 0) && ok;
+
+    if (!ok)
+    {
+      LOG.Error("Writing '%s' failed", path);
+    }
+    return ok;
+  }
+
+  template <class GC>
+  void GridSnapshot<GC>::RemapAtom(T & atom, const TypeMapping * map, u32 count)
+  {
+    const u32 type = atom.GetType();
+    for (u32 i = 0; i < count; ++i)
+    {
+      if (map[i].m_savedType != type) continue;
+
+      const Element<EC> * elt = map[i].m_element;
+      if (!elt) break;
+
+      if (elt->GetType() == type) return;  // Already right
+
+      T fixed = elt->GetDefaultAtom();
+      for (u32 b = T::ATOM_FIRST_STATE_BIT; b < BPA; b += 32)
+      {
+        const u32 len = MIN((u32) 32, BPA - b);
+        fixed.GetBits().Write(b, len, atom.GetBits().Read(b, len));
+      }
+      atom = fixed;
+      return;
+    }
+    atom.SetEmpty();
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::Read(const char * path)
+  {
+    Grid<GC> & grid = m_ecsg.GetGrid();
+    MFM_API_ASSERT_STATE(!grid.IsGridRunning());
+
+    s32 fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+      LOG.Error("Can't open binary snapshot '%s'", path);
+      return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (u64) st.st_size < sizeof(Header))
+    {
+      LOG.Error("Binary snapshot '%s' is too short", path);
+      close(fd);
+      return false;
+    }
+
+    const u32 size = (u32) st.st_size;
+    void * map = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+      LOG.Error("Can't map binary snapshot '%s'", path);
+      return false;
+    }
+    const u8 * base = (const u8 *) map;
+
+    Header h;
+    memcpy(&h, base, sizeof(h));
+
+    const char * problem = 0;
+    if (strncmp(h.m_magic, "MFMSNAP", sizeof(h.m_magic)))
+      problem = "Not a binary snapshot";
+    else if (h.m_version != SNAPSHOT_VERSION)
+      problem = "Unsupported snapshot version";
+    else if (h.m_byteOrder != BYTE_ORDER_MARK)
+      problem = "Wrong byte order";
+    else if (h.m_siteBytes != sizeof(S) || h.m_bitsPerAtom != BPA)
+      problem = "Site layout differs from this simulator";
+    else if (h.m_tileWidth != GC::TILE_WIDTH || h.m_tileHeight != GC::TILE_HEIGHT)
+      problem = "Tile size differs from this simulator";
+    else if (h.m_gridWidth != grid.GetWidth() || h.m_gridHeight != grid.GetHeight())
+      problem = "Grid size differs from this simulator";
+    else if (h.m_tileStride < sizeof(TileHeader) + GC::TILE_WIDTH * GC::TILE_HEIGHT * sizeof(S))
+      problem = "Tile records too small";
+    else if ((u64) h.m_elementsOffset + (u64) h.m_elementCount * sizeof(ElementEntry) > size ||
+             (u64) h.m_configOffset + h.m_configLength > size ||
+             (u64) h.m_tilesOffset + (u64) h.m_tileCount * h.m_tileStride > size)
+      problem = "Truncated snapshot";
+
+    if (problem)
+    {
+      LOG.Error("%s: '%s' (v%d, %dx%d tiles of %dx%d)", problem, path,
+                h.m_version, h.m_gridWidth, h.m_gridHeight, h.m_tileWidth, h.m_tileHeight);
+      munmap(map, size);
+      return false;
+    }
+
+    // Map the written types to our elements
+    ElementRegistry<EC> & er = grid.GetElementRegistry();
+    TypeMapping * types = new TypeMapping[h.m_elementCount + 1];
+    bool identity = true;
+    const ElementEntry * ee = (const ElementEntry *) (base + h.m_elementsOffset);
+    for (u32 i = 0; i < h.m_elementCount; ++i, ++ee)
+    {
+      const char * nul = (const char *) memchr(ee->m_uuid, 0, sizeof(ee->m_uuid));
+      const u32 ulen = nul ? nul - ee->m_uuid : sizeof(ee->m_uuid);
+      UUID uuid;
+      CharBufferByteSource cbs(ee->m_uuid, ulen);
+      Element<EC> * elt = 0;
+      if (uuid.Read(cbs))
+      {
+        elt = er.Lookup(uuid);
+        if (!elt)
+        {
+          elt = er.LookupCompatible(uuid);
+        }
+      }
+      if (!elt)
+      {
+        LOG.Warning("Unknown element '%s' in '%s'; its atoms will be erased", ee->m_uuid, path);
+      }
+
+      types[i].m_savedType = ee->m_type;
+      types[i].m_element = elt;
+      identity = identity && elt && elt->GetType() == ee->m_type;
+    }
+
+    // Load the non-site configuration (this clears the grid)
+    CharBufferByteSource config((const char *) (base + h.m_configOffset), h.m_configLength);
+    m_ec.SetByteSource(config, path);
+    bool ok = m_ec.Read();
+
+    // Then blast in the sites
+    const u32 tileSites = GC::TILE_WIDTH * GC::TILE_HEIGHT;
+    const u8 * tp = base + h.m_tilesOffset;
+    const bool loadSites = m_ecsg.IsEnabled();
+    for (u32 t = 0; ok && loadSites && t < h.m_tileCount; ++t, tp += h.m_tileStride)
+    {
+      const TileHeader * th = (const TileHeader *) tp;
+      if (th->m_siteCount != tileSites ||
+          th->m_x < 0 || (u32) th->m_x >= grid.GetWidth() ||
+          th->m_y < 0 || (u32) th->m_y >= grid.GetHeight() ||
+          grid.IsDummyTileCoord(th->m_x, th->m_y))
+      {
+        LOG.Error("Bad tile record %d (%d,%d) in '%s'", t, th->m_x, th->m_y, path);
+        ok = false;
+        break;
+      }
+
+      Tile<EC> & tile = grid.GetTile(SPoint(th->m_x, th->m_y));
+      const S * sites = (const S *) (tp + sizeof(TileHeader));
+      for (u32 sn = 0; sn < tileSites; ++sn)
+      {
+        typename Tile<EC>::SiteReference site = tile.GetSite(tile.GetCoordOfSiteInTileNumber(sn));
+        site.CopyFrom(sites[sn]);
+        if (!identity)
+        {
+          RemapAtom(site.GetAtom(), types, h.m_elementCount);
+          RemapAtom(site.GetBase().GetBaseAtom(), types, h.m_elementCount);
+        }
+      }
+    }
+
+    delete [] types;
+    munmap(map, size);
+
+    grid.RefreshAllCaches();
+    grid.RecountAtoms();
+
+    return ok;
+  }
+
+} /* namespace MFM */
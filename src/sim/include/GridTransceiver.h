@@ -202,11 +202,29 @@ namespace MFM
     If we set the in-flight data limit to 0, then v will track t
     exactly.
 
+    Each of the four indices has exactly one writer: w belongs to the
+    side writing into the channel, r to the side reading from it, and
+    t and v to whoever calls Advance.  So the data path is lock-free:
+    Write publishes w, Read publishes r, and Transceive publishes t
+    and v, each after a memory barrier, and m_access is only needed
+    to keep Advance consistent with the rate settings.
+
+    Finally, if the transceiver is not throttled (see SetThrottled),
+    the whole t/v machinery is skipped and the reader reads right up
+    to w, making each direction a plain single-producer
+    single-consumer ring buffer.
+
    */
   class GridTransceiver : public AbstractChannel
   {
   public:
 
+    enum {
+      DEFAULT_BUFFER_SIZE = 8192,    // Per direction, in bytes
+      MIN_BUFFER_SIZE = 2048,      // Must hold a maximum-length packet
+      MAX_BUFFER_SIZE = 1<<24
+    };
+
     ////
     // BEGIN AbstractChannel interface
 
@@ -217,8 +235,6 @@ namespace MFM
     virtual u32 CanWrite(bool byA)
     {
       FailUnlessEnabled();
-
-      Mutex::ScopeLock lock(m_access);
       return GetOutputChannel(byA).CanWrite();
     }
 
@@ -229,8 +245,6 @@ namespace MFM
     virtual u32 Write(bool byA, const u8 * data, u32 length)
     {
       FailUnlessEnabled();
-
-      Mutex::ScopeLock lock(m_access);
       return GetOutputChannel(byA).Write(data, length);
     }
 
@@ -241,9 +255,7 @@ namespace MFM
     virtual u32 CanRead(bool byA)
     {
       FailUnlessEnabled();
-
-      Mutex::ScopeLock lock(m_access);
-      return GetInputChannel(byA).CanRead();
+      return GetInputChannel(byA).CanRead(m_throttled);
     }
 
     /**
@@ -253,9 +265,7 @@ namespace MFM
     virtual u32 Read(bool byA, u8 * data, u32 length)
     {
       FailUnlessEnabled();
-
-      Mutex::ScopeLock lock(m_access);
-      return GetInputChannel(byA).Read(data, length);
+      return GetInputChannel(byA).Read(data, length, m_throttled);
     }
 
     // END AbstractChannel interface
@@ -263,18 +273,18 @@ namespace MFM
 
     GridTransceiver() ;
 
+    ~GridTransceiver() ;
+
     /**
        Enable or disable this GridTransceiver.  When a GridTransceiver
        is disabled, the only AbstractChannel interface method that can
        be called successfully is GetChannelState; all other interface
-       will fail.
+       will fail.  The channel buffers are allocated the first time
+       the GridTransceiver is enabled.
 
        \sa IsEnabled
      */
-    void SetEnabled(bool enabled)
-    {
-      m_enabled = enabled;
-    }
+    void SetEnabled(bool enabled) ;
 
     /**
        Return true iff this GridTransceiver is enabled.
@@ -286,6 +296,41 @@ namespace MFM
       return m_enabled;
     }
 
+    /**
+       Set the size in bytes of the buffer used for each direction.
+       \c bytes must be a power of two between MIN_BUFFER_SIZE and
+       MAX_BUFFER_SIZE.  One byte of each buffer is always unused.
+
+       \fail ILLEGAL_ARGUMENT if bytes is not an acceptable size
+       \fail ILLEGAL_STATE if this GridTransceiver has been enabled
+     */
+    void SetBufferSize(u32 bytes) ;
+
+    u32 GetBufferSize() const
+    {
+      return m_bufferSize;
+    }
+
+    /**
+       If \c throttled is true (the default), bytes written must be
+       moved through the modeled transmission line by Advance or
+       AdvanceToTime, at the configured data rate, before they can be
+       read.  If false, bytes are readable as soon as they are
+       written, and Advance does nothing.
+
+       \fail ILLEGAL_STATE if this GridTransceiver has been enabled
+     */
+    void SetThrottled(bool throttled)
+    {
+      MFM_API_ASSERT_STATE(!m_enabled);
+      m_throttled = throttled;
+    }
+
+    bool IsThrottled() const
+    {
+      return m_throttled;
+    }
+
     /**
        Simulate channel communications given the actual wall clock
        time is now.  Return true if any communications occurred.
@@ -328,14 +373,12 @@ namespace MFM
 
     u32 CanXmit(bool byA)
     {
-      Mutex::ScopeLock lock(m_access);
-      return GetOutputChannel(byA).CanXmit();
+      return m_throttled ? GetOutputChannel(byA).CanXmit() : 0;
     }
 
     u32 CanRcv(bool byA)
     {
-      Mutex::ScopeLock lock(m_access);
-      return GetInputChannel(byA).CanRcv();
+      return m_throttled ? GetInputChannel(byA).CanRcv() : 0;
     }
 
   private:
@@ -360,10 +403,6 @@ namespace MFM
       return didWork;
     }
 
-    enum {
-      BUFFER_SIZE = 2048
-    };
-
     bool m_enabled;
     void FailUnlessEnabled()
     {
@@ -373,6 +412,10 @@ namespace MFM
       }
     }
 
+    bool m_throttled;
+
+    u32 m_bufferSize;
+
     u32 m_bytesPerSecond;
 
     u32 m_maxBytesInFlight;
@@ -383,14 +426,20 @@ namespace MFM
 
     struct ByteChannel {
 
-      static inline u32 BytesBetween(u32 idxHi, u32 idxLo)
+      inline u32 BytesBetween(u32 idxHi, u32 idxLo) const
       {
-        return (idxHi + BUFFER_SIZE - idxLo) % BUFFER_SIZE;
+        return (idxHi - idxLo) & m_mask;
       }
 
-      static void Increment(u32 & var, u32 amount = 1)
+      /**
+       * Advance an index that only the calling thread writes, making
+       * everything this thread did before visible to other threads
+       * before the new index value is.
+       */
+      void Publish(volatile u32 & var, u32 amount)
       {
-        var = (var + amount) % BUFFER_SIZE;
+        __sync_synchronize();
+        var = (var + amount) & m_mask;
       }
 
       ByteChannel()
@@ -398,8 +447,22 @@ namespace MFM
         , m_xmitIndex(0)
         , m_rcvIndex(0)
         , m_readIndex(0)
+        , m_mask(0)
+        , m_data(0)
       { }
 
+      ~ByteChannel()
+      {
+        delete [] m_data;
+      }
+
+      void Allocate(u32 bufferSize)
+      {
+        MFM_API_ASSERT_STATE(m_data == 0);
+        m_data = new u8[bufferSize];
+        m_mask = bufferSize - 1;
+      }
+
       /**
        * Move xmitted bytes to rcvd bytes, and written bytes to
        * xmitted bytes; up to maxBytes each.  Return true if any bytes
@@ -407,52 +470,54 @@ namespace MFM
        */
       bool Transceive(u32 maxBytes, u32 maxInFlight) ;
 
-      u32 CanWrite()
+      u32 CanWrite() const
       {
         // We waste one byte so that r==w unconditionally means empty.
         return BytesBetween(m_readIndex, m_writeIndex + 1);
       }
 
-      u32 CanRead()
+      u32 CanRead(bool throttled) const
       {
-        return BytesBetween(m_rcvIndex, m_readIndex);
+        return BytesBetween(throttled ? m_rcvIndex : m_writeIndex, m_readIndex);
       }
 
-      u32 CanXmit()
+      u32 CanXmit() const
       {
         return BytesBetween(m_writeIndex, m_xmitIndex);
       }
 
-      u32 CanRcv()
+      u32 CanRcv() const
       {
         return BytesBetween(m_xmitIndex, m_rcvIndex);
       }
 
       u32 Write(const u8 * data, u32 length) ;
 
-      u32 Read(u8 * data, u32 length) ;
+      u32 Read(u8 * data, u32 length, bool throttled) ;
 
       /**
        * Next data byte to be written goes here
        */
-      u32 m_writeIndex;
+      volatile u32 m_writeIndex;
 
       /**
        * Next written byte to be transmitted is here
        */
-      u32 m_xmitIndex;
+      volatile u32 m_xmitIndex;
 
       /**
        * Next transmitted byte to be received goes here
        */
-      u32 m_rcvIndex;
+      volatile u32 m_rcvIndex;
 
       /**
        * Next received byte to be read is here
        */
-      u32 m_readIndex;
+      volatile u32 m_readIndex;
+
+      u32 m_mask;  // Buffer size - 1
 
-      u8 m_data[BUFFER_SIZE];
+      u8 * m_data;
     };
     ByteChannel & GetOutputChannel(bool byA)
     {
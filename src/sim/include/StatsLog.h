@@ -0,0 +1,182 @@
+/*                                              -*- mode:C++ -*-
+  StatsLog.h A binary, column-oriented log of per-epoch statistics
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file StatsLog.h A binary, column-oriented log of per-epoch statistics
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef STATSLOG_H
+#define STATSLOG_H
+
+#include <stdio.h>  /* For FILE */
+#include "itype.h"
+#include "ByteSink.h"
+
+namespace MFM
+{
+  /**
+     Rows of named numbers -- one row per epoch, in the drivers --
+     appended to a binary file.  Rows are built up with Add and
+     finished with EndRow, and kept in memory until FLUSH_ROWS of
+     them have accumulated (or Flush or Close is called), when they
+     are written as one block, column by column, and the file is
+     flushed.  So a row costs a few stores rather than formatted
+     output, and a crash loses at most FLUSH_ROWS - 1 rows.
+
+     The file is:
+
+     - A FileHeader, written when the file is created.
+
+     - Any number of chunks, each a ChunkHeader and its payload.  A
+       COLUMNS chunk names the columns of the ROWS chunks after it,
+       as that many NUL-terminated strings.  A ROWS chunk holds its
+       rows as doubles, all of the first column, then all of the
+       second, and so on.
+
+     Every row of a block must add the same columns in the same
+     order.  When a row differs from the one before, the rows so far
+     are flushed and a new COLUMNS chunk is written, so runs that
+     are resumed, or whose columns change, can share one file.
+
+     WriteCSV reads such a file back as CSV, for plotting.
+   */
+  class StatsLog
+  {
+  public:
+    // LOG_VERSION = 1 (2026) Initial version
+    enum { LOG_VERSION = 1 };
+
+    enum { FLUSH_ROWS = 16 };
+
+    StatsLog() ;
+
+    ~StatsLog() ;
+
+    /**
+       Append to the log at \c path, creating it if need be.  Return
+       false, having logged an error, if it can't be written or isn't
+       a log of this version.
+     */
+    bool Open(const char * path) ;
+
+    bool IsOpen() const
+    {
+      return m_file != 0;
+    }
+
+    /**
+       Flush any pending rows and close the log.
+     */
+    void Close() ;
+
+    /**
+       Add column \c name, with \c value, to the row in progress.
+       Commas and whitespace in \c name become underscores, so names
+       are usable as CSV headers.
+     */
+    void Add(const char * name, double value) ;
+
+    /**
+       Finish the row in progress, writing a block if it makes
+       FLUSH_ROWS pending rows.  A row with no columns is ignored.
+     */
+    void EndRow() ;
+
+    /**
+       Write out any pending rows now
+     */
+    void Flush() ;
+
+    u32 GetRowsLogged() const
+    {
+      return m_rowsLogged;
+    }
+
+    /**
+       Convert the log at \c path to CSV on \c csv: a header line
+       naming the columns, then a line per row, with another header
+       line wherever the columns change.  A final block cut short, as
+       by a crash, is dropped with a warning.  Return false, having
+       logged an error, if \c path isn't a readable log.
+     */
+    static bool WriteCSV(const char * path, ByteSink & csv) ;
+
+  private:
+    enum { BYTE_ORDER_MARK = 0x01020304 };
+
+    enum ChunkKind
+    {
+      CHUNK_COLUMNS = 1,
+      CHUNK_ROWS = 2
+    };
+
+    struct FileHeader
+    {
+      char m_magic[8];      // "MFMSTAT" plus a NUL
+      u32 m_version;        // LOG_VERSION
+      u32 m_byteOrder;      // BYTE_ORDER_MARK as written
+    };
+
+    struct ChunkHeader
+    {
+      u32 m_kind;           // A ChunkKind
+      u32 m_columns;
+      u32 m_rows;           // 0 for CHUNK_COLUMNS
+      u32 m_bytes;          // Payload bytes after this header
+    };
+
+    /**
+       Return \c buffer, or a bigger copy of it, holding at least \c
+       bytes; \c capacity is its size, updated if it grows
+     */
+    static void * Reserve(void * buffer, u32 & capacity, u32 bytes) ;
+
+    bool WriteChunk(u32 kind, u32 columns, u32 rows, const void * payload, u32 bytes) ;
+
+    FILE * m_file;
+    u32 m_rowsLogged;
+
+    /* The columns of the pending rows, as NUL-terminated names */
+    char * m_columnNames;
+    u32 m_columnNamesLength;
+    u32 m_columnNamesCapacity;
+    u32 m_columns;
+    bool m_columnsWritten;
+
+    /* The pending rows, column-major with a stride of FLUSH_ROWS */
+    double * m_block;
+    u32 m_blockCapacity;
+    u32 m_blockRows;
+
+    /* The row in progress */
+    char * m_rowNames;
+    u32 m_rowNamesLength;
+    u32 m_rowNamesCapacity;
+    double * m_rowValues;
+    u32 m_rowValuesCapacity;
+    u32 m_rowColumns;
+
+    StatsLog(const StatsLog &) ;  // Not implemented
+    StatsLog & operator=(const StatsLog &) ;  // Not implemented
+  };
+}
+
+#endif /* STATSLOG_H */
@@ -0,0 +1,99 @@
+/*                                              -*- mode:C++ -*-
+  TileWorkQueue.h A stealable double-ended queue of tile indices
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file TileWorkQueue.h A stealable double-ended queue of tile indices
+  \date (C) 2026 All rights reserved.
+  \lgpl
+ */
+#ifndef TILEWORKQUEUE_H
+#define TILEWORKQUEUE_H
+
+#include "itype.h"
+#include "Mutex.h"
+
+namespace MFM
+{
+  /**
+    A fixed-capacity double-ended queue of tile indices, owned by one
+    scheduler worker thread but stealable by the others.
+
+    Tiles are never finished, so the owner runs its tiles round-robin:
+    it takes the next tile from the top and puts it back at the
+    bottom after giving it a turn.  Thieves take from the bottom, so
+    they grab the tile the owner would have gotten to last.  Each tile
+    index is held by exactly one queue or one worker at any moment,
+    which is what guarantees a tile is never advanced by two threads
+    at once.
+
+    Every operation is a short critical section on m_access.  Queue
+    operations happen once per tile turn, not once per event, so
+    there's little to gain from anything fancier.
+   */
+  class TileWorkQueue
+  {
+  public:
+    enum { CAPACITY = 512 };  // Must be >= Grid::MAX_TILES_SUPPORTED
+
+  private:
+    Mutex m_access;
+    u32 m_items[CAPACITY];
+    u32 m_top;     // Index of the oldest item
+    u32 m_count;   // Number of items present
+
+  public:
+    TileWorkQueue()
+      : m_top(0)
+      , m_count(0)
+    { }
+
+    /**
+       Add tileIndex at the bottom of this queue.  FAILs with
+       OUT_OF_ROOM if the queue is full.
+     */
+    void PushBottom(u32 tileIndex) ;
+
+    /**
+       Remove the oldest tile index into \c tileIndex and return true,
+       or return false if the queue is empty.  Used by the owner.
+     */
+    bool PopTop(u32 & tileIndex) ;
+
+    /**
+       Remove the most recently pushed tile index into \c tileIndex
+       and return true, or return false if the queue is empty.  Used
+       by workers other than the owner.
+     */
+    bool StealBottom(u32 & tileIndex) ;
+
+    /**
+       Return the number of tile indices currently queued.  The result
+       is only advisory unless the caller is the only thread using
+       this queue.
+     */
+    u32 GetCount()
+    {
+      Mutex::ScopeLock lock(m_access);
+      return m_count;
+    }
+  };
+}
+
+#endif /* TILEWORKQUEUE_H */
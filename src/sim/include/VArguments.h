@@ -32,7 +32,7 @@
 
 namespace MFM
 {
-#define VARGUMENTS_MAX_SIZE 64
+#define VARGUMENTS_MAX_SIZE 96
 
   /**
    * A typedef describing a function callback used to handle the
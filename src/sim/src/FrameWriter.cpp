@@ -0,0 +1,172 @@
+#include "FrameWriter.h"
+#include "Logger.h"
+#include "Fail.h"
+#include <png.h>
+#include <signal.h>  /* For signal, SIGPIPE */
+#include <string.h>  /* For strcmp */
+
+/* libpng reports through these, and longjmps out on errors */
+static void FrameWriter_png_warning(png_structp context, png_const_charp msg)
+{
+  MFM::LOG.Warning("libpng: %s", msg);
+}
+
+static void FrameWriter_png_error(png_structp context, png_const_charp msg)
+{
+  MFM::LOG.Error("libpng: %s", msg);
+  longjmp(png_jmpbuf(context), 1);
+}
+
+namespace MFM
+{
+  FrameWriter::FrameWriter()
+    : m_pipe(0)
+    , m_pipeIsStdout(false)
+    , m_pipeWidth(0)
+    , m_pipeHeight(0)
+    , m_framesPiped(0)
+  { }
+
+  FrameWriter::~FrameWriter()
+  {
+    ClosePipe();
+  }
+
+  bool FrameWriter::WritePNG(const char * path, const u8 * rgba, u32 width, u32 height)
+  {
+    MFM_API_ASSERT_NONNULL(path);
+    MFM_API_ASSERT_NONNULL(rgba);
+
+    FILE * fp = fopen(path, "wb");
+    if (!fp)
+    {
+      LOG.Error("Can't write frame to %s", path);
+      return false;
+    }
+
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL,
+                                              FrameWriter_png_error, FrameWriter_png_warning);
+    png_infop info = png ? png_create_info_struct(png) : 0;
+    if (!info)
+    {
+      png_destroy_write_struct(&png, NULL);
+      fclose(fp);
+      LOG.Error("Can't start PNG for %s", path);
+      return false;
+    }
+
+    if (setjmp(png_jmpbuf(png)))
+    {
+      // libpng has already said what went wrong
+      png_destroy_write_struct(&png, &info);
+      fclose(fp);
+      return false;
+    }
+
+    png_init_io(png, fp);
+    png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+    // Frames are mostly flat runs of color, which compress well
+    // enough even at zlib's fastest level (Z_BEST_SPEED)
+    png_set_compression_level(png, 1);
+    png_set_filter(png, 0, PNG_FILTER_SUB);
+
+    png_write_info(png, info);
+    for (u32 y = 0; y < height; ++y)
+    {
+      png_write_row(png, (png_const_bytep) &rgba[y * width * 4]);
+    }
+    png_write_end(png, info);
+    png_destroy_write_struct(&png, &info);
+
+    if (fclose(fp))
+    {
+      LOG.Error("Error closing frame %s", path);
+      return false;
+    }
+    return true;
+  }
+
+  void FrameWriter::OpenPipe(const char * command)
+  {
+    MFM_API_ASSERT_NONNULL(command);
+    MFM_API_ASSERT_ARG(*command);
+    ClosePipe();
+    m_command.Reset();
+    m_command.Printf("%s", command);
+    MFM_API_ASSERT(!m_command.HasOverflowed(), OUT_OF_ROOM);
+  }
+
+  bool FrameWriter::WriteToPipe(const u8 * rgba, u32 width, u32 height)
+  {
+    MFM_API_ASSERT_NONNULL(rgba);
+    MFM_API_ASSERT_STATE(IsPipeOpen());
+
+    if (!m_pipe)
+    {
+      m_pipeIsStdout = !strcmp(m_command.GetZString(), "-");
+      if (m_pipeIsStdout)
+      {
+        m_pipe = stdout;
+      }
+      else
+      {
+        OString512 command;
+        for (const char * p = m_command.GetZString(); *p; ++p)
+        {
+          if (p[0] == '%' && p[1] == 'S')
+          {
+            command.Printf("%dx%d", width, height);
+            ++p;
+          }
+          else
+          {
+            command.WriteByte(*p);
+          }
+        }
+        MFM_API_ASSERT(!command.HasOverflowed(), OUT_OF_ROOM);
+
+        // Let a dead encoder show up as a failed write, not a signal
+        signal(SIGPIPE, SIG_IGN);
+
+        m_pipe = popen(command.GetZString(), "w");
+        if (!m_pipe)
+        {
+          LOG.Error("Can't start frame encoder '%s'", command.GetZString());
+          m_command.Reset();
+          return false;
+        }
+        LOG.Message("Piping %dx%d RGBA frames to '%s'", width, height, command.GetZString());
+      }
+      m_pipeWidth = width;
+      m_pipeHeight = height;
+    }
+
+    MFM_API_ASSERT_ARG(width == m_pipeWidth && height == m_pipeHeight);
+
+    const size_t bytes = ((size_t) width) * height * 4;
+    if (fwrite(rgba, 1, bytes, m_pipe) != bytes || fflush(m_pipe))
+    {
+      LOG.Error("Frame encoder '%s' stopped taking frames", m_command.GetZString());
+      ClosePipe();
+      return false;
+    }
+    ++m_framesPiped;
+    return true;
+  }
+
+  void FrameWriter::ClosePipe()
+  {
+    if (m_pipe && !m_pipeIsStdout)
+    {
+      int status = pclose(m_pipe);
+      if (status)
+      {
+        LOG.Warning("Frame encoder '%s' exited with status %d", m_command.GetZString(), status);
+      }
+    }
+    m_pipe = 0;
+    m_command.Reset();
+  }
+}
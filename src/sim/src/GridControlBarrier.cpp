@@ -0,0 +1,73 @@
+#include "GridControlBarrier.h"
+#include "Fail.h"
+#include <time.h>  /* For clock_gettime */
+#include <errno.h> /* For ETIMEDOUT */
+
+namespace MFM
+{
+  GridControlBarrier::GridControlBarrier()
+    : m_active(0)
+    , m_generation(0)
+  {
+    MFM_API_ASSERT(!pthread_mutex_init(&m_lock, NULL), LOCK_FAILURE);
+    MFM_API_ASSERT(!pthread_cond_init(&m_changed, NULL), LOCK_FAILURE);
+  }
+
+  GridControlBarrier::~GridControlBarrier()
+  {
+    MFM_API_ASSERT(!pthread_cond_destroy(&m_changed), LOCK_FAILURE);
+    MFM_API_ASSERT(!pthread_mutex_destroy(&m_lock), LOCK_FAILURE);
+  }
+
+  void GridControlBarrier::Begin()
+  {
+    MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+    MFM_API_ASSERT_STATE(!m_active);
+    m_active = 1;
+    MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+  }
+
+  void GridControlBarrier::End()
+  {
+    MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+    MFM_API_ASSERT_STATE(m_active);
+    m_active = 0;
+    MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+  }
+
+  u32 GridControlBarrier::GetGeneration()
+  {
+    MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+    u32 ret = m_generation;
+    MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+    return ret;
+  }
+
+  void GridControlBarrier::Notify()
+  {
+    MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+    ++m_generation;
+    MFM_API_ASSERT(!pthread_cond_broadcast(&m_changed), LOCK_FAILURE);
+    MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+  }
+
+  bool GridControlBarrier::WaitForChange(u32 generation, u32 maxUsec)
+  {
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    u64 nsec = deadline.tv_nsec + ((u64) maxUsec) * 1000;
+    deadline.tv_sec += nsec / 1000000000;
+    deadline.tv_nsec = nsec % 1000000000;
+
+    MFM_API_ASSERT(!pthread_mutex_lock(&m_lock), LOCK_FAILURE);
+    int status = 0;
+    while (m_generation == generation && status != ETIMEDOUT)
+    {
+      status = pthread_cond_timedwait(&m_changed, &m_lock, &deadline);
+      MFM_API_ASSERT(status == 0 || status == ETIMEDOUT, LOCK_FAILURE);
+    }
+    bool changed = m_generation != generation;
+    MFM_API_ASSERT(!pthread_mutex_unlock(&m_lock), LOCK_FAILURE);
+    return changed;
+  }
+}
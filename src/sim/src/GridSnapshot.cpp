@@ -0,0 +1,37 @@
+#include "GridSnapshot.h"
+
+namespace MFM
+{
+  void GrowableByteSink::WriteBytes(const u8 * data, const u32 len)
+  {
+    if (m_length + len > m_capacity)
+    {
+      u32 newCapacity = m_capacity ? m_capacity : 4096;
+      while (newCapacity < m_length + len)
+      {
+        newCapacity *= 2;
+      }
+      u8 * newBuffer = (u8 *) realloc(m_buffer, newCapacity);
+      MFM_API_ASSERT_NONNULL(newBuffer);
+      m_buffer = newBuffer;
+      m_capacity = newCapacity;
+    }
+    memcpy(&m_buffer[m_length], data, len);
+    m_length += len;
+  }
+
+  void GridSnapshotImage::Swap(GridSnapshotImage & other)
+  {
+    u8 * buffer = m_buffer;
+    u32 length = m_length;
+    u32 sitesMark = m_sitesMark;
+
+    m_buffer = other.m_buffer;
+    m_length = other.m_length;
+    m_sitesMark = other.m_sitesMark;
+
+    other.m_buffer = buffer;
+    other.m_length = length;
+    other.m_sitesMark = sitesMark;
+  }
+}
@@ -1,10 +1,13 @@
 #include "GridTransceiver.h"
 #include "Util.h"  // For MIN
+#include <string.h>  // For memcpy
 
 namespace MFM
 {
   GridTransceiver::GridTransceiver()
     : m_enabled(false)
+    , m_throttled(true)
+    , m_bufferSize(DEFAULT_BUFFER_SIZE)
     , m_bytesPerSecond(500000) // default ~500KBps == ~4Mbps
     , m_maxBytesInFlight(1)
     , m_excessNanoseconds(0)
@@ -14,10 +17,36 @@ namespace MFM
     m_lastAdvanced = now;
   }
 
+  GridTransceiver::~GridTransceiver()
+  { }
+
+  void GridTransceiver::SetEnabled(bool enabled)
+  {
+    if (enabled && !m_channelAtoB.m_data)
+    {
+      m_channelAtoB.Allocate(m_bufferSize);
+      m_channelBtoA.Allocate(m_bufferSize);
+    }
+    m_enabled = enabled;
+  }
+
+  void GridTransceiver::SetBufferSize(u32 bytes)
+  {
+    MFM_API_ASSERT_ARG(bytes >= MIN_BUFFER_SIZE && bytes <= MAX_BUFFER_SIZE);
+    MFM_API_ASSERT_ARG((bytes & (bytes - 1)) == 0);
+    MFM_API_ASSERT_STATE(!m_enabled && !m_channelAtoB.m_data);
+    m_bufferSize = bytes;
+  }
+
   bool GridTransceiver::AdvanceToTime(const timespec & now)
   {
     FailUnlessEnabled();
 
+    if (!m_throttled)
+    {
+      return false;
+    }
+
     const u32 ONE_BILLION = 1000*1000*1000;
 
     // We keep max time lapse under 2 secs
@@ -29,6 +58,11 @@ namespace MFM
 
   bool GridTransceiver::Advance(u32 nanoseconds)
   {
+    if (!m_throttled)
+    {
+      return false;
+    }
+
     Mutex::ScopeLock lock(m_access);
 
     const u64 ONE_BILLION = 1000000000;
@@ -42,14 +76,16 @@ namespace MFM
   bool GridTransceiver::ByteChannel::Transceive(u32 maxBytes, u32 maxInFlight)
   {
     u32 rcvable = MIN(CanRcv(), maxBytes);
+    Publish(m_rcvIndex, rcvable);       // First pull up to maxBytes out of the air
+
     u32 sndable = MIN(CanXmit(), maxBytes);
-    Increment(m_rcvIndex, rcvable);     // First pull up to maxBytes out of the air
-    Increment(m_xmitIndex, sndable);    // Now push up to maxBytes into the air
+    Publish(m_xmitIndex, sndable);      // Now push up to maxBytes into the air
 
     // Now if more than maxInFlight are in the air, clear the excess
-    if (CanRcv() > maxInFlight)
+    u32 inFlight = CanRcv();
+    if (inFlight > maxInFlight)
     {
-      Increment(m_rcvIndex, CanRcv() - maxInFlight);
+      Publish(m_rcvIndex, inFlight - maxInFlight);
     }
 
     return rcvable > 0 || sndable > 0;
@@ -58,22 +94,38 @@ namespace MFM
   u32 GridTransceiver::ByteChannel::Write(const u8 * data, u32 length)
   {
     const u32 count = MIN(CanWrite(), length);
-    for (u32 i = 0; i < count; ++i)
+    if (count == 0)
     {
-      m_data[m_writeIndex] = data[i];
-      Increment(m_writeIndex);
+      return 0;
     }
+
+    __sync_synchronize();  // Don't write until the reader is done with the space
+
+    u32 idx = m_writeIndex;
+    const u32 first = MIN(count, m_mask + 1 - idx);
+    memcpy(&m_data[idx], data, first);
+    memcpy(&m_data[0], data + first, count - first);
+
+    Publish(m_writeIndex, count);
     return count;
   }
 
-  u32 GridTransceiver::ByteChannel::Read(u8 * data, u32 length)
+  u32 GridTransceiver::ByteChannel::Read(u8 * data, u32 length, bool throttled)
   {
-    const u32 count = MIN(CanRead(), length);
-    for (u32 i = 0; i < count; ++i)
+    const u32 count = MIN(CanRead(throttled), length);
+    if (count == 0)
     {
-      data[i] = m_data[m_readIndex];
-      Increment(m_readIndex);
+      return 0;
     }
+
+    __sync_synchronize();  // Don't read until the writer's bytes have landed
+
+    u32 idx = m_readIndex;
+    const u32 first = MIN(count, m_mask + 1 - idx);
+    memcpy(data, &m_data[idx], first);
+    memcpy(data + first, &m_data[0], count - first);
+
+    Publish(m_readIndex, count);
     return count;
   }
 
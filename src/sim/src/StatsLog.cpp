@@ -0,0 +1,354 @@
+#include "StatsLog.h"
+#include "Logger.h"
+#include "Fail.h"
+#include <ctype.h>   /* For isspace */
+#include <stdlib.h>  /* For realloc, free */
+#include <string.h>  /* For memcmp, memcpy, strlen, strncmp */
+
+namespace MFM
+{
+  StatsLog::StatsLog()
+    : m_file(0)
+    , m_rowsLogged(0)
+    , m_columnNames(0)
+    , m_columnNamesLength(0)
+    , m_columnNamesCapacity(0)
+    , m_columns(0)
+    , m_columnsWritten(false)
+    , m_block(0)
+    , m_blockCapacity(0)
+    , m_blockRows(0)
+    , m_rowNames(0)
+    , m_rowNamesLength(0)
+    , m_rowNamesCapacity(0)
+    , m_rowValues(0)
+    , m_rowValuesCapacity(0)
+    , m_rowColumns(0)
+  { }
+
+  StatsLog::~StatsLog()
+  {
+    Close();
+    free(m_columnNames);
+    free(m_block);
+    free(m_rowNames);
+    free(m_rowValues);
+  }
+
+  void * StatsLog::Reserve(void * buffer, u32 & capacity, u32 bytes)
+  {
+    if (bytes <= capacity)
+    {
+      return buffer;
+    }
+
+    u32 newCapacity = capacity ? capacity : 256;
+    while (newCapacity < bytes)
+    {
+      newCapacity *= 2;
+    }
+    void * newBuffer = realloc(buffer, newCapacity);
+    MFM_API_ASSERT(newBuffer, OUT_OF_RESOURCES);
+    capacity = newCapacity;
+    return newBuffer;
+  }
+
+  bool StatsLog::Open(const char * path)
+  {
+    MFM_API_ASSERT_NONNULL(path);
+    Close();
+
+    // Appending, but readable so an existing header can be checked
+    FILE * fp = fopen(path, "a+b");
+    if (!fp)
+    {
+      LOG.Error("Can't open statistics log '%s'", path);
+      return false;
+    }
+
+    FileHeader h;
+    fseek(fp, 0, SEEK_END);
+    if (ftell(fp) == 0)
+    {
+      memset(&h, 0, sizeof(h));
+      strcpy(h.m_magic, "MFMSTAT");
+      h.m_version = LOG_VERSION;
+      h.m_byteOrder = BYTE_ORDER_MARK;
+      if (fwrite(&h, sizeof(h), 1, fp) != 1 || fflush(fp))
+      {
+        LOG.Error("Can't write statistics log '%s'", path);
+        fclose(fp);
+        return false;
+      }
+    }
+    else
+    {
+      rewind(fp);
+      if (fread(&h, sizeof(h), 1, fp) != 1 ||
+          strncmp(h.m_magic, "MFMSTAT", sizeof(h.m_magic)) ||
+          h.m_version != LOG_VERSION ||
+          h.m_byteOrder != BYTE_ORDER_MARK)
+      {
+        LOG.Error("'%s' exists but is not a v%d statistics log", path, LOG_VERSION);
+        fclose(fp);
+        return false;
+      }
+    }
+
+    m_file = fp;
+    m_columnsWritten = false;
+    return true;
+  }
+
+  void StatsLog::Close()
+  {
+    Flush();
+    if (m_file)
+    {
+      fclose(m_file);
+      m_file = 0;
+    }
+  }
+
+  void StatsLog::Add(const char * name, double value)
+  {
+    MFM_API_ASSERT_NONNULL(name);
+
+    const u32 bytes = strlen(name) + 1;
+    m_rowNames = (char *) Reserve(m_rowNames, m_rowNamesCapacity, m_rowNamesLength + bytes);
+    char * to = &m_rowNames[m_rowNamesLength];
+    for (u32 i = 0; i < bytes; ++i)
+    {
+      const char c = name[i];
+      to[i] = (c == ',' || isspace(c)) ? '_' : c;
+    }
+    m_rowNamesLength += bytes;
+
+    m_rowValues = (double *) Reserve(m_rowValues, m_rowValuesCapacity,
+                                     (m_rowColumns + 1) * sizeof(double));
+    m_rowValues[m_rowColumns++] = value;
+  }
+
+  void StatsLog::EndRow()
+  {
+    if (m_rowColumns == 0)
+    {
+      return;
+    }
+
+    if (m_rowColumns != m_columns ||
+        m_rowNamesLength != m_columnNamesLength ||
+        memcmp(m_rowNames, m_columnNames, m_rowNamesLength))
+    {
+      // New columns: finish the old ones' block and switch
+      Flush();
+      m_columnNames = (char *) Reserve(m_columnNames, m_columnNamesCapacity, m_rowNamesLength);
+      memcpy(m_columnNames, m_rowNames, m_rowNamesLength);
+      m_columnNamesLength = m_rowNamesLength;
+      m_columns = m_rowColumns;
+      m_columnsWritten = false;
+      m_block = (double *) Reserve(m_block, m_blockCapacity,
+                                   m_columns * FLUSH_ROWS * sizeof(double));
+    }
+
+    for (u32 c = 0; c < m_columns; ++c)
+    {
+      m_block[c * FLUSH_ROWS + m_blockRows] = m_rowValues[c];
+    }
+    ++m_blockRows;
+    ++m_rowsLogged;
+
+    m_rowColumns = 0;
+    m_rowNamesLength = 0;
+
+    if (m_blockRows == FLUSH_ROWS)
+    {
+      Flush();
+    }
+  }
+
+  bool StatsLog::WriteChunk(u32 kind, u32 columns, u32 rows, const void * payload, u32 bytes)
+  {
+    ChunkHeader ch;
+    ch.m_kind = kind;
+    ch.m_columns = columns;
+    ch.m_rows = rows;
+    ch.m_bytes = bytes;
+    return fwrite(&ch, sizeof(ch), 1, m_file) == 1 &&
+      (!payload || fwrite(payload, 1, bytes, m_file) == bytes);
+  }
+
+  void StatsLog::Flush()
+  {
+    if (m_blockRows == 0)
+    {
+      return;
+    }
+
+    // Without a file, rows have nowhere to go
+    bool ok = !m_file;
+    if (m_file)
+    {
+      ok = m_columnsWritten ||
+        WriteChunk(CHUNK_COLUMNS, m_columns, 0, m_columnNames, m_columnNamesLength);
+      m_columnsWritten = ok;
+
+      ok = ok && WriteChunk(CHUNK_ROWS, m_columns, m_blockRows, 0,
+                            m_columns * m_blockRows * sizeof(double));
+      for (u32 c = 0; ok && c < m_columns; ++c)
+      {
+        ok = fwrite(&m_block[c * FLUSH_ROWS], sizeof(double), m_blockRows, m_file) == m_blockRows;
+      }
+      ok = ok && fflush(m_file) == 0;
+    }
+    m_blockRows = 0;
+
+    if (!ok)
+    {
+      LOG.Error("Can't write statistics log; closing it");
+      fclose(m_file);
+      m_file = 0;
+    }
+  }
+
+  bool StatsLog::WriteCSV(const char * path, ByteSink & csv)
+  {
+    MFM_API_ASSERT_NONNULL(path);
+
+    FILE * fp = fopen(path, "rb");
+    if (!fp)
+    {
+      LOG.Error("Can't read statistics log '%s'", path);
+      return false;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    const long size = ftell(fp);
+    rewind(fp);
+
+    FileHeader h;
+    if (fread(&h, sizeof(h), 1, fp) != 1 ||
+        strncmp(h.m_magic, "MFMSTAT", sizeof(h.m_magic)) ||
+        h.m_version != LOG_VERSION ||
+        h.m_byteOrder != BYTE_ORDER_MARK)
+    {
+      LOG.Error("'%s' is not a v%d statistics log", path, LOG_VERSION);
+      fclose(fp);
+      return false;
+    }
+
+    char * names = 0;
+    u32 namesCapacity = 0;
+    char * lastNames = 0;      // Of the last header printed
+    u32 lastNamesCapacity = 0;
+    u32 lastNamesLength = 0;
+    u32 columns = 0;
+    double * values = 0;
+    u32 valuesCapacity = 0;
+    const char * problem = 0;
+    bool truncated = false;
+
+    while (!problem && !truncated)
+    {
+      ChunkHeader ch;
+      const size_t got = fread(&ch, 1, sizeof(ch), fp);
+      if (got == 0)
+      {
+        break;
+      }
+      truncated = got < sizeof(ch) || ch.m_bytes > (u64) (size - ftell(fp));
+      if (truncated)
+      {
+        break;
+      }
+
+      if (ch.m_kind == CHUNK_COLUMNS)
+      {
+        names = (char *) Reserve(names, namesCapacity, ch.m_bytes + 1);
+        truncated = fread(names, 1, ch.m_bytes, fp) != ch.m_bytes;
+        if (truncated)
+        {
+          break;
+        }
+
+        u32 nuls = 0;
+        for (u32 i = 0; i < ch.m_bytes; ++i)
+        {
+          if (!names[i]) ++nuls;
+        }
+        if (nuls != ch.m_columns || ch.m_bytes == 0 || names[ch.m_bytes - 1])
+        {
+          problem = "Bad column names";
+          break;
+        }
+
+        columns = ch.m_columns;
+
+        // A reopened log restates its columns; only print a header
+        // where they actually change
+        if (ch.m_bytes == lastNamesLength && !memcmp(names, lastNames, ch.m_bytes))
+        {
+          continue;
+        }
+        lastNames = (char *) Reserve(lastNames, lastNamesCapacity, ch.m_bytes);
+        memcpy(lastNames, names, ch.m_bytes);
+        lastNamesLength = ch.m_bytes;
+
+        const char * name = names;
+        for (u32 c = 0; c < columns; ++c)
+        {
+          csv.Printf("%s%s", c ? "," : "", name);
+          name += strlen(name) + 1;
+        }
+        csv.Println();
+      }
+      else if (ch.m_kind == CHUNK_ROWS)
+      {
+        const u64 bytes = (u64) ch.m_columns * ch.m_rows * sizeof(double);
+        if (ch.m_columns != columns || bytes != ch.m_bytes)
+        {
+          problem = "Rows don't match their columns";
+          break;
+        }
+
+        values = (double *) Reserve(values, valuesCapacity, ch.m_bytes);
+        truncated = fread(values, 1, ch.m_bytes, fp) != ch.m_bytes;
+        if (truncated)
+        {
+          break;
+        }
+
+        for (u32 r = 0; r < ch.m_rows; ++r)
+        {
+          for (u32 c = 0; c < columns; ++c)
+          {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.15g", values[c * ch.m_rows + r]);
+            csv.Printf("%s%s", c ? "," : "", buf);
+          }
+          csv.Println();
+        }
+      }
+      else if (fseek(fp, ch.m_bytes, SEEK_CUR))
+      {
+        truncated = true;
+      }
+    }
+
+    free(names);
+    free(lastNames);
+    free(values);
+    fclose(fp);
+
+    if (problem)
+    {
+      LOG.Error("%s in statistics log '%s'", problem, path);
+      return false;
+    }
+    if (truncated)
+    {
+      LOG.Warning("Statistics log '%s' ends mid-block; dropped the partial block", path);
+    }
+    return true;
+  }
+}
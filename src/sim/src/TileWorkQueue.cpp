@@ -0,0 +1,40 @@
+#include "TileWorkQueue.h"
+
+namespace MFM
+{
+  void TileWorkQueue::PushBottom(u32 tileIndex)
+  {
+    Mutex::ScopeLock lock(m_access);
+    if (m_count >= CAPACITY)
+    {
+      FAIL(OUT_OF_ROOM);
+    }
+    m_items[(m_top + m_count) % CAPACITY] = tileIndex;
+    ++m_count;
+  }
+
+  bool TileWorkQueue::PopTop(u32 & tileIndex)
+  {
+    Mutex::ScopeLock lock(m_access);
+    if (m_count == 0)
+    {
+      return false;
+    }
+    tileIndex = m_items[m_top];
+    m_top = (m_top + 1) % CAPACITY;
+    --m_count;
+    return true;
+  }
+
+  bool TileWorkQueue::StealBottom(u32 & tileIndex)
+  {
+    Mutex::ScopeLock lock(m_access);
+    if (m_count == 0)
+    {
+      return false;
+    }
+    --m_count;
+    tileIndex = m_items[(m_top + m_count) % CAPACITY];
+    return true;
+  }
+}
@@ -0,0 +1,21 @@
+#ifndef ASYNCGRIDSAVER_TEST_H      /* -*- C++ -*- */
+#define ASYNCGRIDSAVER_TEST_H
+
+#include "Test_Common.h"
+
+namespace MFM {
+
+  /**
+   * Tests for the AsyncGridSaver class
+   */
+  class AsyncGridSaver_Test
+  {
+  public:
+    static void Test_RunTests();
+
+    static void Test_asyncGridSaverMatchesSaveGrid();
+    static void Test_asyncGridSaverOneInFlight();
+  };
+} /* namespace MFM */
+
+#endif /*ASYNCGRIDSAVER_TEST_H*/
@@ -0,0 +1,46 @@
+#ifndef BENCH_COMMON_H      /* -*- C++ -*- */
+#define BENCH_COMMON_H
+
+#include <time.h>  /* For clock_gettime */
+#include "itype.h"
+#include "FileByteSink.h"
+
+namespace MFM {
+
+  /**
+   * Wall-clock stopwatch for the micro-benchmarks run by mfmbench.
+   */
+  class BenchTimer
+  {
+    timespec m_start;
+
+  public:
+    BenchTimer()
+    {
+      Start();
+    }
+
+    void Start()
+    {
+      clock_gettime(CLOCK_MONOTONIC, &m_start);
+    }
+
+    double GetElapsedSeconds() const
+    {
+      timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      return (now.tv_sec - m_start.tv_sec) + (now.tv_nsec - m_start.tv_nsec) / 1.0e9;
+    }
+  };
+
+  /**
+   * Where benchmark results go
+   */
+  inline ByteSink & BenchOutput()
+  {
+    return STDOUT;
+  }
+
+} /* namespace MFM */
+
+#endif /*BENCH_COMMON_H*/
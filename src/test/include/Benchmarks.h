@@ -0,0 +1,18 @@
+#ifndef BENCHMARKS_H      /* -*- C++ -*- */
+#define BENCHMARKS_H
+
+/* Get some types for us to benchmark */
+#include "Test_Common.h"
+#include "Bench_Common.h"
+
+#include "LonglivedLock_Bench.h"
+#include "GridSnapshot_Bench.h"
+#include "EventWindow_Bench.h"
+#include "BitVector_Bench.h"
+#include "Fail_Bench.h"
+#include "UlamElement_Bench.h"
+#include "Random_Bench.h"
+#include "EventHistoryBuffer_Bench.h"
+#include "FrameRenderer_Bench.h"
+
+#endif /*BENCHMARKS_H*/
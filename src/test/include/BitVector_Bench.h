@@ -0,0 +1,24 @@
+#ifndef BITVECTOR_BENCH_H      /* -*- C++ -*- */
+#define BITVECTOR_BENCH_H
+
+#include "Bench_Common.h"
+#include "BitVector.h"
+
+namespace MFM {
+
+  /**
+   * Measures the per-atom cost of BitVector field reads and writes,
+   * of comparing two BitVectors, and of finding which of many pairs
+   * differ, at atom-like sizes.
+   */
+  class BitVector_Bench
+  {
+  private:
+    template <u32 SIZE>
+    static void Bench_size();
+
+  public:
+    static void Bench_RunBenchmarks();
+  };
+} /* namespace MFM */
+#endif /*BITVECTOR_BENCH_H*/
@@ -35,6 +35,10 @@ namespace MFM {
 
     static void Test_bitVectorPopulationCount();
 
+    static void Test_bitVectorLastUnit();
+
+    static void Test_bitVectorFindChanged();
+
   };
 } /* namespace MFM */
 #endif /*BITVECTOR_TEST_H*/
@@ -0,0 +1,21 @@
+#ifndef ELEMENTTABLE_TEST_H      /* -*- C++ -*- */
+#define ELEMENTTABLE_TEST_H
+
+#include "Test_Common.h"
+
+namespace MFM {
+
+  /**
+   * Tests for the ElementTable class
+   */
+  class ElementTable_Test
+  {
+  public:
+    static void Test_RunTests();
+
+    static void Test_elementTableLookup();
+    static void Test_elementTableEntries();
+  };
+} /* namespace MFM */
+
+#endif /*ELEMENTTABLE_TEST_H*/
@@ -0,0 +1,25 @@
+#ifndef EVENTHISTORYBUFFER_BENCH_H      /* -*- C++ -*- */
+#define EVENTHISTORYBUFFER_BENCH_H
+
+#include "Bench_Common.h"
+
+namespace MFM {
+
+  /**
+   * Measures how densely EventHistoryBuffer holds the events of a
+   * Dreg/Res grid shaped like the default mfmc model's -- 5x3 tiles,
+   * each with a 100000-item history -- in memory, against the
+   * twelve-byte-item encoding it replaced, and deflated in a spill
+   * file -- and what recording costs per event.
+   */
+  class EventHistoryBuffer_Bench
+  {
+  private:
+    static void Bench_density();
+    static void Bench_recording();
+
+  public:
+    static void Bench_RunBenchmarks();
+  };
+} /* namespace MFM */
+#endif /*EVENTHISTORYBUFFER_BENCH_H*/
@@ -0,0 +1,23 @@
+#ifndef EVENTHISTORYBUFFER_TEST_H      /* -*- C++ -*- */
+#define EVENTHISTORYBUFFER_TEST_H
+
+#include "Test_Common.h"
+
+namespace MFM {
+
+  /**
+   * Tests for the EventHistoryBuffer class
+   */
+  class EventHistoryBuffer_Test
+  {
+  public:
+    static void Test_RunTests();
+
+    static void Test_historyRewindReplay();
+    static void Test_historyWraps();
+    static void Test_historySpill();
+    static void Test_historySpillWraps();
+  };
+} /* namespace MFM */
+
+#endif /*EVENTHISTORYBUFFER_TEST_H*/
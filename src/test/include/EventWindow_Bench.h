@@ -0,0 +1,26 @@
+#ifndef EVENTWINDOW_BENCH_H      /* -*- C++ -*- */
+#define EVENTWINDOW_BENCH_H
+
+#include "Bench_Common.h"
+
+namespace MFM {
+
+  /**
+   * Measures events per second on a single unconnected tile, mostly
+   * empty, so the cost of loading and storing event windows is
+   * prominent.  Also compares running every event in full against
+   * the tile's fast path for events on inert atoms, and uniform
+   * against occupied-site sampling.
+   */
+  class EventWindow_Bench
+  {
+  private:
+    static void Bench_events(u32 percentFull);
+    static void Bench_inertEvents(u32 percentFull);
+    static void Bench_sampling(u32 percentFull);
+
+  public:
+    static void Bench_RunBenchmarks();
+  };
+} /* namespace MFM */
+#endif /*EVENTWINDOW_BENCH_H*/
@@ -0,0 +1,23 @@
+#ifndef FAIL_BENCH_H      /* -*- C++ -*- */
+#define FAIL_BENCH_H
+
+#include "Bench_Common.h"
+
+namespace MFM {
+
+  /**
+   * Measures the cost of entering the unwind_protect and
+   * unwind_protect_light failure boundaries, alone and around the
+   * Behavior of every event on the same tile.
+   */
+  class Fail_Bench
+  {
+  private:
+    static void Bench_boundaries();
+    static void Bench_events();
+
+  public:
+    static void Bench_RunBenchmarks();
+  };
+} /* namespace MFM */
+#endif /*FAIL_BENCH_H*/
@@ -16,6 +16,8 @@ namespace MFM {
     static void Test_FailWithCode();
     static void Test_NestedFail();
     static void Test_UnsafeModification();
+    static void Test_LightFail();
+    static void Test_MixedNestedFail();
 
     static void Test_RunTests();
   };
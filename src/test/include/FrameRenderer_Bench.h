@@ -0,0 +1,22 @@
+#ifndef FRAMERENDERER_BENCH_H      /* -*- C++ -*- */
+#define FRAMERENDERER_BENCH_H
+
+#include "Bench_Common.h"
+
+namespace MFM {
+
+  /**
+   * Measures headless frames per second on a large populated grid:
+   * FrameRenderer alone at several thread counts and site sizes, and
+   * then with each frame also written as a PNG or piped as raw video.
+   */
+  class FrameRenderer_Bench
+  {
+  private:
+    static void Bench_render(u32 width, u32 height, u32 percentFull);
+
+  public:
+    static void Bench_RunBenchmarks();
+  };
+} /* namespace MFM */
+#endif /*FRAMERENDERER_BENCH_H*/
@@ -0,0 +1,21 @@
+#ifndef GRIDSNAPSHOT_BENCH_H      /* -*- C++ -*- */
+#define GRIDSNAPSHOT_BENCH_H
+
+#include "Bench_Common.h"
+
+namespace MFM {
+
+  /**
+   * Compares the time to save and load a populated grid as text
+   * (.mfs) and as a binary snapshot (.mfb).
+   */
+  class GridSnapshot_Bench
+  {
+  private:
+    static void Bench_saveLoad(u32 width, u32 height, u32 percentFull);
+
+  public:
+    static void Bench_RunBenchmarks();
+  };
+} /* namespace MFM */
+#endif /*GRIDSNAPSHOT_BENCH_H*/
@@ -12,6 +12,8 @@ namespace MFM {
   public:
     static void Test_Basic();
     static void Test_DataRates();
+    static void Test_Unthrottled();
+    static void Test_BufferSize();
 
     static void Test_RunTests();
 
@@ -15,6 +15,9 @@ namespace MFM {
   {
   public:
     static void Test_gridPlaceAtom();
+    static void Test_gridSchedulerWorkers();
+    static void Test_gridElementProfile();
+    static void Test_gridFrameRenderer();
   };
 } /* namespace MFM */
 #endif /*GRID_TEST_H*/
@@ -0,0 +1,23 @@
+#ifndef LONGLIVEDLOCK_BENCH_H      /* -*- C++ -*- */
+#define LONGLIVEDLOCK_BENCH_H
+
+#include "Bench_Common.h"
+#include "LonglivedLock.h"
+
+namespace MFM {
+
+  /**
+   * Compares MutexLonglivedLock and CASLonglivedLock with 2, 4, and 8
+   * threads hammering TryLock/Unlock on shared locks.
+   */
+  class LonglivedLock_Bench
+  {
+  private:
+    template <class LOCK>
+    static void Bench_contention(const char * name, u32 threads, u32 locks);
+
+  public:
+    static void Bench_RunBenchmarks();
+  };
+} /* namespace MFM */
+#endif /*LONGLIVEDLOCK_BENCH_H*/
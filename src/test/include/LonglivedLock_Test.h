@@ -0,0 +1,19 @@
+#ifndef LONGLIVEDLOCK_TEST_H      /* -*- C++ -*- */
+#define LONGLIVEDLOCK_TEST_H
+
+#include "LonglivedLock.h"
+
+namespace MFM {
+
+  class LonglivedLock_Test
+  {
+  private:
+    template <class LOCK> static void Test_lockUnlock();
+    template <class LOCK> static void Test_selfRelockFails();
+    template <class LOCK> static void Test_contentionCount();
+
+  public:
+    static void Test_RunTests();
+  };
+} /* namespace MFM */
+#endif /*LONGLIVEDLOCK_TEST_H*/
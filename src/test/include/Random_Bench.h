@@ -0,0 +1,25 @@
+#ifndef RANDOM_BENCH_H      /* -*- C++ -*- */
+#define RANDOM_BENCH_H
+
+#include "Bench_Common.h"
+
+namespace MFM {
+
+  /**
+   * Measures raw draws from the Mersenne Twister and xoshiro256**
+   * generators, then Random itself -- with whichever generator it
+   * was built with -- one draw at a time, in bulk, and under the
+   * events of a tile.
+   */
+  class Random_Bench
+  {
+  private:
+    static void Bench_generators();
+    static void Bench_random();
+    static void Bench_events();
+
+  public:
+    static void Bench_RunBenchmarks();
+  };
+} /* namespace MFM */
+#endif /*RANDOM_BENCH_H*/
@@ -10,6 +10,9 @@ namespace MFM {
     static Random & setup();
     static void Test_randomSetSeed();
     static void Test_randomDeterministics();
+    static void Test_randomFill();
+    static void Test_randomStreamSeeds();
+    static void Test_randomXoshiro();
 
   public:
     static void Test_RunTests();
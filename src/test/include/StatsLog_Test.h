@@ -0,0 +1,23 @@
+#ifndef STATSLOG_TEST_H      /* -*- C++ -*- */
+#define STATSLOG_TEST_H
+
+#include "Test_Common.h"
+
+namespace MFM {
+
+  /**
+   * Tests for the StatsLog class
+   */
+  class StatsLog_Test
+  {
+  public:
+    static void Test_RunTests();
+
+    static void Test_statsLogRoundTrip();
+    static void Test_statsLogColumnChange();
+    static void Test_statsLogReopen();
+    static void Test_statsLogTruncated();
+  };
+} /* namespace MFM */
+
+#endif /*STATSLOG_TEST_H*/
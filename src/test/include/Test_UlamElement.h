@@ -0,0 +1,105 @@
+#ifndef TEST_ULAMELEMENT_H      /* -*- C++ -*- */
+#define TEST_ULAMELEMENT_H
+
+#include "UlamElement.h"
+#include "UlamRef.h"
+#include "UlamContext.h"
+
+namespace MFM {
+
+  /**
+   * A hand-written stand-in for a culam-generated element, for tests
+   * and benchmarks that need an UlamElement with a real vtable.  Its
+   * behave() overrides UrSelf's, and counts its events in the first
+   * COUNTER_BITS of its state, as well as in a static tally.
+   */
+  template <class EC>
+  class Ue_TestCounter : public UlamElement<EC>
+  {
+    typedef typename EC::ATOM_CONFIG AC;
+    typedef typename AC::ATOM_TYPE T;
+
+  public:
+    enum {
+      REGNUM = 1,          // UrSelf is 0
+      CLASS_LENGTH = 16,
+      COUNTER_BITS = 8
+    };
+
+    static Ue_TestCounter THE_INSTANCE;
+    static u32 s_behaves;
+
+    Ue_TestCounter() : UlamElement<EC>(MFM_UUID_FOR("TestCounter", 1))
+    {
+      Element<EC>::SetAtomicSymbol("Tc");
+      Element<EC>::SetName("TestCounter");
+    }
+
+    virtual u32 GetTypeFromThisElement() const
+    {
+      return 0xCE71;
+    }
+
+    static void Uf_6behave(const UlamContext<EC>& uc, UlamRef<EC>& ur)
+    {
+      ++s_behaves;
+      UlamRef<EC> counter(ur, 0, COUNTER_BITS, NULL, UlamRef<EC>::PRIMITIVE);
+      counter.Write(counter.Read() + 1);
+    }
+
+    virtual const char * GetMangledClassName() const { return "Ue_TestCounter"; }
+    virtual u32 GetMangledClassNameAsStringIndex() const { return 0; }
+    virtual u32 GetUlamClassNameAsStringIndex(bool templateParameters, bool templateValues) const { return 0; }
+    virtual u32 GetRegistrationNumber() const { return REGNUM; }
+    virtual u32 GetClassLength() const { return CLASS_LENGTH; }
+    virtual u32 GetClassDataMembersSize() const { return CLASS_LENGTH; }
+
+    virtual bool internalCMethodImplementingIs(const UlamClass<EC> * cptrarg) const
+    {
+      return cptrarg == this;
+    }
+
+    virtual bool internalCMethodImplementingIs(const u32 regid) const
+    {
+      return regid == 0 || regid == REGNUM;
+    }
+
+    virtual s32 internalCMethodImplementingGetRelativePositionOfBaseClass(const UlamClass<EC> * cptrarg) const
+    {
+      return cptrarg == this ? 0 : -1;
+    }
+
+    virtual s32 internalCMethodImplementingGetRelativePositionOfBaseClass(const u32 regid) const
+    {
+      return regid == REGNUM ? 0 : -1;
+    }
+
+    // One-entry vtable: UrSelf's behave, overridden here
+    virtual VfuncPtr getVTableEntry(u32 idx) const
+    {
+      if (idx != UlamElement<EC>::BEHAVE_VOWNED_INDEX) FAIL(ARRAY_INDEX_OUT_OF_BOUNDS);
+      return (VfuncPtr) Uf_6behave;
+    }
+
+    virtual const UlamClass<EC> * getVTableEntryUlamClassPtr(u32 idx) const
+    {
+      if (idx != UlamElement<EC>::BEHAVE_VOWNED_INDEX) FAIL(ARRAY_INDEX_OUT_OF_BOUNDS);
+      return this;
+    }
+
+    virtual u32 GetVTStartOffsetForClassByRegNum(u32 rn) const
+    {
+      if (rn != 0 && rn != REGNUM) FAIL(ILLEGAL_ARGUMENT);
+      return 0;
+    }
+  };
+
+  template <class EC>
+  Ue_TestCounter<EC> Ue_TestCounter<EC>::THE_INSTANCE;
+
+  template <class EC>
+  u32 Ue_TestCounter<EC>::s_behaves = 0;
+
+} /* namespace MFM */
+
+#endif /*TEST_ULAMELEMENT_H*/
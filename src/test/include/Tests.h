@@ -23,6 +23,8 @@
 #include "BitVector_Test.h"
 #include "Point_Test.h"
 //XXX Deprecated #include "P1Atom_Test.h"
+#include "ElementTable_Test.h"
+#include "EventHistoryBuffer_Test.h"
 #include "Tile_Test.h"
 #include "Grid_Test.h"
 #include "EventWindow_Test.h"
@@ -30,5 +32,9 @@
 #include "ColorMap_Test.h"
 #include "FXP_Test.h"
 #include "ExternalConfig_Test.h"
+#include "LonglivedLock_Test.h"
+#include "StatsLog_Test.h"
+#include "WorkerPool_Test.h"
+#include "AsyncGridSaver_Test.h"
 
 #endif /*TESTS_H*/
@@ -15,6 +15,13 @@ namespace MFM {
 
     static void Test_tilePlaceAtom();
     static void Test_tileSquareDistances();
+    static void Test_tileSiteLayout();
+    static void Test_tileInertEvents();
+    static void Test_tileOccupancy();
+    static void Test_tileUlamBehavior();
+    static void Test_tileAtomCounts();
+    static void Test_tileCounters();
+    static void Test_tileWriteGenerations();
   };
 } /* namespace MFM */
 
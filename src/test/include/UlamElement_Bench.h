@@ -0,0 +1,24 @@
+#ifndef ULAMELEMENT_BENCH_H      /* -*- C++ -*- */
+#define ULAMELEMENT_BENCH_H
+
+#include "Bench_Common.h"
+
+namespace MFM {
+
+  /**
+   * Measures the cost of getting to an ulam element's behave(): the
+   * vtable resolution that UlamElement used to do on every event,
+   * against the cached dispatch it does now, and whole events on a
+   * tile full of such an element.
+   */
+  class UlamElement_Bench
+  {
+  private:
+    static void Bench_dispatch();
+    static void Bench_events();
+
+  public:
+    static void Bench_RunBenchmarks();
+  };
+} /* namespace MFM */
+#endif /*ULAMELEMENT_BENCH_H*/
@@ -0,0 +1,21 @@
+#ifndef WORKERPOOL_TEST_H      /* -*- C++ -*- */
+#define WORKERPOOL_TEST_H
+
+#include "Test_Common.h"
+
+namespace MFM {
+
+  /**
+   * Tests for the WorkerPool class
+   */
+  class WorkerPool_Test
+  {
+  public:
+    static void Test_RunTests();
+
+    static void Test_workerPoolRun();
+    static void Test_workerPoolFailures();
+  };
+} /* namespace MFM */
+
+#endif /*WORKERPOOL_TEST_H*/
@@ -0,0 +1,203 @@
+#include "assert.h"
+#include "AsyncGridSaver_Test.h"
+#include "AsyncGridSaver.h"
+#include "AbstractDriver.h"
+#include "Element_Dreg.h"
+#include <stdio.h>     /* For fopen */
+#include <string.h>    /* For strcmp */
+#include <sys/stat.h>  /* For mkfifo */
+#include <unistd.h>    /* For unlink, access */
+
+namespace MFM {
+
+  struct AsyncGridSaverTestDriver : public AbstractDriver<TestGridConfig>
+  {
+    AsyncGridSaverTestDriver() : AbstractDriver<TestGridConfig>(2,2,GRID_LAYOUT_CHECKERBOARD) { }
+    void ReinitEden() { FAIL(ILLEGAL_STATE); }
+    void DefineNeededElements() { FAIL(ILLEGAL_STATE); }
+  };
+
+  static const SPoint DREG_SPOTS[] = { SPoint(0,0), SPoint(17,30), SPoint(45,3), SPoint(60,50) };
+  static const u32 DREG_SPOT_COUNT = sizeof(DREG_SPOTS) / sizeof(DREG_SPOTS[0]);
+
+  static void InitDriver(AsyncGridSaverTestDriver & td)
+  {
+    td.RegisterExternalConfigSections();
+
+    TestGrid & grid = td.GetGrid();
+    grid.Needed(Element_Empty<TestEventConfig>::THE_INSTANCE);
+    grid.Needed(Element_Dreg<TestEventConfig>::THE_INSTANCE);
+    grid.SetSeed(1);
+    grid.Init();
+
+    const TestAtom dreg = Element_Dreg<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    for (u32 i = 0; i < DREG_SPOT_COUNT; ++i)
+    {
+      grid.PlaceAtom(dreg, DREG_SPOTS[i]);
+    }
+  }
+
+  static bool HasDregSpots(AsyncGridSaverTestDriver & td)
+  {
+    TestGrid & grid = td.GetGrid();
+    const u32 dregType = Element_Dreg<TestEventConfig>::THE_INSTANCE.GetType();
+    for (u32 i = 0; i < DREG_SPOT_COUNT; ++i)
+    {
+      SPoint spot(DREG_SPOTS[i]);
+      if (grid.GetAtom(spot)->GetType() != dregType)
+      {
+        return false;
+      }
+    }
+    SPoint elsewhere(20,20);
+    return grid.GetAtom(elsewhere)->GetType() != dregType;
+  }
+
+  /*
+   * True if the .mfs files at \c path1 and \c path2 match, apart from
+   * their RuntimeData, which holds the wall-clock ticks at each save
+   */
+  static bool SameMFS(const char * path1, const char * path2)
+  {
+    FILE * fp1 = fopen(path1, "r");
+    FILE * fp2 = fopen(path2, "r");
+    assert(fp1 && fp2);
+
+    bool same = true;
+    char line1[4096], line2[4096];
+    while (same)
+    {
+      const bool more1 = fgets(line1, sizeof(line1), fp1) != 0;
+      const bool more2 = fgets(line2, sizeof(line2), fp2) != 0;
+      if (!more1 || !more2)
+      {
+        same = more1 == more2;
+        break;
+      }
+      same = !strcmp(line1, line2) ||
+        (!strncmp(line1, "RuntimeData(", 12) && !strncmp(line2, "RuntimeData(", 12));
+    }
+    fclose(fp1);
+    fclose(fp2);
+    return same;
+  }
+
+  /* Load \c path and copy every atom of the grid into \c atoms */
+  static void LoadAtoms(AsyncGridSaverTestDriver & td, const char * path, TestAtom * atoms)
+  {
+    TestGrid & grid = td.GetGrid();
+    grid.Clear();
+    assert(!HasDregSpots(td));
+    assert(td.LoadMFS(path));
+    assert(HasDregSpots(td));
+
+    for (u32 y = 0; y < grid.GetHeightSites(); ++y)
+    {
+      for (u32 x = 0; x < grid.GetWidthSites(); ++x)
+      {
+        SPoint site(x, y);
+        atoms[y * grid.GetWidthSites() + x] = *grid.GetAtom(site);
+      }
+    }
+  }
+
+  /* Read \c from (a FIFO, say) to its end, writing it all to \c to */
+  static void CopyFile(const char * from, const char * to)
+  {
+    FILE * in = fopen(from, "r");
+    FILE * out = fopen(to, "w");
+    assert(in && out);
+
+    u8 buf[4096];
+    size_t len;
+    bool ok = true;
+    while ((len = fread(buf, 1, sizeof(buf), in)) > 0)
+    {
+      ok = fwrite(buf, len, 1, out) == 1 && ok;
+    }
+    fclose(in);
+    ok = fclose(out) == 0 && ok;
+    assert(ok);
+  }
+
+  void AsyncGridSaver_Test::Test_asyncGridSaverMatchesSaveGrid()
+  {
+    AsyncGridSaverTestDriver td;
+    InitDriver(td);
+    AsyncGridSaver<TestGridConfig> & saver = td.GetAsyncGridSaver();
+
+    const u32 sites = td.GetGrid().GetWidthSites() * td.GetGrid().GetHeightSites();
+    TestAtom * syncAtoms = new TestAtom[sites];
+    TestAtom * asyncAtoms = new TestAtom[sites];
+
+    const char * suffixes[] = { "mfs", "mfb" };
+    for (u32 i = 0; i < 2; ++i)
+    {
+      OString512 syncPath, asyncPath;
+      syncPath.Printf("/tmp/AsyncGridSaver_Test-sync.%s", suffixes[i]);
+      asyncPath.Printf("/tmp/AsyncGridSaver_Test-async.%s", suffixes[i]);
+
+      td.SaveGrid(syncPath.GetZString());
+      assert(saver.Save(asyncPath.GetZString()));
+      saver.WaitUntilIdle();
+      assert(saver.GetLastLatencyUsec() >= saver.GetLastPauseUsec());
+      if (i == 0)
+      {
+        assert(SameMFS(syncPath.GetZString(), asyncPath.GetZString()));
+      }
+
+      LoadAtoms(td, syncPath.GetZString(), syncAtoms);
+      LoadAtoms(td, asyncPath.GetZString(), asyncAtoms);
+      for (u32 s = 0; s < sites; ++s)
+      {
+        assert(syncAtoms[s] == asyncAtoms[s]);
+      }
+
+      unlink(syncPath.GetZString());
+      unlink(asyncPath.GetZString());
+    }
+    assert(saver.GetSkippedSaves() == 0);
+
+    delete [] syncAtoms;
+    delete [] asyncAtoms;
+  }
+
+  void AsyncGridSaver_Test::Test_asyncGridSaverOneInFlight()
+  {
+    AsyncGridSaverTestDriver td;
+    InitDriver(td);
+    AsyncGridSaver<TestGridConfig> & saver = td.GetAsyncGridSaver();
+
+    // Opening a FIFO for writing blocks until it has a reader, so the
+    // first save stays in flight until we read it
+    const char * fifoPath = "/tmp/AsyncGridSaver_Test.fifo";
+    const char * drainedPath = "/tmp/AsyncGridSaver_Test-drained.mfs";
+    const char * laterPath = "/tmp/AsyncGridSaver_Test-later.mfs";
+    unlink(fifoPath);
+    assert(!mkfifo(fifoPath, 0600));
+
+    assert(saver.Save(fifoPath));
+    assert(!saver.Save(laterPath));
+    assert(saver.GetSkippedSaves() == 1);
+    assert(access(laterPath, F_OK) != 0);
+
+    CopyFile(fifoPath, drainedPath);
+    saver.WaitUntilIdle();
+
+    // The queue is free again
+    assert(saver.Save(laterPath));
+    saver.WaitUntilIdle();
+    assert(saver.GetSkippedSaves() == 1);
+    assert(SameMFS(drainedPath, laterPath));
+
+    unlink(fifoPath);
+    unlink(drainedPath);
+    unlink(laterPath);
+  }
+
+  void AsyncGridSaver_Test::Test_RunTests()
+  {
+    Test_asyncGridSaverMatchesSaveGrid();
+    Test_asyncGridSaverOneInFlight();
+  }
+} /* namespace MFM */
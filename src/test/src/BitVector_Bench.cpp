@@ -0,0 +1,105 @@
+#include "BitVector_Bench.h"
+#include "Random.h"
+
+namespace MFM {
+
+  enum { BENCH_ATOMS = 1024, BENCH_PASSES = 2000 };
+
+  static volatile u32 benchSink;  // Keeps results from being optimized away
+
+  static void Report(const char * what, u32 size, double secs, u32 perPass)
+  {
+    const double ns = secs * 1.0e9 / ((double) BENCH_PASSES * perPass);
+    BenchOutput().Printf("  BitVector<%d> %s: %d.%02d ns\n",
+                         size, what, (u32) ns, ((u32) (ns * 100)) % 100);
+  }
+
+  template <u32 SIZE>
+  void BitVector_Bench::Bench_size()
+  {
+    static BitVector<SIZE> before[BENCH_ATOMS];
+    static BitVector<SIZE> after[BENCH_ATOMS];   // About 10% differ from before
+    static BitVector<SIZE> scratch[BENCH_ATOMS];
+    static bool changed[BENCH_ATOMS];
+
+    Random random(1);
+    for (u32 n = 0; n < BENCH_ATOMS; ++n)
+    {
+      for (u32 i = 0; i < SIZE; ++i)
+      {
+        before[n].WriteBit(i, random.CreateBool());
+      }
+      after[n] = before[n];
+      if (random.OneIn(10))
+      {
+        after[n].ToggleBit(random.Create(SIZE));
+      }
+    }
+
+    // Fields at assorted offsets and lengths, many crossing units
+    enum { FIELDS = 8 };
+    u32 starts[FIELDS];
+    u32 lengths[FIELDS];
+    for (u32 f = 0; f < FIELDS; ++f)
+    {
+      lengths[f] = 1 + random.Create(32);
+      starts[f] = random.Create(SIZE - lengths[f] + 1);
+    }
+
+    u32 sum = 0;
+    BenchTimer read;
+    for (u32 p = 0; p < BENCH_PASSES; ++p)
+    {
+      for (u32 n = 0; n < BENCH_ATOMS; ++n)
+      {
+        for (u32 f = 0; f < FIELDS; ++f)
+        {
+          sum += before[n].Read(starts[f], lengths[f]);
+        }
+      }
+    }
+    Report("Read (per field)", SIZE, read.GetElapsedSeconds(), BENCH_ATOMS * FIELDS);
+
+    BenchTimer write;
+    for (u32 p = 0; p < BENCH_PASSES; ++p)
+    {
+      for (u32 n = 0; n < BENCH_ATOMS; ++n)
+      {
+        for (u32 f = 0; f < FIELDS; ++f)
+        {
+          scratch[n].Write(starts[f], lengths[f], p + n);
+        }
+      }
+    }
+    Report("Write (per field)", SIZE, write.GetElapsedSeconds(), BENCH_ATOMS * FIELDS);
+
+    BenchTimer compare;
+    for (u32 p = 0; p < BENCH_PASSES; ++p)
+    {
+      // Touch one atom per pass, so the comparisons can't be hoisted
+      after[p % BENCH_ATOMS].Write(0, 1, p);
+      for (u32 n = 0; n < BENCH_ATOMS; ++n)
+      {
+        sum += before[n] == after[n];
+      }
+    }
+    Report("operator== (per atom)", SIZE, compare.GetElapsedSeconds(), BENCH_ATOMS);
+
+    BenchTimer bulk;
+    for (u32 p = 0; p < BENCH_PASSES; ++p)
+    {
+      after[p % BENCH_ATOMS].Write(0, 1, p);
+      sum += BitVector<SIZE>::FindChanged(before, after, BENCH_ATOMS, changed);
+    }
+    Report("FindChanged (per atom)", SIZE, bulk.GetElapsedSeconds(), BENCH_ATOMS);
+
+    benchSink = sum;
+  }
+
+  void BitVector_Bench::Bench_RunBenchmarks()
+  {
+    Bench_size<96>();
+    Bench_size<71>();
+  }
+
+} /* namespace MFM */
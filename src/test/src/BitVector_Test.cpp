@@ -36,6 +36,8 @@ namespace MFM {
     Test_bitVectorStoreBits();
     Test_bitVectorReadWriteBV();
     Test_bitVectorPopulationCount();
+    Test_bitVectorLastUnit();
+    Test_bitVectorFindChanged();
   }
 
   static BitVector<256> bits(vals);
@@ -503,4 +505,74 @@ namespace MFM {
     }
   }
 
+  template <u32 SIZE>
+  static void CheckAllFields()
+  {
+    // Every field of every length, checked against bitwise access,
+    // including those ending in the last (possibly partial) unit
+    for (u32 len = 1; len <= 32; ++len)
+    {
+      for (u32 start = 0; start + len <= SIZE; ++start)
+      {
+        BitVector<SIZE> bits;
+        for (u32 i = 0; i < SIZE; ++i)
+          bits.WriteBit(i, (i * 7 + start) % 3 == 0);
+
+        u32 expected = 0;
+        for (u32 i = start; i < start + len; ++i)
+          expected = (expected << 1) | bits.ReadBit(i);
+        assert(bits.Read(start, len) == expected);
+
+        const u32 value = 0xa5c3e1f7 & MakeMaskClip(len);
+        bits.Write(start, len, value);
+        assert(bits.Read(start, len) == value);
+        for (u32 i = 0; i < SIZE; ++i)
+        {
+          if (i < start || i >= start + len)
+            assert(bits.ReadBit(i) == ((i * 7 + start) % 3 == 0));
+        }
+      }
+    }
+  }
+
+  void BitVector_Test::Test_bitVectorLastUnit()
+  {
+    CheckAllFields<96>();
+    CheckAllFields<71>();
+    CheckAllFields<32>();
+    CheckAllFields<20>();
+  }
+
+  void BitVector_Test::Test_bitVectorFindChanged()
+  {
+    const u32 COUNT = 10;
+    BitVector<96> before[COUNT];
+    BitVector<96> after[COUNT];
+    bool changed[COUNT];
+
+    for (u32 i = 0; i < COUNT; ++i)
+    {
+      before[i].Write(i * 8, 8, 0x5a);
+      after[i] = before[i];
+    }
+    assert(BitVector<96>::FindChanged(before, after, COUNT, changed) == 0);
+    for (u32 i = 0; i < COUNT; ++i)
+      assert(!changed[i]);
+
+    after[3].ToggleBit(95);
+    after[7].ToggleBit(0);
+    assert(BitVector<96>::FindChanged(before, after, COUNT, changed) == 2);
+    for (u32 i = 0; i < COUNT; ++i)
+      assert(changed[i] == (i == 3 || i == 7));
+    assert(before[3] != after[3]);
+    assert(before[4] == after[4]);
+
+    // Strided: compare every other element
+    assert(BitVector<96>::FindChanged(before, after, COUNT / 2, changed,
+                                      2 * sizeof(BitVector<96>)) == 0);
+    assert(BitVector<96>::FindChanged(before + 1, after + 1, COUNT / 2, changed,
+                                      2 * sizeof(BitVector<96>)) == 2);
+    assert(changed[1] && changed[3] && !changed[0]);
+  }
+
 } /* namespace MFM */
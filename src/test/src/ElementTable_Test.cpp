@@ -0,0 +1,92 @@
+#include "assert.h"
+#include "ElementTable_Test.h"
+#include "Element_Empty.h"
+#include "Element_Res.h"
+#include "Element_Dreg.h"
+
+namespace MFM {
+
+  typedef Element_Empty<TestEventConfig> TestEmpty;
+  typedef Element_Res<TestEventConfig> TestRes;
+  typedef Element_Dreg<TestEventConfig> TestDreg;
+
+  static void Setup(TestElementTable & et)
+  {
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    TestRes::THE_INSTANCE.AllocateType(etnm);
+    TestDreg::THE_INSTANCE.AllocateType(etnm);
+    et.RegisterElement(TestEmpty::THE_INSTANCE);
+    et.RegisterElement(TestRes::THE_INSTANCE);
+    et.RegisterElement(TestDreg::THE_INSTANCE);
+  }
+
+  void ElementTable_Test::Test_RunTests()
+  {
+    Test_elementTableLookup();
+    Test_elementTableEntries();
+  }
+
+  void ElementTable_Test::Test_elementTableLookup()
+  {
+    TestElementTable et;
+    Setup(et);
+
+    const u32 res = TestRes::THE_INSTANCE.GetType();
+    const u32 dreg = TestDreg::THE_INSTANCE.GetType();
+    const u32 empty = TestEmpty::THE_INSTANCE.GetType();
+    assert(et.Lookup(res) == &TestRes::THE_INSTANCE);
+    assert(et.Lookup(dreg) == &TestDreg::THE_INSTANCE);
+    assert(et.Lookup(empty) == &TestEmpty::THE_INSTANCE);
+
+    // Misses sharing a page with registered types, and in pages
+    // nothing is registered in
+    assert(et.Lookup(res ^ 0x80) == 0);
+    assert(et.Lookup(empty - 1) == 0);
+    assert(et.Lookup(0u) == 0);
+    assert(et.Lookup(0x1234) == 0);
+    assert(et.Lookup(1u << TestEventConfig::ATOM_CONFIG::ATOM_TYPE_BITS) == 0);
+    assert(et.GetIndex(0x1234) == -1);
+
+    // Indices are distinct and in range
+    const s32 ri = et.GetIndex(res);
+    const s32 di = et.GetIndex(dreg);
+    const s32 ei = et.GetIndex(empty);
+    assert(ri >= 0 && di >= 0 && ei >= 0);
+    assert(ri != di && di != ei && ei != ri);
+    assert((u32) ri < et.GetSize() && (u32) di < et.GetSize() && (u32) ei < et.GetSize());
+
+    // Registering again is harmless
+    et.RegisterElement(TestRes::THE_INSTANCE);
+    assert(et.GetIndex(res) == ri);
+
+    assert(et.Lookup((const u8 *) "R") == &TestRes::THE_INSTANCE);
+    assert(et.Lookup((const u8 *) "Zz") == 0);
+
+    et.Reinit();
+    assert(et.Lookup(res) == 0);
+    assert(et.GetIndex(empty) == -1);
+  }
+
+  void ElementTable_Test::Test_elementTableEntries()
+  {
+    TestElementTable et;
+    Setup(et);
+
+    const TestElementTable::ElementEntry & empty =
+      et.LookupEntry(TestEmpty::THE_INSTANCE.GetType());
+    assert(empty.m_element == &TestEmpty::THE_INSTANCE);
+    assert(empty.m_boundary == 0);
+    assert(empty.m_isInert);
+
+    const TestElementTable::ElementEntry & res =
+      et.LookupEntry(TestRes::THE_INSTANCE.GetType());
+    assert(res.m_element == &TestRes::THE_INSTANCE);
+    assert(res.m_boundary == TestRes::THE_INSTANCE.GetEventWindowBoundary());
+    assert(!res.m_isInert);
+
+    const TestElementTable::ElementEntry & none = et.LookupEntry(0x1234);
+    assert(none.m_element == 0);
+    assert(!none.m_isInert);
+  }
+
+} /* namespace MFM */
@@ -0,0 +1,168 @@
+#include "EventHistoryBuffer_Bench.h"
+#include "EventHistoryBuffer.h"
+#include "Test_Common.h"
+#include "Element_Dreg.h"
+#include "Element_Res.h"
+#include <unistd.h>  /* For unlink */
+
+namespace MFM {
+
+  enum { BENCH_EVENTS = 1000000, GRID_EVENTS = 80000000 };
+
+  // The default mfmc model: 5x3 tiles of TileC, each with mfmc's
+  // 100000-item history
+  enum { STD_WIDTH = 5, STD_HEIGHT = 3, STD_HISTORY_SIZE = 100000 };
+  typedef GridConfig<TestEventConfig, 40, 40, STD_HISTORY_SIZE> StdGridConfig;
+  typedef Grid<StdGridConfig> StdGrid;
+  typedef StdGrid::GridTile StdTile;
+
+  static const char * SPILL_DIR = "/tmp/EventHistoryBuffer_Bench-";
+
+  static void ReportBytes(const char * what, double bytesPerEvent, u32 events)
+  {
+    BenchOutput().Printf("  %s: %d.%02d bytes/event, %d events retained\n",
+                         what, (u32) bytesPerEvent, ((u32) (bytesPerEvent * 100)) % 100,
+                         events);
+  }
+
+  void EventHistoryBuffer_Bench::Bench_density()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    StdGrid grid(ereg, STD_WIDTH, STD_HEIGHT, GRID_LAYOUT_CHECKERBOARD);
+    grid.SetSeed(1);
+    grid.Init();
+    // One worker runs every tile: with a thread per tile, a machine
+    // with fewer cores than tiles can spin for minutes on cache locks
+    grid.SetSchedulerWorkers(1);
+    grid.InitThreads();
+    grid.Needed(Element_Dreg<TestEventConfig>::THE_INSTANCE);
+    grid.Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+    if (!grid.SetHistorySpill(SPILL_DIR, 64 << 20))
+    {
+      FAIL(IO_ERROR);
+    }
+
+    // A tenth full of Dreg and Res, as GridSnapshot_Bench seeds it
+    Random & random = grid.GetRandom();
+    const TestAtom dreg = Element_Dreg<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    const TestAtom res = Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    for (u32 x = 0; x < grid.GetWidthSites(); ++x)
+    {
+      for (u32 y = 0; y < grid.GetHeightSites(); ++y)
+      {
+        if (random.OneIn(10))
+        {
+          grid.PlaceAtom(random.CreateBool() ? dreg : res, SPoint(x, y));
+        }
+      }
+    }
+
+    // Long enough for every tile's memory to wrap a few times over
+    grid.Unpause();
+    while (grid.SampleTotalEventsExecuted() < GRID_EVENTS)
+    {
+      SleepMsec(500);
+    }
+    grid.Pause();
+
+    u32 events = 0, deltas = 0, held = 0, heldBytes = 0, spilled = 0, spilledBytes = 0, tiles = 0;
+    for (u32 x = 0; x < STD_WIDTH; ++x)
+    {
+      for (u32 y = 0; y < STD_HEIGHT; ++y)
+      {
+        if (!grid.IsLegalTileIndex(SPoint(x, y)) || grid.GetTile(x, y).IsDummyTile())
+          continue;
+
+        const EventHistoryBuffer<TestEventConfig> & ehb = grid.GetTile(x, y).GetEventHistoryBuffer();
+        events += ehb.GetEventsAdded();
+        deltas += ehb.GetDeltasAdded();
+        held += ehb.CountEventsInHistory() - ehb.CountEventsInSpill();
+        heldBytes += ehb.GetBytesInHistory();
+        spilled += ehb.CountEventsInSpill();
+        spilledBytes += ehb.GetBytesInSpill();
+        ++tiles;
+      }
+    }
+    grid.ShutdownTileThreads();
+
+    const u32 capacity = STD_HISTORY_SIZE * sizeof(EventHistoryItem);
+    const double perEvent = (double) deltas / events;
+    BenchOutput().Printf("  %dx%d tiles of %d bytes of history, %d events recorded, "
+                         "%d.%02d changed words/event\n",
+                         STD_WIDTH, STD_HEIGHT, capacity, events,
+                         (u32) perEvent, ((u32) (perEvent * 100)) % 100);
+
+    // START and END items plus one item per changed word
+    const double fixed = sizeof(EventHistoryItem) * (2 + perEvent);
+    ReportBytes("Fixed-width items, per tile", fixed, (u32) (capacity / fixed));
+    ReportBytes("Packed records, per tile", (double) heldBytes / held, held / tiles);
+    ReportBytes("Spilled, deflated, per tile", (double) spilledBytes / spilled, spilled / tiles);
+
+    for (u32 x = 0; x < STD_WIDTH; ++x)
+    {
+      for (u32 y = 0; y < STD_HEIGHT; ++y)
+      {
+        OString512 path;
+        path.Printf("%shistory-%d-%d.dat", SPILL_DIR, x, y);
+        unlink(path.GetZString());
+      }
+    }
+  }
+
+  void EventHistoryBuffer_Bench::Bench_recording()
+  {
+    // One of those tiles, a quarter full of Res, so nearly every
+    // event moves an atom and is recorded
+    StdTile * tile = new StdTile();
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile->RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    Random & random = tile->GetRandom();
+    random.SetSeed(1);
+    const TestAtom res = Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    for (u32 x = 0; x < tile->OWNED_WIDTH; ++x)
+    {
+      for (u32 y = 0; y < tile->OWNED_HEIGHT; ++y)
+      {
+        if (random.OneIn(4))
+        {
+          tile->PlaceAtom(res, SPoint(x, y) + SPoint(tile->EVENT_WINDOW_RADIUS, tile->EVENT_WINDOW_RADIUS));
+        }
+      }
+    }
+
+    const char * spillPath = "/tmp/EventHistoryBuffer_Bench.spill";
+    static const char * passes[] = { "history off", "history on", "history on, spilling" };
+    for (u32 pass = 0; pass < 3; ++pass)
+    {
+      tile->SetHistoryActive(pass > 0);
+      if (pass == 2 && !tile->GetEventHistoryBuffer().SetSpillFile(spillPath, 64 << 20))
+      {
+        FAIL(IO_ERROR);
+      }
+      u32 executed = 0;
+      BenchTimer timer;
+      for (u32 i = 0; i < BENCH_EVENTS; ++i)
+      {
+        if (tile->TryRandomEvent())
+        {
+          ++executed;
+        }
+      }
+      const double secs = timer.GetElapsedSeconds();
+      BenchOutput().Printf("  Res tile, %s: %d events/sec\n",
+                           passes[pass], (u32) (executed / secs));
+    }
+
+    tile->GetEventHistoryBuffer().CloseSpillFile();
+    unlink(spillPath);
+    delete tile;
+  }
+
+  void EventHistoryBuffer_Bench::Bench_RunBenchmarks()
+  {
+    Bench_density();
+    Bench_recording();
+  }
+
+} /* namespace MFM */
@@ -0,0 +1,220 @@
+#include "assert.h"
+#include <unistd.h>
+#include "EventHistoryBuffer_Test.h"
+#include "EventHistoryBuffer.h"
+
+namespace MFM {
+
+  typedef EventHistoryBuffer<TestEventConfig> TestHistory;
+
+  enum { R = TestEventConfig::EVENT_WINDOW_RADIUS };
+
+  // Hash of every atom in the tile, caches included
+  static u32 Fingerprint(TestTile & tile)
+  {
+    u32 hash = 2166136261u;
+    for (u32 x = 0; x < tile.TILE_WIDTH; ++x)
+    {
+      for (u32 y = 0; y < tile.TILE_HEIGHT; ++y)
+      {
+        const TestAtom & atom = *tile.GetAtom(SPoint(x, y));
+        for (u32 w = 0; w < 3; ++w)
+        {
+          hash = (hash ^ atom.GetBits().Read(w * 32, 32)) * 16777619u;
+        }
+      }
+    }
+    return hash;
+  }
+
+  /**
+     Record, and make, an event changing a few random bits of a few
+     sites in the window around a random center
+   */
+  static SPoint RecordEvent(TestTile & tile, Random & random)
+  {
+    const MDist<R> & md = MDist<R>::get();
+    const SPoint ctr(R + random.Create(tile.OWNED_WIDTH), R + random.Create(tile.OWNED_HEIGHT));
+    TestHistory & ehb = tile.GetEventHistoryBuffer();
+    ehb.AddEventStart(ctr);
+    const u32 sites = 1 + random.Create(4);
+    for (u32 i = 0; i < sites; ++i)
+    {
+      const u32 site = (i == 0) ? 0 : random.Create(md.GetSiteCount());
+      TestAtom & atom = *tile.GetWritableAtom(md.GetPoint(site) + ctr);
+      const TestAtom old = atom;
+      atom.GetBits().ToggleBit(random.Create(96));
+      if (random.OneIn(3))
+      {
+        atom.GetBits().Write(random.Create(3) * 32, 32, random.Create());
+      }
+      ehb.AddEventAtom(site, old, atom);
+    }
+    ehb.AddEventEnd();
+    return ctr;
+  }
+
+  void EventHistoryBuffer_Test::Test_RunTests()
+  {
+    Test_historyRewindReplay();
+    Test_historyWraps();
+    Test_historySpill();
+    Test_historySpillWraps();
+  }
+
+  void EventHistoryBuffer_Test::Test_historyRewindReplay()
+  {
+    enum { EVENTS = 20 };
+    TestTile tile;
+    TestHistory & ehb = tile.GetEventHistoryBuffer();
+    Random random(1);
+
+    u32 fingerprints[EVENTS + 1];
+    fingerprints[0] = Fingerprint(tile);
+    SPoint ctr;
+    for (u32 i = 1; i <= EVENTS; ++i)
+    {
+      ctr = RecordEvent(tile, random);
+      fingerprints[i] = Fingerprint(tile);
+    }
+    assert(ehb.CountEventsInHistory() == EVENTS + 1);  // Plus the initial dummy event
+    assert(ehb.IsCursorAtAnEventEnd());
+    SPoint at;
+    assert(ehb.SiteOfCursor(at) && at == ctr);
+
+    for (u32 i = EVENTS; i > 0; --i)
+    {
+      assert(ehb.MoveCursorOlder());
+      assert(ehb.IsCursorAtAnEventStart());
+      assert(Fingerprint(tile) == fingerprints[i - 1]);
+      assert(ehb.MoveCursorOlder());
+      assert(ehb.IsCursorAtAnEventEnd());
+    }
+    assert(ehb.MoveCursorOlder());   // Through the dummy event
+    assert(!ehb.MoveCursorOlder());
+    assert(Fingerprint(tile) == fingerprints[0]);
+
+    assert(ehb.MoveCursor(2 * 5 + 1));  // Replay the dummy and five more
+    assert(Fingerprint(tile) == fingerprints[5]);
+    assert(ehb.MoveCursorToNewest());
+    assert(Fingerprint(tile) == fingerprints[EVENTS]);
+    assert(!ehb.MoveCursorNewer());
+  }
+
+  void EventHistoryBuffer_Test::Test_historyWraps()
+  {
+    enum { EVENTS = 5000 };
+    TestTile tile;
+    TestHistory & ehb = tile.GetEventHistoryBuffer();
+    Random random(2);
+
+    static u32 fingerprints[EVENTS + 1];
+    fingerprints[0] = Fingerprint(tile);
+    for (u32 i = 1; i <= EVENTS; ++i)
+    {
+      RecordEvent(tile, random);
+      fingerprints[i] = Fingerprint(tile);
+    }
+    const u32 kept = ehb.CountEventsInHistory();
+    assert(kept < EVENTS);
+    assert(ehb.GetBytesInHistory() <= TestGridConfig::EVENT_HISTORY_SIZE * sizeof(EventHistoryItem));
+
+    // The oldest event retained is event number EVENTS - kept + 1
+    assert(ehb.MoveCursorToOldest());
+    assert(Fingerprint(tile) == fingerprints[EVENTS - kept]);
+    assert(!ehb.MoveCursorOlder());
+    assert(ehb.MoveCursorToNewest());
+    assert(Fingerprint(tile) == fingerprints[EVENTS]);
+
+    // Recording leaves the cursor on the new event
+    RecordEvent(tile, random);
+    assert(ehb.IsCursorAtAnEventEnd());
+    assert(!ehb.MoveCursorNewer());
+  }
+
+  void EventHistoryBuffer_Test::Test_historySpill()
+  {
+    enum { EVENTS = 5000 };
+    TestTile tile;
+    TestHistory & ehb = tile.GetEventHistoryBuffer();
+    Random random(3);
+
+    const char * path = "/tmp/EventHistoryBuffer_Test.spill";
+    assert(ehb.SetSpillFile(path, 1 << 20));
+    assert(ehb.IsSpilling());
+
+    static u32 fingerprints[EVENTS + 1];
+    fingerprints[0] = Fingerprint(tile);
+    for (u32 i = 1; i <= EVENTS; ++i)
+    {
+      RecordEvent(tile, random);
+      fingerprints[i] = Fingerprint(tile);
+    }
+    assert(ehb.GetBytesInSpill() > 0);
+    assert(ehb.CountEventsInHistory() == EVENTS + 1);  // Nothing lost
+
+    // Rewind across the boundary into the spill file, and back
+    while (!ehb.IsCursorInSpill())
+    {
+      assert(ehb.MoveCursorOlder());
+    }
+    assert(ehb.MoveCursorToOldest());
+    assert(Fingerprint(tile) == fingerprints[0]);
+    assert(ehb.MoveCursorToNewest());
+    assert(!ehb.IsCursorInSpill());
+    assert(Fingerprint(tile) == fingerprints[EVENTS]);
+
+    ehb.CloseSpillFile();
+    unlink(path);
+    assert(!ehb.IsSpilling());
+    assert(ehb.CountEventsInHistory() < EVENTS);
+  }
+
+  void EventHistoryBuffer_Test::Test_historySpillWraps()
+  {
+    enum { EVENTS = 20000 };
+    TestTile tile;
+    TestHistory & ehb = tile.GetEventHistoryBuffer();
+    Random random(4);
+
+    // Room for just two compressed segments, so older ones get dropped
+    const char * path = "/tmp/EventHistoryBuffer_Test.spill";
+    assert(ehb.SetSpillFile(path, 2 * (EventHistorySpill::MAX_SEGMENT_PAYLOAD +
+                                       2 * EventHistoryRing::FRAME_BYTES)));
+
+    static u32 fingerprints[EVENTS + 1];
+    fingerprints[0] = Fingerprint(tile);
+    for (u32 i = 1; i <= EVENTS; ++i)
+    {
+      RecordEvent(tile, random);
+      fingerprints[i] = Fingerprint(tile);
+    }
+
+    // Records held, counting the initial dummy event, and lost
+    const u32 held = ehb.CountEventsInHistory();
+    assert(held < EVENTS);
+    const u32 lost = EVENTS + 1 - held;
+
+    // Back to the oldest event held, then forward through every
+    // segment and into memory, one event at a time
+    assert(ehb.MoveCursorToOldest());
+    assert(ehb.IsCursorInSpill());
+    assert(Fingerprint(tile) == fingerprints[lost - 1]);
+    for (u32 i = lost; i <= EVENTS; ++i)
+    {
+      assert(ehb.MoveCursorNewer());
+      assert(ehb.IsCursorAtAnEventEnd());
+      assert(Fingerprint(tile) == fingerprints[i]);
+      if (i < EVENTS)
+      {
+        assert(ehb.MoveCursorNewer());
+      }
+    }
+    assert(!ehb.IsCursorInSpill());
+    assert(!ehb.MoveCursorNewer());
+
+    ehb.CloseSpillFile();
+    unlink(path);
+  }
+
+} /* namespace MFM */
@@ -0,0 +1,120 @@
+#include "EventWindow_Bench.h"
+#include "Test_Common.h"
+#include "Element_Dreg.h"
+#include "Element_Res.h"
+
+namespace MFM {
+
+  enum { BENCH_EVENTS = 2000000, BENCH_AEPS = 1000 };
+
+  static void FillTile(TestTile & tile, u32 percentFull)
+  {
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Dreg<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Dreg<TestEventConfig>::THE_INSTANCE);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    Random & random = tile.GetRandom();
+    random.SetSeed(1);
+    const TestAtom dreg = Element_Dreg<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    const TestAtom res = Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    for (u32 x = 0; x < tile.OWNED_WIDTH; ++x)
+    {
+      for (u32 y = 0; y < tile.OWNED_HEIGHT; ++y)
+      {
+        if (random.OneIn(100 / percentFull))
+        {
+          tile.PlaceAtom(random.CreateBool() ? dreg : res,
+                         SPoint(x, y) + SPoint(tile.EVENT_WINDOW_RADIUS, tile.EVENT_WINDOW_RADIUS));
+        }
+      }
+    }
+  }
+
+  void EventWindow_Bench::Bench_events(u32 percentFull)
+  {
+    TestTile tile;
+    FillTile(tile, percentFull);
+
+    TestEventWindow & ew = tile.GetEventWindow();
+    u32 executed = 0;
+    BenchTimer timer;
+    for (u32 i = 0; i < BENCH_EVENTS; ++i)
+    {
+      if (ew.TryForceEventAt(tile.GetRandomOwnedCoord()))
+      {
+        ++executed;
+      }
+    }
+    double secs = timer.GetElapsedSeconds();
+
+    BenchOutput().Printf("  %d%% full: %d events in %d ms, %d events/sec\n",
+                         percentFull, executed, (u32) (secs * 1.0e3), (u32) (executed / secs));
+  }
+
+  void EventWindow_Bench::Bench_inertEvents(u32 percentFull)
+  {
+    for (u32 fast = 0; fast < 2; ++fast)
+    {
+      TestTile tile;
+      FillTile(tile, percentFull);
+
+      TestEventWindow & ew = tile.GetEventWindow();
+      u32 executed = 0;
+      BenchTimer timer;
+      for (u32 i = 0; i < BENCH_EVENTS; ++i)
+      {
+        const SPoint pt = tile.GetRandomOwnedCoord();
+        if (fast ? tile.TryEventAt(pt) : ew.TryEventAtForTesting(pt))
+        {
+          ++executed;
+        }
+      }
+      double secs = timer.GetElapsedSeconds();
+
+      BenchOutput().Printf("  %d%% full, %s: %d events (%d inert) in %d ms, %d events/sec\n",
+                           percentFull, fast ? "inert fast path" : "all in full",
+                           executed, (u32) tile.GetInertEventsExecuted(),
+                           (u32) (secs * 1.0e3), (u32) (executed / secs));
+    }
+  }
+
+  void EventWindow_Bench::Bench_sampling(u32 percentFull)
+  {
+    for (u32 occupied = 0; occupied < 2; ++occupied)
+    {
+      TestTile tile;
+      FillTile(tile, percentFull);
+      tile.SetSiteSampling(occupied ? SITE_SAMPLING_OCCUPIED : SITE_SAMPLING_UNIFORM);
+
+      // Run to the same AEPS either way
+      const u64 target = BENCH_AEPS * tile.GetSites();
+      BenchTimer timer;
+      while (tile.GetEventsExecuted() < target)
+      {
+        tile.TryRandomEvent();
+      }
+      double secs = timer.GetElapsedSeconds();
+
+      const u64 run = tile.GetEventsExecuted() - tile.GetInertEventsExecuted();
+      BenchOutput().Printf("  %d%% full, %s sampling: %d AEPS (%d events run, %d%% full at end) in %d ms\n",
+                           percentFull, occupied ? "occupied" : "uniform",
+                           (u32) BENCH_AEPS, (u32) run,
+                           100 * tile.GetOccupiedSiteCount() / tile.GetSites(),
+                           (u32) (secs * 1.0e3));
+    }
+  }
+
+  void EventWindow_Bench::Bench_RunBenchmarks()
+  {
+    Bench_events(1);
+    Bench_events(10);
+    Bench_inertEvents(1);
+    Bench_inertEvents(10);
+    Bench_sampling(1);
+    Bench_sampling(5);
+    Bench_sampling(25);
+  }
+
+} /* namespace MFM */
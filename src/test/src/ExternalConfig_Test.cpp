@@ -13,6 +13,7 @@ namespace MFM
   struct TestDriver : public AbstractDriver<TestGridConfig>
   {
     TestDriver() : AbstractDriver<TestGridConfig>(1,1,GRID_LAYOUT_CHECKERBOARD) { }
+    TestDriver(u32 width, u32 height) : AbstractDriver<TestGridConfig>(width,height,GRID_LAYOUT_CHECKERBOARD) { }
     void ReinitEden() { FAIL(ILLEGAL_STATE); }
     void DefineNeededElements() { FAIL(ILLEGAL_STATE); }
   };
@@ -47,8 +48,46 @@ namespace MFM
 
   }
 
+  static void TestSnapshotRoundTrip()
+  {
+    TestDriver td(2,2);
+    td.RegisterExternalConfigSections();
+
+    TestGrid & grid = td.GetGrid();
+    grid.Needed(Element_Empty<TestEventConfig>::THE_INSTANCE);
+    grid.Needed(Element_Dreg<TestEventConfig>::THE_INSTANCE);
+    grid.SetSeed(1);
+    grid.Init();
+
+    const TestAtom dreg = Element_Dreg<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    const u32 dregType = dreg.GetType();
+    SPoint spots[] = { SPoint(0,0), SPoint(17,30), SPoint(45,3),
+                       SPoint(grid.GetWidthSites() - 1, grid.GetHeightSites() - 1) };
+    const u32 spotCount = sizeof(spots) / sizeof(spots[0]);
+    for (u32 i = 0; i < spotCount; ++i)
+    {
+      grid.PlaceAtom(dreg, spots[i]);
+    }
+
+    const char * path = "/tmp/ExternalConfig_Test.mfb";
+    td.SaveGrid(path);
+    grid.Clear();
+    assert(grid.GetAtom(spots[1])->GetType() != dregType);
+
+    assert(td.LoadMFS(path));
+    unlink(path);
+
+    for (u32 i = 0; i < spotCount; ++i)
+    {
+      assert(grid.GetAtom(spots[i])->GetType() == dregType);
+    }
+    SPoint elsewhere(20,20);
+    assert(grid.GetAtom(elsewhere)->GetType() != dregType);
+  }
+
   void ExternalConfig_Test::Test_RunTests()
   {
     TestBasic();
+    TestSnapshotRoundTrip();
   }
 }
@@ -0,0 +1,108 @@
+#include "Fail_Bench.h"
+#include "Fail.h"
+#include "Test_Common.h"
+#include "Element_Res.h"
+
+namespace MFM {
+
+  enum { BENCH_ENTRIES = 20000000, BENCH_EVENTS = 2000000 };
+
+  static volatile u32 benchSink;
+
+  static void Behave(u32 i)
+  {
+    benchSink = i;
+  }
+
+  // Called through a volatile pointer, as a virtual Behavior would
+  // be, so the compiler can't see that it never fails
+  static void (* volatile behave)(u32) = &Behave;
+
+  static double NsPerEntry(double secs)
+  {
+    return secs * 1.0e9 / BENCH_ENTRIES;
+  }
+
+  static void Report(const char * what, double ns)
+  {
+    BenchOutput().Printf("  %s: %d.%02d ns\n", what, (u32) ns, ((u32) (ns * 100)) % 100);
+  }
+
+  void Fail_Bench::Bench_boundaries()
+  {
+    BenchTimer none;
+    for (u32 i = 0; i < BENCH_ENTRIES; ++i)
+    {
+      behave(i);
+    }
+    const double noneNs = NsPerEntry(none.GetElapsedSeconds());
+
+    BenchTimer full;
+    for (u32 i = 0; i < BENCH_ENTRIES; ++i)
+    {
+      unwind_protect({ benchSink = 0; },{ behave(i); });
+    }
+    const double fullNs = NsPerEntry(full.GetElapsedSeconds());
+
+    BenchTimer light;
+    for (u32 i = 0; i < BENCH_ENTRIES; ++i)
+    {
+      unwind_protect_light({ benchSink = 0; },{ behave(i); });
+    }
+    const double lightNs = NsPerEntry(light.GetElapsedSeconds());
+
+    Report("no boundary (per call)", noneNs);
+    Report("unwind_protect (per call)", fullNs);
+    Report("unwind_protect_light (per call)", lightNs);
+  }
+
+  static u32 EventsPerSecond(TestTile & tile)
+  {
+    TestEventWindow & ew = tile.GetEventWindow();
+    u32 executed = 0;
+    BenchTimer timer;
+    for (u32 i = 0; i < BENCH_EVENTS; ++i)
+    {
+      if (ew.TryForceEventAt(tile.GetRandomOwnedCoord()))
+      {
+        ++executed;
+      }
+    }
+    return (u32) (executed / timer.GetElapsedSeconds());
+  }
+
+  void Fail_Bench::Bench_events()
+  {
+    // A tile full of Res, whose behavior is about as tight as it gets
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    const TestAtom res = Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    for (u32 x = 0; x < tile.OWNED_WIDTH; ++x)
+    {
+      for (u32 y = 0; y < tile.OWNED_HEIGHT; ++y)
+      {
+        tile.PlaceAtom(res, SPoint(x, y) + SPoint(tile.EVENT_WINDOW_RADIUS, tile.EVENT_WINDOW_RADIUS));
+      }
+    }
+
+    TestEventWindow & ew = tile.GetEventWindow();
+
+    // The same tile, behind each boundary in turn
+    ew.SetFullFailBoundaryForTesting(true);
+    const u32 fullRate = EventsPerSecond(tile);
+    ew.SetFullFailBoundaryForTesting(false);
+    const u32 lightRate = EventsPerSecond(tile);
+
+    BenchOutput().Printf("  Res events, full boundary: %d events/sec\n", fullRate);
+    BenchOutput().Printf("  Res events, light boundary: %d events/sec\n", lightRate);
+  }
+
+  void Fail_Bench::Bench_RunBenchmarks()
+  {
+    Bench_boundaries();
+    Bench_events();
+  }
+
+} /* namespace MFM */
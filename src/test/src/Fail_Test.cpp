@@ -12,6 +12,8 @@ namespace MFM {
     Test_FailWithCode();
     Test_NestedFail();
     Test_UnsafeModification();
+    Test_LightFail();
+    Test_MixedNestedFail();
   }
 
   void Fail_Test::Test_NoFail()
@@ -134,5 +136,66 @@ namespace MFM {
     // But it's still unreliable and unsafe so we can't do it!)
   }
 
+  void Fail_Test::Test_LightFail()
+  {
+    bool failed = false;
+    int codeCapture = 0;
+    const char * fileCapture = 0;
+    for (int i = 10; i < 12; ++i) {
+      unwind_protect_light({
+          failed = true;
+          codeCapture = MFMThrownFailCode;
+          fileCapture = MFMThrownFromFile;
+        },{
+          if (i > 10)
+            FAIL(OUT_OF_ROOM);
+        });
+      if (i==10) {
+        assert(failed==false);
+      } else {
+        assert(failed==true);
+        assert(codeCapture==MFM_FAIL_CODE_NUMBER(OUT_OF_ROOM));
+        assert(fileCapture != 0);
+      }
+    }
+  }
+
+  static void failLightHelper(int * pnum) {
+    bool failed = false;
+    unwind_protect_light({ failed = true; },{ FAIL(ILLEGAL_STATE); });
+    assert(failed==true);
+    *pnum = 3;
+    FAIL(ILLEGAL_ARGUMENT);
+  }
+
+  void Fail_Test::Test_MixedNestedFail()
+  {
+    // A light boundary inside a full one, and the reverse
+    bool failed = false;
+    int num = 0;
+    int codeCapture = 0;
+    unwind_protect({
+        failed = true;
+        codeCapture = MFMThrownFailCode;
+      },{
+        failLightHelper(&num);
+        FAIL(UNREACHABLE_CODE);
+      });
+    assert(failed==true);
+    assert(num==3);
+    assert(codeCapture==MFM_FAIL_CODE_NUMBER(ILLEGAL_ARGUMENT));
+
+    failed = false;
+    codeCapture = 0;
+    unwind_protect_light({
+        failed = true;
+        codeCapture = MFMThrownFailCode;
+      },{
+        failIllegalArgumentHelper(&num);
+        FAIL(UNREACHABLE_CODE);
+      });
+    assert(failed==true);
+    assert(codeCapture==MFM_FAIL_CODE_NUMBER(ILLEGAL_ARGUMENT));
+  }
 
 } /* namespace MFM */
@@ -0,0 +1,101 @@
+#include "FrameRenderer_Bench.h"
+#include "Test_Common.h"
+#include "FrameRenderer.h"
+#include "FrameWriter.h"
+#include "ElementRegistry.h"
+#include "Element_Dreg.h"
+#include "Element_Res.h"
+
+namespace MFM {
+
+  typedef FrameRenderer<TestGridConfig> BenchFrameRenderer;
+
+  enum { BENCH_SECONDS = 1 };
+
+  /**
+   * Frames per second rendering grid, and if pngPath or pipe is
+   * non-null, writing each frame there too.
+   */
+  static double Bench_fps(BenchFrameRenderer & renderer, const TestGrid & grid,
+                          const char * pngPath, FrameWriter * pipe)
+  {
+    u32 frames = 0;
+    BenchTimer timer;
+    while (timer.GetElapsedSeconds() < BENCH_SECONDS)
+    {
+      renderer.Render(grid);
+      if (pngPath)
+      {
+        FrameWriter::WritePNG(pngPath, renderer.GetPixels(), renderer.GetWidth(), renderer.GetHeight());
+      }
+      if (pipe)
+      {
+        pipe->WriteToPipe(renderer.GetPixels(), renderer.GetWidth(), renderer.GetHeight());
+      }
+      ++frames;
+    }
+    return frames / timer.GetElapsedSeconds();
+  }
+
+  void FrameRenderer_Bench::Bench_render(u32 width, u32 height, u32 percentFull)
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg, width, height, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+    grid.Needed(Element_Dreg<TestEventConfig>::THE_INSTANCE);
+    grid.Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+    grid.SetSeed(1);
+    grid.Init();
+
+    Random & random = grid.GetRandom();
+    const TestAtom dreg = Element_Dreg<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    const TestAtom res = Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    for (u32 x = 0; x < grid.GetWidthSites(); ++x)
+    {
+      for (u32 y = 0; y < grid.GetHeightSites(); ++y)
+      {
+        if (random.OneIn(100 / percentFull))
+        {
+          grid.PlaceAtom(random.CreateBool() ? dreg : res, SPoint(x, y));
+        }
+      }
+    }
+
+    BenchOutput().Printf("  %dx%d tiles, %dx%d sites, %d%% full\n",
+                         width, height, grid.GetWidthSites(), grid.GetHeightSites(), percentFull);
+
+    const u32 scales[] = { 1, 4 };
+    const u32 threads[] = { 1, 2, 4, 8 };
+    for (u32 s = 0; s < sizeof(scales) / sizeof(scales[0]); ++s)
+    {
+      for (u32 t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t)
+      {
+        BenchFrameRenderer renderer;
+        renderer.SetSitePixels(scales[s]);
+        renderer.SetThreads(threads[t]);
+        BenchOutput().Printf("    render %dpx/site, %d threads: %f fps\n",
+                             scales[s], threads[t], Bench_fps(renderer, grid, 0, 0));
+      }
+    }
+
+    BenchFrameRenderer renderer;
+    renderer.SetSitePixels(2);
+    renderer.SetThreads(4);
+
+    const char * path = "/tmp/FrameRenderer_Bench.png";
+    BenchOutput().Printf("    render+png 2px/site, 4 threads: %f fps\n",
+                         Bench_fps(renderer, grid, path, 0));
+    unlink(path);
+
+    FrameWriter pipe;
+    pipe.OpenPipe("cat > /dev/null");
+    BenchOutput().Printf("    render+pipe 2px/site, 4 threads: %f fps\n",
+                         Bench_fps(renderer, grid, 0, &pipe));
+    pipe.ClosePipe();
+  }
+
+  void FrameRenderer_Bench::Bench_RunBenchmarks()
+  {
+    Bench_render(16, 10, 30);
+  }
+
+} /* namespace MFM */
@@ -0,0 +1,90 @@
+#include "GridSnapshot_Bench.h"
+#include "Test_Common.h"
+#include "AbstractDriver.h"
+#include "Element_Dreg.h"
+#include "Element_Res.h"
+#include <sys/stat.h>  /* For stat */
+
+namespace MFM {
+
+  enum { BENCH_REPEATS = 3 };
+
+  struct SnapshotBenchDriver : public AbstractDriver<TestGridConfig>
+  {
+    SnapshotBenchDriver(u32 width, u32 height)
+      : AbstractDriver<TestGridConfig>(width, height, GRID_LAYOUT_CHECKERBOARD)
+    { }
+    void ReinitEden() { FAIL(ILLEGAL_STATE); }
+    void DefineNeededElements() { FAIL(ILLEGAL_STATE); }
+  };
+
+  static u32 FileKB(const char * path)
+  {
+    struct stat st;
+    return stat(path, &st) ? 0 : (u32) (st.st_size >> 10);
+  }
+
+  static void Bench_one(SnapshotBenchDriver & driver, const char * path)
+  {
+    BenchTimer save;
+    for (u32 i = 0; i < BENCH_REPEATS; ++i)
+    {
+      driver.SaveGrid(path);
+    }
+    double saveSecs = save.GetElapsedSeconds() / BENCH_REPEATS;
+
+    BenchTimer load;
+    for (u32 i = 0; i < BENCH_REPEATS; ++i)
+    {
+      driver.LoadMFS(path);
+    }
+    double loadSecs = load.GetElapsedSeconds() / BENCH_REPEATS;
+
+    BenchOutput().Printf("    %s: save %f ms, load %f ms, %d KB\n",
+                         path, saveSecs * 1.0e3, loadSecs * 1.0e3, FileKB(path));
+    unlink(path);
+  }
+
+  void GridSnapshot_Bench::Bench_saveLoad(u32 width, u32 height, u32 percentFull)
+  {
+    SnapshotBenchDriver driver(width, height);
+    driver.RegisterExternalConfigSections();
+
+    TestGrid & grid = driver.GetGrid();
+    grid.Needed(Element_Empty<TestEventConfig>::THE_INSTANCE);
+    grid.Needed(Element_Dreg<TestEventConfig>::THE_INSTANCE);
+    grid.Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+    grid.SetSeed(1);
+    grid.Init();
+
+    Random & random = grid.GetRandom();
+    const TestAtom dreg = Element_Dreg<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    const TestAtom res = Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    u32 placed = 0;
+    for (u32 x = 0; x < grid.GetWidthSites(); ++x)
+    {
+      for (u32 y = 0; y < grid.GetHeightSites(); ++y)
+      {
+        if (random.OneIn(100 / percentFull))
+        {
+          grid.PlaceAtom(random.CreateBool() ? dreg : res, SPoint(x, y));
+          ++placed;
+        }
+      }
+    }
+
+    BenchOutput().Printf("  %dx%d tiles, %d%% full, %d atoms\n",
+                         width, height, percentFull, placed);
+
+    Bench_one(driver, "/tmp/GridSnapshot_Bench.mfs");
+    Bench_one(driver, "/tmp/GridSnapshot_Bench.mfb");
+  }
+
+  void GridSnapshot_Bench::Bench_RunBenchmarks()
+  {
+    Bench_saveLoad(2, 2, 10);
+    Bench_saveLoad(5, 3, 10);
+    Bench_saveLoad(5, 3, 50);
+  }
+
+} /* namespace MFM */
@@ -13,8 +13,8 @@ namespace MFM {
     assert(pt.CanRead(true) == 0);
     assert(pt.CanRead(false) == 0);
 
-    assert(pt.CanWrite(true) == GridTransceiver::BUFFER_SIZE - 1);
-    assert(pt.CanWrite(false) == GridTransceiver::BUFFER_SIZE - 1);
+    assert(pt.CanWrite(true) == pt.GetBufferSize() - 1);
+    assert(pt.CanWrite(false) == pt.GetBufferSize() - 1);
 
     assert(pt.CanXmit(true) == 0);
     assert(pt.CanXmit(false) == 0);
@@ -222,9 +222,94 @@ namespace MFM {
     assert(pt.CanRead(false) == 13 + 11);
   }
 
+  void GridTransceiver_Test::Test_Unthrottled() {
+    GridTransceiver pt;
+    assert(pt.IsThrottled());  // default
+
+    pt.SetThrottled(false);
+    assert(!pt.IsThrottled());
+
+    pt.SetEnabled(true);
+
+    const char * data = "abcdefghij";
+    const u32 slen = strlen(data);
+
+    assert(pt.Write(true, (const u8*) data, slen) == slen);
+
+    // Readable immediately; nothing modeled in the air
+    assert(pt.CanRead(false) == slen);
+    assert(pt.CanRead(true) == 0);
+    assert(pt.CanXmit(true) == 0);
+    assert(pt.CanRcv(false) == 0);
+
+    // Advancing is a no-op
+    assert(!pt.Advance(1000 * 1000 * 1000));
+    assert(pt.CanRead(false) == slen);
+
+    u8 buff[20];
+    assert(pt.Read(false, buff, sizeof(buff)) == slen);
+    assert(!memcmp(buff, data, slen));
+    assert(pt.CanRead(false) == 0);
+    assert(pt.CanWrite(true) == pt.GetBufferSize() - 1);
+
+    bool failed = false;
+    unwind_protect(
+    {
+      failed = true;
+    },
+    {
+      pt.SetThrottled(true);  // Too late once enabled
+    });
+    assert(failed);
+  }
+
+  void GridTransceiver_Test::Test_BufferSize() {
+    GridTransceiver pt;
+    assert(pt.GetBufferSize() == GridTransceiver::DEFAULT_BUFFER_SIZE);
+
+    bool failed = false;
+    unwind_protect({ failed = true; }, { pt.SetBufferSize(100); });
+    assert(failed);  // Not a power of two
+
+    pt.SetBufferSize(GridTransceiver::MIN_BUFFER_SIZE);
+    pt.SetThrottled(false);
+    pt.SetEnabled(true);
+    assert(pt.GetBufferSize() == GridTransceiver::MIN_BUFFER_SIZE);
+    assert(pt.CanWrite(false) == GridTransceiver::MIN_BUFFER_SIZE - 1);
+
+    // Push enough through to wrap around the buffer several times
+    u8 out[13], in[13];
+    u8 next = 0, expect = 0;
+    for (u32 i = 0; i < 500; ++i)
+    {
+      for (u32 j = 0; j < sizeof(out); ++j)
+      {
+        out[j] = next++;
+      }
+      assert(pt.Write(false, out, sizeof(out)) == sizeof(out));
+      assert(pt.Read(true, in, sizeof(in)) == sizeof(in));
+      for (u32 j = 0; j < sizeof(in); ++j)
+      {
+        assert(in[j] == expect++);
+      }
+    }
+
+    // Can't overfill
+    u8 big[GridTransceiver::MIN_BUFFER_SIZE * 2];
+    memset(big, 0, sizeof(big));
+    assert(pt.Write(false, big, sizeof(big)) == GridTransceiver::MIN_BUFFER_SIZE - 1);
+    assert(pt.CanWrite(false) == 0);
+
+    failed = false;
+    unwind_protect({ failed = true; }, { pt.SetBufferSize(4096); });
+    assert(failed);  // Too late once enabled
+  }
+
   void GridTransceiver_Test::Test_RunTests() {
     Test_Basic();
     Test_DataRates();
+    Test_Unthrottled();
+    Test_BufferSize();
   }
 
 } /* namespace MFM */
@@ -2,6 +2,10 @@
 #include "Grid.h"
 #include "Grid_Test.h"
 #include "Element_Res.h"
+#include "Element_Dreg.h"
+#include "OverflowableCharBufferByteSink.h"
+#include "FrameRenderer.h"
+#include <string.h>
 
 namespace MFM {
 
@@ -27,4 +31,141 @@ namespace MFM {
     assert(out->GetType() == atom.GetType());
 
   }
+
+  void Grid_Test::Test_gridSchedulerWorkers()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,4,3, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetSchedulerWorkers(3);
+    grid.Init();
+    grid.InitThreads();
+    assert(grid.GetSchedulerWorkers() == 3);
+
+    grid.Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    for (u32 i = 0; i < 20; ++i)
+    {
+      grid.PlaceAtom(atom, SPoint(5 + 7 * i % 80, 3 + 5 * i % 50));
+    }
+
+    grid.Unpause();
+    SleepMsec(200);
+    grid.Pause();
+
+    u64 workerEvents = 0;
+    for (u32 w = 0; w < grid.GetSchedulerWorkers(); ++w)
+    {
+      workerEvents += grid.GetWorkerEventsExecuted(w);
+    }
+    assert(workerEvents > 0);
+    assert(workerEvents <= grid.GetTotalEventsExecuted());
+
+    grid.ShutdownTileThreads();
+  }
+
+  void Grid_Test::Test_gridElementProfile()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,2,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.SetSchedulerWorkers(2);
+    grid.Init();
+    grid.InitThreads();
+    assert(grid.GetElementProfiling() == 0);
+    grid.SetElementProfiling(4);
+    assert(grid.GetElementProfiling() == 4);
+
+    grid.Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+    grid.Needed(Element_Dreg<TestEventConfig>::THE_INSTANCE);
+
+    TestAtom dreg(Element_Dreg<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    for (u32 i = 0; i < 20; ++i)
+    {
+      grid.PlaceAtom(dreg, SPoint(5 + 7 * i % 50, 3 + 5 * i % 50));
+    }
+
+    grid.Unpause();
+    SleepMsec(200);
+    grid.Pause();
+
+    OString4096 report;
+    grid.WriteElementProfile(report, 2);
+    assert(!report.HasOverflowed());
+
+    // Header, column names, then at most two elements, Dreg among them
+    const char * zs = report.GetZString();
+    assert(!strncmp(zs, "# Element profile: 1 in 4 events,", 33));
+    assert(strstr(zs, "\n# rank symbol name samples share% lock load behave store\n1 ") != 0);
+    assert(strstr(zs, " Dr Dreg ") != 0);
+    assert(strstr(zs, "\n3 ") == 0);
+
+    grid.ShutdownTileThreads();
+  }
+
+  void Grid_Test::Test_gridFrameRenderer()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,2,2, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.Init();
+    grid.Needed(Element_Dreg<TestEventConfig>::THE_INSTANCE);
+
+    const SPoint at(7, 4);
+    grid.PlaceAtom(Element_Dreg<TestEventConfig>::THE_INSTANCE.GetDefaultAtom(), at);
+
+    typedef FrameRenderer<TestGridConfig> TestFrameRenderer;
+    enum { SCALE = 3 };
+    TestFrameRenderer single, pooled;
+    single.SetSitePixels(SCALE);
+    single.SetForegroundType(TestFrameRenderer::OurSiteColorer::DRAW_SITE_ELEMENT);
+    pooled.SetSitePixels(SCALE);
+    pooled.SetForegroundType(TestFrameRenderer::OurSiteColorer::DRAW_SITE_ELEMENT);
+    pooled.SetThreads(3);
+
+    single.Render(grid);
+    pooled.Render(grid);
+    pooled.Render(grid);
+    assert(pooled.GetFramesRendered() == 2);
+
+    const u32 width = single.GetWidth();
+    assert(width == grid.GetWidthSites() * SCALE);
+    assert(single.GetHeight() == grid.GetHeightSites() * SCALE);
+    assert(!memcmp(single.GetPixels(), pooled.GetPixels(), width * single.GetHeight() * 4));
+
+    // Every pixel of the Dreg's site is its color, in RGBA order
+    const u32 color = Element_Dreg<TestEventConfig>::THE_INSTANCE.GetStaticColor();
+    const u8 * pixels = single.GetPixels();
+    for (u32 y = 0; y < SCALE; ++y)
+    {
+      for (u32 x = 0; x < SCALE; ++x)
+      {
+        const u8 * p = &pixels[((at.GetY() * SCALE + y) * width + at.GetX() * SCALE + x) * 4];
+        assert(p[0] == (u8) (color >> 16));
+        assert(p[1] == (u8) (color >> 8));
+        assert(p[2] == (u8) color);
+        assert(p[3] == (u8) (color >> 24));
+      }
+    }
+
+    // Its empty neighbor shows the dark tile background
+    const u32 * words = (const u32 *) pixels;
+    assert(words[at.GetY() * SCALE * width + (at.GetX() + 1) * SCALE] ==
+           TestFrameRenderer::ToPixel(Drawable::GREY20));
+
+    // Dynamic colors are computed once, then come from the cache
+    TestFrameRenderer dynamic;
+    dynamic.SetSitePixels(SCALE);
+    dynamic.Render(grid);
+    assert(dynamic.GetColorCacheMisses() == 1);
+    assert(dynamic.GetColorCacheHits() == 0);
+    dynamic.Render(grid);
+    assert(dynamic.GetColorCacheMisses() == 1);
+    assert(dynamic.GetColorCacheHits() == 1);
+    assert(!memcmp(single.GetPixels(), dynamic.GetPixels(), width * single.GetHeight() * 4));
+  }
 } /* namespace MFM */
@@ -0,0 +1,97 @@
+#include "LonglivedLock_Bench.h"
+#include <pthread.h>
+
+namespace MFM {
+
+  enum { BENCH_MAX_THREADS = 8, BENCH_ITERATIONS = 2000000 };
+
+  template <class LOCK>
+  struct LonglivedLockBenchThread
+  {
+    pthread_t m_thread;
+    LOCK * m_locks;
+    u32 m_lockCount;
+    u32 m_index;
+    u32 m_acquired;
+    MFMErrorEnvironmentPointer_t m_errorStackTop;
+
+    static void * Run(void * arg)
+    {
+      LonglivedLockBenchThread & t = *(LonglivedLockBenchThread *) arg;
+      t.m_errorStackTop = 0;
+      MFMPtrToErrEnvStackPtr = &t.m_errorStackTop;
+
+      // Walk the locks from a per-thread offset, roughly like a tile
+      // trying each of its edges in turn
+      u32 which = t.m_index;
+      for (u32 i = 0; i < BENCH_ITERATIONS; ++i)
+      {
+        LOCK & lock = t.m_locks[which];
+        if (lock.TryLock(&t))
+        {
+          ++t.m_acquired;
+          lock.Unlock(&t);
+        }
+        if (++which >= t.m_lockCount)
+        {
+          which = 0;
+        }
+      }
+      return NULL;
+    }
+  };
+
+  template <class LOCK>
+  void LonglivedLock_Bench::Bench_contention(const char * name, u32 threads, u32 locks)
+  {
+    LOCK lockArray[BENCH_MAX_THREADS];
+    LonglivedLockBenchThread<LOCK> t[BENCH_MAX_THREADS];
+
+    BenchTimer timer;
+    for (u32 i = 0; i < threads; ++i)
+    {
+      t[i].m_locks = lockArray;
+      t[i].m_lockCount = locks;
+      t[i].m_index = i % locks;
+      t[i].m_acquired = 0;
+      if (pthread_create(&t[i].m_thread, NULL, LonglivedLockBenchThread<LOCK>::Run, &t[i]))
+      {
+        FAIL(ILLEGAL_STATE);
+      }
+    }
+
+    u64 acquired = 0;
+    for (u32 i = 0; i < threads; ++i)
+    {
+      pthread_join(t[i].m_thread, NULL);
+      acquired += t[i].m_acquired;
+    }
+    double secs = timer.GetElapsedSeconds();
+
+    u64 contention = 0;
+    for (u32 i = 0; i < locks; ++i)
+    {
+      contention += lockArray[i].GetContentionCount();
+    }
+
+    u64 attempts = ((u64) threads) * BENCH_ITERATIONS;
+    BenchOutput().Printf("  %s %d threads %d locks: %f Mtrylock/sec, %f%% acquired, %f%% contended\n",
+                         name, threads, locks,
+                         attempts / secs / 1.0e6,
+                         100.0 * acquired / attempts,
+                         100.0 * contention / attempts);
+  }
+
+  void LonglivedLock_Bench::Bench_RunBenchmarks()
+  {
+    const u32 threadCounts[] = { 2, 4, 8 };
+    for (u32 i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); ++i)
+    {
+      u32 threads = threadCounts[i];
+      Bench_contention<MutexLonglivedLock>("Mutex", threads, 1);
+      Bench_contention<CASLonglivedLock>  ("CAS  ", threads, 1);
+      Bench_contention<MutexLonglivedLock>("Mutex", threads, threads);
+      Bench_contention<CASLonglivedLock>  ("CAS  ", threads, threads);
+    }
+  }
+} /* namespace MFM */
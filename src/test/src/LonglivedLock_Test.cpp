@@ -0,0 +1,80 @@
+#include "LonglivedLock_Test.h"
+#include <assert.h>  /* For assert */
+
+namespace MFM {
+
+  void LonglivedLock_Test::Test_RunTests()
+  {
+    Test_lockUnlock<MutexLonglivedLock>();
+    Test_selfRelockFails<MutexLonglivedLock>();
+    Test_contentionCount<MutexLonglivedLock>();
+
+    Test_lockUnlock<CASLonglivedLock>();
+    Test_selfRelockFails<CASLonglivedLock>();
+    Test_contentionCount<CASLonglivedLock>();
+  }
+
+  template <class LOCK>
+  void LonglivedLock_Test::Test_lockUnlock()
+  {
+    LOCK lock;
+    int a, b;
+    assert(lock.GetOwnerIndex() == 0);
+
+    assert(lock.TryLock(&a));
+    assert(lock.GetOwnerIndex() == &a);
+    assert(!lock.TryLock(&b));
+
+    assert(lock.Unlock(&a));
+    assert(lock.GetOwnerIndex() == 0);
+
+    assert(lock.TryLock(&b));
+    assert(lock.GetOwnerIndex() == &b);
+    assert(lock.Unlock(&b));
+  }
+
+  template <class LOCK>
+  void LonglivedLock_Test::Test_selfRelockFails()
+  {
+    LOCK lock;
+    int a, b;
+    assert(lock.TryLock(&a));
+
+    bool failed = false;
+    unwind_protect({
+        failed = true;
+        assert(MFMThrownFailCode == MFM_FAIL_CODE_REASON_LOCK_FAILURE);
+      },{
+        lock.TryLock(&a);
+      });
+    assert(failed);
+
+    failed = false;
+    unwind_protect({
+        failed = true;
+        assert(MFMThrownFailCode == MFM_FAIL_CODE_REASON_LOCK_FAILURE);
+      },{
+        lock.Unlock(&b);   // Not the owner
+      });
+    assert(failed);
+
+    assert(lock.GetOwnerIndex() == &a);
+    assert(lock.Unlock(&a));
+  }
+
+  template <class LOCK>
+  void LonglivedLock_Test::Test_contentionCount()
+  {
+    LOCK lock;
+    int a, b;
+    assert(lock.GetContentionCount() == 0);
+    assert(lock.TryLock(&a));
+    assert(!lock.TryLock(&b));
+    assert(!lock.TryLock(&b));
+    assert(lock.GetContentionCount() == 2);
+    assert(lock.Unlock(&a));
+    assert(lock.TryLock(&b));
+    assert(lock.GetContentionCount() == 2);
+    assert(lock.Unlock(&b));
+  }
+} /* namespace MFM */
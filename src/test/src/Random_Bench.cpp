@@ -0,0 +1,117 @@
+#include "Random_Bench.h"
+#include "Random.h"
+#include "Test_Common.h"
+#include "Element_Dreg.h"
+#include "Element_Res.h"
+
+namespace MFM {
+
+  enum { BENCH_DRAWS = 50000000, BENCH_BATCH = 1024, BENCH_EVENTS = 2000000 };
+
+  static volatile u32 benchSink;
+
+  static void Report(const char * what, double secs)
+  {
+    const double ns = secs * 1.0e9 / BENCH_DRAWS;
+    BenchOutput().Printf("  %s: %d.%02d ns\n", what, (u32) ns, ((u32) (ns * 100)) % 100);
+  }
+
+  void Random_Bench::Bench_generators()
+  {
+    u32 sum = 0;
+
+    RandMT mt;
+    mt.seedMT_MFM(1);
+    BenchTimer mtTimer;
+    for (u32 i = 0; i < BENCH_DRAWS; ++i)
+    {
+      sum += mt.randomMT();
+    }
+    Report("RandMT (per draw)", mtTimer.GetElapsedSeconds());
+
+    RandXoshiro xo;
+    xo.Seed(1);
+    BenchTimer xoTimer;
+    for (u32 i = 0; i < BENCH_DRAWS; ++i)
+    {
+      sum += xo.Next32();
+    }
+    Report("RandXoshiro (per draw)", xoTimer.GetElapsedSeconds());
+
+    benchSink = sum;
+  }
+
+  void Random_Bench::Bench_random()
+  {
+#ifdef MFM_RANDOM_XOSHIRO
+    BenchOutput().Printf("  Random is using RandXoshiro\n");
+#else
+    BenchOutput().Printf("  Random is using RandMT\n");
+#endif
+    Random random(1);
+    u32 sum = 0;
+
+    BenchTimer create;
+    for (u32 i = 0; i < BENCH_DRAWS; ++i)
+    {
+      sum += random.Create();
+    }
+    Report("Create() (per draw)", create.GetElapsedSeconds());
+
+    BenchTimer bounded;
+    for (u32 i = 0; i < BENCH_DRAWS; ++i)
+    {
+      sum += random.Create(41);
+    }
+    Report("Create(41) (per draw)", bounded.GetElapsedSeconds());
+
+    static u32 batch[BENCH_BATCH];
+    BenchTimer fill;
+    for (u32 i = 0; i < BENCH_DRAWS; i += BENCH_BATCH)
+    {
+      random.Fill(batch, BENCH_BATCH);
+      sum += batch[i % BENCH_BATCH];
+    }
+    Report("Fill (per draw)", fill.GetElapsedSeconds());
+
+    benchSink = sum;
+  }
+
+  void Random_Bench::Bench_events()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Dreg<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Dreg<TestEventConfig>::THE_INSTANCE);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    tile.GetRandom().SetSeed(1);
+    tile.PlaceAtom(Element_Dreg<TestEventConfig>::THE_INSTANCE.GetDefaultAtom(),
+                   SPoint(tile.TILE_WIDTH / 2, tile.TILE_WIDTH / 2));
+
+    // Let the Dreg populate the tile, then time it
+    u32 executed = 0;
+    for (u32 i = 0; i < BENCH_EVENTS; ++i)
+    {
+      tile.TryRandomEvent();
+    }
+    BenchTimer timer;
+    for (u32 i = 0; i < BENCH_EVENTS; ++i)
+    {
+      if (tile.TryRandomEvent())
+      {
+        ++executed;
+      }
+    }
+    const double secs = timer.GetElapsedSeconds();
+    BenchOutput().Printf("  Dreg/Res tile: %d events/sec\n", (u32) (executed / secs));
+  }
+
+  void Random_Bench::Bench_RunBenchmarks()
+  {
+    Bench_generators();
+    Bench_random();
+    Bench_events();
+  }
+
+} /* namespace MFM */
@@ -7,6 +7,9 @@ namespace MFM {
   void Random_Test::Test_RunTests() {
     Test_randomSetSeed();
     Test_randomDeterministics();
+    Test_randomFill();
+    Test_randomStreamSeeds();
+    Test_randomXoshiro();
   }
 
   Random & Random_Test::setup()
@@ -70,4 +73,61 @@ namespace MFM {
     }
   }
 
+  void Random_Test::Test_randomFill()
+  {
+    const u32 NUMS = 100;
+    u32 filled[NUMS];
+    Random r1(7), r2(7);
+
+    // Bulk draws are the same stream as one-at-a-time draws
+    r1.Fill(filled, NUMS);
+    for (u32 i = 0; i < NUMS; ++i) {
+      assert(filled[i] == r2.Create());
+    }
+
+    r1.FillBelow(filled, NUMS, 37);
+    for (u32 i = 0; i < NUMS; ++i) {
+      assert(filled[i] < 37);
+      assert(filled[i] == r2.Create(37));
+    }
+    assert(r1.Create() == r2.Create());
+  }
+
+  void Random_Test::Test_randomStreamSeeds()
+  {
+    const u32 STREAMS = 64;
+    u32 seeds[STREAMS];
+
+    for (u32 i = 0; i < STREAMS; ++i) {
+      seeds[i] = Random::GetStreamSeed(1, i);
+      assert(seeds[i] != 0);
+      assert(seeds[i] == Random::GetStreamSeed(1, i));
+      assert(seeds[i] != Random::GetStreamSeed(2, i));
+      for (u32 j = 0; j < i; ++j) {
+        assert(seeds[i] != seeds[j]);
+      }
+    }
+  }
+
+  void Random_Test::Test_randomXoshiro()
+  {
+    // SplitMix64's first output from 0, per its reference code
+    u64 x = 0;
+    assert(RandXoshiro::SplitMix64(x) == HexU64(0xe220a839, 0x7b1dcdaf));
+
+    RandXoshiro a, b;
+    a.Seed(3);
+    b.Seed(3);
+    for (u32 i = 0; i < 100; ++i) {
+      assert(a.Next64() == b.Next64());
+    }
+
+    b.Seed(4);
+    u32 countSame = 0;
+    for (u32 i = 0; i < 100; ++i) {
+      if (a.Next32() == b.Next32()) ++countSame;
+    }
+    assert(countSame < 100);
+  }
+
 } /* namespace MFM */
@@ -0,0 +1,140 @@
+#include "assert.h"
+#include <unistd.h>
+#include <string.h>
+#include "StatsLog_Test.h"
+#include "StatsLog.h"
+
+namespace MFM {
+
+  static const char * PATH = "/tmp/StatsLog_Test.mfstats";
+
+  typedef OverflowableCharBufferByteSink<8192> CSVBuffer;
+
+  static void AddRow(StatsLog & log, u32 row)
+  {
+    log.Add("AEPS", row);
+    log.Add("Half AER", row / 2.0);
+  }
+
+  void StatsLog_Test::Test_RunTests()
+  {
+    Test_statsLogRoundTrip();
+    Test_statsLogColumnChange();
+    Test_statsLogReopen();
+    Test_statsLogTruncated();
+  }
+
+  void StatsLog_Test::Test_statsLogRoundTrip()
+  {
+    unlink(PATH);
+    {
+      StatsLog log;
+      assert(log.Open(PATH));
+      for (u32 r = 0; r < StatsLog::FLUSH_ROWS + 3; ++r)
+      {
+        AddRow(log, r);
+        log.EndRow();
+      }
+      log.EndRow();  // Empty, so ignored
+      assert(log.GetRowsLogged() == StatsLog::FLUSH_ROWS + 3);
+    }  // Closing flushes the last partial block
+
+    CSVBuffer csv;
+    assert(StatsLog::WriteCSV(PATH, csv));
+
+    CSVBuffer expected;
+    expected.Printf("AEPS,Half_AER\n");
+    for (u32 r = 0; r < StatsLog::FLUSH_ROWS + 3; ++r)
+    {
+      expected.Printf("%d,%d%s\n", r, r / 2, (r & 1) ? ".5" : "");
+    }
+    assert(!csv.HasOverflowed());
+    assert(!strcmp(csv.GetZString(), expected.GetZString()));
+    unlink(PATH);
+  }
+
+  void StatsLog_Test::Test_statsLogColumnChange()
+  {
+    unlink(PATH);
+    {
+      StatsLog log;
+      assert(log.Open(PATH));
+      AddRow(log, 1);
+      log.EndRow();
+      log.Add("AEPS", 2);
+      log.Add("Dreg", 7);
+      log.Add("Res", 9);
+      log.EndRow();
+      AddRow(log, 3);
+      log.EndRow();
+    }
+
+    CSVBuffer csv;
+    assert(StatsLog::WriteCSV(PATH, csv));
+    assert(!strcmp(csv.GetZString(),
+                   "AEPS,Half_AER\n1,0.5\n"
+                   "AEPS,Dreg,Res\n2,7,9\n"
+                   "AEPS,Half_AER\n3,1.5\n"));
+    unlink(PATH);
+  }
+
+  void StatsLog_Test::Test_statsLogReopen()
+  {
+    unlink(PATH);
+    for (u32 r = 0; r < 2; ++r)
+    {
+      StatsLog log;
+      assert(log.Open(PATH));
+      AddRow(log, r);
+      log.EndRow();
+    }
+
+    CSVBuffer csv;
+    assert(StatsLog::WriteCSV(PATH, csv));
+    assert(!strcmp(csv.GetZString(), "AEPS,Half_AER\n0,0\n1,0.5\n"));
+
+    // Not a statistics log: won't append to it, or read it
+    FILE * fp = fopen(PATH, "wb");
+    assert(fp);
+    fprintf(fp, "# AEPS AEPS/Frame AER100 Overhead100\n");
+    fclose(fp);
+    StatsLog log;
+    assert(!log.Open(PATH));
+    assert(!StatsLog::WriteCSV(PATH, csv));
+    unlink(PATH);
+  }
+
+  void StatsLog_Test::Test_statsLogTruncated()
+  {
+    unlink(PATH);
+    {
+      StatsLog log;
+      assert(log.Open(PATH));
+      for (u32 r = 0; r < StatsLog::FLUSH_ROWS + 1; ++r)
+      {
+        AddRow(log, r);
+        log.EndRow();
+      }
+    }
+
+    // Lose the end of the last block, as if the run had crashed
+    FILE * fp = fopen(PATH, "r+b");
+    assert(fp);
+    fseek(fp, 0, SEEK_END);
+    assert(!ftruncate(fileno(fp), ftell(fp) - 4));
+    fclose(fp);
+
+    // Everything before it still converts
+    CSVBuffer csv;
+    assert(StatsLog::WriteCSV(PATH, csv));
+    CSVBuffer expected;
+    expected.Printf("AEPS,Half_AER\n");
+    for (u32 r = 0; r < StatsLog::FLUSH_ROWS; ++r)
+    {
+      expected.Printf("%d,%d%s\n", r, r / 2, (r & 1) ? ".5" : "");
+    }
+    assert(!strcmp(csv.GetZString(), expected.GetZString()));
+    unlink(PATH);
+  }
+
+} /* namespace MFM */
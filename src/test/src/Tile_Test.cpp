@@ -3,12 +3,22 @@
 #include "Point.h"
 #include "Tile_Test.h"
 #include "Element_Res.h"
+#include "Element_Dreg.h"
+#include "Test_UlamElement.h"
+#include "OverflowableCharBufferByteSink.h"
 
 namespace MFM {
 
   void Tile_Test::Test_RunTests() {
     Test_tileSquareDistances();
     Test_tilePlaceAtom();
+    Test_tileSiteLayout();
+    Test_tileInertEvents();
+    Test_tileOccupancy();
+    Test_tileUlamBehavior();
+    Test_tileAtomCounts();
+    Test_tileCounters();
+    Test_tileWriteGenerations();
   }
 
   void Tile_Test::Test_tileSquareDistances()
@@ -58,4 +68,302 @@ namespace MFM {
 
     assert(other.GetType() == atom.GetType());
   }
+
+  void Tile_Test::Test_tileSiteLayout()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    SPoint loc(10, 10);
+    SPoint next(11, 10);
+
+    assert(tile.GetSiteLayout() == SITE_LAYOUT_ARRAY_OF_STRUCTS);
+    tile.PlaceAtom(atom, loc);
+    tile.GetSite(loc).SetPaint(0xff123456);
+    tile.GetSite(loc).RecordEventAtSite(7);
+
+    tile.SetSiteLayout(SITE_LAYOUT_STRUCT_OF_ARRAYS);
+    assert(tile.GetSiteLayout() == SITE_LAYOUT_STRUCT_OF_ARRAYS);
+
+    // Contents survive, and the atoms are now packed together
+    assert(tile.GetAtom(loc)->GetType() == atom.GetType());
+    assert(tile.GetAtom(next)->GetType() != atom.GetType());
+    assert(tile.GetAtom(next) == tile.GetAtom(loc) + 1);
+    assert(tile.GetSite(loc).GetPaint() == 0xff123456);
+    assert(tile.GetSite(loc).GetEventCount() == 1);
+
+    tile.PlaceAtom(atom, next);
+    tile.GetSite(next).SetPaint(0xff654321);
+
+    tile.SetSiteLayout(SITE_LAYOUT_ARRAY_OF_STRUCTS);
+    assert(tile.GetAtom(loc)->GetType() == atom.GetType());
+    assert(tile.GetAtom(next)->GetType() == atom.GetType());
+    assert(tile.GetSite(loc).GetPaint() == 0xff123456);
+    assert(tile.GetSite(next).GetPaint() == 0xff654321);
+    assert(tile.GetSite(loc).GetEventCount() == 1);
+    assert(tile.GetSite(next).GetEventCount() == 0);
+  }
+
+  void Tile_Test::Test_tileInertEvents()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    SPoint empty(10, 10);
+    SPoint res(11, 10);
+    tile.PlaceAtom(atom, res);
+
+    // Events may be rejected for recency, so retry until one happens
+    u32 tries = 0;
+    while (!tile.TryEventAt(empty))
+    {
+      assert(++tries < 1000);
+    }
+    assert(tile.GetEventsExecuted() == 1);
+    assert(tile.GetInertEventsExecuted() == 1);
+    assert(tile.GetSite(empty).GetEventCount() == 1);
+    assert(tile.GetEventWindow().IsFree());
+
+    tries = 0;
+    while (!tile.TryEventAt(res))
+    {
+      assert(++tries < 1000);
+    }
+    assert(tile.GetEventsExecuted() == 2);
+    assert(tile.GetInertEventsExecuted() == 1);
+  }
+
+  void Tile_Test::Test_tileOccupancy()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    TestAtom atom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    SPoint first(10, 10);
+    SPoint second(12, 13);
+    tile.PlaceAtom(atom, first);
+
+    tile.SetSiteSampling(SITE_SAMPLING_OCCUPIED);
+    assert(tile.GetOccupiedSiteCount() == 1);
+    assert(tile.GetRandomOccupiedCoord().Equals(first));
+
+    // Kept up to date incrementally
+    tile.PlaceAtom(atom, second);
+    assert(tile.GetOccupiedSiteCount() == 2);
+    tile.PlaceAtom(tile.GetEmptyAtom(), first);
+    assert(tile.GetOccupiedSiteCount() == 1);
+    for (u32 i = 0; i < 10; ++i)
+    {
+      assert(tile.GetRandomOccupiedCoord().Equals(second));
+    }
+
+    // And rebuilt after bulk changes
+    tile.ClearAtoms();
+    assert(tile.GetOccupiedSiteCount() == 0);
+
+    // Each event at the lone Res is credited with the events the
+    // empty sites would have had
+    tile.PlaceAtom(atom, second);
+    u32 tries = 0;
+    while (!tile.TryRandomEvent())
+    {
+      assert(++tries < 1000);
+    }
+    const u64 empties = tile.GetSites() - 1;
+    assert(tile.GetEventsExecuted() == 1 + tile.GetInertEventsExecuted());
+    assert(tile.GetInertEventsExecuted() == empties);
+  }
+
+  void Tile_Test::Test_tileUlamBehavior()
+  {
+    typedef Ue_TestCounter<TestEventConfig> Counter;
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Counter::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Counter::THE_INSTANCE);
+    tile.GetUlamClassRegistry().RegisterUlamClass(Counter::THE_INSTANCE);
+
+    TestAtom atom(Counter::THE_INSTANCE.GetDefaultAtom());
+    SPoint loc(10, 10);
+    tile.PlaceAtom(atom, loc);
+
+    // The first event resolves behave() through the vtable, and the
+    // rest reuse that; both must reach the same bits
+    const u32 behaves = Counter::s_behaves;
+    for (u32 i = 1; i <= 3; ++i)
+    {
+      u32 tries = 0;
+      while (!tile.TryEventAt(loc))
+      {
+        assert(++tries < 1000);
+      }
+      assert(Counter::THE_INSTANCE.IsBehaviorDispatchResolved());
+      assert(Counter::s_behaves == behaves + i);
+      assert(tile.GetAtom(loc)->GetType() == Counter::THE_INSTANCE.GetType());
+      assert(tile.GetAtom(loc)->GetBits().Read(TestAtom::ATOM_FIRST_STATE_BIT, Counter::COUNTER_BITS) == i);
+    }
+  }
+
+  void Tile_Test::Test_tileAtomCounts()
+  {
+    typedef Element_Res<TestEventConfig> Res;
+    typedef Element_Dreg<TestEventConfig> Dreg;
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Res::THE_INSTANCE.AllocateType(etnm);
+    Dreg::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Res::THE_INSTANCE);
+    const u32 res = Res::THE_INSTANCE.GetType();
+    const u32 dreg = Dreg::THE_INSTANCE.GetType();
+    const u32 empty = tile.GetEmptyAtom().GetType();
+
+    assert(tile.GetAtomCount(empty) == tile.GetSites());  // First count scans
+    tile.PlaceAtom(Res::THE_INSTANCE.GetDefaultAtom(), SPoint(10, 10));
+    tile.PlaceAtom(Res::THE_INSTANCE.GetDefaultAtom(), SPoint(11, 10));
+    tile.PlaceAtom(tile.GetEmptyAtom(), SPoint(11, 10));
+    assert(tile.GetAtomCount(res) == 1);
+    assert(tile.GetAtomCount(empty) == tile.GetSites() - 1);
+
+    // Cache sites are not counted
+    tile.PlaceAtom(Res::THE_INSTANCE.GetDefaultAtom(), SPoint(0, 0));
+    assert(tile.GetAtomCount(res) == 1);
+    assert(tile.CheckAtomCounts());
+
+    // Registering an element recounts the atoms of its type
+    tile.PlaceAtom(Dreg::THE_INSTANCE.GetDefaultAtom(), SPoint(20, 20));
+    assert(tile.GetAtomCount(dreg) == (u32) -1);
+    tile.RegisterElement(Dreg::THE_INSTANCE);
+    assert(tile.GetAtomCount(dreg) == 1);
+
+    // Events keep the counts current
+    for (u32 x = 4; x < tile.TILE_WIDTH - 4; x += 4)
+    {
+      for (u32 y = 4; y < tile.TILE_HEIGHT - 4; y += 4)
+      {
+        tile.PlaceAtom(Dreg::THE_INSTANCE.GetDefaultAtom(), SPoint(x, y));
+      }
+    }
+    tile.GetRandom().SetSeed(1);
+    for (u32 i = 0; i < 100000; ++i)
+    {
+      tile.TryRandomEvent();
+    }
+    assert(tile.GetAtomCount(res) > 1);
+    assert(tile.GetAtomCount(empty) + tile.GetAtomCount(res) + tile.GetAtomCount(dreg) == tile.GetSites());
+    assert(tile.CheckAtomCounts());
+  }
+
+  void Tile_Test::Test_tileWriteGenerations()
+  {
+    typedef Element_Res<TestEventConfig> Res;
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Res::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Res::THE_INSTANCE);
+    const u32 B = TestTile::WRITE_BLOCK_SIDE;
+
+    const u32 before = tile.GetWriteGeneration();
+    tile.PlaceAtom(Res::THE_INSTANCE.GetDefaultAtom(), SPoint(2 * B + 1, B));
+    assert(tile.GetWriteGeneration() != before);
+    assert(tile.IsBlockWrittenSince(2, 1, before));
+    assert(!tile.IsBlockWrittenSince(1, 1, before));
+    assert(!tile.IsBlockWrittenSince(2, 2, before));
+    assert(!tile.IsBlockWrittenSince(-1, 0, before));
+
+    // Rewriting what is already there is no write
+    const u32 after = tile.GetWriteGeneration();
+    tile.PlaceAtom(Res::THE_INSTANCE.GetDefaultAtom(), SPoint(2 * B + 1, B));
+    assert(tile.GetWriteGeneration() == after);
+    assert(!tile.IsBlockWrittenSince(2, 1, after));
+
+    // Changes behind PlaceAtom's back touch every block
+    tile.NeedAtomRecount();
+    assert(tile.IsBlockWrittenSince(0, 0, after));
+    assert(tile.IsBlockWrittenSince((tile.TILE_WIDTH - 1) / B, (tile.TILE_HEIGHT - 1) / B, after));
+  }
+
+  static u32 CountCommas(const char * zstr)
+  {
+    u32 commas = 0;
+    for (const char * p = zstr; *p; ++p)
+    {
+      if (*p == ',') ++commas;
+    }
+    return commas;
+  }
+
+  void Tile_Test::Test_tileCounters()
+  {
+    typedef Element_Res<TestEventConfig> Res;
+    typedef Element_Dreg<TestEventConfig> Dreg;
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Res::THE_INSTANCE.AllocateType(etnm);
+    Dreg::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Res::THE_INSTANCE);
+    tile.RegisterElement(Dreg::THE_INSTANCE);
+
+    for (u32 x = 4; x < tile.TILE_WIDTH - 4; x += 4)
+    {
+      for (u32 y = 4; y < tile.TILE_HEIGHT - 4; y += 4)
+      {
+        tile.PlaceAtom(Dreg::THE_INSTANCE.GetDefaultAtom(), SPoint(x, y));
+      }
+    }
+    tile.GetRandom().SetSeed(1);
+    for (u32 i = 0; i < 100000; ++i)
+    {
+      tile.TryRandomEvent();
+    }
+
+    TileCounters tc;
+    tile.SampleCounters(tc);
+    assert(tc.Get(TileCounters::EVENTS_ATTEMPTED) == tile.GetEventWindow().GetEventWindowsAttempted());
+    assert(tc.Get(TileCounters::EVENTS_EXECUTED) == tile.GetEventsExecuted());
+    assert(tc.Get(TileCounters::FAST_PATH_EVENTS) == tile.GetInertEventsExecuted());
+    assert(tc.Get(TileCounters::FAST_PATH_EVENTS) > 0);
+
+    // A lone tile needs no locks, and every attempt is accounted for
+    assert(tc.Get(TileCounters::LOCK_FAILURES) == 0);
+    assert(tc.Get(TileCounters::RECENCY_REJECTIONS) > 0);
+    assert(tc.Get(TileCounters::EVENTS_ATTEMPTED) ==
+           tc.Get(TileCounters::EVENTS_EXECUTED) + tc.Get(TileCounters::RECENCY_REJECTIONS));
+
+    // Dreg's behavior FAILs if it tries to make an element that was
+    // never given a type, which depends on what other tests have run
+    const u64 run = tc.Get(TileCounters::EVENTS_EXECUTED) - tc.Get(TileCounters::FAST_PATH_EVENTS);
+    assert(tc.Get(TileCounters::BEHAVIOR_FAILURES) < run);
+
+    // About one in 2^TIMING_SHIFT events is timed
+    assert(tc.Get(TileCounters::TIMED_EVENTS) > 0);
+    assert(tc.Get(TileCounters::TIMED_EVENTS) <= run);
+    assert(tc.Get(TileCounters::BEHAVIOR_TICKS) > 0);
+
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      assert(tc.Get(d, TileCounters::DIR_LOCK_FAILURES) == 0);
+      assert(tc.Get(d, TileCounters::PACKETS_SENT) == 0);
+    }
+
+    OString4096 header, row;
+    TileCounters::WriteCSVHeader(header, "x,");
+    tc.WriteCSVRow(row, "1,");
+    assert(!header.HasOverflowed() && !row.HasOverflowed());
+    assert(CountCommas(header.GetZString()) == TileCounters::COUNTER_COUNT);
+    assert(CountCommas(row.GetZString()) == TileCounters::COUNTER_COUNT);
+
+    OString4096 json;
+    tc.WriteJSON(json);
+    assert(!json.HasOverflowed());
+    assert(json.GetZString()[0] == '{');
+    assert(json.GetZString()[json.GetLength() - 1] == '}');
+  }
 } /* namespace MFM */
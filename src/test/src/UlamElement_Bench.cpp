@@ -0,0 +1,95 @@
+#include "UlamElement_Bench.h"
+#include "Test_Common.h"
+#include "Test_UlamElement.h"
+#include "UlamContextEvent.h"
+
+namespace MFM {
+
+  enum { BENCH_CALLS = 5000000, BENCH_EVENTS = 2000000 };
+
+  typedef Ue_TestCounter<TestEventConfig> Counter;
+  typedef UlamRef<TestEventConfig> TestUlamRef;
+  typedef void (* Uf_6behave) (const UlamContext<TestEventConfig>&, TestUlamRef& );
+
+  static void Setup(TestTile & tile)
+  {
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Counter::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Counter::THE_INSTANCE);
+    tile.GetUlamClassRegistry().RegisterUlamClass(Counter::THE_INSTANCE);
+  }
+
+  static void Report(const char * what, double secs)
+  {
+    const double ns = secs * 1.0e9 / BENCH_CALLS;
+    BenchOutput().Printf("  %s: %d.%02d ns\n", what, (u32) ns, ((u32) (ns * 100)) % 100);
+  }
+
+  void UlamElement_Bench::Bench_dispatch()
+  {
+    TestTile tile;
+    Setup(tile);
+    UlamContextEvent<TestEventConfig> uc(tile.GetElementTable());
+    uc.SetTile(tile);
+    TestAtom atom(Counter::THE_INSTANCE.GetDefaultAtom());
+    AtomBitStorage<TestEventConfig> stg(atom);
+    const Counter & elt = Counter::THE_INSTANCE;
+
+    // Resolving through the vtable each call, as Behavior used to
+    BenchTimer resolved;
+    for (u32 i = 0; i < BENCH_CALLS; ++i)
+    {
+      TestUlamRef ur(TestAtom::ATOM_FIRST_STATE_BIT, elt.GetClassLength(), stg, &elt, TestUlamRef::ELEMENTAL, uc);
+      VfuncPtr vfuncptr;
+      TestUlamRef vfur(ur, Counter::BEHAVE_VOWNED_INDEX, 0u, true, vfuncptr);
+      ((Uf_6behave) vfuncptr) (uc, vfur);
+    }
+    Report("vtable resolution (per call)", resolved.GetElapsedSeconds());
+
+    // Reusing one resolution, as Behavior does now
+    TestUlamRef ur(TestAtom::ATOM_FIRST_STATE_BIT, elt.GetClassLength(), stg, &elt, TestUlamRef::ELEMENTAL, uc);
+    VfuncPtr vfuncptr;
+    TestUlamRef once(ur, Counter::BEHAVE_VOWNED_INDEX, 0u, true, vfuncptr);
+    BenchTimer cached;
+    for (u32 i = 0; i < BENCH_CALLS; ++i)
+    {
+      TestUlamRef vfur(once.GetPos(), once.GetLen(), once.GetPosToEffectiveSelf(), stg, &elt, once.GetUsage(), uc);
+      ((Uf_6behave) vfuncptr) (uc, vfur);
+    }
+    Report("cached dispatch (per call)", cached.GetElapsedSeconds());
+  }
+
+  void UlamElement_Bench::Bench_events()
+  {
+    TestTile tile;
+    Setup(tile);
+    const TestAtom counter = Counter::THE_INSTANCE.GetDefaultAtom();
+    for (u32 x = 0; x < tile.OWNED_WIDTH; ++x)
+    {
+      for (u32 y = 0; y < tile.OWNED_HEIGHT; ++y)
+      {
+        tile.PlaceAtom(counter, SPoint(x, y) + SPoint(tile.EVENT_WINDOW_RADIUS, tile.EVENT_WINDOW_RADIUS));
+      }
+    }
+
+    TestEventWindow & ew = tile.GetEventWindow();
+    u32 executed = 0;
+    BenchTimer timer;
+    for (u32 i = 0; i < BENCH_EVENTS; ++i)
+    {
+      if (ew.TryForceEventAt(tile.GetRandomOwnedCoord()))
+      {
+        ++executed;
+      }
+    }
+    const double secs = timer.GetElapsedSeconds();
+    BenchOutput().Printf("  TestCounter events: %d events/sec\n", (u32) (executed / secs));
+  }
+
+  void UlamElement_Bench::Bench_RunBenchmarks()
+  {
+    Bench_dispatch();
+    Bench_events();
+  }
+
+} /* namespace MFM */
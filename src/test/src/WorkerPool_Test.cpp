@@ -0,0 +1,107 @@
+#include "assert.h"
+#include "WorkerPool_Test.h"
+#include "WorkerPool.h"
+
+namespace MFM {
+
+  /**
+     Claims ITEMS items from a shared counter, marking each done, and
+     FAILs on the thread numbered m_failOn (if any) after its claims
+     are over, while the other threads may still be working
+   */
+  class CountingJob : public WorkerPool::Job
+  {
+  public:
+    enum { ITEMS = 1000 };
+
+    u32 m_next;
+    u32 m_done[ITEMS];
+    s32 m_failOn;
+
+    CountingJob()
+      : m_next(0)
+      , m_failOn(-1)
+    {
+      for (u32 i = 0; i < ITEMS; ++i)
+      {
+        m_done[i] = 0;
+      }
+    }
+
+    virtual void Work(u32 thread)
+    {
+      while (true)
+      {
+        const u32 index = __sync_fetch_and_add(&m_next, 1);
+        if (index >= ITEMS)
+        {
+          break;
+        }
+        __sync_fetch_and_add(&m_done[index], 1);
+      }
+      if ((s32) thread == m_failOn)
+      {
+        FAIL(ILLEGAL_STATE);
+      }
+    }
+
+    bool AllDoneOnce() const
+    {
+      for (u32 i = 0; i < ITEMS; ++i)
+      {
+        if (m_done[i] != 1)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+  };
+
+  void WorkerPool_Test::Test_RunTests()
+  {
+    Test_workerPoolRun();
+    Test_workerPoolFailures();
+  }
+
+  void WorkerPool_Test::Test_workerPoolRun()
+  {
+    WorkerPool pool;
+    assert(pool.GetThreads() == 0);
+    for (u32 threads = 1; threads <= 4; ++threads)
+    {
+      CountingJob job;
+      pool.Run(job, threads);
+      assert(job.AllDoneOnce());
+      assert(pool.GetThreads() == threads);
+    }
+  }
+
+  void WorkerPool_Test::Test_workerPoolFailures()
+  {
+    WorkerPool pool;
+
+    // The caller's failure, then a worker's, each reach the caller
+    // only after every thread is done, and leave the pool usable
+    for (s32 failOn = 0; failOn < 2; ++failOn)
+    {
+      CountingJob job;
+      job.m_failOn = failOn;
+      s32 code = 0;
+      unwind_protect(
+      {
+        code = MFMThrownFailCode;
+      },
+      {
+        pool.Run(job, 3);
+      });
+      assert(code == MFM_FAIL_CODE_NUMBER(ILLEGAL_STATE));
+      assert(job.AllDoneOnce());
+
+      CountingJob again;
+      pool.Run(again, 3);
+      assert(again.AllDoneOnce());
+    }
+  }
+
+} /* namespace MFM */